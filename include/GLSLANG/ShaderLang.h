@@ -34,7 +34,7 @@ extern "C" {
 
 // Version number for shader translation API.
 // It is incremented everytime the API changes.
-#define SH_VERSION 107
+#define SH_VERSION 125
 
 //
 // The names of the following enums have been derived by replacing GL prefix
@@ -78,7 +78,9 @@ typedef enum {
   SH_ESSL_OUTPUT = 0x8B45,
   SH_GLSL_OUTPUT = 0x8B46,
   SH_HLSL_OUTPUT = 0x8B47,
-  SH_JS_OUTPUT   = 0x8B48
+  SH_JS_OUTPUT   = 0x8B48,
+  SH_JS_EXECUTABLE_OUTPUT = 0x8B49,
+  SH_JS_BINARY_OUTPUT = 0x8B4A
 } ShShaderOutput;
 
 typedef enum {
@@ -111,9 +113,25 @@ typedef enum {
   SH_ACTIVE_UNIFORM_MAX_LENGTH   =  0x8B87,
   SH_ACTIVE_ATTRIBUTES           =  0x8B89,
   SH_ACTIVE_ATTRIBUTE_MAX_LENGTH =  0x8B8A,
-  SH_MAPPED_NAME_MAX_LENGTH      =  0x8B8B
+  SH_MAPPED_NAME_MAX_LENGTH      =  0x8B8B,
+  SH_ACTIVE_VARYINGS             =  0x8C83,  // GL_TRANSFORM_FEEDBACK_VARYINGS
+  SH_ACTIVE_VARYING_MAX_LENGTH   =  0x8C76,  // GL_TRANSFORM_FEEDBACK_VARYING_MAX_LENGTH
+  SH_BUILT_IN_USAGE              =  0x6000,  // No GL counterpart
+  SH_UNIFORM_REGISTER_COUNT      =  0x6001,  // No GL counterpart
+  SH_POOL_PEAK_SIZE              =  0x6002,  // No GL counterpart
+  SH_POOL_ALLOCATION_COUNT       =  0x6003,  // No GL counterpart
+  SH_DEPENDENCY_GRAPH_LENGTH     =  0x6004   // No GL counterpart
 } ShShaderInfo;
 
+// Built-in variables referenced by a shader, as returned by ShGetInfo with
+// SH_BUILT_IN_USAGE.
+typedef enum {
+  SH_USES_FRAG_COORD   = 0x0001,
+  SH_USES_FRONT_FACING = 0x0002,
+  SH_USES_POINT_COORD  = 0x0004,
+  SH_USES_POINT_SIZE   = 0x0008
+} ShBuiltInUsage;
+
 // Compile options.
 typedef enum {
   SH_VALIDATE                = 0,
@@ -143,7 +161,76 @@ typedef enum {
   // - The shader spec is SH_WEBGL_SPEC.
   // - The compile options contain the SH_TIMING_RESTRICTIONS flag.
   // - The shader type is SH_FRAGMENT_SHADER.
-  SH_DEPENDENCY_GRAPH = 0x0400
+  SH_DEPENDENCY_GRAPH = 0x0400,
+
+  // This flag removes code that cannot affect the result of the shader
+  // before translation: functions not reachable from main(), if-branches
+  // with constant conditions that are never taken, and variables that are
+  // never read along with the assignments to them.
+  SH_REMOVE_DEAD_CODE = 0x0800,
+
+  // This flag evaluates side-effect free expressions that are repeated
+  // within a block only once, storing their value in a temporary variable.
+  SH_ELIMINATE_COMMON_SUBEXPRESSIONS = 0x1000,
+
+  // This flag replaces calls to small user-defined functions with the body
+  // of the function. Functions left without callers are only removed if
+  // SH_REMOVE_DEAD_CODE is also set.
+  SH_INLINE_FUNCTIONS = 0x2000,
+
+  // This flag merges adjacent statements that compute the same operations
+  // on different components of vectors into single statements operating
+  // on swizzled vectors.
+  SH_VECTORIZE_SCALAR_OPERATIONS = 0x4000,
+
+  // This flag moves the computations that produce the same value in every
+  // iteration of a for-loop out of the loop.
+  // This flag only has an effect if the compile options contain the
+  // SH_VALIDATE_LOOP_INDEXING flag.
+  SH_HOIST_LOOP_INVARIANTS = 0x8000,
+
+  // This flag replaces the uniforms given values by ShSpecializeUniformfv()
+  // or ShSpecializeUniformiv() with constants, folds the expressions that
+  // become constant, and removes the branches that are never taken.
+  // SH_REMOVE_DEAD_CODE is implied. The specialized shader no longer
+  // declares the uniforms that are replaced everywhere.
+  SH_SPECIALIZE_UNIFORMS = 0x10000,
+
+  // This flag translates the function definitions of GLSL and ESSL output
+  // on several threads when the shader has many of them. The object code
+  // is the same as without the flag. HLSL and JavaScript output are
+  // always translated on the calling thread.
+  SH_PARALLEL_TRANSLATION = 0x40000,
+
+  // This flag restricts the attributes and uniforms extracted by
+  // SH_ATTRIBUTES_UNIFORMS, which it implies, to those that main() or the
+  // functions it calls reference. Variables only referenced by functions
+  // that are never called are not reported.
+  SH_STATIC_USE_ATTRIBUTES_UNIFORMS = 0x80000,
+
+  // This flag removes the declarations of the attributes and uniforms that
+  // main() and the functions it calls do not reference, except for struct
+  // variables. SH_REMOVE_DEAD_CODE is implied.
+  SH_REMOVE_UNUSED_ATTRIBUTES_UNIFORMS = 0x100000,
+
+  // This flag packs the uniforms extracted by SH_ATTRIBUTES_UNIFORMS,
+  // which it implies, in registers of four components, so that they can be
+  // uploaded as one block. The place of each uniform can be queried by
+  // calling ShGetUniformRegister().
+  SH_PACK_UNIFORMS = 0x200000,
+
+  // This flag packs the uniforms as SH_PACK_UNIFORMS does, which it
+  // implies, but in the order that uses the fewest registers rather than
+  // in the order of the uniforms.
+  SH_PACK_UNIFORMS_TIGHTLY = 0x400000,
+
+  // These flags export the whole dependency graph of the shader, which
+  // SH_TIMING_RESTRICTIONS uses, in JSON or in the DOT language of
+  // Graphviz, for tools that analyze it. They work with any spec and shader
+  // type. The graph can be queried by calling ShGetDependencyGraph(). If
+  // both flags are set, the graph is exported in JSON.
+  SH_DEPENDENCY_GRAPH_JSON = 0x800000,
+  SH_DEPENDENCY_GRAPH_DOT = 0x1000000
 } ShCompileOptions;
 
 //
@@ -205,7 +292,14 @@ typedef void* ShHandle;
 // spec: Specifies the language spec the compiler must conform to -
 //       SH_GLES2_SPEC or SH_WEBGL_SPEC.
 // output: Specifies the output code type - SH_ESSL_OUTPUT, SH_GLSL_OUTPUT,
-//         or SH_HLSL_OUTPUT.
+//         SH_HLSL_OUTPUT, SH_JS_OUTPUT, SH_JS_EXECUTABLE_OUTPUT or
+//         SH_JS_BINARY_OUTPUT.
+//         SH_JS_OUTPUT writes the intermediate tree for a JavaScript
+//         interpreter. SH_JS_EXECUTABLE_OUTPUT writes the source of a
+//         JavaScript function that creates the shader's variables and a
+//         main function running the shader. SH_JS_BINARY_OUTPUT writes the
+//         tree of SH_JS_OUTPUT in a binary encoding, described in
+//         compiler/OutputJSBinary.h.
 // resources: Specifies the built-in resources.
 COMPILER_EXPORT ShHandle ShConstructCompiler(
     ShShaderType type,
@@ -235,9 +329,12 @@ COMPILER_EXPORT void ShDestruct(ShHandle handle);
 //                       Can be queried by calling ShGetInfoLog().
 // SH_OBJECT_CODE: Translates intermediate tree to glsl or hlsl shader.
 //                 Can be queried by calling ShGetObjectCode().
-// SH_ATTRIBUTES_UNIFORMS: Extracts attributes and uniforms.
-//                         Can be queried by calling ShGetActiveAttrib() and
-//                         ShGetActiveUniform().
+// SH_ATTRIBUTES_UNIFORMS: Extracts attributes and uniforms, and the
+//                         varyings and built-in variables the shader
+//                         references. Can be queried by calling
+//                         ShGetActiveAttrib(), ShGetActiveUniform(),
+//                         ShGetActiveVarying() and ShGetInfo() with
+//                         SH_BUILT_IN_USAGE.
 //
 COMPILER_EXPORT int ShCompile(
     const ShHandle handle,
@@ -254,7 +351,9 @@ COMPILER_EXPORT int ShCompile(
 // SH_INFO_LOG_LENGTH: the number of characters in the information log
 //                     including the null termination character.
 // SH_OBJECT_CODE_LENGTH: the number of characters in the object code
-//                        including the null termination character.
+//                        including the null termination character. The
+//                        binary object code of SH_JS_BINARY_OUTPUT may
+//                        contain other null characters.
 // SH_ACTIVE_ATTRIBUTES: the number of active attribute variables.
 // SH_ACTIVE_ATTRIBUTE_MAX_LENGTH: the length of the longest active attribute
 //                                 variable name including the null
@@ -265,6 +364,23 @@ COMPILER_EXPORT int ShCompile(
 //                               termination character.
 // SH_MAPPED_NAME_MAX_LENGTH: the length of the mapped variable name including
 //                            the null termination character.
+// SH_ACTIVE_VARYINGS: the number of active varying variables.
+// SH_ACTIVE_VARYING_MAX_LENGTH: the length of the longest active varying
+//                               variable name including the null
+//                               termination character.
+// SH_BUILT_IN_USAGE: a mask of the ShBuiltInUsage flags of the built-in
+//                    variables the shader references.
+// SH_UNIFORM_REGISTER_COUNT: the number of registers of four components
+//                            used by the uniforms packed with
+//                            SH_PACK_UNIFORMS.
+// SH_POOL_PEAK_SIZE: the largest number of bytes of memory the compiler
+//                    pool allocator used at once during the last compile.
+// SH_POOL_ALLOCATION_COUNT: the number of allocations from the pool
+//                           allocator during the last compile.
+// SH_DEPENDENCY_GRAPH_LENGTH: the number of characters in the dependency
+//                             graph exported with SH_DEPENDENCY_GRAPH_JSON
+//                             or SH_DEPENDENCY_GRAPH_DOT, including the
+//                             null termination character.
 // 
 // params: Requested parameter
 COMPILER_EXPORT void ShGetInfo(const ShHandle handle,
@@ -291,6 +407,32 @@ COMPILER_EXPORT void ShGetInfoLog(const ShHandle handle, char* infoLog);
 //          ShGetInfo with SH_OBJECT_CODE_LENGTH.
 COMPILER_EXPORT void ShGetObjectCode(const ShHandle handle, char* objCode);
 
+// Returns the null-terminated dependency graph exported by a compile with
+// SH_DEPENDENCY_GRAPH_JSON or SH_DEPENDENCY_GRAPH_DOT. The graph is empty if
+// the compile did not export it.
+// Parameters:
+// handle: Specifies the compiler
+// graph: Specifies an array of characters that is used to return the
+//        graph. It is assumed that graph has enough memory to accomodate
+//        the graph. The size of the buffer required to store the returned
+//        graph can be obtained by calling ShGetInfo with
+//        SH_DEPENDENCY_GRAPH_LENGTH.
+COMPILER_EXPORT void ShGetDependencyGraph(const ShHandle handle, char* graph);
+
+// Returns the null-terminated information log or object code of a compiled
+// shader without copying it. The returned pointer belongs to the compiler
+// and remains valid until the next call to ShCompile() or ShDestruct() with
+// the same handle. Returns NULL if handle is not a valid compiler.
+// Parameters:
+// handle: Specifies the compiler
+// length: Returns the length of the information log or object code, not
+//         including the null termination character. Binary object code may
+//         contain null characters before its end. Can be NULL.
+COMPILER_EXPORT const char* ShGetInfoLogPointer(const ShHandle handle,
+                                                int* length);
+COMPILER_EXPORT const char* ShGetObjectCodePointer(const ShHandle handle,
+                                                   int* length);
+
 // Returns information about an active attribute variable.
 // Parameters:
 // handle: Specifies the compiler
@@ -345,6 +487,102 @@ COMPILER_EXPORT void ShGetActiveUniform(const ShHandle handle,
                                         char* name,
                                         char* mappedName);
 
+// Returns information about an active varying variable, one that the
+// shader references. Varyings are listed in the order of their names.
+// Parameters:
+// handle: Specifies the compiler
+// index: Specifies the index of the varying variable to be queried.
+// length: Returns the number of characters actually written in the string
+//         indicated by name (excluding the null terminator) if a value
+//         other than NULL is passed.
+// size: Returns the size of the varying variable.
+// type: Returns the data type of the varying variable.
+// name: Returns a null terminated string containing the name of the
+//       varying variable. It is assumed that name has enough memory to
+//       accomodate the varying variable name. The size of the buffer required
+//       to store the varying variable name can be obtained by calling
+//       ShGetInfo with SH_ACTIVE_VARYING_MAX_LENGTH.
+// mappedName: Returns a null terminated string containing the mapped name of
+//             the varying variable, It is assumed that mappedName has enough
+//             memory (SH_MAPPED_NAME_MAX_LENGTH), or NULL if don't care
+//             about the mapped name. If the name is not mapped, then name and
+//             mappedName are the same.
+COMPILER_EXPORT void ShGetActiveVarying(const ShHandle handle,
+                                        int index,
+                                        int* length,
+                                        int* size,
+                                        ShDataType* type,
+                                        char* name,
+                                        char* mappedName);
+
+// Returns the place of an active uniform variable in the registers of four
+// components in which compiling with the SH_PACK_UNIFORMS flag packs the
+// uniforms. Element i of an array starts at component *component of
+// register *registerIndex + i * *arrayStride. The columns of a matrix take
+// consecutive registers: column c of element i is at component *component
+// of register *registerIndex + i * *arrayStride + c. A variable that is not
+// an array is element 0.
+// Parameters:
+// handle: Specifies the compiler
+// index: Specifies the index of the uniform variable, as given to
+//        ShGetActiveUniform().
+// registerIndex: Returns the register holding the first component of the
+//                uniform variable, or -1 if the variable is a sampler or
+//                the uniforms were not packed.
+// component: Returns the first component (0 to 3) of the uniform variable
+//            in its registers.
+// arrayStride: Returns the number of registers taken by each element of
+//              the uniform variable: the number of columns of a matrix, or
+//              one.
+COMPILER_EXPORT void ShGetUniformRegister(const ShHandle handle,
+                                          int index,
+                                          int* registerIndex,
+                                          int* component,
+                                          int* arrayStride);
+
+// Gives the value of a uniform variable, which compiling with the
+// SH_SPECIALIZE_UNIFORMS flag substitutes for the variable. Values are kept
+// from compile to compile until ShClearSpecializedUniforms() is called.
+// Parameters:
+// handle: Specifies the compiler
+// name: Specifies the name of the uniform variable, as returned by
+//       ShGetActiveUniform(). The name of an array element, such as "a[2]",
+//       gives the values of the elements from that one on.
+// count: Specifies the number of components in values. Components of
+//        matrices are given column by column. Values are converted to the
+//        type of the uniform; samplers are never specialized.
+// values: Specifies the values of the components.
+COMPILER_EXPORT void ShSpecializeUniformfv(const ShHandle handle,
+                                           const char* name,
+                                           int count,
+                                           const float* values);
+COMPILER_EXPORT void ShSpecializeUniformiv(const ShHandle handle,
+                                           const char* name,
+                                           int count,
+                                           const int* values);
+
+// Forgets the values given by ShSpecializeUniformfv() and
+// ShSpecializeUniformiv().
+// Parameters:
+// handle: Specifies the compiler
+COMPILER_EXPORT void ShClearSpecializedUniforms(const ShHandle handle);
+
+// Limits the memory and the time each compile may take. A compile that goes
+// over its budget stops where it can, and fails with an error in the info
+// log. The budget is checked before each token of the source is parsed, and
+// between the passes over the tree, so a single pass may still go past it.
+// The budget is kept from compile to compile.
+// Parameters:
+// handle: Specifies the compiler
+// maxMemory: Specifies the number of bytes of memory the pool allocator of
+//            the compiler, or the object code, may take for a compile, or
+//            0 for no limit.
+// maxCompileTime: Specifies the time in milliseconds a compile may take, as
+//                 measured by a monotonic clock, or 0 for no limit.
+COMPILER_EXPORT void ShSetCompileBudget(const ShHandle handle,
+                                        int maxMemory,
+                                        int maxCompileTime);
+
 #ifdef __cplusplus
 }
 #endif
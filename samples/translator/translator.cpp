@@ -11,6 +11,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <string>
 #include <vector>
 
 //
@@ -28,6 +30,8 @@ static ShShaderType FindShaderType(const char* fileName);
 static bool CompileFile(char* fileName, ShHandle compiler, int compileOptions);
 static void LogMsg(const char* msg, const char* name, const int num, const char* logName);
 static void PrintActiveVariables(ShHandle compiler, ShShaderInfo varType, bool mapLongVariableNames);
+static bool SpecializeUniform(ShHandle compiler, const char* assignment);
+static void BenchmarkFile(char* fileName, ShHandle compiler, int compileOptions, int iterations);
 
 // If NUM_SOURCE_STRINGS is set to a value > 1, the input file data is
 // broken into that many chunks.
@@ -64,11 +68,12 @@ int main(int argc, char* argv[])
     int numCompiles = 0;
     ShHandle vertexCompiler = 0;
     ShHandle fragmentCompiler = 0;
-    char* buffer = 0;
-    int bufferLen = 0;
     int numAttribs = 0, numUniforms = 0;
     ShShaderSpec spec = SH_GLES2_SPEC;
     ShShaderOutput output = SH_ESSL_OUTPUT;
+    std::vector<const char*> specializedUniforms;
+    int benchmarkIterations = 0;
+    int maxMemory = 0, maxCompileTime = 0;
 
     ShInitialize();
 
@@ -88,6 +93,49 @@ int main(int argc, char* argv[])
             case 'e': compileOptions |= SH_EMULATE_BUILT_IN_FUNCTIONS; break;
             case 'd': compileOptions |= SH_DEPENDENCY_GRAPH; break;
             case 't': compileOptions |= SH_TIMING_RESTRICTIONS; break;
+            case 'r': compileOptions |= SH_REMOVE_DEAD_CODE; break;
+            case 'c': compileOptions |= SH_ELIMINATE_COMMON_SUBEXPRESSIONS; break;
+            case 'n': compileOptions |= SH_INLINE_FUNCTIONS; break;
+            case 'v': compileOptions |= SH_VECTORIZE_SCALAR_OPERATIONS; break;
+            case 'h': compileOptions |= SH_HOIST_LOOP_INVARIANTS; break;
+            case 'j': compileOptions |= SH_PARALLEL_TRANSLATION; break;
+            case 'a': compileOptions |= SH_ATTRIBUTES_UNIFORMS | SH_STATIC_USE_ATTRIBUTES_UNIFORMS; break;
+            case 'k': compileOptions |= SH_REMOVE_UNUSED_ATTRIBUTES_UNIFORMS; break;
+            case 'y': compileOptions |= SH_ATTRIBUTES_UNIFORMS | SH_PACK_UNIFORMS; break;
+            case 'z': compileOptions |= SH_ATTRIBUTES_UNIFORMS | SH_PACK_UNIFORMS_TIGHTLY; break;
+            case 'p':
+                if (argv[0][2] == '=' && strchr(argv[0] + 3, '=') != NULL) {
+                    compileOptions |= SH_SPECIALIZE_UNIFORMS;
+                    specializedUniforms.push_back(argv[0] + 3);
+                } else {
+                    failCode = EFailUsage;
+                }
+                break;
+            case 'q':
+                if (argv[0][2] == '=' && atoi(argv[0] + 3) > 0)
+                    benchmarkIterations = atoi(argv[0] + 3);
+                else
+                    failCode = EFailUsage;
+                break;
+            case 'w':
+                if (argv[0][2] == '=' && strchr(argv[0] + 3, ',') != NULL) {
+                    maxMemory = atoi(argv[0] + 3);
+                    maxCompileTime = atoi(strchr(argv[0] + 3, ',') + 1);
+                } else {
+                    failCode = EFailUsage;
+                }
+                break;
+            case 'g':
+                if (argv[0][2] == '=') {
+                    switch (argv[0][3]) {
+                        case 'j': compileOptions |= SH_DEPENDENCY_GRAPH_JSON; break;
+                        case 'd': compileOptions |= SH_DEPENDENCY_GRAPH_DOT; break;
+                        default: failCode = EFailUsage;
+                    }
+                } else {
+                    failCode = EFailUsage;
+                }
+                break;
             case 's':
                 if (argv[0][2] == '=') {
                     switch (argv[0][3]) {
@@ -107,6 +155,8 @@ int main(int argc, char* argv[])
                     case 'g': output = SH_GLSL_OUTPUT; break;
                     case 'h': output = SH_HLSL_OUTPUT; break;
                     case 'j': output = SH_JS_OUTPUT; break;
+                    case 'x': output = SH_JS_EXECUTABLE_OUTPUT; break;
+                    case 'b': output = SH_JS_BINARY_OUTPUT; break;
                     default: failCode = EFailUsage;
                     }
                 } else {
@@ -145,22 +195,25 @@ int main(int argc, char* argv[])
             default: break;
             }
             if (compiler) {
+              ShSetCompileBudget(compiler, maxMemory, maxCompileTime);
+              for (size_t i = 0; i < specializedUniforms.size(); ++i) {
+                  if (!SpecializeUniform(compiler, specializedUniforms[i]))
+                      failCode = EFailUsage;
+              }
               bool compiled = CompileFile(argv[0], compiler, compileOptions);
 
               LogMsg("BEGIN", "COMPILER", numCompiles, "INFO LOG");
-              ShGetInfo(compiler, SH_INFO_LOG_LENGTH, &bufferLen);
-              buffer = (char*) realloc(buffer, bufferLen * sizeof(char));
-              ShGetInfoLog(compiler, buffer);
-              puts(buffer);
+              puts(ShGetInfoLogPointer(compiler, NULL));
               LogMsg("END", "COMPILER", numCompiles, "INFO LOG");
               printf("\n\n");
 
               if (compiled && (compileOptions & SH_OBJECT_CODE)) {
                   LogMsg("BEGIN", "COMPILER", numCompiles, "OBJ CODE");
-                  ShGetInfo(compiler, SH_OBJECT_CODE_LENGTH, &bufferLen);
-                  buffer = (char*) realloc(buffer, bufferLen * sizeof(char));
-                  ShGetObjectCode(compiler, buffer);
-                  puts(buffer);
+                  int objCodeLength = 0;
+                  const char* objCode = ShGetObjectCodePointer(compiler, &objCodeLength);
+                  // Binary object code may contain null characters.
+                  fwrite(objCode, 1, objCodeLength, stdout);
+                  putchar('\n');
                   LogMsg("END", "COMPILER", numCompiles, "OBJ CODE");
                   printf("\n\n");
               }
@@ -174,6 +227,28 @@ int main(int argc, char* argv[])
                   PrintActiveVariables(compiler, SH_ACTIVE_UNIFORMS, (compileOptions & SH_MAP_LONG_VARIABLE_NAMES) != 0);
                   LogMsg("END", "COMPILER", numCompiles, "ACTIVE UNIFORMS");
                   printf("\n\n");
+
+                  LogMsg("BEGIN", "COMPILER", numCompiles, "ACTIVE VARYINGS");
+                  PrintActiveVariables(compiler, SH_ACTIVE_VARYINGS, (compileOptions & SH_MAP_LONG_VARIABLE_NAMES) != 0);
+                  LogMsg("END", "COMPILER", numCompiles, "ACTIVE VARYINGS");
+                  printf("\n\n");
+              }
+              if (compileOptions & (SH_DEPENDENCY_GRAPH_JSON | SH_DEPENDENCY_GRAPH_DOT)) {
+                  LogMsg("BEGIN", "COMPILER", numCompiles, "DEPENDENCY GRAPH");
+                  int graphLength = 0;
+                  ShGetInfo(compiler, SH_DEPENDENCY_GRAPH_LENGTH, &graphLength);
+                  char* graph = new char[graphLength];
+                  ShGetDependencyGraph(compiler, graph);
+                  fputs(graph, stdout);
+                  delete [] graph;
+                  LogMsg("END", "COMPILER", numCompiles, "DEPENDENCY GRAPH");
+                  printf("\n\n");
+              }
+              if (compiled && benchmarkIterations > 0) {
+                  LogMsg("BEGIN", "COMPILER", numCompiles, "POOL STATISTICS");
+                  BenchmarkFile(argv[0], compiler, compileOptions, benchmarkIterations);
+                  LogMsg("END", "COMPILER", numCompiles, "POOL STATISTICS");
+                  printf("\n\n");
               }
               if (!compiled)
                   failCode = EFailCompile;
@@ -193,8 +268,6 @@ int main(int argc, char* argv[])
         ShDestruct(vertexCompiler);
     if (fragmentCompiler)
         ShDestruct(fragmentCompiler);
-    if (buffer)
-        free(buffer);
     ShFinalize();
 
     return failCode;
@@ -205,7 +278,7 @@ int main(int argc, char* argv[])
 //
 void usage()
 {
-    printf("Usage: translate [-i -m -o -u -l -e -b=e -b=g -b=h -x=i -x=d] file1 file2 ...\n"
+    printf("Usage: translate [-i -m -o -u -l -e -r -c -n -v -h -j -a -k -y -z -p=name=value -q=n -w=m,t -g=j -g=d -b=e -b=g -b=h -b=j -b=x -b=b -x=i -x=d] file1 file2 ...\n"
         "Where: filename : filename ending in .frag or .vert\n"
         "       -i       : print intermediate tree\n"
         "       -m       : map long variable names\n"
@@ -215,12 +288,30 @@ void usage()
         "       -e       : emulate certain built-in functions (workaround for driver bugs)\n"
         "       -t       : enforce experimental timing restrictions\n"
         "       -d       : print dependency graph used to enforce timing restrictions\n"
+        "       -r       : remove dead code before translation\n"
+        "       -c       : eliminate common subexpressions\n"
+        "       -n       : inline small functions\n"
+        "       -v       : vectorize scalar operations on vector components\n"
+        "       -h       : hoist loop invariants out of for-loops\n"
+        "       -j       : translate functions on several threads\n"
+        "       -a       : print only the attribs and uniforms main() uses (implies -u)\n"
+        "       -k       : remove the attribs and uniforms main() does not use\n"
+        "       -y       : print the registers of packed uniforms (implies -u)\n"
+        "       -z       : print the registers of tightly packed uniforms (implies -u)\n"
+        "       -p=u=v,v : specialize the shader on the value of uniform u\n"
+        "       -q=n     : compile n more times and print pool statistics and timings\n"
+        "       -w=m,t   : limit each compile to m bytes of memory and t ms (0: no limit)\n"
+        "       -g=j     : print the whole dependency graph in JSON\n"
+        "       -g=d     : print the whole dependency graph in the DOT language\n"
         "       -s=e     : use GLES2 spec (this is by default)\n"
         "       -s=w     : use WebGL spec\n"
         "       -s=c     : use CSS Shaders spec\n"
         "       -b=e     : output GLSL ES code (this is by default)\n"
         "       -b=g     : output GLSL code\n"
         "       -b=h     : output HLSL code\n"
+        "       -b=j     : output JavaScript intermediate tree\n"
+        "       -b=x     : output executable JavaScript\n"
+        "       -b=b     : output binary JavaScript intermediate tree\n"
         "       -x=i     : enable GL_OES_EGL_image_external\n"
         "       -x=d     : enable GL_OES_EGL_standard_derivatives\n"
         "       -x=r     : enable ARB_texture_rectangle\n");
@@ -266,6 +357,33 @@ bool CompileFile(char* fileName, ShHandle compiler, int compileOptions)
     return ret ? true : false;
 }
 
+//
+//   Compile the file again the given number of times, and print the pool
+//   allocator statistics of the last compile and the average timings.
+//
+void BenchmarkFile(char* fileName, ShHandle compiler, int compileOptions, int iterations)
+{
+    ShaderSource source;
+    if (!ReadShaderSource(fileName, source))
+        return;
+
+    clock_t start = clock();
+    for (int i = 0; i < iterations; ++i)
+        ShCompile(compiler, &source[0], source.size(), compileOptions);
+    double seconds = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+    FreeShaderSource(source);
+
+    int peakSize = 0;
+    int allocationCount = 0;
+    ShGetInfo(compiler, SH_POOL_PEAK_SIZE, &peakSize);
+    ShGetInfo(compiler, SH_POOL_ALLOCATION_COUNT, &allocationCount);
+    printf("peak pool size: %d bytes\n", peakSize);
+    printf("pool allocations: %d\n", allocationCount);
+    printf("compile time: %.3f ms\n", seconds * 1000.0 / iterations);
+    if (seconds > 0.0)
+        printf("allocation rate: %.0f per second\n", allocationCount * iterations / seconds);
+}
+
 void LogMsg(const char* msg, const char* name, const int num, const char* logName)
 {
     printf("#### %s %s %d %s ####\n", msg, name, num, logName);
@@ -281,6 +399,9 @@ void PrintActiveVariables(ShHandle compiler, ShShaderInfo varType, bool mapLongV
         case SH_ACTIVE_UNIFORMS:
             ShGetInfo(compiler, SH_ACTIVE_UNIFORM_MAX_LENGTH, &nameSize);
             break;
+        case SH_ACTIVE_VARYINGS:
+            ShGetInfo(compiler, SH_ACTIVE_VARYING_MAX_LENGTH, &nameSize);
+            break;
         default: assert(0);
     }
     if (nameSize <= 1) return;
@@ -305,6 +426,9 @@ void PrintActiveVariables(ShHandle compiler, ShShaderInfo varType, bool mapLongV
             case SH_ACTIVE_UNIFORMS:
                 ShGetActiveUniform(compiler, i, NULL, &size, &type, name, mappedName);
                 break;
+            case SH_ACTIVE_VARYINGS:
+                ShGetActiveVarying(compiler, i, NULL, &size, &type, name, mappedName);
+                break;
             default: assert(0);
         }
         switch (type) {
@@ -331,6 +455,12 @@ void PrintActiveVariables(ShHandle compiler, ShShaderInfo varType, bool mapLongV
         printf("%d: name:%s type:%s size:%d", i, name, typeName, size);
         if (mapLongVariableNames)
             printf(" mapped name:%s", mappedName);
+        if (varType == SH_ACTIVE_UNIFORMS) {
+            int registerIndex = -1, component = 0, arrayStride = 0;
+            ShGetUniformRegister(compiler, i, &registerIndex, &component, &arrayStride);
+            if (registerIndex >= 0)
+                printf(" register:%d component:%d stride:%d", registerIndex, component, arrayStride);
+        }
         printf("\n");
     }
     delete [] name;
@@ -375,3 +505,26 @@ static void FreeShaderSource(ShaderSource& source) {
     source.clear();
 }
 
+//
+//   Gives a uniform, in the form "name=value,value,...", a constant value.
+//
+static bool SpecializeUniform(ShHandle compiler, const char* assignment)
+{
+    const char* equal = strchr(assignment, '=');
+    if (!equal)
+        return false;
+    std::string name(assignment, equal);
+
+    std::vector<float> values;
+    const char* value = equal + 1;
+    while (*value) {
+        char* end = NULL;
+        values.push_back(static_cast<float>(strtod(value, &end)));
+        if (end == value)
+            return false;
+        value = *end == ',' ? end + 1 : end;
+    }
+    ShSpecializeUniformfv(compiler, name.c_str(), values.size(),
+                          values.empty() ? NULL : &values[0]);
+    return true;
+}
@@ -70,6 +70,8 @@
         'compiler/Diagnostics.cpp',
         'compiler/DirectiveHandler.h',
         'compiler/DirectiveHandler.cpp',
+        'compiler/EliminateCommonSubexpressions.cpp',
+        'compiler/EliminateCommonSubexpressions.h',
         'compiler/ExtensionBehavior.h',
         'compiler/ForLoopUnroll.cpp',
         'compiler/ForLoopUnroll.h',
@@ -77,6 +79,10 @@
         'compiler/glslang_lex.cpp',
         'compiler/glslang_tab.cpp',
         'compiler/glslang_tab.h',
+        'compiler/HeapProfile.cpp',
+        'compiler/HeapProfile.h',
+        'compiler/HoistLoopInvariants.cpp',
+        'compiler/HoistLoopInvariants.h',
         'compiler/InfoSink.cpp',
         'compiler/InfoSink.h',
         'compiler/Initialize.cpp',
@@ -86,9 +92,13 @@
         'compiler/InitializeGlobals.h',
         'compiler/InitializeParseContext.cpp',
         'compiler/InitializeParseContext.h',
+        'compiler/InlineFunctions.cpp',
+        'compiler/InlineFunctions.h',
         'compiler/Intermediate.cpp',
         'compiler/intermediate.h',
         'compiler/intermOut.cpp',
+        'compiler/IntermUtil.cpp',
+        'compiler/IntermUtil.h',
         'compiler/IntermTraverse.cpp',
         'compiler/localintermediate.h',
         'compiler/MapLongVariableNames.cpp',
@@ -102,10 +112,16 @@
         'compiler/PoolAlloc.h',
         'compiler/QualifierAlive.cpp',
         'compiler/QualifierAlive.h',
+        'compiler/RemoveDeadCode.cpp',
+        'compiler/RemoveDeadCode.h',
         'compiler/RemoveTree.cpp',
         'compiler/RemoveTree.h',
         'compiler/RenameFunction.h',
         'compiler/ShHandle.h',
+        'compiler/SpecializeUniforms.cpp',
+        'compiler/SpecializeUniforms.h',
+        'compiler/StaticUse.cpp',
+        'compiler/StaticUse.h',
         'compiler/SymbolTable.cpp',
         'compiler/SymbolTable.h',
         'compiler/Types.h',
@@ -115,6 +131,8 @@
         'compiler/ValidateLimitations.h',
         'compiler/VariableInfo.cpp',
         'compiler/VariableInfo.h',
+        'compiler/VectorizeScalarOperations.cpp',
+        'compiler/VectorizeScalarOperations.h',
         # Old preprocessor
         'compiler/preprocessor/atom.c',
         'compiler/preprocessor/atom.h',
@@ -184,6 +202,29 @@
         'compiler/VersionGLSL.h',
       ],
     },
+    {
+      'target_name': 'translator_cpu',
+      'type': 'static_library',
+      'dependencies': ['translator_common'],
+      'include_dirs': [
+        '.',
+        '../include',
+      ],
+      'sources': [
+        'compiler/cpu/CpuBindings.cpp',
+        'compiler/cpu/CpuBindings.h',
+        'compiler/cpu/CpuBytecode.cpp',
+        'compiler/cpu/CpuBytecode.h',
+        'compiler/cpu/CpuExecutor.cpp',
+        'compiler/cpu/CpuExecutor.h',
+        'compiler/cpu/CpuProgram.cpp',
+        'compiler/cpu/CpuProgram.h',
+        'compiler/cpu/CpuVirtualMachine.cpp',
+        'compiler/cpu/CpuVirtualMachine.h',
+        'compiler/cpu/TranslatorCPU.cpp',
+        'compiler/cpu/TranslatorCPU.h',
+      ],
+    },
   ],
   'conditions': [
     ['OS=="win"', {
@@ -7,6 +7,8 @@
 #include "compiler/TranslatorGLSL.h"
 #include "compiler/TranslatorESSL.h"
 #include "compiler/TranslatorJS.h"
+#include "compiler/TranslatorJSBinary.h"
+#include "compiler/TranslatorJSExecutable.h"
 
 //
 // This function must be provided to create the actual
@@ -23,6 +25,10 @@ TCompiler* ConstructCompiler(
         return new TranslatorESSL(type, spec);
       case SH_JS_OUTPUT:
         return new TranslatorJS(type, spec);
+      case SH_JS_EXECUTABLE_OUTPUT:
+        return new TranslatorJSExecutable(type, spec);
+      case SH_JS_BINARY_OUTPUT:
+        return new TranslatorJSBinary(type, spec);
       default:
         return NULL;
     }
@@ -6,25 +6,39 @@
 
 #include "compiler/BuiltInFunctionEmulator.h"
 #include "compiler/DetectRecursion.h"
+#include "compiler/EliminateCommonSubexpressions.h"
 #include "compiler/ForLoopUnroll.h"
+#include "compiler/HeapProfile.h"
+#include "compiler/HoistLoopInvariants.h"
 #include "compiler/Initialize.h"
 #include "compiler/InitializeParseContext.h"
+#include "compiler/InlineFunctions.h"
 #include "compiler/MapLongVariableNames.h"
 #include "compiler/ParseHelper.h"
+#include "compiler/RemoveDeadCode.h"
 #include "compiler/RenameFunction.h"
 #include "compiler/ShHandle.h"
+#include "compiler/SpecializeUniforms.h"
+#include "compiler/StaticUse.h"
 #include "compiler/ValidateLimitations.h"
+#include "compiler/VectorizeScalarOperations.h"
 #include "compiler/depgraph/DependencyGraph.h"
 #include "compiler/depgraph/DependencyGraphOutput.h"
+#include "compiler/osinclude.h"
 #include "compiler/timing/RestrictFragmentShaderTiming.h"
 #include "compiler/timing/RestrictVertexShaderTiming.h"
 
+#include <string.h>
+
 bool isWebGLBasedSpec(ShShaderSpec spec)
 {
      return spec == SH_WEBGL_SPEC || spec == SH_CSS_SHADERS_SPEC;
 }
 
 namespace {
+// Number of threads translating a shader with SH_PARALLEL_TRANSLATION.
+const int kTranslationThreads = 4;
+
 bool InitializeSymbolTable(
     const TBuiltInStrings& builtInStrings,
     ShShaderType type, ShShaderSpec spec, const ShBuiltInResources& resources,
@@ -35,7 +49,8 @@ bool InitializeSymbolTable(
     InitExtensionBehavior(resources, extBehavior);
     // The builtins deliberately don't specify precisions for the function
     // arguments and return types. For that reason we don't try to check them.
-    TParseContext parseContext(symbolTable, extBehavior, intermediate, type, spec, 0, false, NULL, infoSink);
+    TParseResources parseResources(extBehavior, infoSink);
+    TParseContext parseContext(symbolTable, intermediate, type, spec, 0, false, NULL, parseResources);
 
     GlobalParseContext = &parseContext;
 
@@ -100,15 +115,19 @@ TShHandleBase::~TShHandleBase() {
 TCompiler::TCompiler(ShShaderType type, ShShaderSpec spec)
     : shaderType(type),
       shaderSpec(spec),
-      builtInFunctionEmulator(type)
+      builtInFunctionEmulator(type),
+      parseResources(new TParseResources(extensionBehavior, infoSink)),
+      builtInUsage(0),
+      uniformRegisterCount(0),
+      maxMemory(0),
+      maxCompileTime(0),
+      translationThreadCount(1)
 {
-    longNameMap = LongNameMap::GetInstance();
 }
 
 TCompiler::~TCompiler()
 {
-    ASSERT(longNameMap);
-    longNameMap->Release();
+    delete parseResources;
 }
 
 bool TCompiler::Init(const ShBuiltInResources& resources)
@@ -127,6 +146,18 @@ bool TCompiler::compile(const char* const shaderStrings[],
                         const int numStrings,
                         int compileOptions)
 {
+    // The time is measured on a clock shared by all threads, so that the
+    // compiles running at the same time do not count against each other.
+    double deadline = 0;
+    if (maxCompileTime > 0)
+        deadline = OS_GetTimeMs() + maxCompileTime;
+
+    allocator.resetStatistics();
+    allocator.setBudget(maxMemory, deadline);
+#ifdef ANGLE_HEAP_PROFILE
+    ResetHeapProfile();
+#endif
+    HEAP_PROFILE_PHASE(EHeapPhaseParse);
     TScopedPoolAllocator scopedAlloc(&allocator, true);
     clearResults();
 
@@ -137,6 +168,27 @@ bool TCompiler::compile(const char* const shaderStrings[],
     if (isWebGLBasedSpec(shaderSpec))
         compileOptions |= SH_VALIDATE_LOOP_INDEXING;
 
+    // Specialized uniforms turn conditions into constants, which leaves
+    // branches that are never taken to remove.
+    if (compileOptions & SH_SPECIALIZE_UNIFORMS)
+        compileOptions |= SH_REMOVE_DEAD_CODE;
+
+    // The functions that are never called may reference the variables that
+    // are no longer declared.
+    if (compileOptions & SH_REMOVE_UNUSED_ATTRIBUTES_UNIFORMS)
+        compileOptions |= SH_REMOVE_DEAD_CODE;
+    if (compileOptions & SH_PACK_UNIFORMS_TIGHTLY)
+        compileOptions |= SH_PACK_UNIFORMS;
+    if (compileOptions & (SH_STATIC_USE_ATTRIBUTES_UNIFORMS | SH_PACK_UNIFORMS))
+        compileOptions |= SH_ATTRIBUTES_UNIFORMS;
+
+    translationThreadCount =
+        (compileOptions & SH_PARALLEL_TRANSLATION) ? kTranslationThreads : 1;
+#ifdef ANGLE_HEAP_PROFILE
+    // The heap profile counts the allocations of a single thread.
+    translationThreadCount = 1;
+#endif
+
     // First string is path of source file if flag is set. The actual source follows.
     const char* sourcePath = NULL;
     int firstSource = 0;
@@ -147,9 +199,9 @@ bool TCompiler::compile(const char* const shaderStrings[],
     }
 
     TIntermediate intermediate(infoSink);
-    TParseContext parseContext(symbolTable, extensionBehavior, intermediate,
+    TParseContext parseContext(symbolTable, intermediate,
                                shaderType, shaderSpec, compileOptions, true,
-                               sourcePath, infoSink);
+                               sourcePath, *parseResources);
     GlobalParseContext = &parseContext;
 
     // We preserve symbols at the built-in level from compile-to-compile.
@@ -162,19 +214,70 @@ bool TCompiler::compile(const char* const shaderStrings[],
     bool success =
         (PaParseStrings(numStrings - firstSource, &shaderStrings[firstSource], NULL, &parseContext) == 0) &&
         (parseContext.treeRoot != NULL);
+    // The parse ends early once the compile is over its budget.
+    success = checkBudget() && success;
     if (success) {
         TIntermNode* root = parseContext.treeRoot;
-        success = intermediate.postProcess(root);
+        HEAP_PROFILE_PHASE(EHeapPhaseValidate);
+        success = intermediate.postProcess(root) && checkBudget();
 
         if (success)
             success = detectRecursion(root);
 
+        TLoopStack validatedLoops;
         if (success && (compileOptions & SH_VALIDATE_LOOP_INDEXING))
-            success = validateLimitations(root);
+            success = validateLimitations(root, &validatedLoops);
+
+        // The graph is exported even if the shader fails the timing restrictions.
+        if (success && (compileOptions & (SH_DEPENDENCY_GRAPH_JSON | SH_DEPENDENCY_GRAPH_DOT)))
+            exportDependencyGraph(root, (compileOptions & SH_DEPENDENCY_GRAPH_JSON) != 0);
 
         if (success && (compileOptions & SH_TIMING_RESTRICTIONS))
             success = enforceTimingRestrictions(root, (compileOptions & SH_DEPENDENCY_GRAPH) != 0);
 
+        HEAP_PROFILE_PHASE(EHeapPhaseTransform);
+
+        // Uniform specialization needs to happen before inlining and dead
+        // code removal, so that they see the folded constants.
+        if (success && (compileOptions & SH_SPECIALIZE_UNIFORMS))
+            SpecializeUniforms(root, specializedUniforms, infoSink);
+
+        // Inlining needs to happen after detectRecursion pass, and before
+        // dead code removal so that the inlined functions can be removed.
+        if (success && (compileOptions & SH_INLINE_FUNCTIONS))
+            InlineFunctions(root, symbolTable);
+
+        // Specialization and inlining may grow the tree, which the passes
+        // below traverse, possibly several times.
+        success = success && checkBudget();
+
+        // Dead code removal needs to happen after detectRecursion pass, and
+        // before built-in function emulation so that only the functions used
+        // in live code get emulated.
+        if (success && (compileOptions & SH_REMOVE_DEAD_CODE))
+            RemoveDeadCode(root);
+
+        // Unused attributes and uniforms are removed after dead code, which
+        // may be all that references them.
+        if (success && (compileOptions & SH_REMOVE_UNUSED_ATTRIBUTES_UNIFORMS))
+            removeUnusedAttribsUniforms(root);
+
+        // Vectorization needs to happen before common subexpression
+        // elimination, which moves the component operations to temporary
+        // variables.
+        if (success && (compileOptions & SH_VECTORIZE_SCALAR_OPERATIONS))
+            VectorizeScalarOperations(root);
+
+        // Loop-invariant code motion needs to happen after validateLimitations
+        // pass, which finds the loops that can be analyzed.
+        if (success && (compileOptions & SH_HOIST_LOOP_INVARIANTS))
+            HoistLoopInvariants(root, validatedLoops, symbolTable);
+
+        if (success && (compileOptions & SH_ELIMINATE_COMMON_SUBEXPRESSIONS))
+            EliminateCommonSubexpressions(root, symbolTable);
+
+        success = success && checkBudget();
+
         if (success && shaderSpec == SH_CSS_SHADERS_SPEC)
             rewriteCSSShader(root);
 
@@ -186,6 +289,8 @@ bool TCompiler::compile(const char* const shaderStrings[],
         if (success && (compileOptions & SH_EMULATE_BUILT_IN_FUNCTIONS))
             builtInFunctionEmulator.MarkBuiltInFunctionsForEmulation(root);
 
+        HEAP_PROFILE_PHASE(EHeapPhaseCollect);
+
         // Call mapLongVariableNames() before collectAttribsUniforms() so in
         // collectAttribsUniforms() we already have the mapped symbol names and
         // we could composite mapped and original variable names.
@@ -193,15 +298,40 @@ bool TCompiler::compile(const char* const shaderStrings[],
             mapLongVariableNames(root);
 
         if (success && (compileOptions & SH_ATTRIBUTES_UNIFORMS))
-            collectAttribsUniforms(root);
+            collectAttribsUniforms(root, (compileOptions & SH_STATIC_USE_ATTRIBUTES_UNIFORMS) != 0);
+
+        if (success && (compileOptions & SH_PACK_UNIFORMS)) {
+            HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemVariables);
+            uniformRegisterCount = PackUniforms(uniforms, (compileOptions & SH_PACK_UNIFORMS_TIGHTLY) != 0);
+        }
+
+        HEAP_PROFILE_PHASE(EHeapPhaseTranslate);
 
         if (success && (compileOptions & SH_INTERMEDIATE_TREE))
             intermediate.outputTree(root);
 
-        if (success && (compileOptions & SH_OBJECT_CODE))
+        if (success && (compileOptions & SH_OBJECT_CODE)) {
+            // The object code is usually somewhat longer than the source.
+            // Reserving room for it saves growing the sink step by step.
+            size_t sourceLength = 0;
+            for (int i = firstSource; i < numStrings; ++i)
+                sourceLength += strlen(shaderStrings[i]);
+            infoSink.obj.reserve(2 * sourceLength);
             translate(root);
+
+            // Unrolled loops stop being written once over budget, which
+            // leaves the object code incomplete.
+            success = checkBudget();
+            if (!success)
+                infoSink.obj.erase();
+        }
     }
 
+    HEAP_PROFILE_PHASE(EHeapPhaseOther);
+#ifdef ANGLE_HEAP_PROFILE
+    WriteHeapProfile(infoSink.info);
+#endif
+
     // Cleanup memory.
     intermediate.remove(parseContext.treeRoot);
     // Ensure symbol table is returned to the built-in level,
@@ -209,6 +339,7 @@ bool TCompiler::compile(const char* const shaderStrings[],
     while (!symbolTable.atBuiltInLevel())
         symbolTable.pop();
 
+    allocator.setBudget(0, 0);
     return success;
 }
 
@@ -229,10 +360,33 @@ void TCompiler::clearResults()
 
     attribs.clear();
     uniforms.clear();
+    varyings.clear();
+    builtInUsage = 0;
+    uniformRegisterCount = 0;
+    dependencyGraph.erase();
 
     builtInFunctionEmulator.Cleanup();
 }
 
+void TCompiler::setBudget(int maxMemory, int maxCompileTime)
+{
+    this->maxMemory = maxMemory > 0 ? maxMemory : 0;
+    this->maxCompileTime = maxCompileTime > 0 ? maxCompileTime : 0;
+}
+
+bool TCompiler::checkBudget()
+{
+    if (allocator.isOverSizeBudget()) {
+        infoSink.info.message(EPrefixError, "Compile exceeded its memory budget");
+        return false;
+    }
+    if (allocator.isOverTimeBudget()) {
+        infoSink.info.message(EPrefixError, "Compile exceeded its time budget");
+        return false;
+    }
+    return true;
+}
+
 bool TCompiler::detectRecursion(TIntermNode* root)
 {
     DetectRecursion detect;
@@ -258,12 +412,23 @@ void TCompiler::rewriteCSSShader(TIntermNode* root)
     root->traverse(&renamer);
 }
 
-bool TCompiler::validateLimitations(TIntermNode* root) {
+bool TCompiler::validateLimitations(TIntermNode* root, TLoopStack* validatedLoops) {
     ValidateLimitations validate(shaderType, infoSink.info);
     root->traverse(&validate);
+    *validatedLoops = validate.validatedLoops();
     return validate.numErrors() == 0;
 }
 
+void TCompiler::exportDependencyGraph(TIntermNode* root, bool json)
+{
+    TDependencyGraph graph(root);
+    TDependencyGraphOutput output(dependencyGraph);
+    if (json)
+        output.outputJSON(graph);
+    else
+        output.outputDot(graph);
+}
+
 bool TCompiler::enforceTimingRestrictions(TIntermNode* root, bool outputGraph)
 {
     if (shaderSpec != SH_WEBGL_SPEC) {
@@ -304,16 +469,28 @@ bool TCompiler::enforceVertexShaderTimingRestrictions(TIntermNode* root)
     return restrictor.numErrors() == 0;
 }
 
-void TCompiler::collectAttribsUniforms(TIntermNode* root)
+void TCompiler::collectAttribsUniforms(TIntermNode* root, bool staticUseOnly)
 {
-    CollectAttribsUniforms collect(attribs, uniforms);
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemVariables);
+    TSymbolIdSet used;
+    if (staticUseOnly)
+        FindStaticallyUsedVariables(root, &used);
+    CollectAttribsUniforms collect(attribs, uniforms, staticUseOnly ? &used : NULL);
     root->traverse(&collect);
+    CollectVaryings collectVaryings(varyings, builtInUsage);
+    root->traverse(&collectVaryings);
+}
+
+void TCompiler::removeUnusedAttribsUniforms(TIntermNode* root)
+{
+    TSymbolIdSet used;
+    FindStaticallyUsedVariables(root, &used);
+    RemoveUnusedDeclarations(root, used);
 }
 
 void TCompiler::mapLongVariableNames(TIntermNode* root)
 {
-    ASSERT(longNameMap);
-    MapLongVariableNames map(longNameMap);
+    MapLongVariableNames map;
     root->traverse(&map);
 }
 
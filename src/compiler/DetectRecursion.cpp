@@ -8,7 +8,8 @@
 
 DetectRecursion::FunctionNode::FunctionNode(const TString& fname)
     : name(fname),
-      visit(PreVisit)
+      visit(PreVisit),
+      reachable(false)
 {
 }
 
@@ -53,6 +54,20 @@ bool DetectRecursion::FunctionNode::detectRecursion()
     return false;
 }
 
+void DetectRecursion::FunctionNode::markReachable()
+{
+    if (reachable)
+        return;
+    reachable = true;
+    for (size_t i = 0; i < callees.size(); ++i)
+        callees[i]->markReachable();
+}
+
+bool DetectRecursion::FunctionNode::isReachable() const
+{
+    return reachable;
+}
+
 DetectRecursion::DetectRecursion()
     : currentFunction(NULL)
 {
@@ -113,6 +128,16 @@ DetectRecursion::ErrorCode DetectRecursion::detectRecursion()
     return kErrorNone;
 }
 
+bool DetectRecursion::isReachableFromMain(const TString& name)
+{
+    FunctionNode* main = findFunctionByName("main(");
+    if (main == NULL)
+        return false;
+    main->markReachable();
+    FunctionNode* func = findFunctionByName(name);
+    return func != NULL && func->isReachable();
+}
+
 DetectRecursion::FunctionNode* DetectRecursion::findFunctionByName(
     const TString& name)
 {
@@ -28,6 +28,10 @@ public:
 
     ErrorCode detectRecursion();
 
+    // Return true if the function with the given mangled name can be
+    // called, directly or indirectly, from main().
+    bool isReachableFromMain(const TString& name);
+
 private:
     class FunctionNode {
     public:
@@ -41,6 +45,10 @@ private:
         // Return true if recursive function calls are detected.
         bool detectRecursion();
 
+        // Mark this function and all its callees as reachable.
+        void markReachable();
+        bool isReachable() const;
+
     private:
         // mangled function name is unique.
         TString name;
@@ -49,6 +57,7 @@ private:
         TVector<FunctionNode*> callees;
 
         Visit visit;
+        bool reachable;
     };
 
     FunctionNode* findFunctionByName(const TString& name);
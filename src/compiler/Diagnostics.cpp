@@ -21,6 +21,12 @@ TDiagnostics::~TDiagnostics()
 {
 }
 
+void TDiagnostics::reset()
+{
+    mNumErrors = 0;
+    mNumWarnings = 0;
+}
+
 void TDiagnostics::writeInfo(Severity severity,
                              const pp::SourceLocation& loc,
                              const std::string& reason,
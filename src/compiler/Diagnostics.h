@@ -21,6 +21,8 @@ class TDiagnostics : public pp::Diagnostics
 
     int numErrors() const { return mNumErrors; }
     int numWarnings() const { return mNumWarnings; }
+    // Clears the counts of errors and warnings.
+    void reset();
 
     void writeInfo(Severity severity,
                    const pp::SourceLocation& loc,
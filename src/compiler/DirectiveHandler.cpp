@@ -36,6 +36,11 @@ TDirectiveHandler::~TDirectiveHandler()
 {
 }
 
+void TDirectiveHandler::reset()
+{
+    mPragma = TPragma();
+}
+
 void TDirectiveHandler::handleError(const pp::SourceLocation& loc,
                                     const std::string& msg)
 {
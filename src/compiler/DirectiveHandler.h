@@ -22,6 +22,8 @@ class TDirectiveHandler : public pp::DirectiveHandler
 
     const TPragma& pragma() const { return mPragma; }
     const TExtensionBehavior& extensionBehavior() const { return mExtensionBehavior; }
+    // Restores the default pragma.
+    void reset();
 
     virtual void handleError(const pp::SourceLocation& loc,
                              const std::string& msg);
@@ -0,0 +1,374 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/EliminateCommonSubexpressions.h"
+
+#include <string.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "compiler/IntermUtil.h"
+#include "compiler/SymbolTable.h"
+
+namespace {
+
+typedef std::set<int> VariableSet;
+typedef std::set<TIntermTyped*> NodeSet;
+
+// An expression evaluated one or more times in a block, while the
+// variables it reads are not written.
+struct Expression {
+    // Identifies structurally equal expressions.
+    TString key;
+    // Ids of the variables read by the expression.
+    VariableSet reads;
+    // Index of the statement where the expression is first evaluated.
+    size_t firstStatement;
+    TVector<TIntermTyped*> occurrences;
+};
+
+void AppendNumber(unsigned int number, TString* key)
+{
+    TStringStream stream;
+    stream << number << ",";
+    *key += stream.str();
+}
+
+void AppendType(const TType& type, TString* key)
+{
+    TType keyType(type);
+    *key += keyType.getMangledName();
+    AppendNumber(type.getPrecision(), key);
+}
+
+// Returns the variable written by an assignment to the given l-value.
+TIntermSymbol* GetAssignedVariable(TIntermTyped* node)
+{
+    while (TIntermBinary* binary = node->getAsBinaryNode())
+        node = binary->getLeft();
+    return node->getAsSymbolNode();
+}
+
+// Finds the expressions evaluated several times within a block.
+class BlockAnalysis {
+public:
+    BlockAnalysis(TIntermSequence& statements);
+
+    // Returns the largest expression evaluated at least twice, or NULL.
+    const Expression* getCommonSubexpression() const;
+
+private:
+    void analyzeStatement(TIntermNode* statement);
+    // Builds the key of the expression and collects the variables it reads.
+    // The subexpressions are recorded if recordable is true. Returns false
+    // if the expression has side effects.
+    bool analyzeExpression(TIntermTyped* node, bool recordable,
+                           TString* key, VariableSet* reads);
+    void record(TIntermTyped* node, const TString& key, const VariableSet& reads);
+    void invalidate(TIntermSymbol* variable);
+
+    size_t mStatement;
+    std::vector<Expression> mExpressions;
+    // Indices of the expressions whose value is still available.
+    std::map<TString, size_t> mAvailable;
+};
+
+BlockAnalysis::BlockAnalysis(TIntermSequence& statements)
+{
+    for (mStatement = 0; mStatement < statements.size(); ++mStatement)
+        analyzeStatement(statements[mStatement]);
+}
+
+const Expression* BlockAnalysis::getCommonSubexpression() const
+{
+    const Expression* result = NULL;
+    for (size_t i = 0; i < mExpressions.size(); ++i) {
+        const Expression& expression = mExpressions[i];
+        if (expression.occurrences.size() < 2)
+            continue;
+        if (result == NULL || expression.key.size() > result->key.size())
+            result = &expression;
+    }
+    return result;
+}
+
+void BlockAnalysis::analyzeStatement(TIntermNode* statement)
+{
+    TString key;
+    VariableSet reads;
+
+    TIntermAggregate* aggregate = statement->getAsAggregate();
+    if (aggregate != NULL && aggregate->getOp() == EOpDeclaration) {
+        if (HasSideEffects(aggregate)) {
+            invalidate(NULL);
+            return;
+        }
+        // The initializers of the other variables may read the first one,
+        // so only the first initializer is searched.
+        TIntermBinary* initialize = aggregate->getSequence().front()->getAsBinaryNode();
+        if (initialize != NULL)
+            analyzeExpression(initialize->getRight(), true, &key, &reads);
+        return;
+    }
+
+    TIntermTyped* expression = statement->getAsTyped();
+    TIntermSelection* selection = statement->getAsSelectionNode();
+    if (expression == NULL || (aggregate != NULL && aggregate->getOp() == EOpSequence) ||
+        (selection != NULL && !selection->usesTernaryOperator())) {
+        // Control flow.
+        invalidate(NULL);
+        return;
+    }
+
+    TIntermBinary* binary = statement->getAsBinaryNode();
+    TIntermUnary* unary = statement->getAsUnaryNode();
+    if (binary != NULL && binary->modifiesState()) {
+        // The assigned value is evaluated before the assignment.
+        if (HasSideEffects(binary->getLeft()) ||
+            !analyzeExpression(binary->getRight(), true, &key, &reads)) {
+            invalidate(NULL);
+            return;
+        }
+        invalidate(GetAssignedVariable(binary->getLeft()));
+    } else if (unary != NULL && unary->modifiesState()) {
+        if (HasSideEffects(unary->getOperand())) {
+            invalidate(NULL);
+            return;
+        }
+        invalidate(GetAssignedVariable(unary->getOperand()));
+    } else if (!analyzeExpression(expression, true, &key, &reads)) {
+        invalidate(NULL);
+    }
+}
+
+bool BlockAnalysis::analyzeExpression(TIntermTyped* node, bool recordable,
+                                      TString* key, VariableSet* reads)
+{
+    TString nodeKey;
+    VariableSet nodeReads;
+
+    if (TIntermSymbol* symbol = node->getAsSymbolNode()) {
+        *key += "s";
+        AppendNumber(symbol->getId(), key);
+        reads->insert(symbol->getId());
+        return true;
+    }
+
+    if (TIntermConstantUnion* constant = node->getAsConstantUnion()) {
+        *key += "c";
+        AppendType(constant->getType(), key);
+        const ConstantUnion* values = constant->getUnionArrayPointer();
+        for (int i = 0; i < constant->getType().getObjectSize(); ++i) {
+            unsigned int bits = 0;
+            switch (values[i].getType()) {
+                case EbtFloat: {
+                    float value = values[i].getFConst();
+                    memcpy(&bits, &value, sizeof(bits));
+                    break;
+                }
+                case EbtInt: bits = values[i].getIConst(); break;
+                case EbtBool: bits = values[i].getBConst(); break;
+                default: break;
+            }
+            AppendNumber(bits, key);
+        }
+        return true;
+    }
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        if (binary->modifiesState())
+            return false;
+        TOperator op = binary->getOp();
+        // The right operand of a logical operator is not always evaluated,
+        // and the selectors of fields or elements are kept in place.
+        bool recordRight = recordable &&
+            op != EOpLogicalAnd && op != EOpLogicalOr &&
+            op != EOpIndexDirect && op != EOpIndexIndirect &&
+            op != EOpIndexDirectStruct && op != EOpVectorSwizzle;
+        nodeKey += "b";
+        AppendNumber(op, &nodeKey);
+        AppendType(binary->getType(), &nodeKey);
+        if (!analyzeExpression(binary->getLeft(), recordable, &nodeKey, &nodeReads))
+            return false;
+        if (op == EOpIndexDirectStruct) {
+            // The selector of a field holds a single index, but has the type
+            // of the field.
+            AppendNumber(binary->getRight()->getAsConstantUnion()->
+                             getUnionArrayPointer()->getIConst(), &nodeKey);
+        } else if (!analyzeExpression(binary->getRight(), recordRight, &nodeKey, &nodeReads)) {
+            return false;
+        }
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        if (unary->modifiesState())
+            return false;
+        nodeKey += "u";
+        AppendNumber(unary->getOp(), &nodeKey);
+        AppendType(unary->getType(), &nodeKey);
+        if (!analyzeExpression(unary->getOperand(), recordable, &nodeKey, &nodeReads))
+            return false;
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        if (aggregate->getOp() == EOpFunctionCall && aggregate->isUserDefined())
+            return false;
+        nodeKey += "a";
+        AppendNumber(aggregate->getOp(), &nodeKey);
+        AppendType(aggregate->getType(), &nodeKey);
+        if (aggregate->getOp() == EOpFunctionCall)
+            nodeKey += aggregate->getName();
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermTyped* argument = sequence[i]->getAsTyped();
+            if (argument == NULL ||
+                !analyzeExpression(argument, recordable, &nodeKey, &nodeReads))
+                return false;
+        }
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        if (!selection->usesTernaryOperator())
+            return false;
+        // Only one of the operands is evaluated, and the condition cannot
+        // be replaced.
+        nodeKey += "t";
+        AppendType(selection->getType(), &nodeKey);
+        TIntermTyped* operands[] = {
+            selection->getCondition()->getAsTyped(),
+            selection->getTrueBlock()->getAsTyped(),
+            selection->getFalseBlock()->getAsTyped()
+        };
+        for (size_t i = 0; i < 3; ++i) {
+            if (operands[i] == NULL ||
+                !analyzeExpression(operands[i], false, &nodeKey, &nodeReads))
+                return false;
+        }
+    } else {
+        return false;
+    }
+
+    nodeKey += ";";
+    if (recordable && IsWorthStoring(node))
+        record(node, nodeKey, nodeReads);
+    *key += nodeKey;
+    reads->insert(nodeReads.begin(), nodeReads.end());
+    return true;
+}
+
+void BlockAnalysis::record(TIntermTyped* node, const TString& key,
+                           const VariableSet& reads)
+{
+    std::map<TString, size_t>::iterator iter = mAvailable.find(key);
+    if (iter != mAvailable.end()) {
+        mExpressions[iter->second].occurrences.push_back(node);
+        return;
+    }
+
+    Expression expression;
+    expression.key = key;
+    expression.reads = reads;
+    expression.firstStatement = mStatement;
+    expression.occurrences.push_back(node);
+    mAvailable[key] = mExpressions.size();
+    mExpressions.push_back(expression);
+}
+
+// Forgets the values of the expressions that read the variable, or of all
+// expressions if the variable is not known.
+void BlockAnalysis::invalidate(TIntermSymbol* variable)
+{
+    std::map<TString, size_t>::iterator iter = mAvailable.begin();
+    while (iter != mAvailable.end()) {
+        const VariableSet& reads = mExpressions[iter->second].reads;
+        if (variable == NULL || reads.find(variable->getId()) != reads.end())
+            mAvailable.erase(iter++);
+        else
+            ++iter;
+    }
+}
+
+// Replaces the given nodes of an expression tree with a reference to the
+// temporary variable.
+TIntermTyped* ReplaceOccurrences(TIntermTyped* node, const NodeSet& occurrences,
+                                 TIntermSymbol* temporary)
+{
+    if (occurrences.find(node) != occurrences.end()) {
+        TIntermSymbol* symbol = new TIntermSymbol(
+            temporary->getId(), temporary->getSymbol(), temporary->getType());
+        symbol->setLine(node->getLine());
+        return symbol;
+    }
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        binary->setLeft(ReplaceOccurrences(binary->getLeft(), occurrences, temporary));
+        binary->setRight(ReplaceOccurrences(binary->getRight(), occurrences, temporary));
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        unary->setOperand(ReplaceOccurrences(unary->getOperand(), occurrences, temporary));
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            if (TIntermTyped* child = sequence[i]->getAsTyped())
+                sequence[i] = ReplaceOccurrences(child, occurrences, temporary);
+        }
+    }
+    return node;
+}
+
+void HoistExpression(TIntermSequence& statements, const Expression& expression,
+                     TSymbolTable& symbolTable)
+{
+    TIntermTyped* first = expression.occurrences.front();
+    TIntermSymbol* temporary = CreateTemporarySymbol(
+        symbolTable.nextUniqueId(), "webgl_cse", first->getType(), first->getLine(), first);
+
+    NodeSet occurrences(expression.occurrences.begin(), expression.occurrences.end());
+    for (size_t i = expression.firstStatement; i < statements.size(); ++i) {
+        if (TIntermTyped* statement = statements[i]->getAsTyped())
+            statements[i] = ReplaceOccurrences(statement, occurrences, temporary);
+    }
+
+    statements.insert(statements.begin() + expression.firstStatement,
+                      CreateTemporaryDeclaration(temporary, first));
+}
+
+class CommonSubexpressionEliminator : public TIntermTraverser {
+public:
+    CommonSubexpressionEliminator(TSymbolTable& symbolTable)
+        : mSymbolTable(symbolTable)
+    {
+    }
+
+    // Expressions contain no blocks, but the fields selected by a swizzle
+    // are held in a sequence node.
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return false;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        // The initializers of global variables are constant expressions.
+        if (node->getOp() != EOpSequence || depth == 0)
+            return true;
+
+        TIntermSequence& statements = node->getSequence();
+        while (true) {
+            BlockAnalysis analysis(statements);
+            const Expression* expression = analysis.getCommonSubexpression();
+            if (expression == NULL)
+                break;
+            HoistExpression(statements, *expression, mSymbolTable);
+        }
+        return true;
+    }
+
+private:
+    TSymbolTable& mSymbolTable;
+};
+
+}  // namespace
+
+void EliminateCommonSubexpressions(TIntermNode* root, TSymbolTable& symbolTable)
+{
+    CommonSubexpressionEliminator eliminator(symbolTable);
+    root->traverse(&eliminator);
+}
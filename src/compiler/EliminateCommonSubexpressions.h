@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_ELIMINATE_COMMON_SUBEXPRESSIONS_H_
+#define COMPILER_ELIMINATE_COMMON_SUBEXPRESSIONS_H_
+
+class TIntermNode;
+class TSymbolTable;
+
+// Evaluates the side-effect free expressions that are computed several
+// times within a block only once. Structurally equal subtrees that read
+// variables not written in between are replaced with a temporary variable,
+// declared before the statement where the expression first occurs.
+// The symbol table provides the ids of the temporary variables.
+void EliminateCommonSubexpressions(TIntermNode* root, TSymbolTable& symbolTable);
+
+#endif  // COMPILER_ELIMINATE_COMMON_SUBEXPRESSIONS_H_
@@ -37,6 +37,28 @@ public:
 
 };
 
+bool SatisfiesCondition(const TLoopIndexInfo& info)
+{
+    // Relational operator is one of: > >= < <= == or !=.
+    switch (info.op) {
+      case EOpEqual:
+        return (info.currentValue == info.stopValue);
+      case EOpNotEqual:
+        return (info.currentValue != info.stopValue);
+      case EOpLessThan:
+        return (info.currentValue < info.stopValue);
+      case EOpGreaterThan:
+        return (info.currentValue > info.stopValue);
+      case EOpLessThanEqual:
+        return (info.currentValue <= info.stopValue);
+      case EOpGreaterThanEqual:
+        return (info.currentValue >= info.stopValue);
+      default:
+        UNREACHABLE();
+    }
+    return false;
+}
+
 }  // anonymous namepsace
 
 void ForLoopUnroll::FillLoopIndexInfo(TIntermLoop* node, TLoopIndexInfo& info)
@@ -88,25 +110,20 @@ void ForLoopUnroll::Step()
 bool ForLoopUnroll::SatisfiesLoopCondition()
 {
     ASSERT(mLoopIndexStack.size() > 0);
-    TLoopIndexInfo& info = mLoopIndexStack[mLoopIndexStack.size() - 1];
-    // Relational operator is one of: > >= < <= == or !=.
-    switch (info.op) {
-      case EOpEqual:
-        return (info.currentValue == info.stopValue);
-      case EOpNotEqual:
-        return (info.currentValue != info.stopValue);
-      case EOpLessThan:
-        return (info.currentValue < info.stopValue);
-      case EOpGreaterThan:
-        return (info.currentValue > info.stopValue);
-      case EOpLessThanEqual:
-        return (info.currentValue <= info.stopValue);
-      case EOpGreaterThanEqual:
-        return (info.currentValue >= info.stopValue);
-      default:
-        UNREACHABLE();
+    return SatisfiesCondition(mLoopIndexStack[mLoopIndexStack.size() - 1]);
+}
+
+// static
+int ForLoopUnroll::CountIterations(const TLoopIndexInfo& info, int limit)
+{
+    TLoopIndexInfo current = info;
+    current.currentValue = info.initValue;
+    int count = 0;
+    while (count <= limit && SatisfiesCondition(current)) {
+        current.currentValue += current.incrementValue;
+        ++count;
     }
-    return false;
+    return count;
 }
 
 bool ForLoopUnroll::NeedsToReplaceSymbolWithValue(TIntermSymbol* symbol)
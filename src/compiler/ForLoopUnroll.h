@@ -27,6 +27,10 @@ public:
     // Return false if loop condition is no longer satisfied.
     bool SatisfiesLoopCondition();
 
+    // Return the number of iterations of a loop, or limit + 1 if the loop
+    // runs more than limit iterations.
+    static int CountIterations(const TLoopIndexInfo& info, int limit);
+
     // Check if the symbol is the index of a loop that's unrolled.
     bool NeedsToReplaceSymbolWithValue(TIntermSymbol* symbol);
 
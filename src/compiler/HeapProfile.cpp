@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/HeapProfile.h"
+
+#ifdef ANGLE_HEAP_PROFILE
+
+#include <stdlib.h>
+#include <new>
+
+#include "compiler/InfoSink.h"
+
+namespace {
+
+// Allocations of one phase and subsystem.
+struct HeapCounts {
+    int allocations;
+    size_t bytes;
+    long liveBytes;      // heap bytes allocated and not freed yet
+    long peakLiveBytes;  // liveBytes when the heap was at its peak
+};
+
+HeapCounts gCounts[EHeapPhaseCount][EHeapSubsystemCount];
+long gLiveBytes = 0;
+long gPeakLiveBytes = 0;
+THeapPhase gPhase = EHeapPhaseOther;
+THeapSubsystem gSubsystem = EHeapSubsystemOther;
+
+const char* const kPhaseNames[EHeapPhaseCount] = {
+    "other", "parse", "validate", "transform", "collect", "translate"
+};
+const char* const kSubsystemNames[EHeapSubsystemCount] = {
+    "other", "pool", "preprocessor", "info sink", "variables", "symbol table"
+};
+
+// Each heap allocation is preceded by a header, which records its size and
+// the counts it is attributed to. The header is as large as the alignment
+// of malloc, so that the allocation stays aligned.
+struct AllocationHeader {
+    size_t size;
+    HeapCounts* counts;
+};
+const size_t kHeaderSize = 16;
+
+void* allocate(size_t size)
+{
+    unsigned char* memory = static_cast<unsigned char*>(malloc(size + kHeaderSize));
+    if (memory == 0)
+        abort();
+
+    HeapCounts* counts = &gCounts[gPhase][gSubsystem];
+    // The pool pages are not allocations of the pool users.
+    if (gSubsystem != EHeapSubsystemPool) {
+        ++counts->allocations;
+        counts->bytes += size;
+    }
+    counts->liveBytes += size;
+    gLiveBytes += size;
+    if (gLiveBytes > gPeakLiveBytes) {
+        gPeakLiveBytes = gLiveBytes;
+        for (int i = 0; i < EHeapPhaseCount; ++i) {
+            for (int j = 0; j < EHeapSubsystemCount; ++j)
+                gCounts[i][j].peakLiveBytes = gCounts[i][j].liveBytes;
+        }
+    }
+
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(memory);
+    header->size = size;
+    header->counts = counts;
+    return memory + kHeaderSize;
+}
+
+void deallocate(void* memory)
+{
+    if (memory == 0)
+        return;
+
+    unsigned char* block = static_cast<unsigned char*>(memory) - kHeaderSize;
+    AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block);
+    header->counts->liveBytes -= header->size;
+    gLiveBytes -= header->size;
+    free(block);
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) throw() { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) throw() { return allocate(size); }
+void operator delete(void* memory) throw() { deallocate(memory); }
+void operator delete[](void* memory) throw() { deallocate(memory); }
+void operator delete(void* memory, const std::nothrow_t&) throw() { deallocate(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) throw() { deallocate(memory); }
+
+void SetHeapPhase(THeapPhase phase)
+{
+    gPhase = phase;
+}
+
+void RecordPoolAllocation(size_t numBytes)
+{
+    HeapCounts& counts = gCounts[gPhase][EHeapSubsystemPool];
+    ++counts.allocations;
+    counts.bytes += numBytes;
+}
+
+void ResetHeapProfile()
+{
+    for (int i = 0; i < EHeapPhaseCount; ++i) {
+        for (int j = 0; j < EHeapSubsystemCount; ++j) {
+            gCounts[i][j].allocations = 0;
+            gCounts[i][j].bytes = 0;
+            gCounts[i][j].peakLiveBytes = gCounts[i][j].liveBytes;
+        }
+    }
+    gPeakLiveBytes = gLiveBytes;
+}
+
+void WriteHeapProfile(TInfoSinkBase& sink)
+{
+    // Copy the counts, which writing to the sink changes.
+    HeapCounts counts[EHeapPhaseCount][EHeapSubsystemCount];
+    for (int i = 0; i < EHeapPhaseCount; ++i) {
+        for (int j = 0; j < EHeapSubsystemCount; ++j)
+            counts[i][j] = gCounts[i][j];
+    }
+    long peakLiveBytes = gPeakLiveBytes;
+
+    sink << "Heap profile: " << peakLiveBytes << " bytes in use at the peak\n";
+    for (int i = 0; i < EHeapPhaseCount; ++i) {
+        for (int j = 0; j < EHeapSubsystemCount; ++j) {
+            const HeapCounts& c = counts[i][j];
+            if (c.allocations == 0 && c.peakLiveBytes == 0)
+                continue;
+            sink << "  " << kPhaseNames[i] << ", " << kSubsystemNames[j] << ": "
+                 << c.allocations << " allocations of " << static_cast<unsigned long>(c.bytes)
+                 << " bytes, " << c.peakLiveBytes << " bytes in use at the peak\n";
+        }
+    }
+}
+
+TScopedHeapSubsystem::TScopedHeapSubsystem(THeapSubsystem subsystem)
+    : mPrevious(gSubsystem)
+{
+    gSubsystem = subsystem;
+}
+
+TScopedHeapSubsystem::~TScopedHeapSubsystem()
+{
+    gSubsystem = mPrevious;
+}
+
+#endif  // ANGLE_HEAP_PROFILE
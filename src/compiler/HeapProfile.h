@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_HEAP_PROFILE_H_
+#define COMPILER_HEAP_PROFILE_H_
+
+//
+// Define ANGLE_HEAP_PROFILE to build the heap profile mode. In that mode,
+// every allocation from the pool allocators, and from the heap through
+// operator new, is attributed to the phase of the compile in progress and
+// to the subsystem allocating it. Each compile appends a summary of its
+// allocations to the info log.
+//
+// The counts are not synchronized, so SH_PARALLEL_TRANSLATION is ignored,
+// and the process must not run compiles on several threads at once.
+//
+
+#include <stddef.h>
+
+class TInfoSinkBase;
+
+enum THeapPhase {
+    EHeapPhaseOther,      // outside of a compile, or cleaning up after it
+    EHeapPhaseParse,      // preprocessing and parsing
+    EHeapPhaseValidate,   // checks of the tree
+    EHeapPhaseTransform,  // optimizations and rewriting of the tree
+    EHeapPhaseCollect,    // attributes, uniforms, varyings and their names
+    EHeapPhaseTranslate,  // output of the tree or the object code
+    EHeapPhaseCount
+};
+
+enum THeapSubsystem {
+    EHeapSubsystemOther,
+    EHeapSubsystemPool,          // pool allocations, and the pages they use
+    EHeapSubsystemPreprocessor,  // tokens, macros and input of pp::Preprocessor
+    EHeapSubsystemInfoSink,      // info log and object code
+    EHeapSubsystemVariables,     // lists of attributes, uniforms and varyings
+    EHeapSubsystemSymbolTable,   // levels and default precisions of TSymbolTable
+    EHeapSubsystemCount
+};
+
+#ifdef ANGLE_HEAP_PROFILE
+
+void SetHeapPhase(THeapPhase phase);
+// Counts an allocation from a pool allocator. The pages of the pools are
+// counted as heap memory of EHeapSubsystemPool.
+void RecordPoolAllocation(size_t numBytes);
+// Restarts the counts, and the peak, from the memory in use.
+void ResetHeapProfile();
+// Writes the allocations and the memory in use at the peak, by phase and
+// subsystem, since the last call to ResetHeapProfile().
+void WriteHeapProfile(TInfoSinkBase& sink);
+
+// Attributes the heap allocations to the subsystem during its lifetime.
+class TScopedHeapSubsystem {
+public:
+    TScopedHeapSubsystem(THeapSubsystem subsystem);
+    ~TScopedHeapSubsystem();
+
+private:
+    THeapSubsystem mPrevious;
+};
+
+#define HEAP_PROFILE_PHASE(phase) SetHeapPhase(phase)
+#define HEAP_PROFILE_SUBSYSTEM(subsystem) TScopedHeapSubsystem scopedHeapSubsystem(subsystem)
+
+#else  // ANGLE_HEAP_PROFILE
+
+#define HEAP_PROFILE_PHASE(phase) ((void)0)
+#define HEAP_PROFILE_SUBSYSTEM(subsystem) ((void)0)
+
+#endif  // ANGLE_HEAP_PROFILE
+
+#endif  // COMPILER_HEAP_PROFILE_H_
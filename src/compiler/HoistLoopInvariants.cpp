@@ -0,0 +1,385 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/HoistLoopInvariants.h"
+
+#include <set>
+#include <vector>
+
+#include "compiler/IntermUtil.h"
+#include "compiler/SymbolTable.h"
+
+namespace {
+
+typedef std::set<int> IdSet;
+
+// Returns the variable written by an assignment to the given l-value.
+TIntermSymbol* GetAssignedVariable(TIntermTyped* node)
+{
+    while (TIntermBinary* binary = node->getAsBinaryNode())
+        node = binary->getLeft();
+    return node->getAsSymbolNode();
+}
+
+// Returns true if the right operand of the operator selects a part of the
+// left one.
+bool IsSelector(TOperator op)
+{
+    switch (op) {
+        case EOpIndexDirect:
+        case EOpIndexIndirect:
+        case EOpIndexDirectStruct:
+        case EOpVectorSwizzle:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Collects the variables that a loop declares or may write.
+class LoopWriteCollector : public TIntermTraverser {
+public:
+    LoopWriteCollector() : mHasUserDefinedCalls(false) {}
+
+    IdSet& written() { return mWritten; }
+    // User-defined functions may write global and output variables.
+    bool hasUserDefinedCalls() const { return mHasUserDefinedCalls; }
+
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        if (node->modifiesState() || node->getOp() == EOpInitialize)
+            write(node->getLeft());
+        return true;
+    }
+
+    virtual bool visitUnary(Visit visit, TIntermUnary* node)
+    {
+        if (node->modifiesState())
+            write(node->getOperand());
+        return true;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        TIntermSequence& sequence = node->getSequence();
+        switch (node->getOp()) {
+            case EOpDeclaration:
+                for (size_t i = 0; i < sequence.size(); ++i)
+                    write(sequence[i]->getAsTyped());
+                break;
+            case EOpFunctionCall:
+                if (node->isUserDefined()) {
+                    mHasUserDefinedCalls = true;
+                    // Any argument may be passed to an out parameter.
+                    for (size_t i = 0; i < sequence.size(); ++i)
+                        write(sequence[i]->getAsTyped());
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+private:
+    void write(TIntermTyped* node)
+    {
+        TIntermSymbol* variable = GetAssignedVariable(node);
+        if (variable != NULL)
+            mWritten.insert(variable->getId());
+    }
+
+    IdSet mWritten;
+    bool mHasUserDefinedCalls;
+};
+
+class LoopInvariantHoister : public TIntermTraverser {
+public:
+    LoopInvariantHoister(const TLoopStack& loops, TSymbolTable& symbolTable)
+        : mSymbolTable(symbolTable),
+          mWritten(NULL),
+          mHasUserDefinedCalls(false),
+          mHoisted(NULL)
+    {
+        for (TLoopStack::const_iterator i = loops.begin(); i != loops.end(); ++i)
+            mLoops.insert(i->loop);
+    }
+
+    // Expressions contain no blocks, but the fields selected by a swizzle
+    // are held in a sequence node.
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return false;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() != EOpSequence)
+            return true;
+
+        TIntermSequence& statements = node->getSequence();
+        for (size_t i = 0; i < statements.size(); ++i) {
+            TIntermLoop* loop = statements[i]->getAsLoopNode();
+            if (loop == NULL || mLoops.find(loop) == mLoops.end()) {
+                statements[i]->traverse(this);
+                continue;
+            }
+
+            // Inner loops are processed first, so that the computations
+            // moved out of them can be moved further.
+            if (loop->getBody() != NULL)
+                loop->getBody()->traverse(this);
+
+            TIntermSequence hoisted;
+            hoistInvariants(loop, &hoisted);
+            statements.insert(statements.begin() + i, hoisted.begin(), hoisted.end());
+            i += hoisted.size();
+        }
+        return false;
+    }
+
+private:
+    void hoistInvariants(TIntermLoop* loop, TIntermSequence* hoisted);
+    void processStatement(TIntermNode* node);
+    bool processExpression(TIntermTyped* node, bool hoistable = true);
+    TIntermTyped* hoistParts(TIntermTyped* node);
+    TIntermSymbol* findHoisted(TIntermTyped* node);
+    bool isHoistedDeclaration(TIntermNode* statement, TIntermBinary** initialize);
+
+    TSymbolTable& mSymbolTable;
+    std::set<TIntermLoop*> mLoops;
+    // Temporary variables declared by this pass.
+    IdSet mTemporaries;
+
+    // State of the loop being processed.
+    IdSet* mWritten;
+    bool mHasUserDefinedCalls;
+    TIntermSequence* mHoisted;
+};
+
+void LoopInvariantHoister::hoistInvariants(TIntermLoop* loop, TIntermSequence* hoisted)
+{
+    LoopWriteCollector collector;
+    loop->traverse(&collector);
+    mWritten = &collector.written();
+    mHasUserDefinedCalls = collector.hasUserDefinedCalls();
+    mHoisted = hoisted;
+
+    TIntermNode* body = loop->getBody();
+    TIntermAggregate* block = body != NULL ? body->getAsAggregate() : NULL;
+    if (block != NULL && block->getOp() == EOpSequence) {
+        TIntermSequence& statements = block->getSequence();
+        for (size_t i = 0; i < statements.size(); ) {
+            // The temporary variables that hold the invariants of an inner
+            // loop are moved along with their declarations.
+            TIntermBinary* initialize = NULL;
+            if (isHoistedDeclaration(statements[i], &initialize) &&
+                processExpression(initialize->getRight())) {
+                mWritten->erase(initialize->getLeft()->getAsSymbolNode()->getId());
+                hoisted->push_back(statements[i]);
+                statements.erase(statements.begin() + i);
+                continue;
+            }
+            processStatement(statements[i]);
+            ++i;
+        }
+        // An empty block is kept, as the loop body can not be NULL in
+        // every output.
+    } else if (body != NULL) {
+        processStatement(body);
+    }
+
+    mWritten = NULL;
+    mHoisted = NULL;
+}
+
+bool LoopInvariantHoister::isHoistedDeclaration(TIntermNode* statement,
+                                                TIntermBinary** initialize)
+{
+    TIntermAggregate* declaration = statement->getAsAggregate();
+    if (declaration == NULL || declaration->getOp() != EOpDeclaration ||
+        declaration->getSequence().size() != 1)
+        return false;
+
+    *initialize = declaration->getSequence().front()->getAsBinaryNode();
+    if (*initialize == NULL)
+        return false;
+    TIntermSymbol* variable = (*initialize)->getLeft()->getAsSymbolNode();
+    return variable != NULL && mTemporaries.find(variable->getId()) != mTemporaries.end();
+}
+
+void LoopInvariantHoister::processStatement(TIntermNode* node)
+{
+    if (node == NULL)
+        return;
+
+    if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        if (!selection->usesTernaryOperator()) {
+            TIntermTyped* condition = selection->getCondition()->getAsTyped();
+            if (processExpression(condition))
+                selection->setCondition(hoistParts(condition));
+            processStatement(selection->getTrueBlock());
+            processStatement(selection->getFalseBlock());
+            return;
+        }
+    }
+    if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        if (aggregate->getOp() == EOpSequence) {
+            TIntermSequence& statements = aggregate->getSequence();
+            for (size_t i = 0; i < statements.size(); ++i)
+                processStatement(statements[i]);
+            return;
+        }
+    }
+    if (TIntermLoop* loop = node->getAsLoopNode()) {
+        // The header of an inner loop depends on its index.
+        processStatement(loop->getBody());
+        return;
+    }
+    if (TIntermTyped* expression = node->getAsTyped())
+        processExpression(expression);
+}
+
+// Returns true if the value of the expression is the same in every
+// iteration. Otherwise the largest invariant subexpressions are replaced
+// with temporary variables, if the expression is hoistable.
+bool LoopInvariantHoister::processExpression(TIntermTyped* node, bool hoistable)
+{
+    if (TIntermSymbol* symbol = node->getAsSymbolNode()) {
+        if (mWritten->find(symbol->getId()) != mWritten->end())
+            return false;
+        return !IsWritableGlobal(symbol->getQualifier()) || !mHasUserDefinedCalls;
+    }
+
+    if (node->getAsConstantUnion() != NULL)
+        return true;
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        TOperator op = binary->getOp();
+        bool leftInvariant = processExpression(binary->getLeft(), hoistable);
+        // The fields selected from a structure or by a swizzle are constants.
+        // Array indices must remain constant index expressions, built from
+        // the loop indices, so they are kept in place.
+        bool selector = IsSelector(op);
+        bool rightInvariant = op == EOpIndexDirectStruct || op == EOpVectorSwizzle ||
+                              processExpression(binary->getRight(), hoistable && !selector);
+        if (leftInvariant && rightInvariant &&
+            !binary->modifiesState() && op != EOpInitialize)
+            return true;
+        if (hoistable && leftInvariant)
+            binary->setLeft(hoistParts(binary->getLeft()));
+        if (hoistable && rightInvariant && !selector)
+            binary->setRight(hoistParts(binary->getRight()));
+        return false;
+    }
+
+    if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        // An operand that is incremented or decremented is written in the
+        // loop, so it is never invariant.
+        return processExpression(unary->getOperand(), hoistable);
+    }
+
+    if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermSequence& sequence = aggregate->getSequence();
+        std::vector<bool> invariants(sequence.size(), false);
+        bool invariant = aggregate->getOp() != EOpDeclaration &&
+                         !(aggregate->getOp() == EOpFunctionCall && aggregate->isUserDefined());
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermTyped* child = sequence[i]->getAsTyped();
+            invariants[i] = child != NULL && processExpression(child, hoistable);
+            invariant = invariant && invariants[i];
+        }
+        if (invariant || !hoistable)
+            return invariant;
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            if (invariants[i])
+                sequence[i] = hoistParts(sequence[i]->getAsTyped());
+        }
+        return false;
+    }
+
+    if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        TIntermTyped* operands[] = {
+            selection->getCondition()->getAsTyped(),
+            selection->getTrueBlock()->getAsTyped(),
+            selection->getFalseBlock()->getAsTyped()
+        };
+        bool invariants[3];
+        for (int i = 0; i < 3; ++i)
+            invariants[i] = processExpression(operands[i], hoistable);
+        if (invariants[0] && invariants[1] && invariants[2])
+            return true;
+        if (!hoistable)
+            return false;
+        if (invariants[0])
+            selection->setCondition(hoistParts(operands[0]));
+        if (invariants[1])
+            selection->setTrueBlock(hoistParts(operands[1]));
+        if (invariants[2])
+            selection->setFalseBlock(hoistParts(operands[2]));
+        return false;
+    }
+
+    return false;
+}
+
+// Returns the expression that replaces an invariant expression in the
+// loop: a temporary variable initialized before the loop, or the same
+// expression with its invariant parts replaced.
+TIntermTyped* LoopInvariantHoister::hoistParts(TIntermTyped* node)
+{
+    if (IsWorthStoring(node)) {
+        // Identical invariants share a temporary variable.
+        if (TIntermSymbol* temporary = findHoisted(node))
+            return CopyExpression(temporary);
+
+        TIntermSymbol* temporary = CreateTemporarySymbol(
+            mSymbolTable.nextUniqueId(), "webgl_inv", node->getType(), node->getLine(), node);
+        mTemporaries.insert(temporary->getId());
+        mHoisted->push_back(CreateTemporaryDeclaration(temporary, node));
+        return CopyExpression(temporary);
+    }
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        binary->setLeft(hoistParts(binary->getLeft()));
+        if (!IsSelector(binary->getOp()))
+            binary->setRight(hoistParts(binary->getRight()));
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        unary->setOperand(hoistParts(unary->getOperand()));
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i)
+            sequence[i] = hoistParts(sequence[i]->getAsTyped());
+    }
+    return node;
+}
+
+// Returns the temporary variable that already holds the value of the
+// expression before the loop, or NULL.
+TIntermSymbol* LoopInvariantHoister::findHoisted(TIntermTyped* node)
+{
+    for (size_t i = 0; i < mHoisted->size(); ++i) {
+        TIntermBinary* initialize = NULL;
+        if (!isHoistedDeclaration((*mHoisted)[i], &initialize))
+            continue;
+        TIntermTyped* value = initialize->getRight();
+        if (value->getPrecision() == node->getPrecision() && IsSameExpression(value, node))
+            return initialize->getLeft()->getAsSymbolNode();
+    }
+    return NULL;
+}
+
+}  // namespace
+
+void HoistLoopInvariants(TIntermNode* root, const TLoopStack& loops,
+                         TSymbolTable& symbolTable)
+{
+    if (loops.empty())
+        return;
+
+    LoopInvariantHoister hoister(loops, symbolTable);
+    root->traverse(&hoister);
+}
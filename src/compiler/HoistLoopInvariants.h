@@ -0,0 +1,25 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_HOIST_LOOP_INVARIANTS_H_
+#define COMPILER_HOIST_LOOP_INVARIANTS_H_
+
+#include "compiler/ValidateLimitations.h"
+
+class TIntermNode;
+class TSymbolTable;
+
+// Moves the computations whose value is the same in every iteration of a
+// for-loop out of the loop. Side-effect free expressions of the loop body
+// that read neither the loop index nor any variable written in the loop
+// are evaluated once into a temporary variable declared before the loop.
+// Only the loops found by ValidateLimitations are considered, as their
+// index can only be modified by the loop header.
+// The symbol table provides the ids of the temporary variables.
+void HoistLoopInvariants(TIntermNode* root, const TLoopStack& loops,
+                         TSymbolTable& symbolTable);
+
+#endif  // COMPILER_HOIST_LOOP_INVARIANTS_H_
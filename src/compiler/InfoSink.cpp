@@ -6,7 +6,35 @@
 
 #include "compiler/InfoSink.h"
 
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/angleutils.h"
+
+namespace {
+
+// Large enough for the digits and the sign of any 64-bit integer.
+const size_t kIntegerBufferSize = 24;
+// Large enough for the fixed notation of the largest float, which has 39
+// digits before the decimal point.
+const size_t kFloatBufferSize = 64;
+
+// Writes the decimal digits of the number backwards from the end of the
+// buffer, and returns a pointer to the first digit.
+char* FormatDigits(unsigned long number, char* end)
+{
+    do {
+        *--end = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    return end;
+}
+
+}  // namespace
+
 void TInfoSinkBase::prefix(TPrefixType message) {
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
     switch(message) {
         case EPrefixNone:
             break;
@@ -32,23 +60,78 @@ void TInfoSinkBase::prefix(TPrefixType message) {
 }
 
 void TInfoSinkBase::location(TSourceLoc loc) {
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
     int string = 0, line = 0, index = 0;
     DecodeSourceLoc(loc, &string, &line, &index);
 
-    TPersistStringStream stream;
-    stream << index;
-    stream << ": ";
+    appendInteger(static_cast<long>(index));
+    sink.append(": ");
+}
 
-    sink.append(stream.str());
+void TInfoSinkBase::appendInteger(long i) {
+    char buffer[kIntegerBufferSize];
+    char* end = buffer + kIntegerBufferSize;
+    // The magnitude is computed with unsigned arithmetic, which also holds
+    // the magnitude of the smallest long.
+    unsigned long magnitude = static_cast<unsigned long>(i);
+    if (i < 0)
+        magnitude = 0UL - magnitude;
+    char* begin = FormatDigits(magnitude, end);
+    if (i < 0)
+        *--begin = '-';
+    sink.append(begin, end - begin);
+}
+
+void TInfoSinkBase::appendInteger(unsigned long i) {
+    char buffer[kIntegerBufferSize];
+    char* end = buffer + kIntegerBufferSize;
+    char* begin = FormatDigits(i, end);
+    sink.append(begin, end - begin);
+}
+
+void TInfoSinkBase::appendFloat(float f) {
+    // Make sure that at least one decimal point is written. If a number
+    // does not have a fractional part, the default precision format does
+    // not write the decimal portion which gets interpreted as integer by
+    // the compiler. The formats are the ones a string stream uses for the
+    // fixed notation with a precision of 1, and for the default notation
+    // with a precision of 8.
+    char buffer[kFloatBufferSize];
+    const char* format = fractionalPart(f) == 0.0f ? "%.1f" : "%.8g";
+    int length = snprintf(buffer, kFloatBufferSize, format, static_cast<double>(f));
+    if (length < 0 || length >= static_cast<int>(kFloatBufferSize)) {
+        // Not expected, but the stream formats any value.
+        TPersistStringStream stream;
+        stream.precision(8);
+        stream << f;
+        sink.append(stream.str());
+        return;
+    }
+
+    // Unlike string streams, the C library formats numbers for the current
+    // locale, which may use another decimal point.
+    const char* point = localeconv()->decimal_point;
+    if (point[0] != '.' || point[1] != '\0') {
+        char* found = strstr(buffer, point);
+        if (found != NULL) {
+            size_t pointLength = strlen(point);
+            *found = '.';
+            memmove(found + 1, found + pointLength, strlen(found + pointLength) + 1);
+            length -= static_cast<int>(pointLength - 1);
+        }
+    }
+    sink.append(buffer, length);
 }
 
 void TInfoSinkBase::message(TPrefixType message, const char* s) {
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
     prefix(message);
     sink.append(s);
     sink.append("\n");
 }
 
 void TInfoSinkBase::message(TPrefixType message, const char* s, TSourceLoc loc) {
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
     prefix(message);
     location(loc);
     sink.append(s);
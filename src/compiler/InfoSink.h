@@ -9,6 +9,7 @@
 
 #include <math.h>
 #include "compiler/Common.h"
+#include "compiler/HeapProfile.h"
 
 // Returns the fractional part of the given floating-point number.
 inline float fractionalPart(float f) {
@@ -41,6 +42,7 @@ public:
 
     template <typename T>
     TInfoSinkBase& operator<<(const T& t) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
         TPersistStringStream stream;
         stream << t;
         sink.append(stream.str());
@@ -49,49 +51,76 @@ public:
     // Override << operator for specific types. It is faster to append strings
     // and characters directly to the sink.
     TInfoSinkBase& operator<<(char c) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
         sink.append(1, c);
         return *this;
     }
     TInfoSinkBase& operator<<(const char* str) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
         sink.append(str);
         return *this;
     }
     TInfoSinkBase& operator<<(const TPersistString& str) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
         sink.append(str);
         return *this;
     }
     TInfoSinkBase& operator<<(const TString& str) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
         sink.append(str.c_str());
         return *this;
     }
+    // Integers are formatted in place rather than through a string stream,
+    // as the output backends write many of them.
+    TInfoSinkBase& operator<<(int i) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        appendInteger(static_cast<long>(i));
+        return *this;
+    }
+    TInfoSinkBase& operator<<(unsigned int i) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        appendInteger(static_cast<unsigned long>(i));
+        return *this;
+    }
+    TInfoSinkBase& operator<<(long i) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        appendInteger(i);
+        return *this;
+    }
+    TInfoSinkBase& operator<<(unsigned long i) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        appendInteger(i);
+        return *this;
+    }
     // Make sure floats are written with correct precision.
     TInfoSinkBase& operator<<(float f) {
-        // Make sure that at least one decimal point is written. If a number
-        // does not have a fractional part, the default precision format does
-        // not write the decimal portion which gets interpreted as integer by
-        // the compiler.
-        TPersistStringStream stream;
-        if (fractionalPart(f) == 0.0f) {
-            stream.precision(1);
-            stream << std::showpoint << std::fixed << f;
-        } else {
-            stream.unsetf(std::ios::fixed);
-            stream.unsetf(std::ios::scientific);
-            stream.precision(8);
-            stream << f;
-        }
-        sink.append(stream.str());
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        appendFloat(f);
         return *this;
     }
     // Write boolean values as their names instead of integral value.
     TInfoSinkBase& operator<<(bool b) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
         const char* str = b ? "true" : "false";
         sink.append(str);
         return *this;
     }
 
+    // Appends raw bytes, which may include null characters, for the
+    // backends whose object code is binary.
+    void append(const char* data, size_t length) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        sink.append(data, length);
+    }
+
     void erase() { sink.clear(); }
-    int size() { return static_cast<int>(sink.size()); }
+    int size() const { return static_cast<int>(sink.size()); }
+    // Avoids growing the sink repeatedly when the size of the output can
+    // be estimated.
+    void reserve(size_t capacity) {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemInfoSink);
+        sink.reserve(capacity);
+    }
 
     const TPersistString& str() const { return sink; }
     const char* c_str() const { return sink.c_str(); }
@@ -102,6 +131,10 @@ public:
     void message(TPrefixType message, const char* s, TSourceLoc loc);
 
 private:
+    void appendInteger(long i);
+    void appendInteger(unsigned long i);
+    void appendFloat(float f);
+
     TPersistString sink;
 };
 
@@ -0,0 +1,646 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/InlineFunctions.h"
+
+#include <map>
+#include <set>
+
+#include "compiler/IntermUtil.h"
+#include "compiler/SymbolTable.h"
+
+namespace {
+
+// Functions whose body has more nodes are not inlined.
+const int kMaxInlinedFunctionSize = 32;
+
+typedef std::set<int> IdSet;
+typedef std::set<TString> NameSet;
+
+// Returns the variable that an assignment to the l-value writes.
+TIntermSymbol* GetLValueVariable(TIntermTyped* node)
+{
+    while (TIntermBinary* binary = node->getAsBinaryNode())
+        node = binary->getLeft();
+    return node->getAsSymbolNode();
+}
+
+// Returns true if the l-value only selects fields, components or elements
+// at constant indices of a variable, so that it can be evaluated twice.
+bool IsSimpleLValue(TIntermTyped* node)
+{
+    while (TIntermBinary* binary = node->getAsBinaryNode()) {
+        switch (binary->getOp()) {
+            case EOpIndexDirect:
+            case EOpIndexDirectStruct:
+            case EOpVectorSwizzle:
+                break;
+            default:
+                return false;
+        }
+        node = binary->getLeft();
+    }
+    return node->getAsSymbolNode() != NULL;
+}
+
+TIntermSequence& GetParameters(TIntermAggregate* function)
+{
+    TIntermAggregate* parameters = function->getSequence()[0]->getAsAggregate();
+    ASSERT(parameters != NULL && parameters->getOp() == EOpParameters);
+    return parameters->getSequence();
+}
+
+// Returns the body of a function definition, which is NULL if empty.
+TIntermAggregate* GetBody(TIntermAggregate* function)
+{
+    TIntermSequence& sequence = function->getSequence();
+    return sequence.size() > 1 ? sequence[1]->getAsAggregate() : NULL;
+}
+
+// Collects the facts about a function body that decide whether the
+// function can be inlined, and how.
+class FunctionAnalysis : public TIntermTraverser {
+public:
+    FunctionAnalysis(TIntermAggregate* function)
+        : size(0),
+          returnCount(0),
+          hasUserDefinedCalls(false),
+          declaresStruct(false)
+    {
+        TIntermSequence& parameters = GetParameters(function);
+        for (size_t i = 0; i < parameters.size(); ++i)
+            declare(parameters[i]->getAsSymbolNode());
+        if (TIntermAggregate* body = GetBody(function))
+            body->traverse(this);
+    }
+
+    // Number of nodes in the body.
+    int size;
+    int returnCount;
+    bool hasUserDefinedCalls;
+    bool declaresStruct;
+    // Variables that the body may write.
+    IdSet written;
+    // Local variables and parameters.
+    IdSet declared;
+    TVector<TIntermSymbol*> locals;
+    // Names of the variables and functions that are not declared in the
+    // body. Declarations at the call site must not hide them.
+    NameSet externalNames;
+
+    virtual void visitSymbol(TIntermSymbol* node)
+    {
+        ++size;
+        references.push_back(node);
+    }
+
+    virtual void visitConstantUnion(TIntermConstantUnion* node)
+    {
+        ++size;
+    }
+
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        ++size;
+        if (node->modifiesState())
+            write(node->getLeft());
+        return true;
+    }
+
+    virtual bool visitUnary(Visit visit, TIntermUnary* node)
+    {
+        ++size;
+        if (node->modifiesState())
+            write(node->getOperand());
+        return true;
+    }
+
+    virtual bool visitSelection(Visit visit, TIntermSelection* node)
+    {
+        ++size;
+        return true;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        ++size;
+        TIntermSequence& sequence = node->getSequence();
+        switch (node->getOp()) {
+            case EOpDeclaration:
+                for (size_t i = 0; i < sequence.size(); ++i) {
+                    TIntermTyped* declarator = sequence[i]->getAsTyped();
+                    if (TIntermBinary* initialize = declarator->getAsBinaryNode())
+                        declarator = initialize->getLeft();
+                    TIntermSymbol* local = declarator->getAsSymbolNode();
+                    if (local->getBasicType() == EbtStruct)
+                        declaresStruct = true;
+                    declare(local);
+                    locals.push_back(local);
+                }
+                break;
+            case EOpFunctionCall:
+                if (node->isUserDefined()) {
+                    hasUserDefinedCalls = true;
+                    externalNames.insert(TFunction::unmangleName(node->getName()));
+                    // Any argument may be passed to an out parameter.
+                    for (size_t i = 0; i < sequence.size(); ++i)
+                        write(sequence[i]->getAsTyped());
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    virtual bool visitLoop(Visit visit, TIntermLoop* node)
+    {
+        ++size;
+        return true;
+    }
+
+    virtual bool visitBranch(Visit visit, TIntermBranch* node)
+    {
+        ++size;
+        if (node->getFlowOp() == EOpReturn)
+            ++returnCount;
+        return true;
+    }
+
+    // Completes the analysis once the whole body has been visited.
+    void finish()
+    {
+        for (size_t i = 0; i < references.size(); ++i) {
+            if (declared.find(references[i]->getId()) == declared.end())
+                externalNames.insert(references[i]->getSymbol());
+        }
+    }
+
+private:
+    void declare(TIntermSymbol* symbol)
+    {
+        declared.insert(symbol->getId());
+    }
+
+    void write(TIntermTyped* node)
+    {
+        TIntermSymbol* variable = GetLValueVariable(node);
+        if (variable != NULL)
+            written.insert(variable->getId());
+    }
+
+    TVector<TIntermSymbol*> references;
+};
+
+// Collects the names of the parameters and local variables of a function.
+class DeclaredNameCollector : public TIntermTraverser {
+public:
+    NameSet names;
+
+    virtual void visitSymbol(TIntermSymbol* node)
+    {
+        if (node->getQualifier() == EvqTemporary || node->getQualifier() == EvqIn ||
+            node->getQualifier() == EvqOut || node->getQualifier() == EvqInOut ||
+            node->getQualifier() == EvqConstReadOnly)
+            names.insert(node->getSymbol());
+    }
+};
+
+class FunctionInliner : public TIntermTraverser {
+public:
+    FunctionInliner(TIntermAggregate* root, TSymbolTable& symbolTable)
+        : mSymbolTable(symbolTable),
+          mCurrentFunction(NULL)
+    {
+        TIntermSequence& globals = root->getSequence();
+        for (size_t i = 0; i < globals.size(); ++i) {
+            TIntermAggregate* function = globals[i]->getAsAggregate();
+            if (function != NULL && function->getOp() == EOpFunction)
+                mFunctions[function->getName()] = function;
+        }
+    }
+
+    // Expressions contain no blocks, but the fields selected by a swizzle
+    // are held in a sequence node.
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return false;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() == EOpFunction) {
+            mCurrentFunction = node;
+            mCallerNames.clear();
+            DeclaredNameCollector collector;
+            node->traverse(&collector);
+            mCallerNames.swap(collector.names);
+        } else if (node->getOp() == EOpSequence && mCurrentFunction != NULL) {
+            TIntermSequence& statements = node->getSequence();
+            // The statements inserted in place of a call may contain other
+            // calls to inline.
+            for (size_t i = 0; i < statements.size(); ) {
+                if (!inlineInStatement(statements, i))
+                    ++i;
+            }
+        }
+        return true;
+    }
+
+private:
+    // What has been evaluated before a call.
+    struct EvaluationState {
+        EvaluationState() : sideEffects(false), readsGlobals(false) {}
+        bool sideEffects;
+        bool readsGlobals;
+        IdSet reads;
+    };
+
+    bool inlineInStatement(TIntermSequence& statements, size_t index);
+    TIntermAggregate* findCall(TIntermTyped* node, bool conditional, EvaluationState* state);
+    bool canInline(TIntermAggregate* call, const EvaluationState& state);
+    bool canSubstitute(TIntermTyped* argument, TIntermSymbol* parameter,
+                       const FunctionAnalysis& analysis);
+    void inlineCall(TIntermSequence& statements, size_t index, TIntermAggregate* call);
+    TIntermSymbol* createTemporary(const TType& type, TSourceLoc line,
+                                   TIntermTyped* initializer = NULL);
+
+    TSymbolTable& mSymbolTable;
+    std::map<TString, TIntermAggregate*> mFunctions;
+    TIntermAggregate* mCurrentFunction;
+    NameSet mCallerNames;
+};
+
+// Returns the expression of a statement that may contain calls to inline,
+// or NULL.
+TIntermTyped* GetStatementExpression(TIntermNode* statement)
+{
+    if (TIntermBranch* branch = statement->getAsBranchNode())
+        return branch->getFlowOp() == EOpReturn ? branch->getExpression() : NULL;
+
+    TIntermTyped* expression = statement->getAsTyped();
+    if (expression == NULL)
+        return NULL;
+
+    if (TIntermSelection* selection = statement->getAsSelectionNode()) {
+        // The condition of an if-statement is evaluated first.
+        return selection->usesTernaryOperator() ?
+            expression : selection->getCondition()->getAsTyped();
+    }
+
+    if (TIntermAggregate* aggregate = statement->getAsAggregate()) {
+        switch (aggregate->getOp()) {
+            case EOpDeclaration: {
+                // The initializers of the other variables may read the first
+                // variable, so only the first initializer is searched.
+                TIntermBinary* initialize =
+                    aggregate->getSequence().front()->getAsBinaryNode();
+                return initialize != NULL ? initialize->getRight() : NULL;
+            }
+            case EOpSequence:
+                return NULL;
+            default:
+                break;
+        }
+    }
+    return expression;
+}
+
+// Replaces a node of an expression tree.
+TIntermTyped* ReplaceNode(TIntermTyped* node, TIntermTyped* original,
+                          TIntermTyped* replacement)
+{
+    if (node == original)
+        return replacement;
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        binary->setLeft(ReplaceNode(binary->getLeft(), original, replacement));
+        binary->setRight(ReplaceNode(binary->getRight(), original, replacement));
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        unary->setOperand(ReplaceNode(unary->getOperand(), original, replacement));
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            if (TIntermTyped* child = sequence[i]->getAsTyped())
+                sequence[i] = ReplaceNode(child, original, replacement);
+        }
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        selection->setCondition(ReplaceNode(
+            selection->getCondition()->getAsTyped(), original, replacement));
+        if (selection->usesTernaryOperator()) {
+            selection->setTrueBlock(ReplaceNode(
+                selection->getTrueBlock()->getAsTyped(), original, replacement));
+            selection->setFalseBlock(ReplaceNode(
+                selection->getFalseBlock()->getAsTyped(), original, replacement));
+        }
+    }
+    return node;
+}
+
+bool FunctionInliner::inlineInStatement(TIntermSequence& statements, size_t index)
+{
+    TIntermTyped* expression = GetStatementExpression(statements[index]);
+    if (expression == NULL)
+        return false;
+
+    EvaluationState state;
+    TIntermAggregate* call = findCall(expression, false, &state);
+    if (call == NULL)
+        return false;
+
+    // A call to a void function has no value to replace it with, so it is
+    // only inlined when it is the whole statement, and not an operand of
+    // the comma operator.
+    if (call->getBasicType() == EbtVoid && statements[index] != call)
+        return false;
+
+    inlineCall(statements, index, call);
+    return true;
+}
+
+// Returns the first call in evaluation order that can be inlined. The code
+// of the called function is executed before the rest of the statement, so
+// nothing evaluated before the call may have side effects or read the
+// variables that the call writes.
+TIntermAggregate* FunctionInliner::findCall(TIntermTyped* node, bool conditional,
+                                            EvaluationState* state)
+{
+    TIntermAggregate* call = NULL;
+
+    if (TIntermSymbol* symbol = node->getAsSymbolNode()) {
+        state->reads.insert(symbol->getId());
+        if (IsWritableGlobal(symbol->getQualifier()))
+            state->readsGlobals = true;
+    } else if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        TOperator op = binary->getOp();
+        // The fields selected by a swizzle are not evaluated.
+        if (op == EOpVectorSwizzle)
+            return findCall(binary->getLeft(), conditional, state);
+        // The right operand of a logical operator is not always evaluated.
+        bool rightConditional = conditional ||
+            op == EOpLogicalAnd || op == EOpLogicalOr;
+        call = findCall(binary->getLeft(), conditional, state);
+        if (call == NULL)
+            call = findCall(binary->getRight(), rightConditional, state);
+        if (binary->modifiesState())
+            state->sideEffects = true;
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        call = findCall(unary->getOperand(), conditional, state);
+        if (unary->modifiesState())
+            state->sideEffects = true;
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        call = findCall(selection->getCondition()->getAsTyped(), conditional, state);
+        if (call == NULL) {
+            findCall(selection->getTrueBlock()->getAsTyped(), true, state);
+            findCall(selection->getFalseBlock()->getAsTyped(), true, state);
+        }
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        bool userDefined = aggregate->getOp() == EOpFunctionCall &&
+                           aggregate->isUserDefined();
+        // The arguments are evaluated before the inlined code in any case.
+        EvaluationState before = *state;
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size() && call == NULL; ++i) {
+            if (TIntermTyped* argument = sequence[i]->getAsTyped())
+                call = findCall(argument, conditional, state);
+        }
+        if (call == NULL && userDefined) {
+            if (!conditional && canInline(aggregate, before))
+                return aggregate;
+            state->sideEffects = true;
+        }
+    }
+    return call;
+}
+
+bool FunctionInliner::canInline(TIntermAggregate* call, const EvaluationState& state)
+{
+    if (state.sideEffects)
+        return false;
+
+    std::map<TString, TIntermAggregate*>::iterator iter = mFunctions.find(call->getName());
+    if (iter == mFunctions.end())
+        return false;
+    TIntermAggregate* function = iter->second;
+
+    FunctionAnalysis analysis(function);
+    analysis.finish();
+    if (analysis.size > kMaxInlinedFunctionSize || analysis.declaresStruct)
+        return false;
+
+    // The only return statement must end the body.
+    TIntermAggregate* body = GetBody(function);
+    TIntermBranch* last = body != NULL ?
+        body->getSequence().back()->getAsBranchNode() : NULL;
+    bool endsWithReturn = last != NULL && last->getFlowOp() == EOpReturn;
+    if (function->getBasicType() == EbtVoid) {
+        if (analysis.returnCount > 1 || (analysis.returnCount == 1 && !endsWithReturn))
+            return false;
+    } else if (analysis.returnCount != 1 || !endsWithReturn) {
+        return false;
+    }
+
+    TIntermSequence& parameters = GetParameters(function);
+    TIntermSequence& arguments = call->getSequence();
+    if (parameters.size() != arguments.size())
+        return false;
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        TIntermSymbol* parameter = parameters[i]->getAsSymbolNode();
+        TIntermTyped* argument = arguments[i]->getAsTyped();
+        // Arrays can not be copied into temporary variables.
+        if (parameter->isArray())
+            return false;
+        TQualifier qualifier = parameter->getQualifier();
+        if (qualifier == EvqOut || qualifier == EvqInOut) {
+            if (!IsSimpleLValue(argument))
+                return false;
+            if (state.reads.find(GetLValueVariable(argument)->getId()) != state.reads.end())
+                return false;
+        }
+        if (IsSampler(parameter->getBasicType()) &&
+            !canSubstitute(argument, parameter, analysis))
+            return false;
+    }
+
+    // The variables read before the call must keep their values.
+    if (analysis.hasUserDefinedCalls && state.readsGlobals)
+        return false;
+    for (IdSet::iterator id = analysis.written.begin(); id != analysis.written.end(); ++id) {
+        if (analysis.declared.find(*id) == analysis.declared.end() &&
+            state.reads.find(*id) != state.reads.end())
+            return false;
+    }
+
+    // The declarations of the calling function must not hide the variables
+    // and functions used by the inlined code.
+    for (NameSet::iterator name = analysis.externalNames.begin();
+         name != analysis.externalNames.end(); ++name) {
+        if (mCallerNames.find(*name) != mCallerNames.end())
+            return false;
+    }
+    return true;
+}
+
+// Returns true if the parameter can be replaced with the argument, which
+// keeps its value during the execution of the body.
+bool FunctionInliner::canSubstitute(TIntermTyped* argument, TIntermSymbol* parameter,
+                                    const FunctionAnalysis& analysis)
+{
+    if (analysis.written.find(parameter->getId()) != analysis.written.end())
+        return false;
+    if (argument->getAsConstantUnion() != NULL)
+        return true;
+
+    // Selecting a component or field at a constant index is cheap enough to
+    // be repeated.
+    if (!IsSimpleLValue(argument))
+        return false;
+    TIntermSymbol* variable = GetLValueVariable(argument);
+    if (analysis.written.find(variable->getId()) != analysis.written.end())
+        return false;
+    // Global and output variables may be written by the functions called
+    // from the body.
+    return !IsWritableGlobal(variable->getQualifier()) || !analysis.hasUserDefinedCalls;
+}
+
+TIntermSymbol* FunctionInliner::createTemporary(const TType& type, TSourceLoc line,
+                                                TIntermTyped* initializer)
+{
+    return CreateTemporarySymbol(mSymbolTable.nextUniqueId(), "webgl_inl",
+                                 type, line, initializer);
+}
+
+TIntermTyped* CreateAssignment(TIntermTyped* left, TIntermTyped* right)
+{
+    TIntermBinary* assignment = new TIntermBinary(EOpAssign);
+    assignment->setLeft(left);
+    assignment->setRight(right);
+    assignment->setType(left->getType());
+    assignment->setLine(right->getLine());
+    return assignment;
+}
+
+TIntermSymbol* CopySymbol(TIntermSymbol* symbol, TSourceLoc line)
+{
+    TIntermSymbol* copy = CopyExpression(symbol)->getAsSymbolNode();
+    copy->setLine(line);
+    return copy;
+}
+
+void FunctionInliner::inlineCall(TIntermSequence& statements, size_t index,
+                                 TIntermAggregate* call)
+{
+    TIntermAggregate* function = mFunctions[call->getName()];
+    FunctionAnalysis analysis(function);
+    TSourceLoc line = call->getLine();
+
+    TIntermSequence code;
+    TIntermSequence copyBack;
+    TSymbolReplacementMap replacements;
+    // Ids of the temporary variables that only the inlined code writes.
+    IdSet temporaries;
+
+    // Parameters.
+    TIntermSequence& parameters = GetParameters(function);
+    TIntermSequence& arguments = call->getSequence();
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        TIntermSymbol* parameter = parameters[i]->getAsSymbolNode();
+        TIntermTyped* argument = arguments[i]->getAsTyped();
+        TQualifier qualifier = parameter->getQualifier();
+        if (qualifier == EvqOut || qualifier == EvqInOut) {
+            TIntermTyped* initializer =
+                qualifier == EvqInOut ? CopyExpression(argument) : NULL;
+            TIntermSymbol* temporary = createTemporary(parameter->getType(), line);
+            code.push_back(CreateTemporaryDeclaration(temporary, initializer));
+            temporaries.insert(temporary->getId());
+            copyBack.push_back(CreateAssignment(argument, CopySymbol(temporary, line)));
+            replacements[parameter->getId()] = temporary;
+        } else if (canSubstitute(argument, parameter, analysis)) {
+            replacements[parameter->getId()] = argument;
+        } else {
+            TIntermSymbol* temporary = createTemporary(parameter->getType(), line);
+            code.push_back(CreateTemporaryDeclaration(temporary, argument));
+            temporaries.insert(temporary->getId());
+            replacements[parameter->getId()] = temporary;
+        }
+    }
+
+    // Local variables get new names, as the body may be inlined several
+    // times in the same scope.
+    for (size_t i = 0; i < analysis.locals.size(); ++i) {
+        TIntermSymbol* local = analysis.locals[i];
+        TIntermSymbol* temporary = createTemporary(local->getType(), local->getLine());
+        temporaries.insert(temporary->getId());
+        replacements[local->getId()] = temporary;
+    }
+
+    TIntermSequence body;
+    if (TIntermAggregate* block = GetBody(function))
+        body = block->getSequence();
+    TIntermTyped* returnValue = NULL;
+    if (!body.empty()) {
+        TIntermBranch* last = body.back()->getAsBranchNode();
+        if (last != NULL && last->getFlowOp() == EOpReturn) {
+            returnValue = CopyExpression(last->getExpression(), &replacements);
+            body.pop_back();
+        }
+    }
+    for (size_t i = 0; i < body.size(); ++i)
+        code.push_back(CopyTree(body[i], &replacements));
+
+    TIntermNode* statement = statements[index];
+    TIntermTyped* result = NULL;
+    if (statement == call) {
+        // The value returned is not used.
+        if (returnValue != NULL && HasSideEffects(returnValue))
+            code.push_back(returnValue);
+    } else if (body.empty() && copyBack.empty()) {
+        result = returnValue;
+    } else if (returnValue->getAsSymbolNode() != NULL &&
+               temporaries.find(returnValue->getAsSymbolNode()->getId()) != temporaries.end()) {
+        // A local variable or parameter is returned.
+        result = returnValue;
+    } else {
+        // The value is computed before the out parameters are copied back.
+        TIntermSymbol* temporary = createTemporary(function->getType(), line);
+        code.push_back(CreateTemporaryDeclaration(temporary, returnValue));
+        result = CopySymbol(temporary, line);
+    }
+    code.insert(code.end(), copyBack.begin(), copyBack.end());
+
+    if (statement == call) {
+        statements.erase(statements.begin() + index);
+    } else if (TIntermBranch* branch = statement->getAsBranchNode()) {
+        TIntermBranch* replacement = new TIntermBranch(
+            EOpReturn, ReplaceNode(branch->getExpression(), call, result));
+        replacement->setLine(branch->getLine());
+        statements[index] = replacement;
+    } else if (TIntermSelection* selection = statement->getAsSelectionNode()) {
+        if (selection->usesTernaryOperator())
+            statements[index] = ReplaceNode(selection, call, result);
+        else
+            selection->setCondition(ReplaceNode(
+                selection->getCondition()->getAsTyped(), call, result));
+    } else {
+        statements[index] = ReplaceNode(statement->getAsTyped(), call, result);
+    }
+
+    statements.insert(statements.begin() + index, code.begin(), code.end());
+}
+
+}  // namespace
+
+void InlineFunctions(TIntermNode* root, TSymbolTable& symbolTable)
+{
+    // The root is a function definition rather than a sequence if the
+    // shader only defines main().
+    TIntermAggregate* aggregate = root->getAsAggregate();
+    if (aggregate == NULL || aggregate->getOp() != EOpSequence)
+        return;
+
+    FunctionInliner inliner(aggregate, symbolTable);
+    root->traverse(&inliner);
+}
@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_INLINE_FUNCTIONS_H_
+#define COMPILER_INLINE_FUNCTIONS_H_
+
+class TIntermNode;
+class TSymbolTable;
+
+// Replaces calls to small user-defined functions with the body of the
+// called function. The arguments are copied into temporary variables
+// unless they can be used directly, and the temporary variables holding
+// out and inout parameters are copied back after the inlined body.
+// Only functions whose single return statement ends the body are inlined,
+// at calls that are evaluated unconditionally and after any other side
+// effect of the statement containing them.
+// Must be called after function recursion has been ruled out. The symbol
+// table provides the ids of the temporary variables.
+void InlineFunctions(TIntermNode* root, TSymbolTable& symbolTable);
+
+#endif  // COMPILER_INLINE_FUNCTIONS_H_
@@ -0,0 +1,323 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/IntermUtil.h"
+
+namespace {
+
+class SideEffectDetector : public TIntermTraverser {
+public:
+    SideEffectDetector(const TFunctionNameSet* pureFunctions)
+        : mPureFunctions(pureFunctions),
+          mHasSideEffects(false)
+    {
+    }
+
+    bool hasSideEffects() const { return mHasSideEffects; }
+
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return detect(node->modifiesState());
+    }
+
+    virtual bool visitUnary(Visit visit, TIntermUnary* node)
+    {
+        return detect(node->modifiesState());
+    }
+
+    virtual bool visitSelection(Visit visit, TIntermSelection* node)
+    {
+        return detect(!node->usesTernaryOperator());
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        return detect(node->getOp() == EOpFunctionCall && node->isUserDefined() &&
+                      (mPureFunctions == NULL ||
+                       mPureFunctions->find(node->getName()) == mPureFunctions->end()));
+    }
+
+    virtual bool visitLoop(Visit visit, TIntermLoop* node)
+    {
+        return detect(true);
+    }
+
+    virtual bool visitBranch(Visit visit, TIntermBranch* node)
+    {
+        return detect(true);
+    }
+
+private:
+    bool detect(bool sideEffect)
+    {
+        if (sideEffect)
+            mHasSideEffects = true;
+        // No need to look further once a side effect is found.
+        return !mHasSideEffects;
+    }
+
+    const TFunctionNameSet* mPureFunctions;
+    bool mHasSideEffects;
+};
+
+class PrecisionFinder : public TIntermTraverser {
+public:
+    PrecisionFinder() : mPrecision(EbpUndefined) { }
+
+    TPrecision getPrecision() const { return mPrecision; }
+
+    virtual void visitSymbol(TIntermSymbol* node)
+    {
+        update(node);
+    }
+
+    virtual void visitConstantUnion(TIntermConstantUnion* node)
+    {
+        update(node);
+    }
+
+private:
+    void update(TIntermTyped* node)
+    {
+        if (node->getPrecision() > mPrecision)
+            mPrecision = node->getPrecision();
+    }
+
+    TPrecision mPrecision;
+};
+
+}  // namespace
+
+bool HasSideEffects(TIntermNode* node, const TFunctionNameSet* pureFunctions)
+{
+    SideEffectDetector detector(pureFunctions);
+    node->traverse(&detector);
+    return detector.hasSideEffects();
+}
+
+bool IsWritableGlobal(TQualifier qualifier)
+{
+    switch (qualifier) {
+        case EvqGlobal:
+        case EvqVaryingOut:
+        case EvqInvariantVaryingOut:
+        case EvqOutput:
+        case EvqPosition:
+        case EvqPointSize:
+        case EvqFragColor:
+        case EvqFragData:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IsWorthStoring(TIntermTyped* node)
+{
+    if (node->isArray() || node->getBasicType() == EbtStruct ||
+        node->getBasicType() == EbtVoid || IsSampler(node->getBasicType()))
+        return false;
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        switch (binary->getOp()) {
+            case EOpIndexDirect:
+            case EOpIndexIndirect:
+            case EOpIndexDirectStruct:
+            case EOpVectorSwizzle:
+            case EOpComma:
+                return false;
+            default:
+                return true;
+        }
+    }
+    if (TIntermAggregate* aggregate = node->getAsAggregate())
+        return aggregate->getOp() != EOpSequence;
+    return node->getAsUnaryNode() != NULL || node->getAsSelectionNode() != NULL;
+}
+
+bool IsSameExpression(TIntermTyped* a, TIntermTyped* b)
+{
+    if (a->getType() != b->getType())
+        return false;
+
+    if (TIntermSymbol* symbol = a->getAsSymbolNode()) {
+        return b->getAsSymbolNode() != NULL &&
+               b->getAsSymbolNode()->getId() == symbol->getId();
+    }
+    if (TIntermConstantUnion* constant = a->getAsConstantUnion()) {
+        TIntermConstantUnion* other = b->getAsConstantUnion();
+        if (other == NULL)
+            return false;
+        for (int i = 0; i < constant->getType().getObjectSize(); ++i) {
+            if (!(constant->getUnionArrayPointer()[i] == other->getUnionArrayPointer()[i]))
+                return false;
+        }
+        return true;
+    }
+    if (TIntermBinary* binary = a->getAsBinaryNode()) {
+        TIntermBinary* other = b->getAsBinaryNode();
+        if (other == NULL || other->getOp() != binary->getOp() ||
+            !IsSameExpression(binary->getLeft(), other->getLeft()))
+            return false;
+        // The selector of a field holds a single index, but has the type of
+        // the field.
+        if (binary->getOp() == EOpIndexDirectStruct) {
+            return binary->getRight()->getAsConstantUnion()->getUnionArrayPointer()->getIConst() ==
+                   other->getRight()->getAsConstantUnion()->getUnionArrayPointer()->getIConst();
+        }
+        return IsSameExpression(binary->getRight(), other->getRight());
+    }
+    if (TIntermUnary* unary = a->getAsUnaryNode()) {
+        TIntermUnary* other = b->getAsUnaryNode();
+        return other != NULL && other->getOp() == unary->getOp() &&
+               IsSameExpression(unary->getOperand(), other->getOperand());
+    }
+    if (TIntermAggregate* aggregate = a->getAsAggregate()) {
+        TIntermAggregate* other = b->getAsAggregate();
+        if (other == NULL || other->getOp() != aggregate->getOp() ||
+            other->getName() != aggregate->getName())
+            return false;
+        TIntermSequence& sequence = aggregate->getSequence();
+        TIntermSequence& otherSequence = other->getSequence();
+        if (sequence.size() != otherSequence.size())
+            return false;
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermTyped* argument = sequence[i]->getAsTyped();
+            TIntermTyped* otherArgument = otherSequence[i]->getAsTyped();
+            if (argument == NULL || otherArgument == NULL ||
+                !IsSameExpression(argument, otherArgument))
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+TPrecision GetOperandPrecision(TIntermTyped* node)
+{
+    PrecisionFinder finder;
+    node->traverse(&finder);
+    return finder.getPrecision();
+}
+
+TIntermSymbol* CreateTemporarySymbol(int id, const char* prefix,
+                                     const TType& type, TSourceLoc line,
+                                     TIntermTyped* initializer)
+{
+    TStringStream name;
+    name << prefix << id;
+
+    TType temporaryType(type);
+    temporaryType.setQualifier(EvqTemporary);
+    if (temporaryType.getPrecision() == EbpUndefined &&
+        (type.getBasicType() == EbtFloat || type.getBasicType() == EbtInt)) {
+        ASSERT(initializer != NULL);
+        temporaryType.setPrecision(GetOperandPrecision(initializer));
+    }
+
+    TIntermSymbol* symbol = new TIntermSymbol(id, name.str(), temporaryType);
+    symbol->setLine(line);
+    return symbol;
+}
+
+TIntermAggregate* CreateTemporaryDeclaration(TIntermSymbol* symbol,
+                                             TIntermTyped* initializer)
+{
+    TIntermAggregate* declaration = new TIntermAggregate();
+    declaration->setOp(EOpDeclaration);
+    declaration->setLine(symbol->getLine());
+
+    if (initializer == NULL) {
+        declaration->getSequence().push_back(symbol);
+        return declaration;
+    }
+
+    TIntermBinary* initialize = new TIntermBinary(EOpInitialize);
+    initialize->setLeft(symbol);
+    initialize->setRight(initializer);
+    initialize->setType(symbol->getType());
+    initialize->setLine(symbol->getLine());
+    declaration->getSequence().push_back(initialize);
+    return declaration;
+}
+
+TIntermNode* CopyTree(TIntermNode* node,
+                      const TSymbolReplacementMap* replacements)
+{
+    if (node == NULL)
+        return NULL;
+
+    TIntermNode* copy = NULL;
+    if (TIntermSymbol* symbol = node->getAsSymbolNode()) {
+        TSymbolReplacementMap::const_iterator iter;
+        if (replacements != NULL &&
+            (iter = replacements->find(symbol->getId())) != replacements->end()) {
+            copy = CopyTree(iter->second);
+        } else {
+            TIntermSymbol* symbolCopy = new TIntermSymbol(
+                symbol->getId(), symbol->getOriginalSymbol(), symbol->getType());
+            symbolCopy->setSymbol(symbol->getSymbol());
+            copy = symbolCopy;
+        }
+    } else if (TIntermConstantUnion* constant = node->getAsConstantUnion()) {
+        copy = new TIntermConstantUnion(constant->getUnionArrayPointer(),
+                                        constant->getType());
+    } else if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        TIntermBinary* binaryCopy = new TIntermBinary(binary->getOp());
+        binaryCopy->setType(binary->getType());
+        binaryCopy->setLeft(CopyExpression(binary->getLeft(), replacements));
+        binaryCopy->setRight(CopyExpression(binary->getRight(), replacements));
+        copy = binaryCopy;
+    } else if (TIntermUnary* unary = node->getAsUnaryNode()) {
+        TIntermUnary* unaryCopy = new TIntermUnary(unary->getOp());
+        unaryCopy->setType(unary->getType());
+        unaryCopy->setOperand(CopyExpression(unary->getOperand(), replacements));
+        copy = unaryCopy;
+    } else if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermAggregate* aggregateCopy = new TIntermAggregate();
+        aggregateCopy->setOp(aggregate->getOp());
+        aggregateCopy->setType(aggregate->getType());
+        aggregateCopy->setName(aggregate->getName());
+        if (aggregate->isUserDefined())
+            aggregateCopy->setUserDefined();
+        aggregateCopy->setEndLine(aggregate->getEndLine());
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i)
+            aggregateCopy->getSequence().push_back(CopyTree(sequence[i], replacements));
+        copy = aggregateCopy;
+    } else if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        copy = new TIntermSelection(
+            CopyExpression(selection->getCondition()->getAsTyped(), replacements),
+            CopyTree(selection->getTrueBlock(), replacements),
+            CopyTree(selection->getFalseBlock(), replacements),
+            selection->getType());
+    } else if (TIntermLoop* loop = node->getAsLoopNode()) {
+        TIntermLoop* loopCopy = new TIntermLoop(
+            loop->getType(),
+            CopyTree(loop->getInit(), replacements),
+            CopyExpression(loop->getCondition(), replacements),
+            CopyExpression(loop->getExpression(), replacements),
+            CopyTree(loop->getBody(), replacements));
+        loopCopy->setUnrollFlag(loop->getUnrollFlag());
+        copy = loopCopy;
+    } else if (TIntermBranch* branch = node->getAsBranchNode()) {
+        copy = new TIntermBranch(branch->getFlowOp(),
+                                 CopyExpression(branch->getExpression(), replacements));
+    } else {
+        UNREACHABLE();
+        return NULL;
+    }
+
+    copy->setLine(node->getLine());
+    return copy;
+}
+
+TIntermTyped* CopyExpression(TIntermTyped* node,
+                             const TSymbolReplacementMap* replacements)
+{
+    TIntermNode* copy = CopyTree(node, replacements);
+    return copy ? copy->getAsTyped() : NULL;
+}
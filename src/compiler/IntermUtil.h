@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_INTERM_UTIL_H_
+#define COMPILER_INTERM_UTIL_H_
+
+//
+// Helpers shared by the passes that transform the intermediate tree.
+//
+
+#include <map>
+#include <set>
+
+#include "compiler/intermediate.h"
+
+// Maps symbol ids to the expressions that replace the symbols in a copy of
+// a tree.
+typedef std::map<int, TIntermTyped*> TSymbolReplacementMap;
+
+// Mangled names of user-defined functions.
+typedef std::set<TString> TFunctionNameSet;
+
+// Returns true if evaluating the node may do more than produce a value:
+// assign to a variable, increment or decrement it, call a user-defined
+// function, which may write to out parameters or global variables, or
+// alter the control flow. Calls to the functions in pureFunctions, if it
+// is given, are known to have no side effects.
+bool HasSideEffects(TIntermNode* node, const TFunctionNameSet* pureFunctions = NULL);
+
+// Returns true if variables with the qualifier can be written by any
+// function: global variables and the output variables of the shader.
+bool IsWritableGlobal(TQualifier qualifier);
+
+// Returns true if a temporary variable can hold the value of the
+// expression, and reusing that value saves computations.
+bool IsWorthStoring(TIntermTyped* node);
+
+// Returns true if the expressions have the same structure and read the
+// same variables, so that they compute the same value when neither has
+// side effects.
+bool IsSameExpression(TIntermTyped* a, TIntermTyped* b);
+
+// Returns the highest precision of the operands of the expression. Unlike
+// variables, the results of some operations, such as built-in function
+// calls, have no precision of their own.
+TPrecision GetOperandPrecision(TIntermTyped* node);
+
+// Returns a reference to a temporary variable of the given type. The
+// variable name is built from the prefix and the id, which must be unique.
+// Types without precision get the precision of the operands of the
+// initializer, which must then be given.
+TIntermSymbol* CreateTemporarySymbol(int id, const char* prefix,
+                                     const TType& type, TSourceLoc line,
+                                     TIntermTyped* initializer = NULL);
+
+// Returns the declaration statement of a temporary variable, initialized
+// with the given expression if it is not NULL.
+TIntermAggregate* CreateTemporaryDeclaration(TIntermSymbol* symbol,
+                                             TIntermTyped* initializer);
+
+// Returns a deep copy of the tree. References to the symbols found in the
+// replacement map are replaced with copies of the mapped expressions.
+TIntermNode* CopyTree(TIntermNode* node,
+                      const TSymbolReplacementMap* replacements = NULL);
+TIntermTyped* CopyExpression(TIntermTyped* node,
+                             const TSymbolReplacementMap* replacements = NULL);
+
+#endif  // COMPILER_INTERM_UTIL_H_
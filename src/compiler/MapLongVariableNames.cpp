@@ -8,77 +8,51 @@
 
 namespace {
 
-TString mapLongName(int id, const TString& name, bool isGlobal)
+TString mapLongName(int id, const TString& name)
 {
     ASSERT(name.size() > MAX_SHORTENED_IDENTIFIER_SIZE);
     TStringStream stream;
-    stream << "webgl_";
-    if (isGlobal)
-        stream << "g";
-    stream << id;
+    stream << "webgl_" << id;
     if (name[0] != '_')
         stream << "_";
     stream << name.substr(0, MAX_SHORTENED_IDENTIFIER_SIZE - stream.str().size());
     return stream.str();
 }
 
-LongNameMap* gLongNameMapInstance = NULL;
-
-}  // anonymous namespace
-
-LongNameMap::LongNameMap()
-    : refCount(0)
-{
-}
-
-LongNameMap::~LongNameMap()
+// Maps the name to "webgl_g" followed by a 64-bit FNV-1a hash of the name
+// in hexadecimal and by as much of the name as fits. The hash makes
+// distinct names collide with a negligible probability.
+TString mapGlobalLongName(const TString& name)
 {
-}
-
-// static
-LongNameMap* LongNameMap::GetInstance()
-{
-    if (gLongNameMapInstance == NULL)
-        gLongNameMapInstance = new LongNameMap;
-    gLongNameMapInstance->refCount++;
-    return gLongNameMapInstance;
-}
-
-void LongNameMap::Release()
-{
-    ASSERT(gLongNameMapInstance == this);
-    ASSERT(refCount > 0);
-    refCount--;
-    if (refCount == 0) {
-        delete gLongNameMapInstance;
-        gLongNameMapInstance = NULL;
+    ASSERT(name.size() > MAX_SHORTENED_IDENTIFIER_SIZE);
+    unsigned int high = 0xcbf29ce4;
+    unsigned int low = 0x84222325;
+    for (size_t i = 0; i < name.size(); ++i) {
+        low ^= static_cast<unsigned char>(name[i]);
+        // Multiply by the FNV prime 2^40 + 0x1b3, modulo 2^64.
+        unsigned int lowLow = (low & 0xffff) * 0x1b3;
+        unsigned int lowHigh = (low >> 16) * 0x1b3 + (lowLow >> 16);
+        high = high * 0x1b3 + (low << 8) + (lowHigh >> 16);
+        low = (lowHigh << 16) | (lowLow & 0xffff);
     }
-}
 
-const char* LongNameMap::Find(const char* originalName) const
-{
-    std::map<std::string, std::string>::const_iterator it = mLongNameMap.find(
-        originalName);
-    if (it != mLongNameMap.end())
-        return (*it).second.c_str();
-    return NULL;
-}
-
-void LongNameMap::Insert(const char* originalName, const char* mappedName)
-{
-    mLongNameMap.insert(std::map<std::string, std::string>::value_type(
-        originalName, mappedName));
+    TStringStream stream;
+    stream << "webgl_g" << std::hex;
+    stream.width(8);
+    stream.fill('0');
+    stream << high;
+    stream.width(8);
+    stream << low;
+    if (name[0] != '_')
+        stream << "_";
+    stream << name.substr(0, MAX_SHORTENED_IDENTIFIER_SIZE - stream.str().size());
+    return stream.str();
 }
 
-int LongNameMap::Size() const
-{
-    return mLongNameMap.size();
-}
+}  // anonymous namespace
 
-MapLongVariableNames::MapLongVariableNames(LongNameMap* globalMap)
+MapLongVariableNames::MapLongVariableNames()
 {
-    ASSERT(globalMap);
-    mGlobalMap = globalMap;
 }
 
 void MapLongVariableNames::visitSymbol(TIntermSymbol* symbol)
@@ -96,7 +70,7 @@ void MapLongVariableNames::visitSymbol(TIntermSymbol* symbol)
             break;
           default:
             symbol->setSymbol(
-                mapLongName(symbol->getId(), symbol->getSymbol(), false));
+                mapLongName(symbol->getId(), symbol->getSymbol()));
             break;
         };
     }
@@ -108,15 +82,3 @@ bool MapLongVariableNames::visitLoop(Visit, TIntermLoop* node)
         node->getInit()->traverse(this);
     return true;
 }
-
-TString MapLongVariableNames::mapGlobalLongName(const TString& name)
-{
-    ASSERT(mGlobalMap);
-    const char* mappedName = mGlobalMap->Find(name.c_str());
-    if (mappedName != NULL)
-        return mappedName;
-    int id = mGlobalMap->Size();
-    TString rt = mapLongName(id, name, true);
-    mGlobalMap->Insert(name.c_str(), rt.c_str());
-    return rt;
-}
@@ -15,45 +15,17 @@
 // This size does not include '\0' in the end.
 #define MAX_SHORTENED_IDENTIFIER_SIZE 32
 
-// This is a ref-counted singleton. GetInstance() returns a pointer to the
-// singleton, and after use, call Release(). GetInstance() and Release() should
-// be paired.
-class LongNameMap {
-public:
-    static LongNameMap* GetInstance();
-    void Release();
-
-    // Return the mapped name if <originalName, mappedName> is in the map;
-    // otherwise, return NULL.
-    const char* Find(const char* originalName) const;
-
-    // Insert a pair into the map.
-    void Insert(const char* originalName, const char* mappedName);
-
-    // Return the number of entries in the map.
-    int Size() const;
-
-private:
-    LongNameMap();
-    ~LongNameMap();
-
-    size_t refCount;
-    std::map<std::string, std::string> mLongNameMap;
-};
-
 // Traverses intermediate tree to map attributes and uniforms names that are
 // longer than MAX_SHORTENED_IDENTIFIER_SIZE to MAX_SHORTENED_IDENTIFIER_SIZE.
+// Varyings and uniforms, which the shaders of a program share, are mapped
+// to names derived from a hash of their original names, so that every
+// compiler, in any thread or process, maps them to the same names.
 class MapLongVariableNames : public TIntermTraverser {
 public:
-    MapLongVariableNames(LongNameMap* globalMap);
+    MapLongVariableNames();
 
     virtual void visitSymbol(TIntermSymbol*);
     virtual bool visitLoop(Visit, TIntermLoop*);
-
-private:
-    TString mapGlobalLongName(const TString& name);
-
-    LongNameMap* mGlobalMap;
 };
 
 #endif  // COMPILER_MAP_LONG_VARIABLE_NAMES_H_
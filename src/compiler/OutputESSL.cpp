@@ -11,6 +11,11 @@ TOutputESSL::TOutputESSL(TInfoSinkBase& objSink)
 {
 }
 
+TOutputGLSLBase* TOutputESSL::createOutput(TInfoSinkBase& objSink) const
+{
+    return new TOutputESSL(objSink);
+}
+
 bool TOutputESSL::writeVariablePrecision(TPrecision precision)
 {
     if (precision == EbpUndefined)
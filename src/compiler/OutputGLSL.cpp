@@ -11,6 +11,11 @@ TOutputGLSL::TOutputGLSL(TInfoSinkBase& objSink)
 {
 }
 
+TOutputGLSLBase* TOutputGLSL::createOutput(TInfoSinkBase& objSink) const
+{
+    return new TOutputGLSL(objSink);
+}
+
 bool TOutputGLSL::writeVariablePrecision(TPrecision)
 {
     return false;
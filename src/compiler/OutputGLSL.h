@@ -15,6 +15,7 @@ public:
     TOutputGLSL(TInfoSinkBase& objSink);
 
 protected:
+    virtual TOutputGLSLBase* createOutput(TInfoSinkBase& objSink) const;
     virtual bool writeVariablePrecision(TPrecision);
 };
 
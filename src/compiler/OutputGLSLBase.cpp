@@ -5,7 +5,12 @@
 //
 
 #include "compiler/OutputGLSLBase.h"
+
+#include <algorithm>
+
 #include "compiler/debug.h"
+#include "compiler/InitializeDll.h"
+#include "compiler/osinclude.h"
 
 namespace
 {
@@ -64,11 +69,76 @@ bool isSingleStatement(TIntermNode* node) {
     }
     return true;
 }
+
+// Function definitions are only translated on other threads when each
+// thread gets at least this many of them.
+const int kMinFunctionsPerThread = 4;
+
+// Finds whether a function definition refers to a struct not declared yet,
+// in which case its translation would declare the struct. Also computes the
+// sizes of the structs it refers to, which TType computes lazily, so that
+// the threads translating the function only read them.
+class UndeclaredStructFinder : public TIntermTraverser
+{
+public:
+    UndeclaredStructFinder(const std::set<TString>& declaredStructs)
+        : mDeclaredStructs(declaredStructs),
+          mFound(false)
+    {
+    }
+
+    bool found() const { return mFound; }
+
+    virtual void visitSymbol(TIntermSymbol* node) { visitType(node->getType()); }
+    virtual void visitConstantUnion(TIntermConstantUnion* node) { visitType(node->getType()); }
+    virtual bool visitBinary(Visit visit, TIntermBinary* node) { return visitType(node->getType()); }
+    virtual bool visitUnary(Visit visit, TIntermUnary* node) { return visitType(node->getType()); }
+    virtual bool visitSelection(Visit visit, TIntermSelection* node) { return visitType(node->getType()); }
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node) { return visitType(node->getType()); }
+
+private:
+    bool visitType(const TType& type)
+    {
+        if (type.getBasicType() == EbtStruct)
+        {
+            type.getObjectSize();
+            if (mDeclaredStructs.find(type.getTypeName()) == mDeclaredStructs.end())
+                mFound = true;
+        }
+        return !mFound;
+    }
+
+    const std::set<TString>& mDeclaredStructs;
+    bool mFound;
+};
 }  // namespace
 
+// A function definition translated separately. Its output is inserted at
+// the given position of the output of the tree.
+struct TOutputGLSLBase::FunctionOutput
+{
+    TIntermAggregate* function;
+    size_t position;
+    TInfoSinkBase sink;
+};
+
+// The function definitions translated on one thread.
+struct TOutputGLSLBase::FunctionGroup
+{
+    const TOutputGLSLBase* prototype;
+    std::vector<FunctionOutput*> functions;
+    OS_Thread thread;
+    // Share of the budget of the pool of the compiler given to the pool of
+    // the thread, and whether the thread went over it.
+    size_t budgetSize;
+    double deadline;
+    bool overBudget;
+};
+
 TOutputGLSLBase::TOutputGLSLBase(TInfoSinkBase& objSink)
     : TIntermTraverser(true, true, true),
       mObjSink(objSink),
+      mPrecedingSize(0),
       mDeclaringVariables(false)
 {
 }
@@ -662,7 +732,9 @@ bool TOutputGLSLBase::visitLoop(Visit visit, TIntermLoop* node)
         TLoopIndexInfo indexInfo;
         mLoopUnroll.FillLoopIndexInfo(node, indexInfo);
         mLoopUnroll.Push(indexInfo);
-        while (mLoopUnroll.SatisfiesLoopCondition())
+        // Loops with many iterations stop being unrolled once the compile
+        // is over budget, which the compiler then reports.
+        while (mLoopUnroll.SatisfiesLoopCondition() && !isOverBudget())
         {
             visitCodeBlock(node->getBody());
             mLoopUnroll.Step();
@@ -718,3 +790,162 @@ void TOutputGLSLBase::visitCodeBlock(TIntermNode* node) {
         out << "{\n}\n";  // Empty code block.
     }
 }
+
+void TOutputGLSLBase::writeTree(TIntermNode* root, int threadCount)
+{
+    TIntermAggregate* global = root->getAsAggregate();
+    if (threadCount < 2 || global == NULL || global->getOp() != EOpSequence)
+    {
+        root->traverse(this);
+        return;
+    }
+
+    // Write the global sequence as visitAggregate does, setting aside the
+    // function definitions that can be translated separately.
+    TInfoSinkBase& out = objSink();
+    std::vector<FunctionOutput*> functions;
+    incrementDepth();
+    const TIntermSequence& sequence = global->getSequence();
+    for (TIntermSequence::const_iterator iter = sequence.begin();
+         iter != sequence.end(); ++iter)
+    {
+        TIntermNode* node = *iter;
+        ASSERT(node != NULL);
+        TIntermAggregate* function = node->getAsAggregate();
+        if (function != NULL && function->getOp() == EOpFunction &&
+            canWriteSeparately(function))
+        {
+            FunctionOutput* output = new FunctionOutput;
+            output->function = function;
+            output->position = out.str().size();
+            functions.push_back(output);
+            continue;
+        }
+
+        node->traverse(this);
+        if (isSingleStatement(node))
+            out << ";\n";
+    }
+    decrementDepth();
+
+    int groupCount = std::min<int>(threadCount, functions.size() / kMinFunctionsPerThread);
+    if (groupCount < 1)
+        groupCount = 1;
+    std::vector<FunctionGroup> groups(groupCount);
+    for (size_t i = 0; i < functions.size(); ++i)
+        groups[i % groupCount].functions.push_back(functions[i]);
+
+    // The current thread translates the first group, and the groups for
+    // which no thread could be created, while the others translate the rest.
+    // Each thread gets an equal share of the size budget, so that together
+    // they do not allocate much more than the budget. The total output is
+    // checked once it is put together.
+    size_t budgetShare = GlobalPoolAllocator.getBudgetSize() / groupCount;
+    if (GlobalPoolAllocator.getBudgetSize() != 0 && budgetShare == 0)
+        budgetShare = 1;
+    std::vector<bool> threadCreated(groupCount, false);
+    for (int i = 1; i < groupCount; ++i)
+    {
+        groups[i].prototype = this;
+        groups[i].budgetSize = budgetShare;
+        groups[i].deadline = GlobalPoolAllocator.getDeadline();
+        groups[i].overBudget = false;
+        threadCreated[i] = OS_CreateThread(&groups[i].thread, writeFunctionGroup, &groups[i]);
+    }
+    size_t writtenSize = out.size();
+    for (int i = 0; i < groupCount; ++i)
+    {
+        if (threadCreated[i])
+            continue;
+        for (size_t j = 0; j < groups[i].functions.size(); ++j)
+        {
+            writeFunction(*this, groups[i].functions[j], writtenSize);
+            writtenSize += groups[i].functions[j]->sink.size();
+        }
+    }
+    for (int i = 1; i < groupCount; ++i)
+    {
+        if (threadCreated[i])
+        {
+            OS_JoinThread(groups[i].thread);
+            if (groups[i].overBudget)
+                GlobalPoolAllocator.exceedSizeBudget();
+        }
+    }
+
+    // Insert the function definitions where they were set aside.
+    std::string text = out.str();
+    out.erase();
+    size_t position = 0;
+    for (size_t i = 0; i < functions.size(); ++i)
+    {
+        out.append(text.data() + position, functions[i]->position - position);
+        out.append(functions[i]->sink.c_str(), functions[i]->sink.size());
+        position = functions[i]->position;
+        delete functions[i];
+    }
+    out.append(text.data() + position, text.size() - position);
+
+    // The threads only checked their share of the output.
+    isOverBudget();
+}
+
+bool TOutputGLSLBase::isOverBudget()
+{
+    // The object code counts against the memory budget of the pool.
+    TPoolAllocator& pool = GlobalPoolAllocator;
+    size_t size = mPrecedingSize + objSink().size();
+    if (pool.getBudgetSize() != 0 && size > pool.getBudgetSize())
+        pool.exceedSizeBudget();
+    return pool.isOverBudget();
+}
+
+bool TOutputGLSLBase::canWriteSeparately(TIntermAggregate* function)
+{
+    UndeclaredStructFinder finder(mDeclaredStructs);
+    function->traverse(&finder);
+    return !finder.found();
+}
+
+void TOutputGLSLBase::writeFunction(const TOutputGLSLBase& prototype, FunctionOutput* function,
+                                    size_t precedingSize)
+{
+    TOutputGLSLBase* output = prototype.createOutput(function->sink);
+    output->mPrecedingSize = precedingSize;
+    // A copy of a TString allocates from the pool of the original, which
+    // belongs to another thread, so the names are copied from their text
+    // into the pool of this thread.
+    for (DeclaredStructs::const_iterator iter = prototype.mDeclaredStructs.begin();
+         iter != prototype.mDeclaredStructs.end(); ++iter)
+        output->mDeclaredStructs.insert(TString(iter->c_str(), iter->size()));
+    // Function definitions are written inside the global sequence.
+    output->incrementDepth();
+    function->function->traverse(output);
+    delete output;
+}
+
+void TOutputGLSLBase::writeFunctionGroup(void* data)
+{
+    FunctionGroup* group = static_cast<FunctionGroup*>(data);
+
+    // The thread allocates from its own pool. The tree and the prototype,
+    // allocated from the pool of the compiler, are only read, and strings
+    // are never copied from them, as the copy would allocate from that pool.
+    TPoolAllocator allocator;
+    InitThread();
+    allocator.push();
+    allocator.setBudget(group->budgetSize, group->deadline);
+    SetGlobalPoolAllocator(&allocator);
+
+    size_t writtenSize = 0;
+    for (size_t i = 0; i < group->functions.size(); ++i)
+    {
+        writeFunction(*group->prototype, group->functions[i], writtenSize);
+        writtenSize += group->functions[i]->sink.size();
+    }
+
+    group->overBudget = allocator.isOverSizeBudget();
+    allocator.pop();
+    SetGlobalPoolAllocator(NULL);
+    DetachThread();
+}
@@ -8,6 +8,8 @@
 #define CROSSCOMPILERGLSL_OUTPUTGLSLBASE_H_
 
 #include <set>
+#include <string>
+#include <vector>
 
 #include "compiler/ForLoopUnroll.h"
 #include "compiler/intermediate.h"
@@ -18,7 +20,16 @@ class TOutputGLSLBase : public TIntermTraverser
 public:
     TOutputGLSLBase(TInfoSinkBase& objSink);
 
+    // Writes the tree, as traversing it does. Function definitions that
+    // declare no struct are translated on up to threadCount threads if
+    // there are enough of them. The output does not depend on threadCount.
+    void writeTree(TIntermNode* root, int threadCount);
+
 protected:
+    // Returns a new output of the same kind writing to the sink, which
+    // translates function definitions on other threads.
+    virtual TOutputGLSLBase* createOutput(TInfoSinkBase& objSink) const = 0;
+
     TInfoSinkBase& objSink() { return mObjSink; }
     void writeTriplet(Visit visit, const char* preStr, const char* inStr, const char* postStr);
     void writeVariableType(const TType& type);
@@ -38,7 +49,19 @@ protected:
     void visitCodeBlock(TIntermNode* node);
 
 private:
+    struct FunctionOutput;
+    struct FunctionGroup;
+
+    bool isOverBudget();
+    bool canWriteSeparately(TIntermAggregate* function);
+    static void writeFunction(const TOutputGLSLBase& prototype, FunctionOutput* function,
+                              size_t precedingSize);
+    static void writeFunctionGroup(void* group);
+
     TInfoSinkBase& mObjSink;
+    // Size of the output already written to other sinks, which counts
+    // against the budget along with the output of this sink.
+    size_t mPrecedingSize;
     bool mDeclaringVariables;
 
     // Structs are declared as the tree is traversed. This set contains all
@@ -9,6 +9,63 @@
 
 namespace
 {
+// Loops marked for unrolling are unrolled only if the unrolled body has at
+// most this many nodes. Other loops with a constant number of iterations
+// are written as counted loops.
+const int kMaxUnrolledLoopSize = 256;
+// Loops that run more iterations are written as ordinary for loops.
+const int kMaxCountedLoopIterations = 1 << 20;
+
+// Returns the number of iterations of a loop marked for unrolling, or
+// kMaxCountedLoopIterations + 1 if it runs more iterations.
+int getLoopIterations(TIntermLoop* node)
+{
+    ForLoopUnroll loopUnroll;
+    TLoopIndexInfo indexInfo;
+    loopUnroll.FillLoopIndexInfo(node, indexInfo);
+    return ForLoopUnroll::CountIterations(indexInfo, kMaxCountedLoopIterations);
+}
+
+bool shouldUnrollLoop(int iterations, int bodySize)
+{
+    return iterations <= kMaxUnrolledLoopSize &&
+           iterations * bodySize <= kMaxUnrolledLoopSize;
+}
+
+// Counts the nodes that TOutputJS writes for a subtree, including the
+// copies of the bodies of unrolled loops.
+class OutputSizeCounter : public TIntermTraverser
+{
+public:
+    OutputSizeCounter() : size(0) { }
+
+    virtual void visitSymbol(TIntermSymbol*) { ++size; }
+    virtual void visitConstantUnion(TIntermConstantUnion*) { ++size; }
+    virtual bool visitBinary(Visit, TIntermBinary*) { ++size; return true; }
+    virtual bool visitUnary(Visit, TIntermUnary*) { ++size; return true; }
+    virtual bool visitSelection(Visit, TIntermSelection*) { ++size; return true; }
+    virtual bool visitAggregate(Visit, TIntermAggregate*) { ++size; return true; }
+    virtual bool visitBranch(Visit, TIntermBranch*) { ++size; return true; }
+    virtual bool visitLoop(Visit, TIntermLoop* node)
+    {
+        ++size;
+        if (!node->getUnrollFlag())
+            return true;
+
+        OutputSizeCounter body;
+        if (node->getBody())
+            node->getBody()->traverse(&body);
+        int iterations = getLoopIterations(node);
+        if (shouldUnrollLoop(iterations, body.size))
+            size += iterations * body.size;
+        else
+            size += body.size;
+        return false;
+    }
+
+    int size;
+};
+
 TString getTypeName(const TType& type)
 {
     TInfoSinkBase out;
@@ -639,9 +696,40 @@ bool TOutputJS::visitLoop(Visit visit, TIntermLoop* node)
     incrementDepth();
     // Loop header.
     TLoopType loopType = node->getType();
+    bool unroll = false;
+    if (loopType == ELoopFor && node->getUnrollFlag())
+    {
+        OutputSizeCounter body;
+        if (node->getBody())
+            node->getBody()->traverse(&body);
+        int iterations = getLoopIterations(node);
+        if (shouldUnrollLoop(iterations, body.size))
+        {
+            unroll = true;
+        }
+        else if (iterations <= kMaxCountedLoopIterations)
+        {
+            // The index takes the values first + k * step for k from 0 to
+            // count - 1, and the body reads it as an ordinary variable.
+            TLoopIndexInfo indexInfo;
+            mLoopUnroll.FillLoopIndexInfo(node, indexInfo);
+            TIntermAggregate* decl = node->getInit()->getAsAggregate();
+            TIntermSymbol* index =
+                decl->getSequence()[0]->getAsBinaryNode()->getLeft()->getAsSymbolNode();
+            out << "[\"counted_for\", " << index->getId()
+                << ", \"" << index->getSymbol() << "\", "
+                << indexInfo.initValue << ", " << iterations << ", "
+                << indexInfo.incrementValue << ", ";
+            visitCodeBlock(node->getBody());
+            out << "]";
+            decrementDepth();
+            return false;
+        }
+    }
+
     if (loopType == ELoopFor)  // for loop
     {
-        if (!node->getUnrollFlag()) {
+        if (!unroll) {
             out << "[\"for\", ";
             if (node->getInit())
                 node->getInit()->traverse(this);
@@ -679,7 +767,7 @@ bool TOutputJS::visitLoop(Visit visit, TIntermLoop* node)
     }
 
     // Loop body.
-    if (node->getUnrollFlag())
+    if (unroll)
     {
         out << "[\"block\", [";
         TLoopIndexInfo indexInfo;
@@ -13,6 +13,25 @@
 #include "compiler/intermediate.h"
 #include "compiler/ParseHelper.h"
 
+//
+// Writes the tree as nested arrays whose first element names the kind of
+// node, such as ["if", condition, true block], followed by the false block
+// if there is one. Loops are written as:
+//
+//   ["for", init, condition, expression, body]
+//   ["while", condition, body]
+//   ["do_while", condition, body]
+//   ["counted_for", id, name, first, count, step, body]
+//
+// where a missing part of a for loop is null. Loops with an integer index
+// that are small enough are unrolled into a ["block", [body, ...]], with
+// the index replaced by its value in each copy. Other such loops that run
+// a known number of iterations are written as counted_for nodes: the int
+// loop index, whose symbol has the given id and name, takes the values
+// first + k * step for k from 0 to count - 1, and the body reads it as an
+// ordinary variable, which it never writes. Break and continue behave as
+// in a for loop.
+//
 class TOutputJS : public TIntermTraverser
 {
 public:
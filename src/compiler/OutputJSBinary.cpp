@@ -0,0 +1,646 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/OutputJSBinary.h"
+
+#include <string.h>
+
+#include "compiler/debug.h"
+
+namespace
+{
+const char kMagic[] = { 'G', 'L', 'B', 'T' };
+const int kVersion = 1;
+
+int basicCode(TBasicType type)
+{
+    switch (type)
+    {
+        case EbtVoid: return 0;
+        case EbtFloat: return 1;
+        case EbtInt: return 2;
+        case EbtBool: return 3;
+        case EbtSampler2D: return 4;
+        case EbtSamplerCube: return 5;
+        case EbtSamplerExternalOES: return 6;
+        case EbtSampler2DRect: return 7;
+        case EbtStruct: return 8;
+        default: UNREACHABLE(); return 0;
+    }
+}
+
+int qualifierCode(TQualifier qualifier)
+{
+    switch (qualifier)
+    {
+        case EvqTemporary:
+        case EvqGlobal: return 0;
+        case EvqConst: return 1;
+        case EvqAttribute: return 2;
+        case EvqVaryingIn:
+        case EvqVaryingOut: return 3;
+        case EvqInvariantVaryingIn:
+        case EvqInvariantVaryingOut: return 4;
+        case EvqUniform: return 5;
+        case EvqIn: return 6;
+        case EvqOut: return 7;
+        case EvqInOut: return 8;
+        case EvqConstReadOnly: return 9;
+        default: return 10;
+    }
+}
+
+int binaryOpcode(TOperator op)
+{
+    switch (op)
+    {
+        case EOpInitialize: return EJsbInitialize;
+        case EOpAssign: return EJsbAssign;
+        case EOpAddAssign: return EJsbAddAssign;
+        case EOpSubAssign: return EJsbSubAssign;
+        case EOpDivAssign: return EJsbDivAssign;
+        case EOpMulAssign:
+        case EOpVectorTimesMatrixAssign:
+        case EOpVectorTimesScalarAssign:
+        case EOpMatrixTimesScalarAssign:
+        case EOpMatrixTimesMatrixAssign: return EJsbMulAssign;
+        case EOpAdd: return EJsbAdd;
+        case EOpSub: return EJsbSub;
+        case EOpMul:
+        case EOpVectorTimesScalar:
+        case EOpVectorTimesMatrix:
+        case EOpMatrixTimesVector:
+        case EOpMatrixTimesScalar:
+        case EOpMatrixTimesMatrix: return EJsbMul;
+        case EOpDiv: return EJsbDiv;
+        case EOpEqual: return EJsbEqual;
+        case EOpNotEqual: return EJsbNotEqual;
+        case EOpLessThan: return EJsbLessThan;
+        case EOpGreaterThan: return EJsbGreaterThan;
+        case EOpLessThanEqual: return EJsbLessThanEqual;
+        case EOpGreaterThanEqual: return EJsbGreaterThanEqual;
+        case EOpLogicalOr: return EJsbLogicalOr;
+        case EOpLogicalXor: return EJsbLogicalXor;
+        case EOpLogicalAnd: return EJsbLogicalAnd;
+        default: UNREACHABLE(); return EJsbNull;
+    }
+}
+
+// Returns the built-in function of an operator, or -1 if the operator is
+// not a built-in function.
+int builtInCode(TOperator op)
+{
+    switch (op)
+    {
+        case EOpRadians: return EJsbRadians;
+        case EOpDegrees: return EJsbDegrees;
+        case EOpSin: return EJsbSin;
+        case EOpCos: return EJsbCos;
+        case EOpTan: return EJsbTan;
+        case EOpAsin: return EJsbAsin;
+        case EOpAcos: return EJsbAcos;
+        case EOpAtan: return EJsbAtan;
+        case EOpPow: return EJsbPow;
+        case EOpExp: return EJsbExp;
+        case EOpLog: return EJsbLog;
+        case EOpExp2: return EJsbExp2;
+        case EOpLog2: return EJsbLog2;
+        case EOpSqrt: return EJsbSqrt;
+        case EOpInverseSqrt: return EJsbInverseSqrt;
+        case EOpAbs: return EJsbAbs;
+        case EOpSign: return EJsbSign;
+        case EOpFloor: return EJsbFloor;
+        case EOpCeil: return EJsbCeil;
+        case EOpFract: return EJsbFract;
+        case EOpMod: return EJsbMod;
+        case EOpMin: return EJsbMin;
+        case EOpMax: return EJsbMax;
+        case EOpClamp: return EJsbClamp;
+        case EOpMix: return EJsbMix;
+        case EOpStep: return EJsbStep;
+        case EOpSmoothStep: return EJsbSmoothStep;
+        case EOpLength: return EJsbLength;
+        case EOpDistance: return EJsbDistance;
+        case EOpDot: return EJsbDot;
+        case EOpCross: return EJsbCross;
+        case EOpNormalize: return EJsbNormalize;
+        case EOpFaceForward: return EJsbFaceForward;
+        case EOpReflect: return EJsbReflect;
+        case EOpRefract: return EJsbRefract;
+        case EOpMul: return EJsbMatrixCompMult;
+        case EOpLessThan: return EJsbVectorLessThan;
+        case EOpLessThanEqual: return EJsbVectorLessThanEqual;
+        case EOpGreaterThan: return EJsbVectorGreaterThan;
+        case EOpGreaterThanEqual: return EJsbVectorGreaterThanEqual;
+        case EOpVectorEqual: return EJsbVectorEqual;
+        case EOpVectorNotEqual: return EJsbVectorNotEqual;
+        case EOpAny: return EJsbAny;
+        case EOpAll: return EJsbAll;
+        case EOpVectorLogicalNot: return EJsbNot;
+        case EOpDFdx: return EJsbDFdx;
+        case EOpDFdy: return EJsbDFdy;
+        case EOpFwidth: return EJsbFwidth;
+        default: return -1;
+    }
+}
+
+int lineIndex(TSourceLoc line)
+{
+    int index;
+    DecodeSourceLoc(line, NULL, NULL, &index);
+    return index;
+}
+}  // namespace
+
+bool TOutputJSBinary::TypeKey::operator<(const TypeKey& other) const
+{
+    if (basic != other.basic) return basic < other.basic;
+    if (qualifier != other.qualifier) return qualifier < other.qualifier;
+    if (precision != other.precision) return precision < other.precision;
+    if (size != other.size) return size < other.size;
+    if (flags != other.flags) return flags < other.flags;
+    if (arraySize != other.arraySize) return arraySize < other.arraySize;
+    return structure < other.structure;
+}
+
+TOutputJSBinary::TOutputJSBinary(TInfoSinkBase& objSink)
+    : mObjSink(objSink)
+{
+}
+
+void TOutputJSBinary::output(TIntermNode* root)
+{
+    writeNode(root);
+
+    TString out(kMagic, sizeof(kMagic));
+    writeByte(out, kVersion);
+
+    TString strings;
+    writeVarint(strings, static_cast<unsigned int>(mStringIndices.size()));
+    strings.append(mStrings);
+    writeVarint(out, static_cast<unsigned int>(strings.size()));
+    out.append(strings);
+
+    TString types;
+    writeVarint(types, static_cast<unsigned int>(mTypeIndices.size()));
+    types.append(mTypes);
+    writeVarint(out, static_cast<unsigned int>(types.size()));
+    out.append(types);
+
+    writeVarint(out, static_cast<unsigned int>(mTree.size()));
+    mObjSink.append(out.data(), out.size());
+    mObjSink.append(mTree.data(), mTree.size());
+}
+
+void TOutputJSBinary::writeByte(TString& out, int value)
+{
+    ASSERT(value >= 0 && value < 256);
+    out.push_back(static_cast<char>(value));
+}
+
+void TOutputJSBinary::writeVarint(TString& out, unsigned int value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void TOutputJSBinary::writeSint(TString& out, int value)
+{
+    unsigned int zigzag = (static_cast<unsigned int>(value) << 1) ^
+                          static_cast<unsigned int>(value >> 31);
+    writeVarint(out, zigzag);
+}
+
+void TOutputJSBinary::writeFloat(TString& out, float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<char>(bits & 0xff));
+        bits >>= 8;
+    }
+}
+
+int TOutputJSBinary::stringIndex(const TString& str)
+{
+    std::map<TString, int>::const_iterator iter = mStringIndices.find(str);
+    if (iter != mStringIndices.end())
+        return iter->second;
+
+    int index = static_cast<int>(mStringIndices.size());
+    mStringIndices[str] = index;
+    writeVarint(mStrings, static_cast<unsigned int>(str.size()));
+    mStrings.append(str);
+    return index;
+}
+
+int TOutputJSBinary::typeIndex(const TType& type)
+{
+    TypeKey key;
+    key.basic = basicCode(type.getBasicType());
+    key.qualifier = qualifierCode(type.getQualifier());
+    key.precision = type.getPrecision();
+    key.size = type.getNominalSize();
+    key.flags = (type.isMatrix() ? 1 : 0) | (type.isArray() ? 2 : 0);
+    key.arraySize = type.isArray() ? type.getArraySize() : 0;
+    key.structure = type.getStruct();
+
+    std::map<TypeKey, int>::const_iterator iter = mTypeIndices.find(key);
+    if (iter != mTypeIndices.end())
+        return iter->second;
+
+    // The fields enter the table before the struct that refers to them.
+    TVector<int> fields;
+    if (key.structure)
+    {
+        for (size_t i = 0; i < key.structure->size(); ++i)
+            fields.push_back(typeIndex(*(*key.structure)[i].type));
+    }
+
+    writeByte(mTypes, key.basic);
+    writeByte(mTypes, key.qualifier);
+    writeByte(mTypes, key.precision);
+    writeByte(mTypes, key.size);
+    writeByte(mTypes, key.flags);
+    if (type.isArray())
+        writeVarint(mTypes, key.arraySize);
+    if (key.structure)
+    {
+        writeVarint(mTypes, stringIndex(type.getTypeName()));
+        writeVarint(mTypes, static_cast<unsigned int>(fields.size()));
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            writeVarint(mTypes, stringIndex((*key.structure)[i].type->getFieldName()));
+            writeVarint(mTypes, fields[i]);
+        }
+    }
+
+    int index = static_cast<int>(mTypeIndices.size());
+    mTypeIndices[key] = index;
+    return index;
+}
+
+void TOutputJSBinary::writeType(const TType& type)
+{
+    writeVarint(mTree, typeIndex(type));
+}
+
+void TOutputJSBinary::writeString(const TString& str)
+{
+    writeVarint(mTree, stringIndex(str));
+}
+
+void TOutputJSBinary::writeNode(TIntermNode* node)
+{
+    if (node == NULL)
+    {
+        writeByte(mTree, EJsbNull);
+    }
+    else if (TIntermSymbol* symbol = node->getAsSymbolNode())
+    {
+        writeSymbol(symbol);
+    }
+    else if (TIntermConstantUnion* constant = node->getAsConstantUnion())
+    {
+        writeTyped(EJsbConstant, constant);
+        writeConstant(constant->getType(), constant->getUnionArrayPointer());
+    }
+    else if (TIntermBinary* binary = node->getAsBinaryNode())
+    {
+        writeBinary(binary);
+    }
+    else if (TIntermUnary* unary = node->getAsUnaryNode())
+    {
+        writeUnary(unary);
+    }
+    else if (TIntermSelection* selection = node->getAsSelectionNode())
+    {
+        writeSelection(selection);
+    }
+    else if (TIntermAggregate* aggregate = node->getAsAggregate())
+    {
+        writeAggregate(aggregate);
+    }
+    else if (TIntermLoop* loop = node->getAsLoopNode())
+    {
+        writeLoop(loop);
+    }
+    else if (TIntermBranch* branch = node->getAsBranchNode())
+    {
+        writeBranch(branch);
+    }
+    else
+    {
+        UNREACHABLE();
+    }
+}
+
+void TOutputJSBinary::writeTyped(int opcode, TIntermTyped* node)
+{
+    writeByte(mTree, opcode);
+    writeType(node->getType());
+}
+
+// Code blocks are always written as blocks, so that the statements of the
+// branches and loop bodies that were not enclosed in braces have lines too.
+void TOutputJSBinary::writeBlock(TIntermNode* node)
+{
+    TIntermAggregate* aggregate = node ? node->getAsAggregate() : NULL;
+    if (aggregate && aggregate->getOp() == EOpSequence)
+    {
+        writeNode(aggregate);
+        return;
+    }
+
+    writeByte(mTree, EJsbBlock);
+    if (node == NULL)
+    {
+        writeVarint(mTree, 0);
+        return;
+    }
+    writeVarint(mTree, 1);
+    writeVarint(mTree, lineIndex(node->getLine()));
+    writeNode(node);
+}
+
+void TOutputJSBinary::writeParameters(TIntermAggregate* parameters)
+{
+    const TIntermSequence& sequence = parameters->getSequence();
+    writeVarint(mTree, static_cast<unsigned int>(sequence.size()));
+    for (TIntermSequence::const_iterator iter = sequence.begin();
+         iter != sequence.end(); ++iter)
+    {
+        TIntermSymbol* parameter = (*iter)->getAsSymbolNode();
+        ASSERT(parameter != NULL);
+        writeByte(mTree, EJsbParameter);
+        writeType(parameter->getType());
+        writeVarint(mTree, parameter->getId());
+        writeString(parameter->getSymbol());
+    }
+}
+
+void TOutputJSBinary::writeArguments(TIntermAggregate* node)
+{
+    const TIntermSequence& sequence = node->getSequence();
+    writeVarint(mTree, static_cast<unsigned int>(sequence.size()));
+    for (TIntermSequence::const_iterator iter = sequence.begin();
+         iter != sequence.end(); ++iter)
+    {
+        writeNode(*iter);
+    }
+}
+
+const ConstantUnion* TOutputJSBinary::writeConstant(const TType& type,
+                                                    const ConstantUnion* constant)
+{
+    if (type.getBasicType() == EbtStruct)
+    {
+        const TTypeList* structure = type.getStruct();
+        ASSERT(structure != NULL);
+        for (size_t i = 0; i < structure->size(); ++i)
+            constant = writeConstant(*(*structure)[i].type, constant);
+        return constant;
+    }
+
+    int size = type.getObjectSize();
+    for (int i = 0; i < size; ++i, ++constant)
+    {
+        switch (constant->getType())
+        {
+            case EbtFloat: writeFloat(mTree, constant->getFConst()); break;
+            case EbtInt: writeSint(mTree, constant->getIConst()); break;
+            case EbtBool: writeByte(mTree, constant->getBConst() ? 1 : 0); break;
+            default: UNREACHABLE(); break;
+        }
+    }
+    return constant;
+}
+
+void TOutputJSBinary::writeSymbol(TIntermSymbol* node)
+{
+    writeTyped(EJsbSymbol, node);
+    writeVarint(mTree, node->getId());
+    writeString(node->getSymbol());
+}
+
+void TOutputJSBinary::writeBinary(TIntermBinary* node)
+{
+    switch (node->getOp())
+    {
+        case EOpIndexDirect:
+        case EOpIndexIndirect:
+            writeTyped(EJsbIndex, node);
+            writeNode(node->getLeft());
+            writeNode(node->getRight());
+            break;
+        case EOpIndexDirectStruct: {
+            writeTyped(EJsbField, node);
+            writeNode(node->getLeft());
+            const TIntermConstantUnion* index = node->getRight()->getAsConstantUnion();
+            ASSERT(index != NULL);
+            writeVarint(mTree, index->getUnionArrayPointer()->getIConst());
+            break;
+        }
+        case EOpVectorSwizzle: {
+            writeTyped(EJsbSwizzle, node);
+            writeNode(node->getLeft());
+            TIntermAggregate* components = node->getRight()->getAsAggregate();
+            ASSERT(components != NULL);
+            const TIntermSequence& sequence = components->getSequence();
+            writeByte(mTree, static_cast<int>(sequence.size()));
+            for (TIntermSequence::const_iterator iter = sequence.begin();
+                 iter != sequence.end(); ++iter)
+            {
+                const TIntermConstantUnion* element = (*iter)->getAsConstantUnion();
+                ASSERT(element != NULL);
+                writeByte(mTree, element->getUnionArrayPointer()->getIConst());
+            }
+            break;
+        }
+        default:
+            writeTyped(binaryOpcode(node->getOp()), node);
+            writeNode(node->getLeft());
+            writeNode(node->getRight());
+            break;
+    }
+}
+
+void TOutputJSBinary::writeUnary(TIntermUnary* node)
+{
+    int opcode = EJsbNull;
+    switch (node->getOp())
+    {
+        case EOpNegative: opcode = EJsbNegative; break;
+        case EOpLogicalNot: opcode = EJsbLogicalNot; break;
+        case EOpPostIncrement: opcode = EJsbPostIncrement; break;
+        case EOpPostDecrement: opcode = EJsbPostDecrement; break;
+        case EOpPreIncrement: opcode = EJsbPreIncrement; break;
+        case EOpPreDecrement: opcode = EJsbPreDecrement; break;
+        case EOpConvIntToBool:
+        case EOpConvFloatToBool:
+        case EOpConvBoolToFloat:
+        case EOpConvIntToFloat:
+        case EOpConvFloatToInt:
+        case EOpConvBoolToInt: opcode = EJsbConvert; break;
+        default: {
+            int builtIn = builtInCode(node->getOp());
+            ASSERT(builtIn >= 0);
+            writeTyped(EJsbBuiltIn, node);
+            writeByte(mTree, builtIn);
+            writeVarint(mTree, 1);
+            writeNode(node->getOperand());
+            return;
+        }
+    }
+
+    writeTyped(opcode, node);
+    writeNode(node->getOperand());
+}
+
+void TOutputJSBinary::writeSelection(TIntermSelection* node)
+{
+    if (node->usesTernaryOperator())
+    {
+        writeTyped(EJsbTernary, node);
+        writeNode(node->getCondition());
+        writeNode(node->getTrueBlock());
+        writeNode(node->getFalseBlock());
+    }
+    else
+    {
+        writeByte(mTree, EJsbIf);
+        writeNode(node->getCondition());
+        writeBlock(node->getTrueBlock());
+        if (node->getFalseBlock())
+            writeBlock(node->getFalseBlock());
+        else
+            writeByte(mTree, EJsbNull);
+    }
+}
+
+void TOutputJSBinary::writeAggregate(TIntermAggregate* node)
+{
+    switch (node->getOp())
+    {
+        case EOpSequence: {
+            const TIntermSequence& sequence = node->getSequence();
+            writeByte(mTree, EJsbBlock);
+            writeVarint(mTree, static_cast<unsigned int>(sequence.size()));
+            for (TIntermSequence::const_iterator iter = sequence.begin();
+                 iter != sequence.end(); ++iter)
+            {
+                writeVarint(mTree, lineIndex((*iter)->getLine()));
+                writeNode(*iter);
+            }
+            break;
+        }
+        case EOpPrototype:
+            writeTyped(EJsbPrototype, node);
+            writeString(node->getName());
+            writeParameters(node);
+            break;
+        case EOpFunction: {
+            // Function definition node contains one or two children nodes
+            // representing function parameters and function body. The latter
+            // is not present in case of empty function bodies.
+            const TIntermSequence& sequence = node->getSequence();
+            ASSERT((sequence.size() == 1) || (sequence.size() == 2));
+            TIntermAggregate* parameters = sequence[0]->getAsAggregate();
+            ASSERT(parameters != NULL && parameters->getOp() == EOpParameters);
+
+            writeTyped(EJsbFunction, node);
+            writeString(node->getName());
+            writeParameters(parameters);
+            writeBlock(sequence.size() == 2 ? sequence[1] : NULL);
+            break;
+        }
+        case EOpFunctionCall:
+            writeTyped(EJsbCall, node);
+            writeString(node->getName());
+            writeArguments(node);
+            break;
+        case EOpDeclaration:
+            writeByte(mTree, EJsbDeclaration);
+            writeArguments(node);
+            break;
+        case EOpComma:
+            writeTyped(EJsbComma, node);
+            ASSERT(node->getSequence().size() == 2);
+            writeNode(node->getSequence()[0]);
+            writeNode(node->getSequence()[1]);
+            break;
+        case EOpConstructFloat:
+        case EOpConstructVec2:
+        case EOpConstructVec3:
+        case EOpConstructVec4:
+        case EOpConstructBool:
+        case EOpConstructBVec2:
+        case EOpConstructBVec3:
+        case EOpConstructBVec4:
+        case EOpConstructInt:
+        case EOpConstructIVec2:
+        case EOpConstructIVec3:
+        case EOpConstructIVec4:
+        case EOpConstructMat2:
+        case EOpConstructMat3:
+        case EOpConstructMat4:
+        case EOpConstructStruct:
+            writeTyped(EJsbConstruct, node);
+            writeArguments(node);
+            break;
+        default: {
+            int builtIn = builtInCode(node->getOp());
+            ASSERT(builtIn >= 0);
+            writeTyped(EJsbBuiltIn, node);
+            writeByte(mTree, builtIn);
+            writeArguments(node);
+            break;
+        }
+    }
+}
+
+void TOutputJSBinary::writeLoop(TIntermLoop* node)
+{
+    switch (node->getType())
+    {
+        case ELoopFor:
+            writeByte(mTree, EJsbFor);
+            writeNode(node->getInit());
+            writeNode(node->getCondition());
+            writeNode(node->getExpression());
+            break;
+        case ELoopWhile:
+            writeByte(mTree, EJsbWhile);
+            writeNode(node->getCondition());
+            break;
+        case ELoopDoWhile:
+            writeByte(mTree, EJsbDoWhile);
+            writeNode(node->getCondition());
+            break;
+        default: UNREACHABLE(); break;
+    }
+    writeBlock(node->getBody());
+}
+
+void TOutputJSBinary::writeBranch(TIntermBranch* node)
+{
+    switch (node->getFlowOp())
+    {
+        case EOpKill: writeByte(mTree, EJsbDiscard); break;
+        case EOpBreak: writeByte(mTree, EJsbBreak); break;
+        case EOpContinue: writeByte(mTree, EJsbContinue); break;
+        case EOpReturn:
+            writeByte(mTree, EJsbReturn);
+            writeNode(node->getExpression());
+            break;
+        default: UNREACHABLE(); break;
+    }
+}
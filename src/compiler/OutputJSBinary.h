@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_OUTPUTJSBINARY_H_
+#define COMPILER_OUTPUTJSBINARY_H_
+
+//
+// Writes the intermediate tree in a compact binary encoding for JavaScript
+// interpreters. It carries the same tree as TOutputJS, but types, symbol
+// names and operators are not repeated as text on every node, and a reader
+// walks the bytes without parsing.
+//
+// The object code may contain null bytes. Its length is the value of
+// SH_OBJECT_CODE_LENGTH minus one.
+//
+// Encoding
+//
+//   varint   Unsigned LEB128: seven bits per byte, least significant
+//            group first, the high bit set on all but the last byte.
+//   sint     Signed integer as a varint after zigzag encoding:
+//            (i << 1) ^ (i >> 31), decoded as (v >>> 1) ^ -(v & 1).
+//   float    IEEE 754 single precision, four bytes, little endian.
+//   string   Index into the string table, as a varint.
+//   type     Index into the type table, as a varint.
+//
+// Layout
+//
+//   'G' 'L' 'B' 'T' version(1)
+//   varint byteLength, varint count, count * (varint length, bytes)
+//                                        the string table, UTF-8
+//   varint byteLength, varint count, count * typeEntry
+//                                        the type table
+//   varint byteLength, node              the tree, whose root is a block
+//
+// The byte lengths let a reader skip or slice a section without decoding
+// it. Each string appears once in the string table, however often it is
+// referenced. A type entry is
+//
+//   basic        byte: 0 void, 1 float, 2 int, 3 bool, 4 sampler2D,
+//                5 samplerCube, 6 samplerExternalOES, 7 sampler2DRect,
+//                8 struct
+//   qualifier    byte: 0 none, 1 const, 2 attribute, 3 varying,
+//                4 invariant varying, 5 uniform, 6 in, 7 out, 8 inout,
+//                9 const in, 10 built-in output or input such as
+//                gl_Position or gl_FragCoord
+//   precision    byte: 0 undefined, 1 lowp, 2 mediump, 3 highp
+//   size         byte: components of a vector, columns of a matrix, 1
+//   flags        byte: 1 matrix, 2 array
+//   arraySize    varint, for arrays only
+//   struct       string name, varint fieldCount,
+//                fieldCount * (string name, type), for structs only
+//
+// The types of the fields of a struct always precede the struct in the
+// table.
+//
+// A node is an opcode byte from JSBinaryOpcode followed by its operands,
+// listed next to each opcode below. Operands named node are nested nodes,
+// which are EJsbNull where the tree has no node. Every expression carries
+// the type of its result. Functions are named by their mangled names, such
+// as "main(" or "texture2D(s21;vf2;"; the GLSL name is the part before the
+// parenthesis. The bodies of functions, loops and branches are always
+// blocks. Loops are written as loops, whether or not the compiler would
+// unroll them for a GLSL driver.
+//
+// A reader is a loop over this grammar. In JavaScript, with the object
+// code in a Uint8Array named bytes:
+//
+//   function varint() {
+//       var value = 0, shift = 0, b;
+//       do { b = bytes[offset++]; value += (b & 0x7f) * Math.pow(2, shift);
+//            shift += 7; } while (b & 0x80);
+//       return value;
+//   }
+//   function node() {
+//       var op = bytes[offset++];
+//       switch (op) {
+//         case 0: return null;
+//         case 1: var n = varint(), block = [];
+//                 while (n--) { var line = varint(); block.push(node()); }
+//                 return block;
+//         case 2: return { op: op, type: types[varint()], id: varint(),
+//                          name: strings[varint()] };
+//         ...
+//       }
+//   }
+//
+
+#include <map>
+
+#include "compiler/InfoSink.h"
+#include "compiler/intermediate.h"
+
+enum JSBinaryOpcode
+{
+    EJsbNull = 0,
+    EJsbBlock = 1,           // varint count, count * (varint line, node)
+    EJsbSymbol = 2,          // type, varint id, string name
+    EJsbConstant = 3,        // type, one value per component: float, sint
+                             // for ints, byte for bools; struct fields in
+                             // order
+    EJsbDeclaration = 4,     // varint count, count * node (symbol or init)
+    EJsbPrototype = 5,       // type, string name, varint count,
+                             // count * parameter
+    EJsbFunction = 6,        // type, string name, varint count,
+                             // count * parameter, node body
+    EJsbParameter = 7,       // type, varint id, string name
+    EJsbCall = 8,            // type, string name, varint count, count * node
+    EJsbConstruct = 9,       // type, varint count, count * node
+    EJsbIf = 10,             // node condition, node true, node false
+    EJsbTernary = 11,        // type, node condition, node true, node false
+    EJsbFor = 12,            // node init, node condition, node expression,
+                             // node body
+    EJsbWhile = 13,          // node condition, node body
+    EJsbDoWhile = 14,        // node condition, node body
+    EJsbDiscard = 15,
+    EJsbBreak = 16,
+    EJsbContinue = 17,
+    EJsbReturn = 18,         // node value
+    EJsbIndex = 19,          // type, node base, node index
+    EJsbField = 20,          // type, node base, varint field index
+    EJsbSwizzle = 21,        // type, node base, byte count, count * byte
+    EJsbComma = 22,          // type, node left, node right
+
+    // Binary operators: type, node left, node right. Products of vectors
+    // and matrices are told apart by the types of their operands.
+    EJsbInitialize = 32,
+    EJsbAssign = 33,
+    EJsbAddAssign = 34,
+    EJsbSubAssign = 35,
+    EJsbMulAssign = 36,
+    EJsbDivAssign = 37,
+    EJsbAdd = 38,
+    EJsbSub = 39,
+    EJsbMul = 40,
+    EJsbDiv = 41,
+    EJsbEqual = 42,
+    EJsbNotEqual = 43,
+    EJsbLessThan = 44,
+    EJsbGreaterThan = 45,
+    EJsbLessThanEqual = 46,
+    EJsbGreaterThanEqual = 47,
+    EJsbLogicalOr = 48,
+    EJsbLogicalXor = 49,
+    EJsbLogicalAnd = 50,
+
+    // Unary operators: type, node operand. EJsbConvert converts the
+    // operand to the basic type of the result.
+    EJsbNegative = 64,
+    EJsbLogicalNot = 65,
+    EJsbPostIncrement = 66,
+    EJsbPostDecrement = 67,
+    EJsbPreIncrement = 68,
+    EJsbPreDecrement = 69,
+    EJsbConvert = 70,
+
+    // Built-in functions other than texture lookups, which are calls:
+    // type, byte function from JSBinaryBuiltIn, varint count, count * node.
+    EJsbBuiltIn = 80,
+};
+
+enum JSBinaryBuiltIn
+{
+    EJsbRadians, EJsbDegrees, EJsbSin, EJsbCos, EJsbTan, EJsbAsin, EJsbAcos,
+    EJsbAtan, EJsbPow, EJsbExp, EJsbLog, EJsbExp2, EJsbLog2, EJsbSqrt,
+    EJsbInverseSqrt, EJsbAbs, EJsbSign, EJsbFloor, EJsbCeil, EJsbFract,
+    EJsbMod, EJsbMin, EJsbMax, EJsbClamp, EJsbMix, EJsbStep, EJsbSmoothStep,
+    EJsbLength, EJsbDistance, EJsbDot, EJsbCross, EJsbNormalize,
+    EJsbFaceForward, EJsbReflect, EJsbRefract, EJsbMatrixCompMult,
+    EJsbVectorLessThan, EJsbVectorLessThanEqual, EJsbVectorGreaterThan,
+    EJsbVectorGreaterThanEqual, EJsbVectorEqual, EJsbVectorNotEqual,
+    EJsbAny, EJsbAll, EJsbNot, EJsbDFdx, EJsbDFdy, EJsbFwidth,
+};
+
+class TOutputJSBinary
+{
+public:
+    TOutputJSBinary(TInfoSinkBase& objSink);
+
+    void output(TIntermNode* root);
+
+private:
+    // Types are keyed by everything their table entry holds.
+    struct TypeKey
+    {
+        bool operator<(const TypeKey& other) const;
+
+        int basic;
+        int qualifier;
+        int precision;
+        int size;
+        int flags;
+        int arraySize;
+        const TTypeList* structure;
+    };
+
+    static void writeByte(TString& out, int value);
+    static void writeVarint(TString& out, unsigned int value);
+    static void writeSint(TString& out, int value);
+    static void writeFloat(TString& out, float value);
+
+    int stringIndex(const TString& str);
+    int typeIndex(const TType& type);
+
+    void writeType(const TType& type);
+    void writeString(const TString& str);
+    void writeNode(TIntermNode* node);
+    void writeTyped(int opcode, TIntermTyped* node);
+    void writeBlock(TIntermNode* node);
+    void writeParameters(TIntermAggregate* parameters);
+    void writeArguments(TIntermAggregate* node);
+    const ConstantUnion* writeConstant(const TType& type, const ConstantUnion* constant);
+
+    void writeSymbol(TIntermSymbol* node);
+    void writeBinary(TIntermBinary* node);
+    void writeUnary(TIntermUnary* node);
+    void writeSelection(TIntermSelection* node);
+    void writeAggregate(TIntermAggregate* node);
+    void writeLoop(TIntermLoop* node);
+    void writeBranch(TIntermBranch* node);
+
+    TInfoSinkBase& mObjSink;
+
+    // The tree and the tables are written to separate buffers, since the
+    // tables are complete only when the tree has been written.
+    TString mTree;
+    TString mStrings;
+    TString mTypes;
+
+    std::map<TString, int> mStringIndices;
+    std::map<TypeKey, int> mTypeIndices;
+};
+
+#endif  // COMPILER_OUTPUTJSBINARY_H_
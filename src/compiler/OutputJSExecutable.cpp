@@ -0,0 +1,1854 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/OutputJSExecutable.h"
+
+#include <ctype.h>
+#include <float.h>
+#include <stdio.h>
+
+#include "common/angleutils.h"
+#include "compiler/SymbolTable.h"
+#include "compiler/debug.h"
+
+namespace
+{
+
+const char* const kRuntime = "$runtime";
+const char* const kDiscard = "$discard";
+const char* const kInitialize = "$initialize";
+
+TString Str(int value)
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%d", value);
+    return buffer;
+}
+
+bool IsIdentifierChar(char c)
+{
+    return isalnum(c) || (c == '_') || (c == '$');
+}
+
+bool IsInterface(TQualifier qualifier)
+{
+    switch (qualifier)
+    {
+        case EvqAttribute:
+        case EvqVaryingIn:
+        case EvqVaryingOut:
+        case EvqInvariantVaryingIn:
+        case EvqInvariantVaryingOut:
+        case EvqUniform:
+        case EvqPosition:
+        case EvqPointSize:
+        case EvqFragCoord:
+        case EvqFrontFacing:
+        case EvqPointCoord:
+        case EvqFragColor:
+        case EvqFragData:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Scalars that are not stored in arrays are JavaScript variables or
+// properties of their own.
+bool IsPlainScalar(const TType& type)
+{
+    return type.isScalar() && !type.isArray();
+}
+
+// Structs and arrays are only handled by reference.
+bool IsComposite(const TType& type)
+{
+    return type.isArray() || (type.getBasicType() == EbtStruct);
+}
+
+TString InitialValue(const TType& type)
+{
+    return type.getBasicType() == EbtBool ? "false" : "0";
+}
+
+TString FloatLiteral(float value)
+{
+    if (value != value)
+        return "NaN";
+    if (value > FLT_MAX)
+        return "Infinity";
+    if (value < -FLT_MAX)
+        return "(-Infinity)";
+
+    TInfoSinkBase out;
+    out << (value < 0.0f ? -value : value);
+    TString literal(out.c_str());
+    return value < 0.0f ? "(-" + literal + ")" : literal;
+}
+
+TString ComponentLiteral(const ConstantUnion& constant, TBasicType type)
+{
+    float value = 0.0f;
+    switch (constant.getType())
+    {
+        case EbtFloat: value = constant.getFConst(); break;
+        case EbtInt: value = static_cast<float>(constant.getIConst()); break;
+        case EbtBool: value = constant.getBConst() ? 1.0f : 0.0f; break;
+        default: UNREACHABLE(); break;
+    }
+
+    switch (type)
+    {
+        case EbtFloat:
+            return FloatLiteral(value);
+        case EbtBool:
+            return value != 0.0f ? "true" : "false";
+        default: {
+            int integer = constant.getType() == EbtInt ? constant.getIConst() :
+                                                         static_cast<int>(value);
+            return integer < 0 ? "(" + Str(integer) + ")" : Str(integer);
+        }
+    }
+}
+
+bool IsLiteral(const TString& expression)
+{
+    if ((expression == "true") || (expression == "false") ||
+        (expression == "NaN") || (expression == "Infinity"))
+        return true;
+    size_t start = expression.compare(0, 2, "(-") == 0 ? 2 : 0;
+    return (start < expression.size()) &&
+           (isdigit(expression[start]) || (expression.compare(start, 8, "Infinity") == 0));
+}
+
+bool IsTemporary(const TString& expression)
+{
+    if ((expression.size() < 3) || (expression.compare(0, 2, "$t") != 0))
+        return false;
+    for (size_t i = 2; i < expression.size(); ++i)
+    {
+        if (!isdigit(expression[i]))
+            return false;
+    }
+    return true;
+}
+
+// Returns true if the expression is cheap enough to be repeated: a literal,
+// a variable, or an element of an array.
+bool IsSimple(const TString& expression)
+{
+    if (IsLiteral(expression))
+        return true;
+    for (size_t i = 0; i < expression.size(); ++i)
+    {
+        char c = expression[i];
+        if (!IsIdentifierChar(c) && (c != '.') && (c != '[') && (c != ']') &&
+            (c != ' ') && (c != '+') && (c != '*'))
+            return false;
+    }
+    return !expression.empty();
+}
+
+// Returns the variable that holds the storage of an l-value, or an empty
+// string if it is not known.
+TString RootName(const TString& expression)
+{
+    size_t length = 0;
+    while ((length < expression.size()) && IsIdentifierChar(expression[length]))
+        ++length;
+    return expression.substr(0, length);
+}
+
+bool References(const TString& expression, const TString& name)
+{
+    for (size_t position = expression.find(name); position != TString::npos;
+         position = expression.find(name, position + 1))
+    {
+        size_t end = position + name.size();
+        if (((position == 0) || !IsIdentifierChar(expression[position - 1])) &&
+            ((end == expression.size()) || !IsIdentifierChar(expression[end])))
+            return true;
+    }
+    return false;
+}
+
+// Returns true if writing to the l-value may change the value read by the
+// expression. Writes to constant elements of an array only change reads of
+// the same element or of dynamically indexed elements.
+bool MayAlias(const TString& written, const TString& read)
+{
+    TString root = RootName(written);
+    if (root.empty())
+        return true;
+    if (!References(read, root))
+        return false;
+
+    size_t length = root.size();
+    if ((written.size() <= length + 2) || (written[length] != '[') ||
+        (written[written.size() - 1] != ']'))
+        return true;
+    TString element = written.substr(length + 1, written.size() - length - 2);
+    for (size_t i = 0; i < element.size(); ++i)
+    {
+        if (!isdigit(element[i]))
+            return true;
+    }
+    for (size_t position = read.find(root + "["); position != TString::npos;
+         position = read.find(root + "[", position + 1))
+    {
+        if ((position > 0) && IsIdentifierChar(read[position - 1]))
+            continue;
+        size_t start = position + length + 1;
+        size_t end = read.find(']', start);
+        TString index = read.substr(start, end - start);
+        if (index == element)
+            return true;
+        for (size_t i = 0; i < index.size(); ++i)
+        {
+            if (!isdigit(index[i]))
+                return true;
+        }
+    }
+    // Any other use of the variable reads the whole of it.
+    size_t uses = 0;
+    for (size_t position = read.find(root); position != TString::npos;
+         position = read.find(root, position + 1))
+    {
+        size_t end = position + length;
+        if (((position == 0) || !IsIdentifierChar(read[position - 1])) &&
+            ((end == read.size()) || !IsIdentifierChar(read[end])) &&
+            ((end == read.size()) || (read[end] != '[')))
+            ++uses;
+    }
+    return uses > 0;
+}
+
+// Returns true if the statement only declares a temporary variable without
+// calling a user-defined function, whose names start with '$' and a digit.
+bool IsPure(const TString& statement)
+{
+    if ((statement.compare(0, 6, "var $t") != 0) || (statement.find('\n') != TString::npos))
+        return false;
+    for (size_t i = 0; i + 1 < statement.size(); ++i)
+    {
+        if ((statement[i] == '$') && isdigit(statement[i + 1]))
+            return false;
+    }
+    return true;
+}
+
+// Removes the parentheses around the whole expression, if any.
+TString StripParentheses(const TString& expression)
+{
+    if ((expression.size() < 2) || (expression[0] != '(') ||
+        (expression[expression.size() - 1] != ')'))
+        return expression;
+    int depth = 0;
+    for (size_t i = 0; i < expression.size() - 1; ++i)
+    {
+        if (expression[i] == '(')
+            ++depth;
+        else if (expression[i] == ')')
+            --depth;
+        if (depth == 0)
+            return expression;
+    }
+    return expression.substr(1, expression.size() - 2);
+}
+
+int CountUses(const char* pattern, int operand)
+{
+    int uses = 0;
+    for (const char* c = pattern; *c; ++c)
+    {
+        if ((c[0] == '%') && (c[1] == '0' + operand))
+            ++uses;
+    }
+    return uses;
+}
+
+TString Substitute(const char* pattern, const TVector<const TString*>& operands)
+{
+    TString result;
+    for (const char* c = pattern; *c; ++c)
+    {
+        if ((c[0] == '%') && isdigit(c[1]))
+        {
+            result += *operands[c[1] - '0'];
+            ++c;
+        }
+        else
+        {
+            result += *c;
+        }
+    }
+    return result;
+}
+
+TString Join(const TVector<TString>& strings, const char* separator)
+{
+    TString result;
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        if (i > 0)
+            result += separator;
+        result += strings[i];
+    }
+    return result;
+}
+
+TString Element(const TString& reference, const TString& offset, int index)
+{
+    if (offset.empty())
+        return reference + "[" + Str(index) + "]";
+    if (index == 0)
+        return reference + "[" + offset + "]";
+    return reference + "[" + offset + " + " + Str(index) + "]";
+}
+
+TString Indent(const TString& text)
+{
+    TString result;
+    bool lineStart = true;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (lineStart && (text[i] != '\n'))
+            result += "    ";
+        result += text[i];
+        lineStart = text[i] == '\n';
+    }
+    return result;
+}
+
+void AppendBlock(TString& out, const TVector<TString>& statements)
+{
+    out += "{\n";
+    for (size_t i = 0; i < statements.size(); ++i)
+        out += Indent(statements[i]) + "\n";
+    out += "}";
+}
+
+// Returns true if the statements are plain expression statements that can
+// be joined with commas, as in the update expression of a for loop.
+bool IsExpressionList(const TVector<TString>& statements)
+{
+    for (size_t i = 0; i < statements.size(); ++i)
+    {
+        const TString& statement = statements[i];
+        if ((statement.compare(0, 4, "var ") == 0) ||
+            (statement.find('\n') != TString::npos) ||
+            (statement.find(';') != statement.size() - 1))
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+TOutputJSExecutable::TOutputJSExecutable(TInfoSinkBase& objSink)
+    : mObjSink(objSink),
+      mStatements(NULL),
+      mCurrentFunction(NULL),
+      mTemporaryCount(0),
+      mLabelCount(0),
+      mUsesDiscard(false)
+{
+}
+
+void TOutputJSExecutable::output(TIntermNode* root)
+{
+    TIntermSequence globals;
+    TIntermAggregate* aggregate = root->getAsAggregate();
+    if (aggregate && (aggregate->getOp() == EOpSequence))
+        globals = aggregate->getSequence();
+    else
+        globals.push_back(root);
+
+    // Name the functions first, since they may be called before they are
+    // defined.
+    for (TIntermSequence::const_iterator iter = globals.begin(); iter != globals.end(); ++iter)
+    {
+        TIntermAggregate* function = (*iter)->getAsAggregate();
+        if (!function || (function->getOp() != EOpFunction))
+            continue;
+
+        FunctionInfo info;
+        TString index = Str(static_cast<int>(mFunctionMap.size()));
+        info.name = "$" + index + "_" + TFunction::unmangleName(function->getName());
+        info.resultName = "$r" + index;
+        info.parameters = function->getSequence().front()->getAsAggregate();
+        info.returnType = &function->getType();
+        if ((info.returnType->getBasicType() != EbtVoid) && !IsPlainScalar(*info.returnType))
+            mDeclarations.push_back("var " + info.resultName + " = " + newStorage(*info.returnType) + ";");
+        mFunctionMap[function->getName()] = info;
+    }
+
+    mStatements = &mInitialization;
+    for (TIntermSequence::const_iterator iter = globals.begin(); iter != globals.end(); ++iter)
+    {
+        TIntermAggregate* global = (*iter)->getAsAggregate();
+        if (global && (global->getOp() == EOpFunction))
+            translateFunction(global);
+        else if (global && (global->getOp() == EOpDeclaration))
+            translateDeclaration(global, true);
+        else if (!global || (global->getOp() != EOpPrototype))
+            translateStatement(*iter);
+    }
+    mStatements = NULL;
+
+    TString program = "\"use strict\";\n";
+    if (mUsesDiscard)
+        program += "var " + TString(kDiscard) + " = {};\n";
+    for (size_t i = 0; i < mDeclarations.size(); ++i)
+        program += mDeclarations[i] + "\n";
+    for (size_t i = 0; i < mHelpers.size(); ++i)
+        program += mHelpers[i] + "\n";
+    program += "function " + TString(kInitialize) + "() ";
+    AppendBlock(program, mInitialization);
+    program += "\n";
+    for (size_t i = 0; i < mFunctions.size(); ++i)
+        program += mFunctions[i] + "\n";
+
+    TVector<TString> run;
+    FunctionMap::const_iterator entry = mFunctionMap.find("main(");
+    TString call = TString(kInitialize) + "();";
+    if (entry != mFunctionMap.end())
+        call += "\n" + entry->second.name + "();";
+    if (mUsesDiscard)
+    {
+        run.push_back("try {\n" + Indent(call) + "\n} catch (e) {\n"
+                      "    if (e === " + kDiscard + ")\n"
+                      "        return false;\n"
+                      "    throw e;\n"
+                      "}");
+    }
+    else
+    {
+        run.push_back(call);
+    }
+    run.push_back("return true;");
+
+    TString main = "main: function () ";
+    AppendBlock(main, run);
+    program += "return {\n";
+    program += "    uniforms: { " + Join(mUniforms, ", ") + " },\n";
+    program += "    attributes: { " + Join(mAttributes, ", ") + " },\n";
+    program += "    varyings: { " + Join(mVaryings, ", ") + " },\n";
+    program += "    builtIns: { " + Join(mBuiltIns, ", ") + " },\n";
+    program += Indent(main) + "\n";
+    program += "};\n";
+
+    TInfoSinkBase& out = mObjSink;
+    out << "(function (" << kRuntime << ") {\n";
+    out << Indent(program);
+    out << "})\n";
+}
+
+TString TOutputJSExecutable::newTemporary()
+{
+    return "$t" + Str(mTemporaryCount++);
+}
+
+TString TOutputJSExecutable::declareTemporary(const TString& initializer)
+{
+    TString name = newTemporary();
+    mStatements->push_back("var " + name + " = " + StripParentheses(initializer) + ";");
+    return name;
+}
+
+TString TOutputJSExecutable::newLabel()
+{
+    return "$l" + Str(mLabelCount++);
+}
+
+TString TOutputJSExecutable::variableName(const TIntermSymbol* symbol) const
+{
+    // Generated names all contain a '$', which GLSL identifiers cannot, so
+    // they never collide with JavaScript keywords or with each other.
+    return symbol->getSymbol() + "$" + Str(symbol->getId());
+}
+
+TString TOutputJSExecutable::structName(const TType& type)
+{
+    const TTypeList* structure = type.getStruct();
+    ASSERT(structure != NULL);
+    std::map<const TTypeList*, TString>::const_iterator iter = mStructNames.find(structure);
+    if (iter != mStructNames.end())
+        return iter->second;
+
+    TString name = type.getTypeName() + "_" + Str(static_cast<int>(mStructNames.size()));
+    mStructNames[structure] = name;
+
+    TVector<TString> fields, copies, comparisons;
+    for (size_t i = 0; i < structure->size(); ++i)
+    {
+        const TType& field = *(*structure)[i].type;
+        const TString& fieldName = field.getFieldName();
+        fields.push_back(fieldName + ": " +
+                         (IsPlainScalar(field) ? InitialValue(field) : newStorage(field)));
+        copies.push_back(copyStorage(field, "destination." + fieldName, "source." + fieldName));
+        comparisons.push_back(equalStorage(field, "left." + fieldName, "right." + fieldName));
+    }
+
+    TVector<TString> statements;
+    statements.push_back("return { " + Join(fields, ", ") + " };");
+    TString helpers = "function $new_" + name + "() ";
+    AppendBlock(helpers, statements);
+    helpers += "\nfunction $copy_" + name + "(destination, source) ";
+    AppendBlock(helpers, copies);
+    statements[0] = "return " + Join(comparisons, " && ") + ";";
+    helpers += "\nfunction $equal_" + name + "(left, right) ";
+    AppendBlock(helpers, statements);
+    mHelpers.push_back(helpers);
+    return name;
+}
+
+TString TOutputJSExecutable::newStorage(const TType& type)
+{
+    if (type.getBasicType() == EbtStruct)
+    {
+        TString object = "$new_" + structName(type) + "()";
+        if (!type.isArray())
+            return object;
+        TVector<TString> elements;
+        elements.resize(type.getArraySize(), object);
+        return "[" + Join(elements, ", ") + "]";
+    }
+
+    int size = type.getObjectSize();
+    switch (type.getBasicType())
+    {
+        case EbtFloat:
+            return "new Float32Array(" + Str(size) + ")";
+        case EbtBool: {
+            TVector<TString> elements;
+            elements.resize(size, "false");
+            return "[" + Join(elements, ", ") + "]";
+        }
+        default:
+            // Integers and sampler units.
+            return "new Int32Array(" + Str(size) + ")";
+    }
+}
+
+TString TOutputJSExecutable::copyStorage(const TType& type, const TString& destination,
+                                         const TString& source)
+{
+    if (IsPlainScalar(type))
+        return destination + " = " + source + ";";
+
+    TVector<TString> copies;
+    if (type.getBasicType() == EbtStruct)
+    {
+        TString copy = "$copy_" + structName(type);
+        if (!type.isArray())
+            return copy + "(" + destination + ", " + source + ");";
+        for (int i = 0; i < type.getArraySize(); ++i)
+        {
+            TString element = "[" + Str(i) + "]";
+            copies.push_back(copy + "(" + destination + element + ", " + source + element + ");");
+        }
+        return Join(copies, " ");
+    }
+    if (type.getBasicType() != EbtBool)
+        return destination + ".set(" + source + ");";
+    for (int i = 0; i < type.getObjectSize(); ++i)
+        copies.push_back(Element(destination, "", i) + " = " + Element(source, "", i) + ";");
+    return Join(copies, " ");
+}
+
+TString TOutputJSExecutable::equalStorage(const TType& type, const TString& left,
+                                          const TString& right)
+{
+    if (IsPlainScalar(type))
+        return left + " === " + right;
+
+    TVector<TString> comparisons;
+    if (type.getBasicType() == EbtStruct)
+    {
+        TString equal = "$equal_" + structName(type);
+        if (!type.isArray())
+            return equal + "(" + left + ", " + right + ")";
+        for (int i = 0; i < type.getArraySize(); ++i)
+        {
+            TString element = "[" + Str(i) + "]";
+            comparisons.push_back(equal + "(" + left + element + ", " + right + element + ")");
+        }
+        return Join(comparisons, " && ");
+    }
+    for (int i = 0; i < type.getObjectSize(); ++i)
+        comparisons.push_back(Element(left, "", i) + " === " + Element(right, "", i));
+    return Join(comparisons, " && ");
+}
+
+TString TOutputJSExecutable::constantLiteral(const TType& type, const ConstantUnion*& constant)
+{
+    if (type.getBasicType() == EbtStruct)
+    {
+        const TTypeList* structure = type.getStruct();
+        TVector<TString> fields;
+        for (size_t i = 0; i < structure->size(); ++i)
+        {
+            const TType& field = *(*structure)[i].type;
+            fields.push_back(field.getFieldName() + ": " + constantLiteral(field, constant));
+        }
+        return "{ " + Join(fields, ", ") + " }";
+    }
+
+    TVector<TString> components;
+    for (int i = 0; i < type.getObjectSize(); ++i, ++constant)
+        components.push_back(ComponentLiteral(*constant, type.getBasicType()));
+    if (IsPlainScalar(type))
+        return components.front();
+    switch (type.getBasicType())
+    {
+        case EbtFloat: return "new Float32Array([" + Join(components, ", ") + "])";
+        case EbtBool: return "[" + Join(components, ", ") + "]";
+        default: return "new Int32Array([" + Join(components, ", ") + "])";
+    }
+}
+
+void TOutputJSExecutable::declareModuleVariable(const TIntermSymbol* symbol)
+{
+    if (!mDeclaredVariables.insert(symbol->getId()).second)
+        return;
+
+    const TType& type = symbol->getType();
+    TQualifier qualifier = type.getQualifier();
+    TString name = variableName(symbol);
+    bool boxed = IsInterface(qualifier);
+    mDeclarations.push_back("var " + name + " = " +
+                            (IsPlainScalar(type) && !boxed ? InitialValue(type) : newStorage(type)) +
+                            ";");
+
+    TString entry = "\"" + symbol->getSymbol() + "\": " + name;
+    switch (qualifier)
+    {
+        case EvqUniform:
+            mUniforms.push_back(entry);
+            break;
+        case EvqAttribute:
+            mAttributes.push_back(entry);
+            break;
+        case EvqVaryingIn:
+        case EvqVaryingOut:
+        case EvqInvariantVaryingIn:
+        case EvqInvariantVaryingOut:
+            mVaryings.push_back(entry);
+            break;
+        default:
+            if (boxed)
+                mBuiltIns.push_back(entry);
+            break;
+    }
+}
+
+void TOutputJSExecutable::declareVariable(TIntermSymbol* symbol, TIntermTyped* initializer,
+                                          bool global)
+{
+    const TType& type = symbol->getType();
+    TString name = variableName(symbol);
+    bool boxed = IsInterface(type.getQualifier());
+    if (!global && !boxed && IsPlainScalar(type))
+    {
+        TString value = initializer ? translateExpression(initializer).components.front() :
+                                      InitialValue(type);
+        mStatements->push_back("var " + name + " = " + StripParentheses(value) + ";");
+        return;
+    }
+
+    declareModuleVariable(symbol);
+    if (initializer)
+        store(storageValue(type, name, boxed), translateExpression(initializer), type);
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::storageValue(const TType& type,
+                                                             const TString& name,
+                                                             bool boxed) const
+{
+    Value value;
+    if (IsPlainScalar(type))
+    {
+        value.components.push_back(boxed ? name + "[0]" : name);
+        return value;
+    }
+
+    value.reference = name;
+    if (!IsComposite(type))
+        loadComponents(value, type.getObjectSize());
+    return value;
+}
+
+void TOutputJSExecutable::loadComponents(Value& value, int count) const
+{
+    value.components.clear();
+    for (int i = 0; i < count; ++i)
+        value.components.push_back(Element(value.reference, value.offset, value.base + i));
+}
+
+void TOutputJSExecutable::makeSimple(Value& value)
+{
+    for (size_t i = 0; i < value.components.size(); ++i)
+    {
+        if (!IsSimple(value.components[i]))
+            value.components[i] = declareTemporary(value.components[i]);
+    }
+}
+
+void TOutputJSExecutable::saveValue(Value& value, size_t position)
+{
+    TVector<TString> saved;
+    for (size_t i = 0; i < value.components.size(); ++i)
+    {
+        TString& component = value.components[i];
+        if (IsLiteral(component) || IsTemporary(component))
+            continue;
+        TString name = newTemporary();
+        saved.push_back("var " + name + " = " + StripParentheses(component) + ";");
+        component = name;
+    }
+    mStatements->insert(mStatements->begin() + position, saved.begin(), saved.end());
+}
+
+void TOutputJSExecutable::materialize(Value& value)
+{
+    value.reference = declareTemporary("[" + Join(value.components, ", ") + "]");
+    value.offset.clear();
+    value.base = 0;
+}
+
+void TOutputJSExecutable::store(const Value& target, Value value, const TType& type)
+{
+    if (IsComposite(type))
+    {
+        mStatements->push_back(copyStorage(type, target.reference, value.reference));
+        return;
+    }
+
+    // Components written first must not change the components read later.
+    bool aliased = false;
+    for (size_t i = 0; i < target.components.size() && !aliased; ++i)
+    {
+        for (size_t j = i + 1; j < value.components.size() && !aliased; ++j)
+            aliased = MayAlias(target.components[i], value.components[j]);
+    }
+    if (aliased)
+        saveValue(value, mStatements->size());
+    for (size_t i = 0; i < target.components.size(); ++i)
+    {
+        mStatements->push_back(target.components[i] + " = " +
+                               StripParentheses(value.components[i]) + ";");
+    }
+}
+
+void TOutputJSExecutable::translateOperands(const TIntermSequence& operands,
+                                            const TVector<bool>& targets,
+                                            TVector<Value>& values)
+{
+    for (size_t i = 0; i < operands.size(); ++i)
+    {
+        // Operands are evaluated in order. If an operand needs statements
+        // that may have side effects, the values of the operands before it
+        // are saved first. Assignment targets are not values.
+        size_t mark = mStatements->size();
+        values.push_back(translateExpression(operands[i]->getAsTyped()));
+        bool pure = true;
+        for (size_t j = mark; j < mStatements->size() && pure; ++j)
+            pure = IsPure((*mStatements)[j]);
+        if (pure)
+            continue;
+        for (size_t j = 0; j < i; ++j)
+        {
+            if ((j >= targets.size()) || !targets[j])
+                saveValue(values[j], mark);
+        }
+    }
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::componentWise(const char* pattern,
+                                                              TVector<Value>& operands)
+{
+    size_t size = 1;
+    for (size_t i = 0; i < operands.size(); ++i)
+        size = std::max(size, operands[i].components.size());
+
+    // Operands that are used more than once per component, or scalars that
+    // are used for every component, are computed only once.
+    for (size_t i = 0; i < operands.size(); ++i)
+    {
+        if ((CountUses(pattern, static_cast<int>(i)) > 1) ||
+            ((operands[i].components.size() == 1) && (size > 1)))
+            makeSimple(operands[i]);
+    }
+
+    Value result;
+    TVector<const TString*> arguments(operands.size());
+    for (size_t k = 0; k < size; ++k)
+    {
+        for (size_t i = 0; i < operands.size(); ++i)
+        {
+            const TVector<TString>& components = operands[i].components;
+            arguments[i] = &components[components.size() == 1 ? 0 : k];
+        }
+        result.components.push_back(Substitute(pattern, arguments));
+    }
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::componentWise(const char* pattern, Value operand)
+{
+    TVector<Value> operands;
+    operands.push_back(operand);
+    return componentWise(pattern, operands);
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::componentWise(const char* pattern, Value left,
+                                                              Value right)
+{
+    TVector<Value> operands;
+    operands.push_back(left);
+    operands.push_back(right);
+    return componentWise(pattern, operands);
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::convert(const Value& value, TBasicType from,
+                                                        TBasicType to)
+{
+    if ((from == to) || ((from == EbtInt) && (to == EbtFloat)))
+        return value;
+
+    switch (to)
+    {
+        case EbtBool:
+            return componentWise("(%0 !== 0)", value);
+        case EbtInt:
+            return componentWise(from == EbtBool ? "(%0 ? 1 : 0)" : "(%0 | 0)", value);
+        default:
+            ASSERT(from == EbtBool);
+            return componentWise("(%0 ? 1.0 : 0.0)", value);
+    }
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::arithmetic(TOperator op, Value left, Value right,
+                                                           const TType& leftType,
+                                                           const TType& rightType)
+{
+    switch (op)
+    {
+        case EOpAdd:
+            return componentWise("(%0 + %1)", left, right);
+        case EOpSub:
+            return componentWise("(%0 - %1)", left, right);
+        case EOpMul:
+        case EOpVectorTimesScalar:
+        case EOpMatrixTimesScalar:
+            return componentWise("(%0 * %1)", left, right);
+        case EOpDiv:
+            return componentWise(leftType.getBasicType() == EbtInt ? "((%0 / %1) | 0)" :
+                                                                     "(%0 / %1)",
+                                 left, right);
+        default:
+            break;
+    }
+
+    // Linear algebra products use every component several times.
+    makeSimple(left);
+    makeSimple(right);
+    Value result;
+    switch (op)
+    {
+        case EOpVectorTimesMatrix: {
+            int size = rightType.getNominalSize();
+            for (int column = 0; column < size; ++column)
+            {
+                TVector<TString> products;
+                for (int row = 0; row < size; ++row)
+                    products.push_back(left.components[row] + " * " +
+                                       right.components[column * size + row]);
+                result.components.push_back("(" + Join(products, " + ") + ")");
+            }
+            break;
+        }
+        case EOpMatrixTimesVector: {
+            int size = leftType.getNominalSize();
+            for (int row = 0; row < size; ++row)
+            {
+                TVector<TString> products;
+                for (int column = 0; column < size; ++column)
+                    products.push_back(left.components[column * size + row] + " * " +
+                                       right.components[column]);
+                result.components.push_back("(" + Join(products, " + ") + ")");
+            }
+            break;
+        }
+        case EOpMatrixTimesMatrix: {
+            int size = leftType.getNominalSize();
+            for (int column = 0; column < size; ++column)
+            {
+                for (int row = 0; row < size; ++row)
+                {
+                    TVector<TString> products;
+                    for (int k = 0; k < size; ++k)
+                        products.push_back(left.components[k * size + row] + " * " +
+                                           right.components[column * size + k]);
+                    result.components.push_back("(" + Join(products, " + ") + ")");
+                }
+            }
+            break;
+        }
+        default:
+            UNREACHABLE();
+            break;
+    }
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::dot(Value left, Value right)
+{
+    TVector<TString> products;
+    for (size_t i = 0; i < left.components.size(); ++i)
+        products.push_back(left.components[i] + " * " + right.components[i]);
+    Value result;
+    result.components.push_back("(" + Join(products, " + ") + ")");
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::equal(const Value& left, const Value& right,
+                                                      const TType& type, bool notEqual)
+{
+    TString comparison;
+    if (IsComposite(type))
+    {
+        comparison = equalStorage(type, left.reference, right.reference);
+    }
+    else
+    {
+        TVector<TString> comparisons;
+        for (size_t i = 0; i < left.components.size(); ++i)
+            comparisons.push_back(left.components[i] + " === " + right.components[i]);
+        comparison = Join(comparisons, " && ");
+    }
+
+    Value result;
+    result.components.push_back(notEqual ? "!(" + comparison + ")" : "(" + comparison + ")");
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateExpression(TIntermTyped* node)
+{
+    if (TIntermSymbol* symbol = node->getAsSymbolNode())
+        return translateSymbol(symbol);
+    if (TIntermConstantUnion* constant = node->getAsConstantUnion())
+        return translateConstant(constant);
+    if (TIntermBinary* binary = node->getAsBinaryNode())
+        return translateBinary(binary);
+    if (TIntermUnary* unary = node->getAsUnaryNode())
+        return translateUnary(unary, true);
+    if (TIntermSelection* selection = node->getAsSelectionNode())
+        return translateTernary(selection);
+    if (TIntermAggregate* aggregate = node->getAsAggregate())
+        return translateAggregate(aggregate);
+    UNREACHABLE();
+    return Value();
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateNested(TIntermTyped* node,
+                                                                TVector<TString>& statements)
+{
+    TVector<TString>* enclosing = mStatements;
+    mStatements = &statements;
+    Value value = translateExpression(node);
+    mStatements = enclosing;
+    return value;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateSymbol(TIntermSymbol* node)
+{
+    const TType& type = node->getType();
+    bool boxed = IsInterface(type.getQualifier());
+    // Built-in variables are used without being declared.
+    if (boxed)
+        declareModuleVariable(node);
+    return storageValue(type, variableName(node), boxed);
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateConstant(TIntermConstantUnion* node)
+{
+    const TType& type = node->getType();
+    const ConstantUnion* constant = node->getUnionArrayPointer();
+    Value value;
+    if (type.getBasicType() == EbtStruct)
+    {
+        value.reference = newTemporary();
+        mDeclarations.push_back("var " + value.reference + " = " +
+                                constantLiteral(type, constant) + ";");
+        return value;
+    }
+
+    for (int i = 0; i < type.getObjectSize(); ++i)
+        value.components.push_back(ComponentLiteral(constant[i], type.getBasicType()));
+    return value;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateBinary(TIntermBinary* node)
+{
+    TIntermTyped* left = node->getLeft();
+    TIntermTyped* right = node->getRight();
+    switch (node->getOp())
+    {
+        case EOpInitialize:
+        case EOpAssign:
+        case EOpAddAssign:
+        case EOpSubAssign:
+        case EOpMulAssign:
+        case EOpVectorTimesMatrixAssign:
+        case EOpVectorTimesScalarAssign:
+        case EOpMatrixTimesScalarAssign:
+        case EOpMatrixTimesMatrixAssign:
+        case EOpDivAssign:
+            return translateAssignment(node);
+        case EOpIndexDirect:
+        case EOpIndexIndirect:
+        case EOpIndexDirectStruct:
+            return translateIndex(node);
+        case EOpVectorSwizzle: {
+            Value vector = translateExpression(left);
+            Value result;
+            const TIntermSequence& offsets = right->getAsAggregate()->getSequence();
+            for (TIntermSequence::const_iterator iter = offsets.begin(); iter != offsets.end(); ++iter)
+            {
+                int offset = (*iter)->getAsConstantUnion()->getUnionArrayPointer()->getIConst();
+                result.components.push_back(vector.components[offset]);
+            }
+            return result;
+        }
+        case EOpLogicalAnd:
+        case EOpLogicalOr:
+            return translateLogical(node);
+        default:
+            break;
+    }
+
+    TIntermSequence operands;
+    operands.push_back(left);
+    operands.push_back(right);
+    TVector<Value> values;
+    translateOperands(operands, TVector<bool>(), values);
+    switch (node->getOp())
+    {
+        case EOpEqual: return equal(values[0], values[1], left->getType(), false);
+        case EOpNotEqual: return equal(values[0], values[1], left->getType(), true);
+        case EOpLessThan: return componentWise("(%0 < %1)", values);
+        case EOpGreaterThan: return componentWise("(%0 > %1)", values);
+        case EOpLessThanEqual: return componentWise("(%0 <= %1)", values);
+        case EOpGreaterThanEqual: return componentWise("(%0 >= %1)", values);
+        case EOpLogicalXor: return componentWise("(%0 !== %1)", values);
+        default:
+            return arithmetic(node->getOp(), values[0], values[1],
+                              left->getType(), right->getType());
+    }
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateIndex(TIntermBinary* node)
+{
+    const TType& type = node->getLeft()->getType();
+    Value base = translateExpression(node->getLeft());
+    if (node->getOp() == EOpIndexDirectStruct)
+    {
+        const TType& fieldType = node->getType();
+        return storageValue(fieldType, base.reference + "." + fieldType.getFieldName(), false);
+    }
+
+    // Dynamic indices are saved so that l-values keep pointing to the same
+    // element.
+    int constant = 0;
+    TString dynamic;
+    if (TIntermConstantUnion* index = node->getRight()->getAsConstantUnion())
+    {
+        constant = index->getUnionArrayPointer()->getIConst();
+    }
+    else
+    {
+        dynamic = translateExpression(node->getRight()).components.front();
+        if (!IsLiteral(dynamic) && !IsTemporary(dynamic))
+            dynamic = declareTemporary(dynamic);
+    }
+
+    Value result;
+    if (type.isArray() && (type.getBasicType() == EbtStruct))
+    {
+        result.reference = base.reference + "[" + (dynamic.empty() ? Str(constant) : dynamic) + "]";
+        return result;
+    }
+
+    int stride = type.isArray() ? node->getType().getObjectSize() :
+                 type.isMatrix() ? type.getNominalSize() : 1;
+    if (base.reference.empty())
+    {
+        if (dynamic.empty())
+        {
+            result.components.assign(base.components.begin() + constant * stride,
+                                     base.components.begin() + (constant + 1) * stride);
+            return result;
+        }
+        materialize(base);
+    }
+
+    result.reference = base.reference;
+    result.offset = base.offset;
+    if (!dynamic.empty())
+    {
+        TString scaled = stride == 1 ? dynamic : dynamic + " * " + Str(stride);
+        result.offset = result.offset.empty() ? scaled : result.offset + " + " + scaled;
+    }
+    result.base = base.base + constant * stride;
+    loadComponents(result, stride);
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateAssignment(TIntermBinary* node)
+{
+    TIntermSequence operands;
+    operands.push_back(node->getLeft());
+    operands.push_back(node->getRight());
+    TVector<Value> values;
+    TVector<bool> targets;
+    targets.push_back(true);
+    translateOperands(operands, targets, values);
+
+    const TType& leftType = node->getLeft()->getType();
+    const TType& rightType = node->getRight()->getType();
+    Value& target = values[0];
+    Value value = values[1];
+    TOperator op = EOpNull;
+    switch (node->getOp())
+    {
+        case EOpAddAssign: op = EOpAdd; break;
+        case EOpSubAssign: op = EOpSub; break;
+        case EOpMulAssign: op = EOpMul; break;
+        case EOpDivAssign: op = EOpDiv; break;
+        case EOpVectorTimesMatrixAssign: op = EOpVectorTimesMatrix; break;
+        case EOpVectorTimesScalarAssign: op = EOpVectorTimesScalar; break;
+        case EOpMatrixTimesScalarAssign: op = EOpMatrixTimesScalar; break;
+        case EOpMatrixTimesMatrixAssign: op = EOpMatrixTimesMatrix; break;
+        default: break;
+    }
+    if (op != EOpNull)
+        value = arithmetic(op, target, value, leftType, rightType);
+
+    store(target, value, leftType);
+    return target;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateLogical(TIntermBinary* node)
+{
+    bool isAnd = node->getOp() == EOpLogicalAnd;
+    Value left = translateExpression(node->getLeft());
+    TVector<TString> statements;
+    Value right = translateNested(node->getRight(), statements);
+
+    Value result;
+    if (statements.empty())
+    {
+        result.components.push_back("(" + left.components.front() + (isAnd ? " && " : " || ") +
+                                    right.components.front() + ")");
+        return result;
+    }
+
+    // The right operand is only evaluated if the left one does not decide
+    // the result.
+    TString name = declareTemporary(left.components.front());
+    statements.push_back(name + " = " + StripParentheses(right.components.front()) + ";");
+    TString text = (isAnd ? "if (" : "if (!") + name + ") ";
+    AppendBlock(text, statements);
+    mStatements->push_back(text);
+    result.components.push_back(name);
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateUnary(TIntermUnary* node, bool valueUsed)
+{
+    TIntermTyped* operand = node->getOperand();
+    bool isInt = operand->getBasicType() == EbtInt;
+    switch (node->getOp())
+    {
+        case EOpPostIncrement:
+        case EOpPostDecrement:
+        case EOpPreIncrement:
+        case EOpPreDecrement: {
+            bool post = (node->getOp() == EOpPostIncrement) ||
+                        (node->getOp() == EOpPostDecrement);
+            bool increment = (node->getOp() == EOpPostIncrement) ||
+                             (node->getOp() == EOpPreIncrement);
+            Value target = translateExpression(operand);
+            Value result = target;
+            if (post && valueUsed)
+                saveValue(result, mStatements->size());
+            const char* pattern = increment ? (isInt ? "(%0 + 1)" : "(%0 + 1.0)") :
+                                              (isInt ? "(%0 - 1)" : "(%0 - 1.0)");
+            store(target, componentWise(pattern, target), operand->getType());
+            return result;
+        }
+        default:
+            break;
+    }
+
+    Value value = translateExpression(operand);
+    const char* pattern = NULL;
+    switch (node->getOp())
+    {
+        case EOpNegative: pattern = "(-%0)"; break;
+        case EOpVectorLogicalNot:
+        case EOpLogicalNot: pattern = "(!%0)"; break;
+
+        case EOpConvIntToBool:
+        case EOpConvFloatToBool:
+        case EOpConvBoolToFloat:
+        case EOpConvIntToFloat:
+        case EOpConvFloatToInt:
+        case EOpConvBoolToInt:
+            return convert(value, operand->getBasicType(), node->getBasicType());
+
+        case EOpRadians: pattern = "(%0 * 0.017453292519943295)"; break;
+        case EOpDegrees: pattern = "(%0 * 57.29577951308232)"; break;
+        case EOpSin: pattern = "Math.sin(%0)"; break;
+        case EOpCos: pattern = "Math.cos(%0)"; break;
+        case EOpTan: pattern = "Math.tan(%0)"; break;
+        case EOpAsin: pattern = "Math.asin(%0)"; break;
+        case EOpAcos: pattern = "Math.acos(%0)"; break;
+        case EOpAtan: pattern = "Math.atan(%0)"; break;
+
+        case EOpExp: pattern = "Math.exp(%0)"; break;
+        case EOpLog: pattern = "Math.log(%0)"; break;
+        case EOpExp2: pattern = "Math.pow(2.0, %0)"; break;
+        case EOpLog2: pattern = "(Math.log(%0) * 1.4426950408889634)"; break;
+        case EOpSqrt: pattern = "Math.sqrt(%0)"; break;
+        case EOpInverseSqrt: pattern = "(1.0 / Math.sqrt(%0))"; break;
+
+        case EOpAbs: pattern = "Math.abs(%0)"; break;
+        case EOpSign: pattern = "(%0 > 0.0 ? 1.0 : (%0 < 0.0 ? -1.0 : 0.0))"; break;
+        case EOpFloor: pattern = "Math.floor(%0)"; break;
+        case EOpCeil: pattern = "Math.ceil(%0)"; break;
+        case EOpFract: pattern = "(%0 - Math.floor(%0))"; break;
+
+        case EOpLength: {
+            makeSimple(value);
+            Value result = dot(value, value);
+            result.components.front() = "Math.sqrt" + result.components.front();
+            return result;
+        }
+        case EOpNormalize: {
+            makeSimple(value);
+            TString length = declareTemporary("Math.sqrt" + dot(value, value).components.front());
+            return componentWise(("(%0 / " + length + ")").c_str(), value);
+        }
+
+        // Neighboring fragments are not available.
+        case EOpDFdx:
+        case EOpDFdy:
+        case EOpFwidth: pattern = "0.0"; break;
+
+        case EOpAny: {
+            Value result;
+            result.components.push_back("(" + Join(value.components, " || ") + ")");
+            return result;
+        }
+        case EOpAll: {
+            Value result;
+            result.components.push_back("(" + Join(value.components, " && ") + ")");
+            return result;
+        }
+
+        default: UNREACHABLE(); break;
+    }
+    return componentWise(pattern, value);
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateTernary(TIntermSelection* node)
+{
+    const TType& type = node->getType();
+    TString condition =
+        translateExpression(node->getCondition()->getAsTyped()).components.front();
+    TVector<TString> trueStatements, falseStatements;
+    Value trueValue = translateNested(node->getTrueBlock()->getAsTyped(), trueStatements);
+    Value falseValue = translateNested(node->getFalseBlock()->getAsTyped(), falseStatements);
+
+    Value result;
+    if (trueStatements.empty() && falseStatements.empty())
+    {
+        if (IsComposite(type))
+        {
+            result.reference = "(" + condition + " ? " + trueValue.reference + " : " +
+                               falseValue.reference + ")";
+            return result;
+        }
+        if ((trueValue.components.size() > 1) && !IsSimple(condition))
+            condition = declareTemporary(condition);
+        for (size_t i = 0; i < trueValue.components.size(); ++i)
+        {
+            result.components.push_back("(" + condition + " ? " + trueValue.components[i] +
+                                        " : " + falseValue.components[i] + ")");
+        }
+        return result;
+    }
+
+    // Only the selected operand is evaluated.
+    if (IsComposite(type))
+    {
+        result.reference = newTemporary();
+        mDeclarations.push_back("var " + result.reference + " = " + newStorage(type) + ";");
+        trueStatements.push_back(copyStorage(type, result.reference, trueValue.reference));
+        falseStatements.push_back(copyStorage(type, result.reference, falseValue.reference));
+    }
+    else
+    {
+        for (size_t i = 0; i < trueValue.components.size(); ++i)
+            result.components.push_back(newTemporary());
+        mStatements->push_back("var " + Join(result.components, ", ") + ";");
+        for (size_t i = 0; i < result.components.size(); ++i)
+        {
+            trueStatements.push_back(result.components[i] + " = " +
+                                     StripParentheses(trueValue.components[i]) + ";");
+            falseStatements.push_back(result.components[i] + " = " +
+                                      StripParentheses(falseValue.components[i]) + ";");
+        }
+    }
+    TString text = "if (" + StripParentheses(condition) + ") ";
+    AppendBlock(text, trueStatements);
+    text += " else ";
+    AppendBlock(text, falseStatements);
+    mStatements->push_back(text);
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateAggregate(TIntermAggregate* node)
+{
+    switch (node->getOp())
+    {
+        case EOpFunctionCall:
+            return translateCall(node);
+        case EOpComma: {
+            const TIntermSequence& sequence = node->getSequence();
+            for (size_t i = 0; i + 1 < sequence.size(); ++i)
+                translateStatement(sequence[i]);
+            return translateExpression(sequence.back()->getAsTyped());
+        }
+        case EOpConstructFloat:
+        case EOpConstructVec2:
+        case EOpConstructVec3:
+        case EOpConstructVec4:
+        case EOpConstructBool:
+        case EOpConstructBVec2:
+        case EOpConstructBVec3:
+        case EOpConstructBVec4:
+        case EOpConstructInt:
+        case EOpConstructIVec2:
+        case EOpConstructIVec3:
+        case EOpConstructIVec4:
+        case EOpConstructMat2:
+        case EOpConstructMat3:
+        case EOpConstructMat4:
+        case EOpConstructStruct:
+            return translateConstructor(node);
+        default:
+            return translateBuiltIn(node);
+    }
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateConstructor(TIntermAggregate* node)
+{
+    const TType& type = node->getType();
+    const TIntermSequence& arguments = node->getSequence();
+    TVector<Value> values;
+    translateOperands(arguments, TVector<bool>(), values);
+
+    Value result;
+    if (node->getOp() == EOpConstructStruct)
+    {
+        result.reference = newTemporary();
+        mDeclarations.push_back("var " + result.reference + " = " + newStorage(type) + ";");
+        const TTypeList* structure = type.getStruct();
+        for (size_t i = 0; i < structure->size(); ++i)
+        {
+            const TType& field = *(*structure)[i].type;
+            store(storageValue(field, result.reference + "." + field.getFieldName(), false),
+                  values[i], field);
+        }
+        return result;
+    }
+
+    TBasicType basicType = type.getBasicType();
+    Value components;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        Value converted = convert(values[i], arguments[i]->getAsTyped()->getBasicType(), basicType);
+        components.components.insert(components.components.end(),
+                                     converted.components.begin(), converted.components.end());
+    }
+
+    int size = type.getObjectSize();
+    const TType& firstType = arguments.front()->getAsTyped()->getType();
+    if (type.isMatrix() && (values.size() == 1) && (firstType.isScalar() || firstType.isMatrix()))
+    {
+        // A scalar sets the diagonal; a matrix sets the upper-left corner of
+        // an identity matrix.
+        int size = type.getNominalSize();
+        int argumentSize = firstType.isMatrix() ? firstType.getNominalSize() : 0;
+        makeSimple(components);
+        for (int column = 0; column < size; ++column)
+        {
+            for (int row = 0; row < size; ++row)
+            {
+                if ((column < argumentSize) && (row < argumentSize))
+                    result.components.push_back(components.components[column * argumentSize + row]);
+                else if (row != column)
+                    result.components.push_back("0.0");
+                else
+                    result.components.push_back(argumentSize > 0 ? "1.0" : components.components.front());
+            }
+        }
+        return result;
+    }
+    if ((components.components.size() == 1) && (size > 1))
+    {
+        makeSimple(components);
+        result.components.assign(size, components.components.front());
+        return result;
+    }
+    result.components.assign(components.components.begin(), components.components.begin() + size);
+    return result;
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateBuiltIn(TIntermAggregate* node)
+{
+    TVector<Value> values;
+    translateOperands(node->getSequence(), TVector<bool>(), values);
+
+    const char* pattern = NULL;
+    switch (node->getOp())
+    {
+        case EOpLessThan: pattern = "(%0 < %1)"; break;
+        case EOpGreaterThan: pattern = "(%0 > %1)"; break;
+        case EOpLessThanEqual: pattern = "(%0 <= %1)"; break;
+        case EOpGreaterThanEqual: pattern = "(%0 >= %1)"; break;
+        case EOpVectorEqual: pattern = "(%0 === %1)"; break;
+        case EOpVectorNotEqual: pattern = "(%0 !== %1)"; break;
+
+        case EOpMod: pattern = "(%0 - %1 * Math.floor(%0 / %1))"; break;
+        case EOpPow: pattern = "Math.pow(%0, %1)"; break;
+        case EOpAtan: pattern = "Math.atan2(%0, %1)"; break;
+        case EOpMin: pattern = "Math.min(%0, %1)"; break;
+        case EOpMax: pattern = "Math.max(%0, %1)"; break;
+        case EOpClamp: pattern = "Math.min(Math.max(%0, %1), %2)"; break;
+        case EOpMix: pattern = "(%0 + (%1 - %0) * %2)"; break;
+        case EOpStep: pattern = "(%1 < %0 ? 0.0 : 1.0)"; break;
+        case EOpSmoothStep: {
+            Value t = componentWise("Math.min(Math.max((%2 - %0) / (%1 - %0), 0.0), 1.0)", values);
+            return componentWise("(%0 * %0 * (3.0 - 2.0 * %0))", t);
+        }
+        case EOpMul: pattern = "(%0 * %1)"; break;
+
+        case EOpDot:
+            return dot(values[0], values[1]);
+        case EOpDistance: {
+            Value difference = componentWise("(%0 - %1)", values);
+            makeSimple(difference);
+            Value result = dot(difference, difference);
+            result.components.front() = "Math.sqrt" + result.components.front();
+            return result;
+        }
+        case EOpCross: {
+            makeSimple(values[0]);
+            makeSimple(values[1]);
+            const TVector<TString>& a = values[0].components;
+            const TVector<TString>& b = values[1].components;
+            Value result;
+            result.components.push_back("(" + a[1] + " * " + b[2] + " - " + a[2] + " * " + b[1] + ")");
+            result.components.push_back("(" + a[2] + " * " + b[0] + " - " + a[0] + " * " + b[2] + ")");
+            result.components.push_back("(" + a[0] + " * " + b[1] + " - " + a[1] + " * " + b[0] + ")");
+            return result;
+        }
+        case EOpFaceForward: {
+            TString facing = declareTemporary(dot(values[2], values[1]).components.front() + " < 0.0");
+            return componentWise(("(" + facing + " ? %0 : -%0)").c_str(), values[0]);
+        }
+        case EOpReflect: {
+            TString d = declareTemporary(dot(values[1], values[0]).components.front());
+            return componentWise(("(%0 - 2.0 * " + d + " * %1)").c_str(), values[0], values[1]);
+        }
+        case EOpRefract: {
+            makeSimple(values[2]);
+            const TString& eta = values[2].components.front();
+            TString d = declareTemporary(dot(values[1], values[0]).components.front());
+            TString k = declareTemporary("1.0 - " + eta + " * " + eta + " * (1.0 - " + d + " * " + d + ")");
+            TString s = declareTemporary(eta + " * " + d + " + Math.sqrt(" + k + ")");
+            return componentWise(("(" + k + " < 0.0 ? 0.0 : %2 * %0 - " + s + " * %1)").c_str(), values);
+        }
+
+        default: UNREACHABLE(); break;
+    }
+    return componentWise(pattern, values);
+}
+
+TOutputJSExecutable::Value TOutputJSExecutable::translateCall(TIntermAggregate* node)
+{
+    const TIntermSequence& arguments = node->getSequence();
+    const TType& type = node->getType();
+    Value result;
+    if (!node->isUserDefined())
+    {
+        // Texture lookups are done by the runtime.
+        TVector<Value> values;
+        translateOperands(arguments, TVector<bool>(), values);
+        TVector<TString> components;
+        for (size_t i = 0; i < values.size(); ++i)
+            components.insert(components.end(), values[i].components.begin(), values[i].components.end());
+        TString lookup = declareTemporary(TString(kRuntime) + "." +
+                                          TFunction::unmangleName(node->getName()) + "(" +
+                                          Join(components, ", ") + ")");
+        if (IsPlainScalar(type))
+        {
+            result.components.push_back(lookup);
+            return result;
+        }
+        for (int i = 0; i < type.getObjectSize(); ++i)
+            result.components.push_back(declareTemporary(Element(lookup, "", i)));
+        return result;
+    }
+
+    FunctionMap::const_iterator iter = mFunctionMap.find(node->getName());
+    ASSERT(iter != mFunctionMap.end());
+    const FunctionInfo& function = iter->second;
+    const TIntermSequence& parameters = function.parameters->getSequence();
+
+    TVector<bool> targets;
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        TQualifier qualifier = parameters[i]->getAsTyped()->getQualifier();
+        targets.push_back((qualifier == EvqOut) || (qualifier == EvqInOut));
+    }
+    TVector<Value> values;
+    translateOperands(arguments, targets, values);
+
+    TVector<TString> passed;
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        const TType& parameterType = parameters[i]->getAsTyped()->getType();
+        if (parameterType.getQualifier() == EvqOut)
+            continue;
+        if (IsComposite(parameterType))
+            passed.push_back(values[i].reference);
+        else
+            passed.insert(passed.end(), values[i].components.begin(), values[i].components.end());
+    }
+    TString call = function.name + "(" + Join(passed, ", ") + ")";
+
+    if (type.getBasicType() == EbtVoid)
+    {
+        mStatements->push_back(call + ";");
+    }
+    else if (IsPlainScalar(type))
+    {
+        result.components.push_back(declareTemporary(call));
+    }
+    else
+    {
+        // The result is copied before another call overwrites it.
+        mStatements->push_back(call + ";");
+        if (IsComposite(type))
+        {
+            result.reference = newTemporary();
+            mDeclarations.push_back("var " + result.reference + " = " + newStorage(type) + ";");
+            mStatements->push_back(copyStorage(type, result.reference, function.resultName));
+        }
+        else
+        {
+            Value stored = storageValue(type, function.resultName, false);
+            for (size_t i = 0; i < stored.components.size(); ++i)
+                result.components.push_back(declareTemporary(stored.components[i]));
+        }
+    }
+
+    // Copy the out parameters back to the arguments.
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        if (!targets[i])
+            continue;
+        TIntermSymbol* parameter = parameters[i]->getAsSymbolNode();
+        const TType& parameterType = parameter->getType();
+        store(values[i], storageValue(parameterType, variableName(parameter), false), parameterType);
+    }
+    return result;
+}
+
+void TOutputJSExecutable::translateStatement(TIntermNode* node)
+{
+    if (TIntermAggregate* aggregate = node->getAsAggregate())
+    {
+        if (aggregate->getOp() == EOpSequence)
+        {
+            const TIntermSequence& sequence = aggregate->getSequence();
+            for (TIntermSequence::const_iterator iter = sequence.begin(); iter != sequence.end(); ++iter)
+                translateStatement(*iter);
+            return;
+        }
+        if (aggregate->getOp() == EOpDeclaration)
+        {
+            translateDeclaration(aggregate, false);
+            return;
+        }
+    }
+    TIntermSelection* selection = node->getAsSelectionNode();
+    if (selection && !selection->usesTernaryOperator())
+    {
+        translateSelection(selection);
+        return;
+    }
+    if (TIntermLoop* loop = node->getAsLoopNode())
+    {
+        translateLoop(loop);
+        return;
+    }
+    if (TIntermBranch* branch = node->getAsBranchNode())
+    {
+        translateBranch(branch);
+        return;
+    }
+
+    // The value of an expression statement is not used, so only the
+    // statements that compute it remain.
+    if (TIntermUnary* unary = node->getAsUnaryNode())
+        translateUnary(unary, false);
+    else
+        translateExpression(node->getAsTyped());
+}
+
+void TOutputJSExecutable::translateBlock(TIntermNode* node, TVector<TString>& statements)
+{
+    TVector<TString>* enclosing = mStatements;
+    mStatements = &statements;
+    if (node)
+        translateStatement(node);
+    mStatements = enclosing;
+}
+
+void TOutputJSExecutable::translateDeclaration(TIntermAggregate* node, bool global)
+{
+    const TIntermSequence& sequence = node->getSequence();
+    for (TIntermSequence::const_iterator iter = sequence.begin(); iter != sequence.end(); ++iter)
+    {
+        TIntermSymbol* symbol = (*iter)->getAsSymbolNode();
+        TIntermTyped* initializer = NULL;
+        TIntermBinary* binary = (*iter)->getAsBinaryNode();
+        if (binary && (binary->getOp() == EOpInitialize))
+        {
+            symbol = binary->getLeft()->getAsSymbolNode();
+            initializer = binary->getRight();
+        }
+        // Struct definitions without variables and invariant declarations
+        // have nothing to store.
+        if (!symbol || symbol->getSymbol().empty() ||
+            (symbol->getBasicType() == EbtInvariant))
+            continue;
+        declareVariable(symbol, initializer, global);
+    }
+}
+
+void TOutputJSExecutable::translateSelection(TIntermSelection* node)
+{
+    TString condition =
+        translateExpression(node->getCondition()->getAsTyped()).components.front();
+    TVector<TString> trueStatements, falseStatements;
+    translateBlock(node->getTrueBlock(), trueStatements);
+
+    TString text = "if (" + StripParentheses(condition) + ") ";
+    AppendBlock(text, trueStatements);
+    if (node->getFalseBlock())
+    {
+        translateBlock(node->getFalseBlock(), falseStatements);
+        text += " else ";
+        AppendBlock(text, falseStatements);
+    }
+    mStatements->push_back(text);
+}
+
+void TOutputJSExecutable::translateLoop(TIntermLoop* node)
+{
+    // Loops are not unrolled; the loop index is an ordinary variable.
+    TLoopType loopType = node->getType();
+    if (node->getInit())
+        translateStatement(node->getInit());
+
+    TString condition;
+    TVector<TString> conditionStatements;
+    if (node->getCondition())
+    {
+        condition = StripParentheses(
+            translateNested(node->getCondition(), conditionStatements).components.front());
+    }
+    TVector<TString> updateStatements;
+    translateBlock(node->getExpression(), updateStatements);
+    bool mergeUpdate = IsExpressionList(updateStatements);
+
+    // Statements that must run before continuing to the next iteration
+    // follow the body, which continue statements leave with a break.
+    bool labeled = ((loopType == ELoopFor) && !mergeUpdate) ||
+                   ((loopType == ELoopDoWhile) && !conditionStatements.empty());
+    TString label = labeled ? newLabel() : "";
+    TVector<TString> body;
+    mContinueLabels.push_back(label);
+    translateBlock(node->getBody(), body);
+    mContinueLabels.pop_back();
+
+    TVector<TString> statements;
+    if ((loopType != ELoopDoWhile) && !conditionStatements.empty())
+    {
+        statements = conditionStatements;
+        statements.push_back("if (!(" + condition + ")) break;");
+    }
+    if (labeled)
+    {
+        TString block = label + ": ";
+        AppendBlock(block, body);
+        statements.push_back(block);
+    }
+    else
+    {
+        statements.insert(statements.end(), body.begin(), body.end());
+    }
+
+    TString text;
+    switch (loopType)
+    {
+        case ELoopFor: {
+            TString update;
+            if (mergeUpdate)
+            {
+                for (size_t i = 0; i < updateStatements.size(); ++i)
+                {
+                    const TString& statement = updateStatements[i];
+                    update += (i > 0 ? ", " : "") + statement.substr(0, statement.size() - 1);
+                }
+            }
+            else
+            {
+                statements.insert(statements.end(), updateStatements.begin(), updateStatements.end());
+            }
+            text = "for (; " + (conditionStatements.empty() ? condition : "") + "; " + update + ") ";
+            AppendBlock(text, statements);
+            break;
+        }
+        case ELoopWhile:
+            text = conditionStatements.empty() ? "while (" + condition + ") " : "for (;;) ";
+            AppendBlock(text, statements);
+            break;
+        default:
+            ASSERT(loopType == ELoopDoWhile);
+            statements.insert(statements.end(), conditionStatements.begin(), conditionStatements.end());
+            text = "do ";
+            AppendBlock(text, statements);
+            text += " while (" + condition + ");";
+            break;
+    }
+    mStatements->push_back(text);
+}
+
+void TOutputJSExecutable::translateBranch(TIntermBranch* node)
+{
+    switch (node->getFlowOp())
+    {
+        case EOpKill:
+            mUsesDiscard = true;
+            mStatements->push_back("throw " + TString(kDiscard) + ";");
+            break;
+        case EOpBreak:
+            mStatements->push_back("break;");
+            break;
+        case EOpContinue: {
+            ASSERT(!mContinueLabels.empty());
+            const TString& label = mContinueLabels.back();
+            mStatements->push_back(label.empty() ? "continue;" : "break " + label + ";");
+            break;
+        }
+        case EOpReturn: {
+            ASSERT(mCurrentFunction != NULL);
+            if (node->getExpression())
+            {
+                Value value = translateExpression(node->getExpression());
+                const TType& type = *mCurrentFunction->returnType;
+                if (IsPlainScalar(type))
+                {
+                    mStatements->push_back("return " +
+                                           StripParentheses(value.components.front()) + ";");
+                    break;
+                }
+                store(storageValue(type, mCurrentFunction->resultName, false), value, type);
+            }
+            mStatements->push_back("return;");
+            break;
+        }
+        default:
+            UNREACHABLE();
+            break;
+    }
+}
+
+void TOutputJSExecutable::translateFunction(TIntermAggregate* node)
+{
+    FunctionMap::const_iterator iter = mFunctionMap.find(node->getName());
+    ASSERT(iter != mFunctionMap.end());
+    mCurrentFunction = &iter->second;
+
+    TVector<TString> statements;
+    TVector<TString>* enclosing = mStatements;
+    mStatements = &statements;
+
+    // Scalars are passed by value and vectors and matrices component by
+    // component. Everything else, and parameters that are copied back to
+    // the arguments, lives in storage of its own, which the caller reads
+    // after the call. Recursion is not allowed, so the storage is never in
+    // use by two calls at once.
+    TVector<TString> parameters;
+    const TIntermSequence& sequence = mCurrentFunction->parameters->getSequence();
+    for (TIntermSequence::const_iterator param = sequence.begin(); param != sequence.end(); ++param)
+    {
+        TIntermSymbol* symbol = (*param)->getAsSymbolNode();
+        const TType& type = symbol->getType();
+        TQualifier qualifier = type.getQualifier();
+        TString name = variableName(symbol);
+        if (IsPlainScalar(type) && (qualifier != EvqOut) && (qualifier != EvqInOut))
+        {
+            parameters.push_back(name);
+            continue;
+        }
+        declareModuleVariable(symbol);
+        if (qualifier == EvqOut)
+            continue;
+        if (IsPlainScalar(type) || IsComposite(type))
+        {
+            parameters.push_back(name + "_");
+            statements.push_back(copyStorage(type, name, name + "_"));
+            continue;
+        }
+        for (int i = 0; i < type.getObjectSize(); ++i)
+        {
+            TString component = name + "_" + Str(i);
+            parameters.push_back(component);
+            statements.push_back(Element(name, "", i) + " = " + component + ";");
+        }
+    }
+
+    const TIntermSequence& children = node->getSequence();
+    if (children.size() > 1)
+        translateStatement(children[1]);
+
+    TString text = "function " + mCurrentFunction->name + "(" + Join(parameters, ", ") + ") ";
+    AppendBlock(text, statements);
+    mFunctions.push_back(text);
+
+    mStatements = enclosing;
+    mCurrentFunction = NULL;
+}
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_OUTPUTJSEXECUTABLE_H_
+#define COMPILER_OUTPUTJSEXECUTABLE_H_
+
+//
+// Translates the intermediate tree into executable JavaScript.
+//
+// Unlike TOutputJS, which writes the tree as nested arrays to be interpreted
+// by a runtime, the output is the source of a factory function:
+//
+//   (function ($runtime) { ... return { uniforms: ..., main: ... }; })
+//
+// Calling the factory returns an object with the storage of the uniforms,
+// attributes, varyings and built-in variables, keyed by their names, and a
+// main function that runs the shader once. main returns false if the
+// fragment was discarded. Non-scalar variables are backed by Float32Array
+// and Int32Array storage, or plain arrays for booleans, allocated once when
+// the factory is called; scalars of the interface are stored in arrays of
+// one element so that they can be shared with the caller. Swizzles, index
+// expressions and built-in functions are resolved at translate time into
+// scalar JavaScript expressions, so the generated code does not allocate.
+//
+// Texture lookups are the only calls into the runtime: a call to a built-in
+// function such as texture2D(s, uv) becomes $runtime.texture2D(unit, u, v),
+// whose result must be an array of four components. Derivatives are not
+// available to code that runs one fragment at a time and evaluate to zero.
+//
+
+#include <map>
+#include <set>
+
+#include "compiler/InfoSink.h"
+#include "compiler/intermediate.h"
+
+class TOutputJSExecutable
+{
+public:
+    TOutputJSExecutable(TInfoSinkBase& objSink);
+
+    void output(TIntermNode* root);
+
+private:
+    // The value of an expression. Scalars, vectors and matrices have one
+    // JavaScript expression per component, in column-major order for
+    // matrices. Values read from storage also keep the array that holds
+    // them, with a dynamic and a constant offset, so that they can be
+    // indexed dynamically. Structs and arrays only have a reference to
+    // their storage.
+    struct Value
+    {
+        Value() : base(0) { }
+
+        TVector<TString> components;
+        TString reference;
+        TString offset;
+        int base;
+    };
+
+    struct FunctionInfo
+    {
+        TString name;
+        TString resultName;
+        TIntermAggregate* parameters;
+        const TType* returnType;
+    };
+    typedef std::map<TString, FunctionInfo> FunctionMap;
+
+    TString newTemporary();
+    TString declareTemporary(const TString& initializer);
+    TString newLabel();
+
+    TString variableName(const TIntermSymbol* symbol) const;
+    TString structName(const TType& type);
+    TString newStorage(const TType& type);
+    TString copyStorage(const TType& type, const TString& destination, const TString& source);
+    TString equalStorage(const TType& type, const TString& left, const TString& right);
+    TString constantLiteral(const TType& type, const ConstantUnion*& constant);
+
+    void declareModuleVariable(const TIntermSymbol* symbol);
+    void declareVariable(TIntermSymbol* symbol, TIntermTyped* initializer, bool global);
+
+    Value storageValue(const TType& type, const TString& name, bool boxed) const;
+    void loadComponents(Value& value, int count) const;
+    void makeSimple(Value& value);
+    void saveValue(Value& value, size_t position);
+    void materialize(Value& value);
+    void store(const Value& target, Value value, const TType& type);
+    void translateOperands(const TIntermSequence& operands, const TVector<bool>& targets,
+                           TVector<Value>& values);
+
+    Value componentWise(const char* pattern, TVector<Value>& operands);
+    Value componentWise(const char* pattern, Value operand);
+    Value componentWise(const char* pattern, Value left, Value right);
+    Value convert(const Value& value, TBasicType from, TBasicType to);
+    Value arithmetic(TOperator op, Value left, Value right,
+                     const TType& leftType, const TType& rightType);
+    Value dot(Value left, Value right);
+    Value equal(const Value& left, const Value& right, const TType& type, bool notEqual);
+
+    Value translateExpression(TIntermTyped* node);
+    Value translateNested(TIntermTyped* node, TVector<TString>& statements);
+    Value translateSymbol(TIntermSymbol* node);
+    Value translateConstant(TIntermConstantUnion* node);
+    Value translateBinary(TIntermBinary* node);
+    Value translateIndex(TIntermBinary* node);
+    Value translateAssignment(TIntermBinary* node);
+    Value translateLogical(TIntermBinary* node);
+    Value translateUnary(TIntermUnary* node, bool valueUsed);
+    Value translateTernary(TIntermSelection* node);
+    Value translateAggregate(TIntermAggregate* node);
+    Value translateConstructor(TIntermAggregate* node);
+    Value translateBuiltIn(TIntermAggregate* node);
+    Value translateCall(TIntermAggregate* node);
+
+    void translateStatement(TIntermNode* node);
+    void translateBlock(TIntermNode* node, TVector<TString>& statements);
+    void translateDeclaration(TIntermAggregate* node, bool global);
+    void translateSelection(TIntermSelection* node);
+    void translateLoop(TIntermLoop* node);
+    void translateBranch(TIntermBranch* node);
+    void translateFunction(TIntermAggregate* node);
+
+    TInfoSinkBase& mObjSink;
+
+    // Declarations of the variables that live as long as the program,
+    // helper functions, initializers of the global variables and
+    // translated functions, in output order.
+    TVector<TString> mDeclarations;
+    TVector<TString> mHelpers;
+    TVector<TString> mInitialization;
+    TVector<TString> mFunctions;
+
+    // Storage of the uniforms, attributes, varyings and built-in
+    // variables, returned by the factory.
+    TVector<TString> mUniforms;
+    TVector<TString> mAttributes;
+    TVector<TString> mVaryings;
+    TVector<TString> mBuiltIns;
+
+    std::set<int> mDeclaredVariables;
+    std::map<const TTypeList*, TString> mStructNames;
+    FunctionMap mFunctionMap;
+
+    // Statements of the block being translated. Expressions write the
+    // statements needed to compute their values here.
+    TVector<TString>* mStatements;
+    // Targets of continue statements in the enclosing loops. Loops that
+    // evaluate statements between iterations wrap their bodies in labeled
+    // blocks, and continue breaks out of the block.
+    TVector<TString> mContinueLabels;
+    const FunctionInfo* mCurrentFunction;
+    int mTemporaryCount;
+    int mLabelCount;
+    bool mUsesDiscard;
+};
+
+#endif  // COMPILER_OUTPUTJSEXECUTABLE_H_
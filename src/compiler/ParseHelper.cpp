@@ -1490,6 +1490,25 @@ bool TParseContext::structNestingErrorCheck(TSourceLoc line, const TType& fieldT
     return false;
 }
 
+TParseResources::TParseResources(TExtensionBehavior& ext, TInfoSink& is) :
+    diagnostics(is),
+    directiveHandler(ext, diagnostics),
+    preprocessor(&diagnostics, &directiveHandler),
+    scanner(NULL)
+{
+}
+
+TParseResources::~TParseResources()
+{
+    glslang_destroy(scanner);
+}
+
+void TParseResources::reset()
+{
+    diagnostics.reset();
+    directiveHandler.reset();
+}
+
 //
 // Parse an array of strings using yyparse.
 //
@@ -20,12 +20,34 @@ struct TMatrixFields {
     int col;
 };
 
+//
+// The preprocessor and the scanner of the parser. A compiler keeps them
+// from parse to parse, so that their tables and buffers stay allocated.
+//
+struct TParseResources {
+    TParseResources(TExtensionBehavior& ext, TInfoSink& is);
+    ~TParseResources();
+
+    // Prepares the diagnostics and directives for another parse. The
+    // preprocessor and the scanner start over when they get their input.
+    void reset();
+
+    TDiagnostics diagnostics;
+    TDirectiveHandler directiveHandler;
+    pp::Preprocessor preprocessor;
+    void* scanner;  // created by the first parse
+
+private:
+    TParseResources(const TParseResources&);
+    TParseResources& operator=(const TParseResources&);
+};
+
 //
 // The following are extra variables needed during parsing, grouped together so
 // they can be passed to the parser without needing a global.
 //
 struct TParseContext {
-    TParseContext(TSymbolTable& symt, TExtensionBehavior& ext, TIntermediate& interm, ShShaderType type, ShShaderSpec spec, int options, bool checksPrecErrors, const char* sourcePath, TInfoSink& is) :
+    TParseContext(TSymbolTable& symt, TIntermediate& interm, ShShaderType type, ShShaderSpec spec, int options, bool checksPrecErrors, const char* sourcePath, TParseResources& resources) :
             intermediate(interm),
             symbolTable(symt),
             shaderType(type),
@@ -40,11 +62,11 @@ struct TParseContext {
             currentFunctionType(NULL),
             functionReturnsValue(false),
             checksPrecisionErrors(checksPrecErrors),
-            diagnostics(is),
-            directiveHandler(ext, diagnostics),
-            preprocessor(&diagnostics, &directiveHandler),
-            scanner(NULL),
-            line(0) {  }
+            diagnostics(resources.diagnostics),
+            directiveHandler(resources.directiveHandler),
+            preprocessor(resources.preprocessor),
+            scanner(resources.scanner),
+            line(0) { resources.reset(); }
     TIntermediate& intermediate; // to hold and build a parse tree
     TSymbolTable& symbolTable;   // symbol table that goes with the language currently being parsed
     ShShaderType shaderType;              // vertex or fragment language (future: pack or unpack)
@@ -61,10 +83,10 @@ struct TParseContext {
     bool checksPrecisionErrors;  // true if an error will be generated when a variable is declared without precision, explicit or implicit.
     TString HashErrMsg;
     bool AfterEOF;
-    TDiagnostics diagnostics;
-    TDirectiveHandler directiveHandler;
-    pp::Preprocessor preprocessor;
-    void* scanner;
+    TDiagnostics& diagnostics;
+    TDirectiveHandler& directiveHandler;
+    pp::Preprocessor& preprocessor;
+    void*& scanner;
     TSourceLoc line;
 
     int numErrors() const { return diagnostics.numErrors(); }
@@ -12,6 +12,7 @@
 #include <stdio.h>
 
 #include "common/angleutils.h"
+#include "compiler/HeapProfile.h"
 #include "compiler/InitializeGlobals.h"
 #include "compiler/osinclude.h"
 
@@ -77,8 +78,16 @@ TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
     alignment(allocationAlignment),
     freeList(0),
     inUseList(0),
+    recycledClasses(0),
     numCalls(0),
-    totalBytes(0)
+    totalBytes(0),
+    usedBytes(0),
+    peakBytes(0),
+    budgetBytes(0),
+    sizeLimit(0),
+    deadline(0),
+    overSizeBudget(false),
+    overTimeBudget(false)
 {
     //
     // Don't allow page sizes we know are smaller than all common
@@ -114,6 +123,8 @@ TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
     if (headerSkip < sizeof(tHeader)) {
         headerSkip = (sizeof(tHeader) + alignmentMask) & ~alignmentMask;
     }
+
+    clearRecycledBlocks();
 }
 
 TPoolAllocator::~TPoolAllocator()
@@ -182,6 +193,12 @@ void TPoolAllocator::push()
     // Indicate there is no current page to allocate from.
     //
     currentPageOffset = pageSize;
+
+    //
+    // Memory recycled from before the push would not be freed by the
+    // matching pop.
+    //
+    clearRecycledBlocks();
 }
 
 //
@@ -204,6 +221,7 @@ void TPoolAllocator::pop()
         inUseList->~tHeader();
         
         tHeader* nextInUse = inUseList->nextPage;
+        usedBytes -= inUseList->pageCount * pageSize;
         if (inUseList->pageCount > 1)
             delete [] reinterpret_cast<char*>(inUseList);
         else {
@@ -214,6 +232,7 @@ void TPoolAllocator::pop()
     }
 
     stack.pop_back();
+    clearRecycledBlocks();
 }
 
 //
@@ -240,6 +259,25 @@ void* TPoolAllocator::allocate(size_t numBytes)
     //
     ++numCalls;
     totalBytes += numBytes;
+#ifdef ANGLE_HEAP_PROFILE
+    RecordPoolAllocation(numBytes);
+#endif
+
+    //
+    // Reuse a deallocated block of the smallest size class that fits.
+    //
+    if (recycledClasses != 0 && numBytes <= (alignment << (kSizeClassCount - 1))) {
+        int sizeClass = 0;
+        while ((alignment << sizeClass) < numBytes)
+            ++sizeClass;
+        if (recycledClasses & (1 << sizeClass)) {
+            void* memory = recycledBlocks[sizeClass];
+            recycledBlocks[sizeClass] = *reinterpret_cast<void**>(memory);
+            if (recycledBlocks[sizeClass] == 0)
+                recycledClasses &= ~(1 << sizeClass);
+            return memory;
+        }
+    }
 
     //
     // Do the allocation, most likely case first, for efficiency.
@@ -262,6 +300,7 @@ void* TPoolAllocator::allocate(size_t numBytes)
         // The OS is efficient and allocating and free-ing multiple pages.
         //
         size_t numBytesToAlloc = allocationSize + headerSkip;
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemPool);
         tHeader* memory = reinterpret_cast<tHeader*>(::new char[numBytesToAlloc]);
         if (memory == 0)
             return 0;
@@ -269,6 +308,7 @@ void* TPoolAllocator::allocate(size_t numBytes)
         // Use placement-new to initialize header
         new(memory) tHeader(inUseList, (numBytesToAlloc + pageSize - 1) / pageSize);
         inUseList = memory;
+        addUsedBytes(memory->pageCount * pageSize);
 
         currentPageOffset = pageSize;  // make next allocation come from a new page
 
@@ -284,6 +324,7 @@ void* TPoolAllocator::allocate(size_t numBytes)
         memory = freeList;
         freeList = freeList->nextPage;
     } else {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemPool);
         memory = reinterpret_cast<tHeader*>(::new char[pageSize]);
         if (memory == 0)
             return 0;
@@ -292,13 +333,87 @@ void* TPoolAllocator::allocate(size_t numBytes)
     // Use placement-new to initialize header
     new(memory) tHeader(inUseList, 1);
     inUseList = memory;
-    
+    addUsedBytes(pageSize);
+
     unsigned char* ret = reinterpret_cast<unsigned char *>(inUseList) + headerSkip;
     currentPageOffset = (headerSkip + allocationSize + alignmentMask) & ~alignmentMask;
 
     return initializeAllocation(inUseList, ret, numBytes);
 }
 
+void TPoolAllocator::deallocate(void* memory, size_t numBytes)
+{
+#ifdef GUARD_BLOCKS
+    //
+    // Allocations are tracked to check their guard blocks, and their
+    // memory is not reused.
+    //
+    return;
+#else
+    //
+    // The block must be able to hold the link of the free list.
+    //
+    if (memory == 0 || numBytes < alignment)
+        return;
+
+    //
+    // Other threads may free containers allocated from this pool, but
+    // only the thread allocating from it may modify the free lists.
+    //
+    TThreadGlobalPools* threadData = static_cast<TThreadGlobalPools*>(OS_GetTLSValue(PoolIndex));
+    if (threadData == 0 || threadData->globalPoolAllocator != this)
+        return;
+
+    //
+    // File the block under the largest size class it can hold.
+    //
+    int sizeClass = 0;
+    while (sizeClass + 1 < kSizeClassCount && (alignment << (sizeClass + 1)) <= numBytes)
+        ++sizeClass;
+    *reinterpret_cast<void**>(memory) = recycledBlocks[sizeClass];
+    recycledBlocks[sizeClass] = memory;
+    recycledClasses |= 1 << sizeClass;
+#endif
+}
+
+void TPoolAllocator::resetStatistics()
+{
+    numCalls = 0;
+    totalBytes = 0;
+    peakBytes = usedBytes;
+}
+
+void TPoolAllocator::setBudget(size_t maxBytes, double deadline)
+{
+    budgetBytes = maxBytes;
+    sizeLimit = maxBytes != 0 ? usedBytes + maxBytes : 0;
+    this->deadline = deadline;
+    overSizeBudget = false;
+    overTimeBudget = false;
+}
+
+bool TPoolAllocator::isOverTimeBudget()
+{
+    if (deadline != 0 && !overTimeBudget && OS_GetTimeMs() > deadline)
+        overTimeBudget = true;
+    return overTimeBudget;
+}
+
+void TPoolAllocator::addUsedBytes(size_t numBytes)
+{
+    usedBytes += numBytes;
+    if (usedBytes > peakBytes)
+        peakBytes = usedBytes;
+    if (sizeLimit != 0 && usedBytes > sizeLimit)
+        overSizeBudget = true;
+}
+
+void TPoolAllocator::clearRecycledBlocks()
+{
+    for (int i = 0; i < kSizeClassCount; ++i)
+        recycledBlocks[i] = 0;
+    recycledClasses = 0;
+}
 
 //
 // Check all allocations in a list for damage by calling check on each.
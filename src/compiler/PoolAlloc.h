@@ -113,9 +113,14 @@ private:
 // page size.  But, having it be about that size or equal to a set of 
 // pages is likely most optimal.
 //
+// Memory given back with deallocate(), like the buffers that growing
+// containers leave behind, is kept on a free list per size class, and
+// reused by the allocations of that size class until the next push() or
+// pop().  Size classes are powers of two times the alignment.
+//
 class TPoolAllocator {
 public:
-    TPoolAllocator(int growthIncrement = 8*1024, int allocationAlignment = 16);
+    TPoolAllocator(int growthIncrement = 32*1024, int allocationAlignment = 16);
 
     //
     // Don't call the destructor just to free up the memory, call pop()
@@ -146,11 +151,42 @@ public:
     void* allocate(size_t numBytes);
 
     //
-    // There is no deallocate.  The point of this class is that
-    // deallocation can be skipped by the user of it, as the model
-    // of use is to simultaneously deallocate everything at once
-    // by calling pop(), and to not have to solve memory leak problems.
+    // Call deallocate() to give back 'numBytes' of memory returned by
+    // allocate() for recycling.  It does not have to be called: the
+    // model of use is still to simultaneously deallocate everything at
+    // once by calling pop().  Memory is only recycled when the pool is the
+    // global pool of the calling thread, and never with guard blocks.
+    //
+    void deallocate(void* memory, size_t numBytes);
+
+    //
+    // Statistics since the pool was created or resetStatistics() called:
+    // the number of allocations, and the largest number of bytes of pages
+    // in use at once.
+    //
+    void resetStatistics();
+    int getAllocationCount() const { return numCalls; }
+    size_t getPeakSize() const { return peakBytes; }
+
+    //
+    // Call setBudget() to limit the bytes of pages the pool takes beyond
+    // those in use now to 'maxBytes', and the time to 'deadline', as
+    // returned by OS_GetTimeMs().  Zero means no limit.  Allocations past the
+    // budget still succeed, since their callers do not check for failure,
+    // but put the pool over budget until the next call to setBudget().
+    // Users of the pool call isOverBudget() where they can stop cleanly.
     //
+    void setBudget(size_t maxBytes, double deadline);
+    size_t getBudgetSize() const { return budgetBytes; }
+    double getDeadline() const { return deadline; }
+    bool isOverBudget() { return isOverSizeBudget() || isOverTimeBudget(); }
+    bool isOverSizeBudget() const { return overSizeBudget; }
+    bool isOverTimeBudget();
+
+    //
+    // Call exceedSizeBudget() when a pool given the same budget went over it.
+    //
+    void exceedSizeBudget() { overSizeBudget = true; }
 
 protected:
     friend struct tHeader;
@@ -194,6 +230,11 @@ protected:
         return TAllocation::offsetAllocation(memory);
     }
 
+    void addUsedBytes(size_t numBytes);
+    void clearRecycledBlocks();
+
+    static const int kSizeClassCount = 8;
+
     size_t pageSize;        // granularity of allocation from the OS
     size_t alignment;       // all returned allocations will be aligned at 
                             // this granularity, which will be a power of 2
@@ -205,9 +246,18 @@ protected:
     tHeader* freeList;      // list of popped memory
     tHeader* inUseList;     // list of all memory currently being used
     tAllocStack stack;      // stack of where to allocate from, to partition pool
+    void* recycledBlocks[kSizeClassCount];  // free list of each size class
+    unsigned int recycledClasses;  // mask of the size classes with free blocks
 
     int numCalls;           // just an interesting statistic
     size_t totalBytes;      // just an interesting statistic
+    size_t usedBytes;       // bytes of the pages in inUseList
+    size_t peakBytes;       // largest usedBytes
+    size_t budgetBytes;     // bytes of pages allowed by setBudget()
+    size_t sizeLimit;       // largest usedBytes within the budget, or 0
+    double deadline;        // time allowed by setBudget(), or 0
+    bool overSizeBudget;
+    bool overTimeBudget;
 private:
     TPoolAllocator& operator=(const TPoolAllocator&);  // dont allow assignment operator
     TPoolAllocator(const TPoolAllocator&);  // dont allow default copy constructor
@@ -276,7 +326,9 @@ public:
     void* allocate(size_type n, const void*) {
         return getAllocator().allocate(n);
     }
-    void deallocate(void*, size_type) {}
+    void deallocate(void* p, size_type n) {
+        getAllocator().deallocate(p, n);
+    }
 #else
     pointer allocate(size_type n) { 
         return reinterpret_cast<pointer>(getAllocator().allocate(n * sizeof(T)));
@@ -284,7 +336,9 @@ public:
     pointer allocate(size_type n, const void*) { 
         return reinterpret_cast<pointer>(getAllocator().allocate(n * sizeof(T)));
     }
-    void deallocate(pointer, size_type) {}
+    void deallocate(pointer p, size_type n) {
+        getAllocator().deallocate(p, n * sizeof(T));
+    }
 #endif  // _RWSTD_ALLOCATOR
 
     void construct(pointer p, const T& val) { new ((void *)p) T(val); }
@@ -0,0 +1,542 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/RemoveDeadCode.h"
+
+#include <map>
+
+#include "compiler/DetectRecursion.h"
+#include "compiler/IntermUtil.h"
+
+namespace {
+
+bool IsEmptySequence(TIntermNode* node)
+{
+    TIntermAggregate* aggregate = node ? node->getAsAggregate() : NULL;
+    return aggregate != NULL &&
+           aggregate->getOp() == EOpSequence &&
+           aggregate->getSequence().empty();
+}
+
+bool IsDeclaration(TIntermNode* node)
+{
+    TIntermAggregate* aggregate = node->getAsAggregate();
+    return aggregate != NULL && aggregate->getOp() == EOpDeclaration;
+}
+
+bool IsBlockWithoutDeclarations(TIntermNode* node)
+{
+    TIntermAggregate* aggregate = node->getAsAggregate();
+    if (aggregate == NULL || aggregate->getOp() != EOpSequence)
+        return false;
+    TIntermSequence& sequence = aggregate->getSequence();
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        if (IsDeclaration(sequence[i]))
+            return false;
+    }
+    return true;
+}
+
+// Returns the node that replaces an if-statement whose condition is a
+// constant, i.e. the branch that is always taken, which may be NULL.
+// Other nodes are returned unchanged.
+TIntermNode* FoldConstantSelection(TIntermNode* node)
+{
+    while (node != NULL) {
+        TIntermSelection* selection = node->getAsSelectionNode();
+        if (selection == NULL || selection->usesTernaryOperator())
+            break;
+        TIntermConstantUnion* condition =
+            selection->getCondition()->getAsConstantUnion();
+        if (condition == NULL || condition->getBasicType() != EbtBool)
+            break;
+        node = condition->getUnionArrayPointer()->getBConst() ?
+            selection->getTrueBlock() : selection->getFalseBlock();
+    }
+    return node;
+}
+
+// Removes the if-statements with constant conditions and the statements
+// that follow a return, break, continue or discard in the same block.
+// Nested blocks without declarations are merged into the enclosing block.
+class RemoveUnreachableStatements : public TIntermTraverser {
+public:
+    // Binary expressions contain no statements, but the fields selected by
+    // a swizzle are held in a sequence node.
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return false;
+    }
+
+    virtual bool visitSelection(Visit visit, TIntermSelection* node)
+    {
+        if (!node->usesTernaryOperator()) {
+            node->setTrueBlock(FoldConstantSelection(node->getTrueBlock()));
+            node->setFalseBlock(FoldConstantSelection(node->getFalseBlock()));
+        }
+        return true;
+    }
+
+    virtual bool visitLoop(Visit visit, TIntermLoop* node)
+    {
+        node->setBody(FoldConstantSelection(node->getBody()));
+        return true;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() != EOpSequence)
+            return true;
+
+        TIntermSequence& sequence = node->getSequence();
+        // Statements still to be processed, in reverse order.
+        TIntermSequence pending;
+        pending.insert(pending.end(), sequence.rbegin(), sequence.rend());
+        TIntermSequence statements;
+        while (!pending.empty()) {
+            TIntermNode* original = pending.back();
+            pending.pop_back();
+            TIntermNode* statement = FoldConstantSelection(original);
+            if (statement == NULL)
+                continue;
+            // The statements of a nested block, including the block of a
+            // taken branch, can be moved into this block unless they declare
+            // variables in the scope of the nested block.
+            if (IsBlockWithoutDeclarations(statement)) {
+                TIntermSequence& block = statement->getAsAggregate()->getSequence();
+                pending.insert(pending.end(), block.rbegin(), block.rend());
+                continue;
+            }
+            statements.push_back(statement);
+            if (statement->getAsBranchNode())
+                break;
+        }
+        sequence.swap(statements);
+        return true;
+    }
+};
+
+// Builds the mangled name of the function declared by the given prototype.
+// The name of a prototype node is not mangled, unlike the names of
+// function definition and function call nodes.
+TString GetMangledName(TIntermAggregate* prototype)
+{
+    TString name = prototype->getName() + "(";
+    TIntermSequence& params = prototype->getSequence();
+    for (size_t i = 0; i < params.size(); ++i) {
+        TType type = params[i]->getAsTyped()->getType();
+        name += type.getMangledName();
+    }
+    return name;
+}
+
+// Removes the functions and prototypes not reachable from main(). Returns
+// true if any was removed.
+bool RemoveUnreachableFunctions(TIntermAggregate* root)
+{
+    DetectRecursion callGraph;
+    root->traverse(&callGraph);
+
+    TIntermSequence& sequence = root->getSequence();
+    TIntermSequence globals;
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        TIntermAggregate* aggregate = sequence[i]->getAsAggregate();
+        if (aggregate != NULL) {
+            if (aggregate->getOp() == EOpFunction &&
+                !callGraph.isReachableFromMain(aggregate->getName()))
+                continue;
+            if (aggregate->getOp() == EOpPrototype &&
+                !callGraph.isReachableFromMain(GetMangledName(aggregate)))
+                continue;
+        }
+        globals.push_back(sequence[i]);
+    }
+    bool removed = globals.size() != sequence.size();
+    sequence.swap(globals);
+    return removed;
+}
+
+// Finds whether a function definition may do more than compute its return
+// value: write to an out or inout parameter or to a variable that is not
+// local, discard the fragment, or call a function that may.
+class FunctionSideEffectDetector : public TIntermTraverser {
+public:
+    FunctionSideEffectDetector(const TFunctionNameSet& pureFunctions)
+        : mPureFunctions(pureFunctions),
+          mHasSideEffects(false)
+    {
+    }
+
+    bool hasSideEffects() const { return mHasSideEffects; }
+
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        if (node->modifiesState())
+            write(node->getLeft());
+        return !mHasSideEffects;
+    }
+
+    virtual bool visitUnary(Visit visit, TIntermUnary* node)
+    {
+        if (node->modifiesState())
+            write(node->getOperand());
+        return !mHasSideEffects;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() == EOpParameters) {
+            TIntermSequence& params = node->getSequence();
+            for (size_t i = 0; i < params.size(); ++i) {
+                TQualifier qualifier = params[i]->getAsTyped()->getQualifier();
+                if (qualifier == EvqOut || qualifier == EvqInOut)
+                    mHasSideEffects = true;
+            }
+        } else if (node->getOp() == EOpFunctionCall && node->isUserDefined() &&
+                   mPureFunctions.find(node->getName()) == mPureFunctions.end()) {
+            mHasSideEffects = true;
+        }
+        return !mHasSideEffects;
+    }
+
+    virtual bool visitBranch(Visit visit, TIntermBranch* node)
+    {
+        if (node->getFlowOp() == EOpKill)
+            mHasSideEffects = true;
+        return !mHasSideEffects;
+    }
+
+private:
+    void write(TIntermTyped* node)
+    {
+        while (TIntermBinary* binary = node->getAsBinaryNode())
+            node = binary->getLeft();
+        TQualifier qualifier = node->getQualifier();
+        if (node->getAsSymbolNode() == NULL ||
+            (qualifier != EvqTemporary && qualifier != EvqIn))
+            mHasSideEffects = true;
+    }
+
+    const TFunctionNameSet& mPureFunctions;
+    bool mHasSideEffects;
+};
+
+// Collects the user-defined functions without side effects. Recursion has
+// been ruled out, so the definitions are checked again until no more are
+// found, by which time the callees of each function have been decided.
+void FindPureFunctions(TIntermAggregate* root, TFunctionNameSet* pureFunctions)
+{
+    TIntermSequence& sequence = root->getSequence();
+    bool found = true;
+    while (found) {
+        found = false;
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermAggregate* function = sequence[i]->getAsAggregate();
+            if (function == NULL || function->getOp() != EOpFunction ||
+                pureFunctions->find(function->getName()) != pureFunctions->end())
+                continue;
+            FunctionSideEffectDetector detector(*pureFunctions);
+            function->traverse(&detector);
+            if (!detector.hasSideEffects()) {
+                pureFunctions->insert(function->getName());
+                found = true;
+            }
+        }
+    }
+}
+
+// Returns the variable declared by one entry of a declaration statement,
+// and its initializer, if any.
+TIntermSymbol* GetDeclaredVariable(TIntermNode* declarator,
+                                   TIntermTyped** initializer)
+{
+    *initializer = NULL;
+    TIntermBinary* binary = declarator->getAsBinaryNode();
+    if (binary != NULL) {
+        if (binary->getOp() != EOpInitialize)
+            return NULL;
+        *initializer = binary->getRight();
+        return binary->getLeft()->getAsSymbolNode();
+    }
+    return declarator->getAsSymbolNode();
+}
+
+// Returns the variable assigned to if the node is a statement of the
+// form "variable = expression;".
+TIntermSymbol* GetAssignedVariable(TIntermNode* node,
+                                   TIntermTyped** expression)
+{
+    TIntermBinary* binary = node->getAsBinaryNode();
+    if (binary == NULL || binary->getOp() != EOpAssign)
+        return NULL;
+    *expression = binary->getRight();
+    return binary->getLeft()->getAsSymbolNode();
+}
+
+// Returns true if the node is an expression evaluated as a statement.
+bool IsExpressionStatement(TIntermNode* node)
+{
+    if (node->getAsTyped() == NULL)
+        return false;
+    TIntermSelection* selection = node->getAsSelectionNode();
+    if (selection != NULL && !selection->usesTernaryOperator())
+        return false;
+    TIntermAggregate* aggregate = node->getAsAggregate();
+    if (aggregate != NULL) {
+        switch (aggregate->getOp()) {
+            case EOpSequence:
+            case EOpDeclaration:
+            case EOpFunction:
+            case EOpPrototype:
+            case EOpParameters:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// Counts the references to each variable that read its value. The
+// declaration of a variable and the assignments to it without side effects
+// do not read its value.
+class VariableReadCounter : public TIntermTraverser {
+public:
+    VariableReadCounter(const TFunctionNameSet& pureFunctions)
+        : mPureFunctions(pureFunctions)
+    {
+    }
+
+    bool isRead(int id)
+    {
+        return mReferences[id] > mWrites[id];
+    }
+
+    virtual void visitSymbol(TIntermSymbol* node)
+    {
+        ++mReferences[node->getId()];
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() != EOpSequence)
+            return true;
+
+        TIntermSequence& sequence = node->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermNode* statement = sequence[i];
+            TIntermTyped* expression = NULL;
+            if (IsDeclaration(statement)) {
+                TIntermSequence& declarators =
+                    statement->getAsAggregate()->getSequence();
+                for (size_t j = 0; j < declarators.size(); ++j) {
+                    TIntermSymbol* variable =
+                        GetDeclaredVariable(declarators[j], &expression);
+                    if (variable != NULL)
+                        ++mWrites[variable->getId()];
+                }
+            } else {
+                TIntermSymbol* variable =
+                    GetAssignedVariable(statement, &expression);
+                if (variable != NULL && !HasSideEffects(expression, &mPureFunctions))
+                    ++mWrites[variable->getId()];
+            }
+        }
+        return true;
+    }
+
+private:
+    const TFunctionNameSet& mPureFunctions;
+    std::map<int, int> mReferences;
+    std::map<int, int> mWrites;
+};
+
+// Removes the declarations of and assignments to the variables that are
+// never read, as well as expression statements without side effects.
+class RemoveDeadStatements : public TIntermTraverser {
+public:
+    RemoveDeadStatements(VariableReadCounter& counter,
+                         const TFunctionNameSet& pureFunctions)
+        : mCounter(counter),
+          mPureFunctions(pureFunctions),
+          mRemoved(false)
+    {
+    }
+
+    bool removed() const { return mRemoved; }
+
+    // Binary expressions contain no statements, but the fields selected by
+    // a swizzle are held in a sequence node.
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return false;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() != EOpSequence)
+            return true;
+
+        TIntermSequence& sequence = node->getSequence();
+        TIntermSequence statements;
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermNode* statement = sequence[i];
+            TIntermTyped* expression = NULL;
+            if (IsDeclaration(statement)) {
+                TIntermSequence& declarators =
+                    statement->getAsAggregate()->getSequence();
+                TIntermSequence liveDeclarators;
+                for (size_t j = 0; j < declarators.size(); ++j) {
+                    TIntermSymbol* variable =
+                        GetDeclaredVariable(declarators[j], &expression);
+                    if (variable == NULL || !isDead(variable) ||
+                        (expression != NULL && HasSideEffects(expression, &mPureFunctions)))
+                        liveDeclarators.push_back(declarators[j]);
+                }
+                if (liveDeclarators.size() != declarators.size()) {
+                    mRemoved = true;
+                    if (liveDeclarators.empty())
+                        continue;
+                    declarators.swap(liveDeclarators);
+                }
+            } else if (IsExpressionStatement(statement)) {
+                TIntermSymbol* variable =
+                    GetAssignedVariable(statement, &expression);
+                bool dead = variable != NULL ?
+                    isDead(variable) && !HasSideEffects(expression, &mPureFunctions) :
+                    !HasSideEffects(statement, &mPureFunctions);
+                if (dead) {
+                    mRemoved = true;
+                    continue;
+                }
+            }
+            statements.push_back(statement);
+        }
+        sequence.swap(statements);
+        return true;
+    }
+
+private:
+    // Only plain local and global variables are considered. Struct
+    // variables are left alone since their declaration may also declare
+    // the struct type.
+    bool isDead(TIntermSymbol* variable)
+    {
+        TQualifier qualifier = variable->getQualifier();
+        if (qualifier != EvqTemporary && qualifier != EvqGlobal)
+            return false;
+        if (variable->getBasicType() == EbtStruct ||
+            variable->getSymbol().empty())
+            return false;
+        return !mCounter.isRead(variable->getId());
+    }
+
+    VariableReadCounter& mCounter;
+    const TFunctionNameSet& mPureFunctions;
+    bool mRemoved;
+};
+
+// Removes the blocks left without statements, and the if-statements left
+// without code blocks whose condition has no side effects. Back-ends do not
+// expect empty sequences, but handle missing code blocks.
+class RemoveEmptyBlocks : public TIntermTraverser {
+public:
+    RemoveEmptyBlocks(const TFunctionNameSet& pureFunctions)
+        : TIntermTraverser(false, false, true),
+          mPureFunctions(pureFunctions),
+          mRemoved(false)
+    {
+    }
+
+    // Returns true if an if-statement was removed.
+    bool removed() const { return mRemoved; }
+
+    virtual bool visitSelection(Visit visit, TIntermSelection* node)
+    {
+        if (IsEmptySequence(node->getTrueBlock()))
+            node->setTrueBlock(NULL);
+        if (IsEmptySequence(node->getFalseBlock()))
+            node->setFalseBlock(NULL);
+        return true;
+    }
+
+    virtual bool visitLoop(Visit visit, TIntermLoop* node)
+    {
+        if (IsEmptySequence(node->getBody()))
+            node->setBody(NULL);
+        return true;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() != EOpSequence && node->getOp() != EOpFunction)
+            return true;
+
+        // The body of a function definition is optional as well.
+        TIntermSequence& sequence = node->getSequence();
+        TIntermSequence children;
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            if (IsEmptySequence(sequence[i]))
+                continue;
+            if (isEmptySelection(sequence[i])) {
+                mRemoved = true;
+                continue;
+            }
+            children.push_back(sequence[i]);
+        }
+        sequence.swap(children);
+        return true;
+    }
+
+private:
+    bool isEmptySelection(TIntermNode* node)
+    {
+        TIntermSelection* selection = node->getAsSelectionNode();
+        return selection != NULL &&
+               !selection->usesTernaryOperator() &&
+               selection->getTrueBlock() == NULL &&
+               selection->getFalseBlock() == NULL &&
+               !HasSideEffects(selection->getCondition(), &mPureFunctions);
+    }
+
+    const TFunctionNameSet& mPureFunctions;
+    bool mRemoved;
+};
+
+}  // namespace
+
+void RemoveDeadCode(TIntermNode* root)
+{
+    RemoveUnreachableStatements unreachableStatements;
+    root->traverse(&unreachableStatements);
+
+    // The root is a function definition rather than a sequence if the
+    // shader only defines main().
+    TIntermAggregate* aggregate = root->getAsAggregate();
+    if (aggregate != NULL && aggregate->getOp() != EOpSequence)
+        aggregate = NULL;
+    TFunctionNameSet pureFunctions;
+    if (aggregate != NULL) {
+        RemoveUnreachableFunctions(aggregate);
+        FindPureFunctions(aggregate, &pureFunctions);
+    }
+
+    // Removing a variable may leave the variables used to compute its value
+    // unread, and removing a call may leave the function unreachable, so
+    // repeat until nothing more is removed.
+    bool removed = true;
+    while (removed) {
+        VariableReadCounter counter(pureFunctions);
+        root->traverse(&counter);
+        RemoveDeadStatements deadStatements(counter, pureFunctions);
+        root->traverse(&deadStatements);
+        RemoveEmptyBlocks emptyBlocks(pureFunctions);
+        root->traverse(&emptyBlocks);
+        removed = deadStatements.removed() || emptyBlocks.removed();
+        if (aggregate != NULL && RemoveUnreachableFunctions(aggregate))
+            removed = true;
+    }
+}
@@ -0,0 +1,24 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_REMOVE_DEAD_CODE_H_
+#define COMPILER_REMOVE_DEAD_CODE_H_
+
+class TIntermNode;
+
+// Removes code that cannot affect the result of the shader:
+// - branches of if-statements with constant conditions that are never taken,
+//   and statements following a return, break, continue or discard;
+// - functions and function prototypes not reachable from main();
+// - local and global variables that are never read, together with their
+//   declarations and the assignments to them that have no side effects.
+//   A call to a user-defined function has side effects only if the function
+//   has out or inout parameters, writes variables that are not local,
+//   discards the fragment, or calls a function that has side effects.
+// Must be called after function recursion has been ruled out.
+void RemoveDeadCode(TIntermNode* root);
+
+#endif  // COMPILER_REMOVE_DEAD_CODE_H_
@@ -19,12 +19,14 @@
 #include "compiler/BuiltInFunctionEmulator.h"
 #include "compiler/ExtensionBehavior.h"
 #include "compiler/InfoSink.h"
+#include "compiler/SpecializeUniforms.h"
 #include "compiler/SymbolTable.h"
+#include "compiler/ValidateLimitations.h"
 #include "compiler/VariableInfo.h"
 
-class LongNameMap;
 class TCompiler;
 class TDependencyGraph;
+struct TParseResources;
 
 //
 // Helper function to identify specs that are based on the WebGL spec,
@@ -41,6 +43,8 @@ public:
     virtual ~TShHandleBase();
     virtual TCompiler* getAsCompiler() { return 0; }
 
+    const TPoolAllocator& getPoolAllocator() const { return allocator; }
+
 protected:
     // Memory allocator. Allocates and tracks memory required by the compiler.
     // Deallocates all memory when compiler is destructed.
@@ -66,28 +70,54 @@ public:
     TInfoSink& getInfoSink() { return infoSink; }
     const TVariableInfoList& getAttribs() const { return attribs; }
     const TVariableInfoList& getUniforms() const { return uniforms; }
+    const TVariableInfoList& getVaryings() const { return varyings; }
+    int getBuiltInUsage() const { return builtInUsage; }
+    int getUniformRegisterCount() const { return uniformRegisterCount; }
+    const TInfoSinkBase& getDependencyGraph() const { return dependencyGraph; }
     int getMappedNameMaxLength() const;
 
+    // Values substituted for uniforms when compiling with
+    // SH_SPECIALIZE_UNIFORMS. They are kept from compile to compile.
+    TUniformValueMap& getSpecializedUniforms() { return specializedUniforms; }
+
+    // Limits each compile to maxMemory bytes of pool memory or of object
+    // code, and to maxCompileTime milliseconds as measured by
+    // OS_GetTimeMs(). Zero means no limit.
+    void setBudget(int maxMemory, int maxCompileTime);
+
 protected:
     ShShaderType getShaderType() const { return shaderType; }
     ShShaderSpec getShaderSpec() const { return shaderSpec; }
+    // Number of threads translate() may use, from SH_PARALLEL_TRANSLATION.
+    int getTranslationThreadCount() const { return translationThreadCount; }
     // Initialize symbol-table with built-in symbols.
     bool InitBuiltInSymbolTable(const ShBuiltInResources& resources);
     // Clears the results from the previous compilation.
     void clearResults();
+    // Returns false, after writing an error to the info log, if the compile
+    // went over its budget.
+    bool checkBudget();
     // Return true if function recursion is detected.
     bool detectRecursion(TIntermNode* root);
     // Rewrites a shader's intermediate tree according to the CSS Shaders spec.
     void rewriteCSSShader(TIntermNode* root);
     // Returns true if the given shader does not exceed the minimum
-    // functionality mandated in GLSL 1.0 spec Appendix A.
-    bool validateLimitations(TIntermNode* root);
-    // Collect info for all attribs and uniforms.
-    void collectAttribsUniforms(TIntermNode* root);
+    // functionality mandated in GLSL 1.0 spec Appendix A. The for-loops
+    // that conform are added to validatedLoops.
+    bool validateLimitations(TIntermNode* root, TLoopStack* validatedLoops);
+    // Collect info for all attribs and uniforms, or only for those main()
+    // and the functions it calls reference if staticUseOnly is true, and
+    // for the varyings and built-in variables the shader references.
+    void collectAttribsUniforms(TIntermNode* root, bool staticUseOnly);
+    // Removes the declarations of the attribs and uniforms that main() and
+    // the functions it calls do not reference.
+    void removeUnusedAttribsUniforms(TIntermNode* root);
     // Map long variable names into shorter ones.
     void mapLongVariableNames(TIntermNode* root);
     // Translate to object code.
     virtual void translate(TIntermNode* root) = 0;
+    // Writes the dependency graph of the shader to dependencyGraph.
+    void exportDependencyGraph(TIntermNode* root, bool json);
     // Returns true if the shader passes the restrictions that aim to prevent timing attacks.
     bool enforceTimingRestrictions(TIntermNode* root, bool outputGraph);
     // Returns true if the shader does not use samplers.
@@ -114,11 +144,22 @@ private:
 
     // Results of compilation.
     TInfoSink infoSink;  // Output sink.
+    // Preprocessor and scanner, kept with their buffers from compile to compile.
+    TParseResources* parseResources;
     TVariableInfoList attribs;  // Active attributes in the compiled shader.
     TVariableInfoList uniforms;  // Active uniforms in the compiled shader.
+    TVariableInfoList varyings;  // Active varyings in the compiled shader.
+    int builtInUsage;  // ShBuiltInUsage flags of the compiled shader.
+    int uniformRegisterCount;  // Registers used by the packed uniforms.
+    TInfoSinkBase dependencyGraph;  // Exported with SH_DEPENDENCY_GRAPH_JSON or _DOT.
+
+    TUniformValueMap specializedUniforms;
+
+    // Budget of each compile, from setBudget().
+    int maxMemory;
+    int maxCompileTime;
 
-    // Cached copy of the ref-counted singleton.
-    LongNameMap* longNameMap;
+    int translationThreadCount;
 };
 
 //
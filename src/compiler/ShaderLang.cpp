@@ -27,7 +27,11 @@ static bool checkActiveUniformAndAttribMaxLengths(const ShHandle handle,
     ShGetInfo(handle, SH_ACTIVE_UNIFORM_MAX_LENGTH, &activeUniformLimit);
     int activeAttribLimit = 0;
     ShGetInfo(handle, SH_ACTIVE_ATTRIBUTE_MAX_LENGTH, &activeAttribLimit);
-    return (expectedValue == activeUniformLimit && expectedValue == activeAttribLimit);
+    int activeVaryingLimit = 0;
+    ShGetInfo(handle, SH_ACTIVE_VARYING_MAX_LENGTH, &activeVaryingLimit);
+    return (expectedValue == activeUniformLimit &&
+            expectedValue == activeAttribLimit &&
+            expectedValue == activeVaryingLimit);
 }
 
 static bool checkMappedNameMaxLength(const ShHandle handle, int expectedValue)
@@ -49,15 +53,18 @@ static void getVariableInfo(ShShaderInfo varType,
     if (!handle || !size || !type || !name)
         return;
     ASSERT((varType == SH_ACTIVE_ATTRIBUTES) ||
-           (varType == SH_ACTIVE_UNIFORMS));
+           (varType == SH_ACTIVE_UNIFORMS) ||
+           (varType == SH_ACTIVE_VARYINGS));
 
     TShHandleBase* base = reinterpret_cast<TShHandleBase*>(handle);
     TCompiler* compiler = base->getAsCompiler();
     if (compiler == 0)
         return;
 
-    const TVariableInfoList& varList = varType == SH_ACTIVE_ATTRIBUTES ?
-        compiler->getAttribs() : compiler->getUniforms();
+    const TVariableInfoList& varList =
+        varType == SH_ACTIVE_ATTRIBUTES ? compiler->getAttribs() :
+        varType == SH_ACTIVE_UNIFORMS ? compiler->getUniforms() :
+        compiler->getVaryings();
     if (index < 0 || index >= static_cast<int>(varList.size()))
         return;
 
@@ -67,8 +74,8 @@ static void getVariableInfo(ShShaderInfo varType,
     *type = varInfo.type;
 
     // This size must match that queried by
-    // SH_ACTIVE_UNIFORM_MAX_LENGTH and SH_ACTIVE_ATTRIBUTE_MAX_LENGTH
-    // in ShGetInfo, below.
+    // SH_ACTIVE_UNIFORM_MAX_LENGTH, SH_ACTIVE_ATTRIBUTE_MAX_LENGTH and
+    // SH_ACTIVE_VARYING_MAX_LENGTH in ShGetInfo, below.
     int activeUniformAndAttribLength = 1 + MAX_SYMBOL_NAME_LEN;
     ASSERT(checkActiveUniformAndAttribMaxLengths(handle, activeUniformAndAttribLength));
     strncpy(name, varInfo.name.c_str(), activeUniformAndAttribLength);
@@ -224,6 +231,27 @@ void ShGetInfo(const ShHandle handle, ShShaderInfo pname, int* params)
         // handle array and struct dereferences.
         *params = 1 + MAX_SYMBOL_NAME_LEN;
         break;
+    case SH_ACTIVE_VARYINGS:
+        *params = compiler->getVaryings().size();
+        break;
+    case SH_ACTIVE_VARYING_MAX_LENGTH:
+        *params = 1 + MAX_SYMBOL_NAME_LEN;
+        break;
+    case SH_BUILT_IN_USAGE:
+        *params = compiler->getBuiltInUsage();
+        break;
+    case SH_UNIFORM_REGISTER_COUNT:
+        *params = compiler->getUniformRegisterCount();
+        break;
+    case SH_POOL_PEAK_SIZE:
+        *params = compiler->getPoolAllocator().getPeakSize();
+        break;
+    case SH_POOL_ALLOCATION_COUNT:
+        *params = compiler->getPoolAllocator().getAllocationCount();
+        break;
+    case SH_DEPENDENCY_GRAPH_LENGTH:
+        *params = compiler->getDependencyGraph().size() + 1;
+        break;
     default: UNREACHABLE();
     }
 }
@@ -257,7 +285,56 @@ void ShGetObjectCode(const ShHandle handle, char* objCode)
     if (!compiler) return;
 
     TInfoSink& infoSink = compiler->getInfoSink();
-    strcpy(objCode, infoSink.obj.c_str());
+    // Binary object code may contain null characters.
+    memcpy(objCode, infoSink.obj.c_str(), infoSink.obj.size() + 1);
+}
+
+//
+// Return the dependency graph exported by the compile.
+//
+void ShGetDependencyGraph(const ShHandle handle, char* graph)
+{
+    if (!handle || !graph)
+        return;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return;
+
+    strcpy(graph, compiler->getDependencyGraph().c_str());
+}
+
+//
+// Return the info log and object code in place.
+//
+const char* ShGetInfoLogPointer(const ShHandle handle, int* length)
+{
+    if (!handle)
+        return NULL;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return NULL;
+
+    TInfoSink& infoSink = compiler->getInfoSink();
+    if (length)
+        *length = infoSink.info.size();
+    return infoSink.info.c_str();
+}
+
+const char* ShGetObjectCodePointer(const ShHandle handle, int* length)
+{
+    if (!handle)
+        return NULL;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return NULL;
+
+    TInfoSink& infoSink = compiler->getInfoSink();
+    if (length)
+        *length = infoSink.obj.size();
+    return infoSink.obj.c_str();
 }
 
 void ShGetActiveAttrib(const ShHandle handle,
@@ -283,3 +360,104 @@ void ShGetActiveUniform(const ShHandle handle,
     getVariableInfo(SH_ACTIVE_UNIFORMS,
                     handle, index, length, size, type, name, mappedName);
 }
+
+void ShGetActiveVarying(const ShHandle handle,
+                        int index,
+                        int* length,
+                        int* size,
+                        ShDataType* type,
+                        char* name,
+                        char* mappedName)
+{
+    getVariableInfo(SH_ACTIVE_VARYINGS,
+                    handle, index, length, size, type, name, mappedName);
+}
+
+void ShGetUniformRegister(const ShHandle handle,
+                          int index,
+                          int* registerIndex,
+                          int* component,
+                          int* arrayStride)
+{
+    if (!handle || !registerIndex || !component || !arrayStride)
+        return;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return;
+
+    const TVariableInfoList& uniforms = compiler->getUniforms();
+    if (index < 0 || index >= static_cast<int>(uniforms.size()))
+        return;
+
+    const TVariableInfo& uniform = uniforms[index];
+    *registerIndex = uniform.registerIndex;
+    *component = uniform.registerComponent;
+    *arrayStride = uniform.arrayStride;
+}
+
+//
+// Specialize the shader on the given uniform values.
+//
+static ConstantUnion* getSpecializedUniform(const ShHandle handle,
+                                            const char* name,
+                                            int count,
+                                            const void* values)
+{
+    if (!handle || !name || count < 0 || (count > 0 && !values))
+        return NULL;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return NULL;
+
+    std::vector<ConstantUnion>& value = compiler->getSpecializedUniforms()[name];
+    value.resize(count);
+    return count > 0 ? &value[0] : NULL;
+}
+
+void ShSpecializeUniformfv(const ShHandle handle,
+                           const char* name,
+                           int count,
+                           const float* values)
+{
+    ConstantUnion* value = getSpecializedUniform(handle, name, count, values);
+    for (int i = 0; value && i < count; ++i)
+        value[i].setFConst(values[i]);
+}
+
+void ShSpecializeUniformiv(const ShHandle handle,
+                           const char* name,
+                           int count,
+                           const int* values)
+{
+    ConstantUnion* value = getSpecializedUniform(handle, name, count, values);
+    for (int i = 0; value && i < count; ++i)
+        value[i].setIConst(values[i]);
+}
+
+void ShClearSpecializedUniforms(const ShHandle handle)
+{
+    if (!handle)
+        return;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return;
+
+    compiler->getSpecializedUniforms().clear();
+}
+
+void ShSetCompileBudget(const ShHandle handle,
+                        int maxMemory,
+                        int maxCompileTime)
+{
+    if (!handle)
+        return;
+
+    TShHandleBase* base = static_cast<TShHandleBase*>(handle);
+    TCompiler* compiler = base->getAsCompiler();
+    if (!compiler) return;
+
+    compiler->setBudget(maxMemory, maxCompileTime);
+}
@@ -0,0 +1,500 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/SpecializeUniforms.h"
+
+#include "compiler/InfoSink.h"
+#include "compiler/IntermUtil.h"
+
+namespace {
+
+TString ArrayBrackets(int index)
+{
+    TStringStream stream;
+    stream << "[" << index << "]";
+    return stream.str();
+}
+
+// Converts a component to the given basic type, as constructors do.
+ConstantUnion ConvertConstant(const ConstantUnion& value, TBasicType type)
+{
+    double number = 0.0;
+    switch (value.getType()) {
+        case EbtFloat: number = value.getFConst(); break;
+        case EbtInt: number = value.getIConst(); break;
+        case EbtBool: number = value.getBConst() ? 1.0 : 0.0; break;
+        default: break;
+    }
+
+    ConstantUnion result;
+    switch (type) {
+        case EbtFloat: result.setFConst(static_cast<float>(number)); break;
+        case EbtInt: result.setIConst(static_cast<int>(number)); break;
+        case EbtBool: result.setBConst(number != 0.0); break;
+        default: UNREACHABLE(); break;
+    }
+    return result;
+}
+
+// Returns a constant of the given type holding a copy of the values.
+TIntermConstantUnion* CreateConstant(const ConstantUnion* values,
+                                     const TType& type, TSourceLoc line)
+{
+    int size = type.getObjectSize();
+    ConstantUnion* copy = new ConstantUnion[size];
+    for (int i = 0; i < size; ++i)
+        copy[i] = values[i];
+
+    TType constantType(type);
+    constantType.setQualifier(EvqConst);
+    TIntermConstantUnion* constant = new TIntermConstantUnion(copy, constantType);
+    constant->setLine(line);
+    return constant;
+}
+
+// Returns true if the operation folds by TIntermConstantUnion::fold.
+bool IsFoldableBinary(TOperator op)
+{
+    switch (op) {
+        case EOpAdd:
+        case EOpSub:
+        case EOpMul:
+        case EOpDiv:
+        case EOpVectorTimesScalar:
+        case EOpMatrixTimesScalar:
+        case EOpMatrixTimesVector:
+        case EOpVectorTimesMatrix:
+        case EOpMatrixTimesMatrix:
+        case EOpLogicalXor:
+        case EOpLessThan:
+        case EOpGreaterThan:
+        case EOpLessThanEqual:
+        case EOpGreaterThanEqual:
+        case EOpEqual:
+        case EOpNotEqual:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IsConstructor(TOperator op)
+{
+    return op >= EOpConstructInt && op <= EOpConstructStruct;
+}
+
+bool HasZeroComponent(TIntermConstantUnion* node)
+{
+    const ConstantUnion* values = node->getUnionArrayPointer();
+    for (int i = 0; i < node->getType().getObjectSize(); ++i) {
+        if (values[i].getType() == EbtFloat ? values[i].getFConst() == 0.0f :
+                                              values[i].getIConst() == 0)
+            return true;
+    }
+    return false;
+}
+
+// Builds the name under which the uniform, the array element or the struct
+// field referenced by the node is reported. For an element of an array of
+// basic types, the name is that of the array and element is its index;
+// element is -1 otherwise.
+bool GetUniformName(TIntermTyped* node, TString* name, int* element)
+{
+    TIntermSymbol* symbol = node->getAsSymbolNode();
+    if (symbol != NULL) {
+        *name = symbol->getSymbol();
+        *element = -1;
+        return symbol->getQualifier() == EvqUniform;
+    }
+
+    TIntermBinary* binary = node->getAsBinaryNode();
+    if (binary == NULL)
+        return false;
+    TIntermConstantUnion* index = binary->getRight()->getAsConstantUnion();
+    if (index == NULL)
+        return false;
+    TIntermTyped* base = binary->getLeft();
+    int indexValue = index->getUnionArrayPointer()->getIConst();
+
+    switch (binary->getOp()) {
+        case EOpIndexDirect:
+            if (!base->isArray() || !GetUniformName(base, name, element))
+                return false;
+            *element = indexValue;
+            return true;
+        case EOpIndexDirectStruct:
+            if (!GetUniformName(base, name, element))
+                return false;
+            if (*element >= 0) {
+                *name += ArrayBrackets(*element);
+                *element = -1;
+            }
+            *name += "." + (*base->getType().getStruct())[indexValue].type->getFieldName();
+            return true;
+        default:
+            return false;
+    }
+}
+
+class UniformSpecializer : public TIntermTraverser {
+public:
+    UniformSpecializer(const TUniformValueMap& values, TInfoSink& infoSink)
+        : TIntermTraverser(false, false, true),
+          mValues(values),
+          mInfoSink(infoSink)
+    {
+    }
+
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        // The variable being initialized is not a uniform.
+        if (node->getOp() != EOpInitialize)
+            node->setLeft(fold(node->getLeft()));
+        node->setRight(fold(node->getRight()));
+        return true;
+    }
+
+    virtual bool visitUnary(Visit visit, TIntermUnary* node)
+    {
+        node->setOperand(fold(node->getOperand()));
+        return true;
+    }
+
+    virtual bool visitSelection(Visit visit, TIntermSelection* node)
+    {
+        node->setCondition(fold(node->getCondition()->getAsTyped()));
+        if (node->usesTernaryOperator()) {
+            node->setTrueBlock(fold(node->getTrueBlock()->getAsTyped()));
+            node->setFalseBlock(fold(node->getFalseBlock()->getAsTyped()));
+        }
+        return true;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        // The symbols of a declaration are the variables being declared.
+        if (node->getOp() == EOpDeclaration)
+            return true;
+
+        TIntermSequence& sequence = node->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermTyped* typed = sequence[i]->getAsTyped();
+            if (typed != NULL)
+                sequence[i] = fold(typed);
+        }
+        return true;
+    }
+
+    virtual bool visitLoop(Visit visit, TIntermLoop* node)
+    {
+        node->setCondition(fold(node->getCondition()));
+        node->setExpression(fold(node->getExpression()));
+        return true;
+    }
+
+    virtual bool visitBranch(Visit visit, TIntermBranch* node)
+    {
+        node->setExpression(fold(node->getExpression()));
+        return true;
+    }
+
+private:
+    // Returns the constant that replaces the expression, or the expression
+    // itself. The children of the expression have already been folded.
+    TIntermTyped* fold(TIntermTyped* node)
+    {
+        if (node == NULL)
+            return NULL;
+
+        TIntermTyped* folded = NULL;
+        TString name;
+        int element = -1;
+        if (GetUniformName(node, &name, &element)) {
+            if (!node->isArray()) {
+                ConstantUnion* values = new ConstantUnion[node->getType().getObjectSize()];
+                if (getValue(node->getType(), name, element, values))
+                    folded = CreateConstant(values, node->getType(), node->getLine());
+            }
+        } else if (node->getAsBinaryNode() != NULL) {
+            folded = foldBinary(node->getAsBinaryNode());
+        } else if (node->getAsUnaryNode() != NULL) {
+            folded = foldUnary(node->getAsUnaryNode());
+        } else if (node->getAsAggregate() != NULL) {
+            folded = foldConstructor(node->getAsAggregate());
+        } else if (node->getAsSelectionNode() != NULL) {
+            folded = foldTernary(node->getAsSelectionNode());
+        }
+        return folded != NULL ? folded : node;
+    }
+
+    // Returns the values given for the name, if there are at least size.
+    const std::vector<ConstantUnion>* findValues(const TString& name, size_t size)
+    {
+        TUniformValueMap::const_iterator iter = mValues.find(name.c_str());
+        if (iter == mValues.end() || iter->second.size() < size)
+            return NULL;
+        return &iter->second;
+    }
+
+    // Fills values with the value of the uniform, array element or struct
+    // field of the given name and type. Returns false if any component is
+    // unknown.
+    bool getValue(const TType& type, const TString& name, int element,
+                  ConstantUnion* values)
+    {
+        if (type.getBasicType() == EbtStruct) {
+            TString prefix = element >= 0 ? name + ArrayBrackets(element) : name;
+            const TTypeList* fields = type.getStruct();
+            for (size_t i = 0; i < fields->size(); ++i) {
+                const TType* field = (*fields)[i].type;
+                if (field->isArray() ||
+                    !getValue(*field, prefix + "." + field->getFieldName(), -1, values))
+                    return false;
+                values += field->getObjectSize();
+            }
+            return true;
+        }
+
+        if (IsSampler(type.getBasicType()))
+            return false;
+
+        // The elements of an array can be given from the first element on,
+        // under the name of the array with or without "[0]", or from the
+        // element itself on.
+        size_t size = type.getObjectSize();
+        size_t offset = 0;
+        const std::vector<ConstantUnion>* given = NULL;
+        if (element < 0) {
+            given = findValues(name, size);
+        } else {
+            offset = element * size;
+            given = findValues(name + ArrayBrackets(0), offset + size);
+            if (given == NULL)
+                given = findValues(name, offset + size);
+            if (given == NULL) {
+                offset = 0;
+                given = findValues(name + ArrayBrackets(element), size);
+            }
+        }
+        if (given == NULL)
+            return false;
+
+        for (size_t i = 0; i < size; ++i)
+            values[i] = ConvertConstant((*given)[offset + i], type.getBasicType());
+        return true;
+    }
+
+    TIntermTyped* foldBinary(TIntermBinary* node)
+    {
+        TIntermConstantUnion* left = node->getLeft()->getAsConstantUnion();
+        TIntermConstantUnion* right = node->getRight()->getAsConstantUnion();
+        TOperator op = node->getOp();
+
+        // A constant right operand of a logical operator decides the result
+        // or leaves it to the left operand, which is still evaluated.
+        if (left == NULL && right != NULL &&
+            (op == EOpLogicalAnd || op == EOpLogicalOr)) {
+            bool value = right->getUnionArrayPointer()->getBConst();
+            if (value == (op == EOpLogicalAnd))
+                return node->getLeft();
+            return HasSideEffects(node->getLeft()) ? NULL : right;
+        }
+
+        if (left == NULL || left->isArray())
+            return NULL;
+        const ConstantUnion* leftValues = left->getUnionArrayPointer();
+
+        // The right operand of a logical operator is only evaluated when
+        // the left operand does not decide the result.
+        if (op == EOpLogicalAnd)
+            return leftValues[0].getBConst() ? node->getRight() : left;
+        if (op == EOpLogicalOr)
+            return leftValues[0].getBConst() ? left : node->getRight();
+
+        if (op == EOpVectorSwizzle) {
+            TIntermSequence& fields = node->getRight()->getAsAggregate()->getSequence();
+            ConstantUnion values[4];
+            for (size_t i = 0; i < fields.size(); ++i) {
+                int index = fields[i]->getAsConstantUnion()->getUnionArrayPointer()->getIConst();
+                values[i] = leftValues[index];
+            }
+            return CreateConstant(values, node->getType(), node->getLine());
+        }
+
+        if (right == NULL)
+            return NULL;
+
+        if (op == EOpIndexDirect || op == EOpIndexDirectStruct) {
+            int index = right->getUnionArrayPointer()->getIConst();
+            int offset = 0;
+            if (op == EOpIndexDirect) {
+                offset = index * node->getType().getObjectSize();
+            } else {
+                const TTypeList* fields = left->getType().getStruct();
+                for (int i = 0; i < index; ++i)
+                    offset += (*fields)[i].type->getObjectSize();
+            }
+            if (index < 0 || offset + node->getType().getObjectSize() >
+                             left->getType().getObjectSize())
+                return NULL;
+            return CreateConstant(leftValues + offset, node->getType(), node->getLine());
+        }
+
+        if (!IsFoldableBinary(op) || right->isArray() ||
+            (op == EOpDiv && HasZeroComponent(right)))
+            return NULL;
+        TIntermTyped* folded = left->fold(op, right, mInfoSink);
+        if (folded == NULL || folded->getAsConstantUnion() == NULL ||
+            folded->getType().getObjectSize() != node->getType().getObjectSize())
+            return NULL;
+        return CreateConstant(folded->getAsConstantUnion()->getUnionArrayPointer(),
+                              node->getType(), node->getLine());
+    }
+
+    TIntermTyped* foldUnary(TIntermUnary* node)
+    {
+        TIntermConstantUnion* operand = node->getOperand()->getAsConstantUnion();
+        if (operand == NULL ||
+            (node->getOp() != EOpNegative && node->getOp() != EOpLogicalNot))
+            return NULL;
+        TIntermTyped* folded = operand->fold(node->getOp(), NULL, mInfoSink);
+        if (folded == NULL || folded->getAsConstantUnion() == NULL)
+            return NULL;
+        return CreateConstant(folded->getAsConstantUnion()->getUnionArrayPointer(),
+                              node->getType(), node->getLine());
+    }
+
+    TIntermTyped* foldConstructor(TIntermAggregate* node)
+    {
+        if (!IsConstructor(node->getOp()))
+            return NULL;
+
+        // The components of the arguments, in order.
+        TIntermSequence& arguments = node->getSequence();
+        std::vector<ConstantUnion> components;
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            TIntermConstantUnion* argument = arguments[i]->getAsConstantUnion();
+            if (argument == NULL || argument->isArray())
+                return NULL;
+            const ConstantUnion* values = argument->getUnionArrayPointer();
+            components.insert(components.end(), values,
+                              values + argument->getType().getObjectSize());
+        }
+
+        const TType& type = node->getType();
+        int size = type.getObjectSize();
+        if (node->getOp() == EOpConstructStruct) {
+            if (static_cast<int>(components.size()) != size)
+                return NULL;
+            return CreateConstant(&components[0], type, node->getLine());
+        }
+
+        std::vector<ConstantUnion> values(size);
+        TBasicType basicType = type.getBasicType();
+        TIntermTyped* first = arguments[0]->getAsTyped();
+        if (arguments.size() == 1 && first->getType().getObjectSize() == 1) {
+            // A scalar fills a vector, or the diagonal of a matrix.
+            int n = type.getNominalSize();
+            ConstantUnion zero;
+            zero.setFConst(0.0f);
+            for (int i = 0; i < size; ++i) {
+                bool diagonal = !type.isMatrix() || i % n == i / n;
+                values[i] = ConvertConstant(diagonal ? components[0] : zero, basicType);
+            }
+        } else if (type.isMatrix() && first->isMatrix()) {
+            // Matrices built from matrices of another size are not folded.
+            if (first->getNominalSize() != type.getNominalSize())
+                return NULL;
+            values = components;
+        } else {
+            if (static_cast<int>(components.size()) < size)
+                return NULL;
+            for (int i = 0; i < size; ++i)
+                values[i] = ConvertConstant(components[i], basicType);
+        }
+        return CreateConstant(&values[0], type, node->getLine());
+    }
+
+    TIntermTyped* foldTernary(TIntermSelection* node)
+    {
+        if (!node->usesTernaryOperator())
+            return NULL;
+        TIntermConstantUnion* condition = node->getCondition()->getAsConstantUnion();
+        if (condition == NULL)
+            return NULL;
+        TIntermNode* branch = condition->getUnionArrayPointer()->getBConst() ?
+            node->getTrueBlock() : node->getFalseBlock();
+        return branch->getAsTyped();
+    }
+
+    const TUniformValueMap& mValues;
+    TInfoSink& mInfoSink;
+};
+
+// Counts the references to each uniform, including its declaration.
+class UniformReferenceCounter : public TIntermTraverser {
+public:
+    bool isUnused(int id)
+    {
+        return mReferences[id] <= 1;
+    }
+
+    virtual void visitSymbol(TIntermSymbol* node)
+    {
+        if (node->getQualifier() == EvqUniform)
+            ++mReferences[node->getId()];
+    }
+
+private:
+    std::map<int, int> mReferences;
+};
+
+// Removes the declarations of the uniforms that were replaced everywhere,
+// so that they are no longer reported as active.
+void RemoveUnusedUniforms(TIntermAggregate* root)
+{
+    UniformReferenceCounter counter;
+    root->traverse(&counter);
+
+    TIntermSequence& sequence = root->getSequence();
+    TIntermSequence globals;
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        TIntermAggregate* declaration = sequence[i]->getAsAggregate();
+        if (declaration != NULL && declaration->getOp() == EOpDeclaration) {
+            TIntermSequence& declarators = declaration->getSequence();
+            TIntermSequence used;
+            for (size_t j = 0; j < declarators.size(); ++j) {
+                TIntermSymbol* symbol = declarators[j]->getAsSymbolNode();
+                if (symbol == NULL || symbol->getQualifier() != EvqUniform ||
+                    !counter.isUnused(symbol->getId()))
+                    used.push_back(declarators[j]);
+            }
+            if (used.empty())
+                continue;
+            declarators.swap(used);
+        }
+        globals.push_back(sequence[i]);
+    }
+    sequence.swap(globals);
+}
+
+}  // namespace
+
+void SpecializeUniforms(TIntermNode* root, const TUniformValueMap& values,
+                        TInfoSink& infoSink)
+{
+    if (values.empty())
+        return;
+
+    UniformSpecializer specializer(values, infoSink);
+    root->traverse(&specializer);
+
+    // The root is a function definition rather than a sequence if the
+    // shader only defines main().
+    TIntermAggregate* aggregate = root->getAsAggregate();
+    if (aggregate != NULL && aggregate->getOp() == EOpSequence)
+        RemoveUnusedUniforms(aggregate);
+}
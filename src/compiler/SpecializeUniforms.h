@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_SPECIALIZE_UNIFORMS_H_
+#define COMPILER_SPECIALIZE_UNIFORMS_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "compiler/intermediate.h"
+
+class TInfoSink;
+
+// Values known at compile time for uniforms, by the names under which
+// ShGetActiveUniform reports them. A value holds the components of the
+// uniform or, for the element of an array, the components of that element
+// and of the elements following it. The values are converted to the type
+// of the uniform.
+typedef std::map<std::string, std::vector<ConstantUnion> > TUniformValueMap;
+
+// Replaces the references to the uniforms with known values by constants,
+// then folds the operations on constants that the substitution creates:
+// arithmetic, comparisons, logical operators, constructors, indexing,
+// field selection, swizzles and ternary operators. Indexing an array
+// with a constant index is replaced by the element of the array, while
+// indexing it with a variable keeps referencing the uniform. Samplers are
+// never replaced. The declarations of the uniforms that are no longer
+// referenced are removed.
+// Branches of if-statements whose condition became constant are left to
+// RemoveDeadCode.
+void SpecializeUniforms(TIntermNode* root, const TUniformValueMap& values,
+                        TInfoSink& infoSink);
+
+#endif  // COMPILER_SPECIALIZE_UNIFORMS_H_
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/StaticUse.h"
+
+#include "compiler/DetectRecursion.h"
+#include "compiler/intermediate.h"
+
+namespace {
+
+bool IsAttributeOrUniform(TQualifier qualifier)
+{
+    return qualifier == EvqAttribute || qualifier == EvqUniform;
+}
+
+// Returns true if the node declares attributes or uniforms, which does not
+// use them.
+bool DeclaresAttributesOrUniforms(TIntermNode* node)
+{
+    TIntermAggregate* declaration = node->getAsAggregate();
+    if (declaration == NULL || declaration->getOp() != EOpDeclaration)
+        return false;
+    TIntermTyped* variable = declaration->getSequence().front()->getAsTyped();
+    return variable != NULL && IsAttributeOrUniform(variable->getQualifier());
+}
+
+// Collects the attributes and uniforms referenced in the traversed nodes.
+class VariableUseCollector : public TIntermTraverser {
+public:
+    VariableUseCollector(TSymbolIdSet* used)
+        : mUsed(used)
+    {
+    }
+
+    virtual void visitSymbol(TIntermSymbol* node)
+    {
+        if (IsAttributeOrUniform(node->getQualifier()))
+            mUsed->insert(node->getId());
+    }
+
+private:
+    TSymbolIdSet* mUsed;
+};
+
+}  // namespace
+
+void FindStaticallyUsedVariables(TIntermNode* root, TSymbolIdSet* used)
+{
+    VariableUseCollector collector(used);
+
+    // The root is a function definition rather than a sequence if the
+    // shader only defines main().
+    TIntermAggregate* aggregate = root->getAsAggregate();
+    if (aggregate == NULL || aggregate->getOp() != EOpSequence) {
+        root->traverse(&collector);
+        return;
+    }
+
+    DetectRecursion callGraph;
+    root->traverse(&callGraph);
+
+    TIntermSequence& sequence = aggregate->getSequence();
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        TIntermAggregate* global = sequence[i]->getAsAggregate();
+        if (global != NULL && global->getOp() == EOpFunction &&
+            !callGraph.isReachableFromMain(global->getName()))
+            continue;
+        if (DeclaresAttributesOrUniforms(sequence[i]))
+            continue;
+        sequence[i]->traverse(&collector);
+    }
+}
+
+void RemoveUnusedDeclarations(TIntermNode* root, const TSymbolIdSet& used)
+{
+    TIntermAggregate* aggregate = root->getAsAggregate();
+    if (aggregate == NULL || aggregate->getOp() != EOpSequence)
+        return;
+
+    TIntermSequence& sequence = aggregate->getSequence();
+    TIntermSequence globals;
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        if (DeclaresAttributesOrUniforms(sequence[i])) {
+            TIntermSequence& declarators =
+                sequence[i]->getAsAggregate()->getSequence();
+            TIntermSequence usedDeclarators;
+            for (size_t j = 0; j < declarators.size(); ++j) {
+                // Struct variables are kept since their declaration may
+                // also declare the struct type.
+                TIntermSymbol* symbol = declarators[j]->getAsSymbolNode();
+                if (symbol == NULL || symbol->getBasicType() == EbtStruct ||
+                    used.count(symbol->getId()) > 0)
+                    usedDeclarators.push_back(declarators[j]);
+            }
+            if (usedDeclarators.empty())
+                continue;
+            declarators.swap(usedDeclarators);
+        }
+        globals.push_back(sequence[i]);
+    }
+    sequence.swap(globals);
+}
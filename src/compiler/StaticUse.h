@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_STATIC_USE_H_
+#define COMPILER_STATIC_USE_H_
+
+#include <set>
+
+class TIntermNode;
+
+// Ids of the symbols of variables.
+typedef std::set<int> TSymbolIdSet;
+
+// Finds the attributes and uniforms that main() or the functions it calls
+// reference, or that initialize global variables. References from
+// functions that are never called do not count.
+// Must be called after function recursion has been ruled out.
+void FindStaticallyUsedVariables(TIntermNode* root, TSymbolIdSet* used);
+
+// Removes the declarations of the attributes and uniforms not in used,
+// except for those of structs.
+// The functions that are never called must have been removed, since they
+// may still reference them.
+void RemoveUnusedDeclarations(TIntermNode* root, const TSymbolIdSet& used);
+
+#endif  // COMPILER_STATIC_USE_H_
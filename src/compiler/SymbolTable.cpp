@@ -242,6 +242,7 @@ TSymbolTableLevel* TSymbolTableLevel::clone(TStructureMap& remapper)
 
 void TSymbolTable::copyTable(const TSymbolTable& copyOf)
 {
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemSymbolTable);
     TStructureMap remapper;
     uniqueId = copyOf.uniqueId;
     for (unsigned int i = 0; i < copyOf.table.size(); ++i) {
@@ -32,6 +32,7 @@
 
 #include <assert.h>
 
+#include "compiler/HeapProfile.h"
 #include "compiler/InfoSink.h"
 #include "compiler/intermediate.h"
 
@@ -265,6 +266,7 @@ public:
     bool atGlobalLevel() { return table.size() <= 2; }
     void push()
     {
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemSymbolTable);
         table.push_back(new TSymbolTableLevel);
         precisionStack.push_back( PrecisionStackLevel() );
     }
@@ -320,11 +322,14 @@ public:
         table[0]->relateToExtension(name, ext);
     }
     int getMaxSymbolId() { return uniqueId; }
+    // Reserves the id of a symbol created by a pass over the intermediate tree.
+    int nextUniqueId() { return ++uniqueId; }
     void dump(TInfoSink &infoSink) const;
     void copyTable(const TSymbolTable& copyOf);
 
     void setDefaultPrecision( TBasicType type, TPrecision prec ){
         if( type != EbtFloat && type != EbtInt ) return; // Only set default precision for int/float
+        HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemSymbolTable);
         int indexOfLastElement = static_cast<int>(precisionStack.size()) - 1;
         precisionStack[indexOfLastElement][type] = prec; // Uses map operator [], overwrites the current value
     }
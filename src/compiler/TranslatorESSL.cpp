@@ -24,7 +24,7 @@ void TranslatorESSL::translate(TIntermNode* root) {
 
     // Write translated shader.
     TOutputESSL outputESSL(sink);
-    root->traverse(&outputESSL);
+    outputESSL.writeTree(root, getTranslationThreadCount());
 }
 
 void TranslatorESSL::writeExtensionBehavior() {
@@ -37,5 +37,5 @@ void TranslatorGLSL::translate(TIntermNode* root) {
 
     // Write translated shader.
     TOutputGLSL outputGLSL(sink);
-    root->traverse(&outputGLSL);
+    outputGLSL.writeTree(root, getTranslationThreadCount());
 }
@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/TranslatorJSBinary.h"
+
+#include "compiler/OutputJSBinary.h"
+
+TranslatorJSBinary::TranslatorJSBinary(ShShaderType type, ShShaderSpec spec)
+    : TCompiler(type, spec) {
+}
+
+void TranslatorJSBinary::translate(TIntermNode* root) {
+    // Extension directives and emulated built-in functions are GLSL text,
+    // which has no place in the binary tree.
+    TOutputJSBinary outputJS(getInfoSink().obj);
+    outputJS.output(root);
+}
@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_TRANSLATORJSBINARY_H_
+#define COMPILER_TRANSLATORJSBINARY_H_
+
+#include "compiler/ShHandle.h"
+
+class TranslatorJSBinary : public TCompiler {
+public:
+    TranslatorJSBinary(ShShaderType type, ShShaderSpec spec);
+
+protected:
+    virtual void translate(TIntermNode* root);
+};
+
+#endif  // COMPILER_TRANSLATORJSBINARY_H_
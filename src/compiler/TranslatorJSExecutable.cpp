@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/TranslatorJSExecutable.h"
+
+#include "compiler/OutputJSExecutable.h"
+
+TranslatorJSExecutable::TranslatorJSExecutable(ShShaderType type, ShShaderSpec spec)
+    : TCompiler(type, spec) {
+}
+
+void TranslatorJSExecutable::translate(TIntermNode* root) {
+    // Extension directives and emulated built-in functions are GLSL; the
+    // generated JavaScript evaluates built-in functions itself.
+    TOutputJSExecutable outputJS(getInfoSink().obj);
+    outputJS.output(root);
+}
@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_TRANSLATORJSEXECUTABLE_H_
+#define COMPILER_TRANSLATORJSEXECUTABLE_H_
+
+#include "compiler/ShHandle.h"
+
+class TranslatorJSExecutable : public TCompiler {
+public:
+    TranslatorJSExecutable(ShShaderType type, ShShaderSpec spec);
+
+protected:
+    virtual void translate(TIntermNode* root);
+};
+
+#endif  // COMPILER_TRANSLATORJSEXECUTABLE_H_
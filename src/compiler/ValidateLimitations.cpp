@@ -171,6 +171,7 @@ bool ValidateLimitations::visitLoop(Visit, TIntermLoop* node)
     info.loop = node;
     if (!validateForLoopHeader(node, &info))
         return false;
+    mValidatedLoops.push_back(info);
 
     TIntermNode* body = node->getBody();
     if (body != NULL) {
@@ -4,6 +4,9 @@
 // found in the LICENSE file.
 //
 
+#ifndef COMPILER_VALIDATE_LIMITATIONS_H_
+#define COMPILER_VALIDATE_LIMITATIONS_H_
+
 #include "GLSLANG/ShaderLang.h"
 #include "compiler/intermediate.h"
 
@@ -24,6 +27,9 @@ public:
     ValidateLimitations(ShShaderType shaderType, TInfoSinkBase& sink);
 
     int numErrors() const { return mNumErrors; }
+    // Returns the for-loops whose headers passed validation, in the order
+    // they appear in the shader.
+    const TLoopStack& validatedLoops() const { return mValidatedLoops; }
 
     virtual bool visitBinary(Visit, TIntermBinary*);
     virtual bool visitUnary(Visit, TIntermUnary*);
@@ -55,5 +61,7 @@ private:
     TInfoSinkBase& mSink;
     int mNumErrors;
     TLoopStack mLoopStack;
+    TLoopStack mValidatedLoops;
 };
 
+#endif  // COMPILER_VALIDATE_LIMITATIONS_H_
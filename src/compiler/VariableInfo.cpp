@@ -6,6 +6,8 @@
 
 #include "compiler/VariableInfo.h"
 
+#include <algorithm>
+
 static TString arrayBrackets(int index)
 {
     TStringStream stream;
@@ -13,7 +15,7 @@ static TString arrayBrackets(int index)
     return stream.str();
 }
 
-// Returns the data type for an attribute or uniform.
+// Returns the data type for an attribute, uniform or varying.
 static ShDataType getVariableDataType(const TType& type)
 {
     switch (type.getBasicType()) {
@@ -70,6 +72,19 @@ static ShDataType getVariableDataType(const TType& type)
     return SH_NONE;
 }
 
+static bool isVarying(TQualifier qualifier)
+{
+    switch (qualifier) {
+      case EvqVaryingIn:
+      case EvqVaryingOut:
+      case EvqInvariantVaryingIn:
+      case EvqInvariantVaryingOut:
+          return true;
+      default:
+          return false;
+    }
+}
+
 static void getBuiltInVariableInfo(const TType& type,
                                    const TString& name,
                                    const TString& mappedName,
@@ -79,7 +94,7 @@ static void getUserDefinedVariableInfo(const TType& type,
                                        const TString& mappedName,
                                        TVariableInfoList& infoList);
 
-// Returns info for an attribute or uniform.
+// Returns info for an attribute, uniform or varying.
 static void getVariableInfo(const TType& type,
                             const TString& name,
                             const TString& mappedName,
@@ -118,6 +133,9 @@ void getBuiltInVariableInfo(const TType& type,
         varInfo.size = 1;
     }
     varInfo.type = getVariableDataType(type);
+    varInfo.registerIndex = -1;
+    varInfo.registerComponent = 0;
+    varInfo.arrayStride = 0;
     infoList.push_back(varInfo);
 }
 
@@ -139,9 +157,11 @@ void getUserDefinedVariableInfo(const TType& type,
 }
 
 CollectAttribsUniforms::CollectAttribsUniforms(TVariableInfoList& attribs,
-                                               TVariableInfoList& uniforms)
+                                               TVariableInfoList& uniforms,
+                                               const TSymbolIdSet* used)
     : mAttribs(attribs),
-      mUniforms(uniforms)
+      mUniforms(uniforms),
+      mUsed(used)
 {
 }
 
@@ -196,6 +216,8 @@ bool CollectAttribsUniforms::visitAggregate(Visit, TIntermAggregate* node)
                 // cannot be initialized in a shader, we must have only
                 // TIntermSymbol nodes in the sequence.
                 ASSERT(variable != NULL);
+                if (mUsed != NULL && mUsed->count(variable->getId()) == 0)
+                    continue;
                 getVariableInfo(variable->getType(),
                                 variable->getOriginalSymbol(),
                                 variable->getSymbol(),
@@ -220,3 +242,182 @@ bool CollectAttribsUniforms::visitBranch(Visit, TIntermBranch*)
     return false;
 }
 
+
+CollectVaryings::CollectVaryings(TVariableInfoList& varyings,
+                                 int& builtInUsage)
+    : mVaryings(varyings),
+      mBuiltInUsage(builtInUsage)
+{
+}
+
+void CollectVaryings::visitSymbol(TIntermSymbol* node)
+{
+    const TString& name = node->getOriginalSymbol();
+    if (name == "gl_FragCoord")
+        mBuiltInUsage |= SH_USES_FRAG_COORD;
+    else if (name == "gl_FrontFacing")
+        mBuiltInUsage |= SH_USES_FRONT_FACING;
+    else if (name == "gl_PointCoord")
+        mBuiltInUsage |= SH_USES_POINT_COORD;
+    else if (name == "gl_PointSize")
+        mBuiltInUsage |= SH_USES_POINT_SIZE;
+
+    if (!isVarying(node->getQualifier()))
+        return;
+
+    // Keep the list sorted by name, with each varying once.
+    TVariableInfoList varying;
+    getVariableInfo(node->getType(), name, node->getSymbol(), varying);
+    ASSERT(varying.size() == 1);
+    TVariableInfoList::iterator iter = mVaryings.begin();
+    while (iter != mVaryings.end() && iter->name < varying[0].name)
+        ++iter;
+    if (iter == mVaryings.end() || iter->name != varying[0].name)
+        mVaryings.insert(iter, varying[0]);
+}
+
+// Declaring a varying does not reference it.
+bool CollectVaryings::visitAggregate(Visit, TIntermAggregate* node)
+{
+    if (node->getOp() == EOpDeclaration) {
+        const TIntermTyped* variable = node->getSequence().front()->getAsTyped();
+        return !isVarying(variable->getQualifier());
+    }
+    return true;
+}
+
+// Returns the number of registers and components per register used by one
+// element of a variable of the given type, or false if it is not packed.
+static bool getRegisterShape(ShDataType type, int* rows, int* columns)
+{
+    *rows = 1;
+    switch (type) {
+      case SH_FLOAT:
+      case SH_INT:
+      case SH_BOOL:
+          *columns = 1;
+          return true;
+      case SH_FLOAT_VEC2:
+      case SH_INT_VEC2:
+      case SH_BOOL_VEC2:
+          *columns = 2;
+          return true;
+      case SH_FLOAT_VEC3:
+      case SH_INT_VEC3:
+      case SH_BOOL_VEC3:
+          *columns = 3;
+          return true;
+      case SH_FLOAT_VEC4:
+      case SH_INT_VEC4:
+      case SH_BOOL_VEC4:
+          *columns = 4;
+          return true;
+      case SH_FLOAT_MAT2:
+          *rows = *columns = 2;
+          return true;
+      case SH_FLOAT_MAT3:
+          *rows = *columns = 3;
+          return true;
+      case SH_FLOAT_MAT4:
+          *rows = *columns = 4;
+          return true;
+      default:
+          return false;
+    }
+}
+
+// A uniform to pack, taking rows registers and columns components of each.
+struct RegisterBlock {
+    TVariableInfo* uniform;
+    int rows;
+    int columns;
+};
+
+// Places wider blocks first, then taller blocks.
+static bool isPackedBefore(const RegisterBlock& a, const RegisterBlock& b)
+{
+    if (a.columns != b.columns)
+        return a.columns > b.columns;
+    return a.rows > b.rows;
+}
+
+// Finds the first place in the registers where the block fits.
+static void placeFirstFit(std::vector<unsigned char>& usedComponents,
+                          RegisterBlock& block)
+{
+    int mask = (1 << block.columns) - 1;
+    for (int reg = 0; ; ++reg) {
+        for (int component = 0; component + block.columns <= 4; ++component) {
+            bool fits = true;
+            for (int row = 0; fits && row < block.rows; ++row) {
+                size_t index = reg + row;
+                fits = index >= usedComponents.size() ||
+                       (usedComponents[index] & (mask << component)) == 0;
+            }
+            if (!fits)
+                continue;
+
+            if (usedComponents.size() < static_cast<size_t>(reg + block.rows))
+                usedComponents.resize(reg + block.rows, 0);
+            for (int row = 0; row < block.rows; ++row)
+                usedComponents[reg + row] |= mask << component;
+            block.uniform->registerIndex = reg;
+            block.uniform->registerComponent = component;
+            return;
+        }
+    }
+}
+
+int PackUniforms(TVariableInfoList& uniforms, bool tightly)
+{
+    std::vector<RegisterBlock> blocks;
+    for (size_t i = 0; i < uniforms.size(); ++i) {
+        TVariableInfo& uniform = uniforms[i];
+        int rows = 0, columns = 0;
+        uniform.registerIndex = -1;
+        uniform.registerComponent = 0;
+        uniform.arrayStride = 0;
+        if (!getRegisterShape(uniform.type, &rows, &columns))
+            continue;
+        uniform.arrayStride = rows;
+
+        RegisterBlock block;
+        block.uniform = &uniform;
+        block.rows = rows * uniform.size;
+        block.columns = columns;
+        blocks.push_back(block);
+    }
+
+    if (tightly) {
+        std::stable_sort(blocks.begin(), blocks.end(), isPackedBefore);
+        std::vector<unsigned char> usedComponents;
+        for (size_t i = 0; i < blocks.size(); ++i)
+            placeFirstFit(usedComponents, blocks[i]);
+        return static_cast<int>(usedComponents.size());
+    }
+
+    // Place the blocks one after the other. Only blocks of one register
+    // share a register with the previous block.
+    int reg = 0;
+    int component = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        RegisterBlock& block = blocks[i];
+        if (block.rows > 1 || component + block.columns > 4) {
+            if (component > 0)
+                ++reg;
+            component = 0;
+        }
+        block.uniform->registerIndex = reg;
+        block.uniform->registerComponent = component;
+        if (block.rows > 1) {
+            reg += block.rows;
+        } else {
+            component += block.columns;
+            if (component == 4) {
+                ++reg;
+                component = 0;
+            }
+        }
+    }
+    return component > 0 ? reg + 1 : reg;
+}
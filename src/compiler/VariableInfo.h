@@ -9,22 +9,41 @@
 
 #include "GLSLANG/ShaderLang.h"
 #include "compiler/intermediate.h"
+#include "compiler/StaticUse.h"
 
 // Provides information about a variable.
-// It is currently being used to store info about active attribs and uniforms.
+// It is currently being used to store info about active attribs, uniforms
+// and varyings.
 struct TVariableInfo {
     TPersistString name;
     TPersistString mappedName;
     ShDataType type;
     int size;
+    // Place of a uniform in registers of four components, set by
+    // PackUniforms(). The register is -1 if the variable is not packed.
+    int registerIndex;
+    int registerComponent;
+    int arrayStride;
 };
 typedef std::vector<TVariableInfo> TVariableInfoList;
 
+// Packs the uniforms, except samplers, in registers of four components.
+// Each column of a matrix and each element of an array starts a register;
+// the registers holding an array or a matrix all start at the same
+// component. Other uniforms share a register when they fit in it. The
+// uniforms are placed in order unless tightly is true, in which case
+// they are placed from the widest to the narrowest in the first place
+// they fit, which uses fewer registers. Returns the number of registers.
+int PackUniforms(TVariableInfoList& uniforms, bool tightly);
+
 // Traverses intermediate tree to collect all attributes and uniforms.
 class CollectAttribsUniforms : public TIntermTraverser {
 public:
+    // If used is not NULL, only the attributes and uniforms it contains
+    // are collected.
     CollectAttribsUniforms(TVariableInfoList& attribs,
-                           TVariableInfoList& uniforms);
+                           TVariableInfoList& uniforms,
+                           const TSymbolIdSet* used);
 
     virtual void visitSymbol(TIntermSymbol*);
     virtual void visitConstantUnion(TIntermConstantUnion*);
@@ -38,6 +57,21 @@ public:
 private:
     TVariableInfoList& mAttribs;
     TVariableInfoList& mUniforms;
+    const TSymbolIdSet* mUsed;
+};
+
+// Finds the varyings that are referenced in the shader, in the order of
+// their names, and the built-in variables of ShBuiltInUsage it references.
+class CollectVaryings : public TIntermTraverser {
+public:
+    CollectVaryings(TVariableInfoList& varyings, int& builtInUsage);
+
+    virtual void visitSymbol(TIntermSymbol*);
+    virtual bool visitAggregate(Visit, TIntermAggregate*);
+
+private:
+    TVariableInfoList& mVaryings;
+    int& mBuiltInUsage;
 };
 
 #endif  // COMPILER_VARIABLE_INFO_H_
@@ -0,0 +1,429 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/VectorizeScalarOperations.h"
+
+#include <set>
+
+#include "compiler/IntermUtil.h"
+
+namespace {
+
+typedef TVector<TIntermTyped*> Lanes;
+typedef std::set<int> ComponentSet;
+
+// Returns the vector variable of a component selection such as v.x, which
+// the parser represents as an index at a constant, or NULL.
+TIntermSymbol* GetSelectedVector(TIntermTyped* node, int* component)
+{
+    TIntermBinary* binary = node->getAsBinaryNode();
+    if (binary == NULL || binary->getOp() != EOpIndexDirect)
+        return NULL;
+
+    TIntermSymbol* vector = binary->getLeft()->getAsSymbolNode();
+    TIntermConstantUnion* index = binary->getRight()->getAsConstantUnion();
+    if (vector == NULL || index == NULL || !vector->isVector() || vector->isArray())
+        return NULL;
+
+    *component = index->getUnionArrayPointer()->getIConst();
+    return vector;
+}
+
+// Returns true if the operator computes each component of its result from
+// the corresponding components of its operands.
+bool IsComponentWise(TOperator op)
+{
+    switch (op) {
+        case EOpNegative:
+        case EOpAdd:
+        case EOpSub:
+        case EOpMul:
+        case EOpDiv:
+        case EOpRadians:
+        case EOpDegrees:
+        case EOpSin:
+        case EOpCos:
+        case EOpTan:
+        case EOpAsin:
+        case EOpAcos:
+        case EOpAtan:
+        case EOpPow:
+        case EOpExp:
+        case EOpLog:
+        case EOpExp2:
+        case EOpLog2:
+        case EOpSqrt:
+        case EOpInverseSqrt:
+        case EOpAbs:
+        case EOpSign:
+        case EOpFloor:
+        case EOpCeil:
+        case EOpFract:
+        case EOpMod:
+        case EOpMin:
+        case EOpMax:
+        case EOpClamp:
+        case EOpMix:
+        case EOpStep:
+        case EOpSmoothStep:
+            return true;
+        default:
+            return false;
+    }
+}
+
+TType GetVectorType(TIntermTyped* scalar, int size)
+{
+    return TType(scalar->getBasicType(), scalar->getPrecision(), EvqTemporary, size);
+}
+
+// Returns a vector with every component set to the scalar.
+TIntermTyped* CreateSplat(TIntermTyped* scalar, int size)
+{
+    if (TIntermConstantUnion* constant = scalar->getAsConstantUnion()) {
+        ConstantUnion* unionArray = new ConstantUnion[size];
+        for (int i = 0; i < size; ++i)
+            unionArray[i] = *constant->getUnionArrayPointer();
+        TIntermConstantUnion* splat = new TIntermConstantUnion(
+            unionArray, TType(scalar->getBasicType(), scalar->getPrecision(), EvqConst, size));
+        splat->setLine(scalar->getLine());
+        return splat;
+    }
+
+    TOperator op = EOpNull;
+    switch (scalar->getBasicType()) {
+        case EbtFloat: op = EOpConstructVec2; break;
+        case EbtInt: op = EOpConstructIVec2; break;
+        case EbtBool: op = EOpConstructBVec2; break;
+        default: UNREACHABLE(); break;
+    }
+    TIntermAggregate* splat = new TIntermAggregate(static_cast<TOperator>(op + size - 2));
+    splat->setType(GetVectorType(scalar, size));
+    splat->getSequence().push_back(scalar);
+    splat->setLine(scalar->getLine());
+    return splat;
+}
+
+TIntermTyped* CreateSwizzle(TIntermSymbol* vector, const TVector<int>& components,
+                            TSourceLoc line)
+{
+    TIntermSymbol* copy = CopyExpression(vector)->getAsSymbolNode();
+    int size = static_cast<int>(components.size());
+    bool identity = size == vector->getNominalSize();
+    for (int i = 0; i < size && identity; ++i)
+        identity = components[i] == i;
+    if (identity)
+        return copy;
+
+    TIntermAggregate* fields = new TIntermAggregate(EOpSequence);
+    fields->setLine(line);
+    for (int i = 0; i < size; ++i) {
+        ConstantUnion* unionArray = new ConstantUnion[1];
+        unionArray->setIConst(components[i]);
+        TIntermConstantUnion* field = new TIntermConstantUnion(
+            unionArray, TType(EbtInt, EbpUndefined, EvqConst));
+        field->setLine(line);
+        fields->getSequence().push_back(field);
+    }
+    TIntermBinary* swizzle = new TIntermBinary(EOpVectorSwizzle);
+    swizzle->setLeft(copy);
+    swizzle->setRight(fields);
+    swizzle->setType(TType(vector->getBasicType(), vector->getPrecision(),
+                           EvqTemporary, size));
+    swizzle->setLine(line);
+    return swizzle;
+}
+
+// Returns an expression whose components are the values of the scalar
+// expressions, or NULL if their structures differ in more than the
+// selected components and the constants. Equal expressions are returned as
+// a single scalar.
+TIntermTyped* Vectorize(const Lanes& lanes)
+{
+    TIntermTyped* first = lanes.front();
+    int size = static_cast<int>(lanes.size());
+    TSourceLoc line = first->getLine();
+
+    bool same = true;
+    for (int i = 1; i < size && same; ++i)
+        same = IsSameExpression(first, lanes[i]);
+    if (same)
+        return CopyExpression(first);
+
+    if (first->getAsConstantUnion() != NULL) {
+        ConstantUnion* unionArray = new ConstantUnion[size];
+        for (int i = 0; i < size; ++i) {
+            TIntermConstantUnion* constant = lanes[i]->getAsConstantUnion();
+            if (constant == NULL || constant->getType() != first->getType())
+                return NULL;
+            unionArray[i] = *constant->getUnionArrayPointer();
+        }
+        TIntermConstantUnion* vector = new TIntermConstantUnion(
+            unionArray, TType(first->getBasicType(), first->getPrecision(), EvqConst, size));
+        vector->setLine(line);
+        return vector;
+    }
+
+    int component = 0;
+    if (TIntermSymbol* vector = GetSelectedVector(first, &component)) {
+        TVector<int> components;
+        for (int i = 0; i < size; ++i) {
+            TIntermSymbol* laneVector = GetSelectedVector(lanes[i], &component);
+            if (laneVector == NULL || laneVector->getId() != vector->getId())
+                return NULL;
+            components.push_back(component);
+        }
+        return CreateSwizzle(vector, components, line);
+    }
+
+    if (TIntermBinary* binary = first->getAsBinaryNode()) {
+        TOperator op = binary->getOp();
+        if (!IsComponentWise(op))
+            return NULL;
+        Lanes left, right;
+        for (int i = 0; i < size; ++i) {
+            TIntermBinary* lane = lanes[i]->getAsBinaryNode();
+            if (lane == NULL || lane->getOp() != op)
+                return NULL;
+            left.push_back(lane->getLeft());
+            right.push_back(lane->getRight());
+        }
+        TIntermTyped* vectorLeft = Vectorize(left);
+        TIntermTyped* vectorRight = vectorLeft != NULL ? Vectorize(right) : NULL;
+        if (vectorRight == NULL || (!vectorLeft->isVector() && !vectorRight->isVector()))
+            return NULL;
+        // One of the operands may remain a scalar.
+        if (op == EOpMul && vectorLeft->isVector() != vectorRight->isVector())
+            op = EOpVectorTimesScalar;
+        TIntermBinary* vector = new TIntermBinary(op);
+        vector->setLeft(vectorLeft);
+        vector->setRight(vectorRight);
+        vector->setType(GetVectorType(first, size));
+        vector->setLine(line);
+        return vector;
+    }
+
+    if (TIntermUnary* unary = first->getAsUnaryNode()) {
+        TOperator op = unary->getOp();
+        if (!IsComponentWise(op))
+            return NULL;
+        Lanes operands;
+        for (int i = 0; i < size; ++i) {
+            TIntermUnary* lane = lanes[i]->getAsUnaryNode();
+            if (lane == NULL || lane->getOp() != op)
+                return NULL;
+            operands.push_back(lane->getOperand());
+        }
+        TIntermTyped* operand = Vectorize(operands);
+        if (operand == NULL || !operand->isVector())
+            return NULL;
+        TIntermUnary* vector = new TIntermUnary(op);
+        vector->setOperand(operand);
+        vector->setType(GetVectorType(first, size));
+        vector->setLine(line);
+        return vector;
+    }
+
+    if (TIntermAggregate* aggregate = first->getAsAggregate()) {
+        TOperator op = aggregate->getOp();
+        if (!IsComponentWise(op))
+            return NULL;
+        size_t argumentCount = aggregate->getSequence().size();
+        TIntermAggregate* vector = new TIntermAggregate(op);
+        vector->setType(GetVectorType(first, size));
+        vector->setLine(line);
+        for (size_t argument = 0; argument < argumentCount; ++argument) {
+            Lanes arguments;
+            for (int i = 0; i < size; ++i) {
+                TIntermAggregate* lane = lanes[i]->getAsAggregate();
+                if (lane == NULL || lane->getOp() != op ||
+                    lane->getSequence().size() != argumentCount)
+                    return NULL;
+                arguments.push_back(lane->getSequence()[argument]->getAsTyped());
+            }
+            TIntermTyped* vectorArgument = Vectorize(arguments);
+            if (vectorArgument == NULL)
+                return NULL;
+            // Not all the built-in functions accept scalar arguments
+            // along with vectors.
+            if (!vectorArgument->isVector())
+                vectorArgument = CreateSplat(vectorArgument, size);
+            vector->getSequence().push_back(vectorArgument);
+        }
+        return vector;
+    }
+
+    return NULL;
+}
+
+// Returns true if the expression reads any of the components of the
+// vector variable.
+bool ReadsComponents(TIntermTyped* node, int vectorId, const ComponentSet& components)
+{
+    int component = 0;
+    if (TIntermSymbol* vector = GetSelectedVector(node, &component)) {
+        return vector->getId() == vectorId &&
+               components.find(component) != components.end();
+    }
+    if (TIntermSymbol* symbol = node->getAsSymbolNode())
+        return symbol->getId() == vectorId;
+
+    if (TIntermBinary* binary = node->getAsBinaryNode()) {
+        // The fields selected by a swizzle are constants.
+        return ReadsComponents(binary->getLeft(), vectorId, components) ||
+               (binary->getOp() != EOpVectorSwizzle &&
+                ReadsComponents(binary->getRight(), vectorId, components));
+    }
+    if (TIntermUnary* unary = node->getAsUnaryNode())
+        return ReadsComponents(unary->getOperand(), vectorId, components);
+    if (TIntermAggregate* aggregate = node->getAsAggregate()) {
+        TIntermSequence& sequence = aggregate->getSequence();
+        for (size_t i = 0; i < sequence.size(); ++i) {
+            TIntermTyped* argument = sequence[i]->getAsTyped();
+            if (argument != NULL && ReadsComponents(argument, vectorId, components))
+                return true;
+        }
+        return false;
+    }
+    if (TIntermSelection* selection = node->getAsSelectionNode()) {
+        return ReadsComponents(selection->getCondition()->getAsTyped(), vectorId, components) ||
+               ReadsComponents(selection->getTrueBlock()->getAsTyped(), vectorId, components) ||
+               ReadsComponents(selection->getFalseBlock()->getAsTyped(), vectorId, components);
+    }
+    return false;
+}
+
+// Returns the assignment to a single vector component that the statement
+// is made of, or NULL.
+TIntermBinary* GetComponentAssignment(TIntermNode* statement, TIntermSymbol** vector,
+                                      int* component)
+{
+    TIntermBinary* assignment = statement->getAsBinaryNode();
+    if (assignment == NULL)
+        return NULL;
+
+    switch (assignment->getOp()) {
+        case EOpAssign:
+        case EOpAddAssign:
+        case EOpSubAssign:
+        case EOpMulAssign:
+        case EOpDivAssign:
+            break;
+        default:
+            return NULL;
+    }
+
+    *vector = GetSelectedVector(assignment->getLeft(), component);
+    if (*vector == NULL || HasSideEffects(assignment->getRight()))
+        return NULL;
+    return assignment;
+}
+
+// Returns the statement that replaces the group of assignments, or NULL if
+// the assigned values can not be computed by vector operations.
+TIntermTyped* VectorizeAssignments(const TVector<TIntermBinary*>& assignments,
+                                   TIntermSymbol* vector,
+                                   const TVector<int>& components)
+{
+    Lanes values;
+    for (size_t i = 0; i < assignments.size(); ++i)
+        values.push_back(assignments[i]->getRight());
+    TIntermTyped* value = Vectorize(values);
+    if (value == NULL)
+        return NULL;
+
+    TIntermBinary* first = assignments.front();
+    TOperator op = first->getOp();
+    int size = static_cast<int>(assignments.size());
+    if (!value->isVector()) {
+        if (op == EOpAssign)
+            value = CreateSplat(value, size);
+        else if (op == EOpMulAssign)
+            op = EOpVectorTimesScalarAssign;
+    }
+
+    TIntermTyped* target = CreateSwizzle(vector, components, first->getLine());
+    TIntermBinary* assignment = new TIntermBinary(op);
+    assignment->setLeft(target);
+    assignment->setRight(value);
+    assignment->setType(target->getType());
+    assignment->setLine(first->getLine());
+    return assignment;
+}
+
+// Replaces the longest run of vectorizable assignments starting at the
+// statement.
+void VectorizeStatements(TIntermSequence& statements, size_t index)
+{
+    TIntermSymbol* vector = NULL;
+    int component = 0;
+    TIntermBinary* first = GetComponentAssignment(statements[index], &vector, &component);
+    if (first == NULL)
+        return;
+
+    TVector<TIntermBinary*> assignments;
+    assignments.push_back(first);
+    TVector<int> components;
+    components.push_back(component);
+    ComponentSet written;
+    written.insert(component);
+    TIntermTyped* replacement = NULL;
+
+    for (size_t i = index + 1; i < statements.size() &&
+                               written.size() < static_cast<size_t>(vector->getNominalSize()); ++i) {
+        TIntermSymbol* nextVector = NULL;
+        TIntermBinary* next = GetComponentAssignment(statements[i], &nextVector, &component);
+        if (next == NULL || nextVector->getId() != vector->getId() ||
+            next->getOp() != first->getOp() || written.find(component) != written.end())
+            break;
+        // The merged statement reads all the values before writing any.
+        if (ReadsComponents(next->getRight(), vector->getId(), written))
+            break;
+
+        assignments.push_back(next);
+        components.push_back(component);
+        TIntermTyped* merged = VectorizeAssignments(assignments, vector, components);
+        if (merged == NULL)
+            break;
+        replacement = merged;
+        written.insert(component);
+    }
+
+    if (replacement == NULL)
+        return;
+
+    statements[index] = replacement;
+    statements.erase(statements.begin() + index + 1,
+                     statements.begin() + index + written.size());
+}
+
+class ScalarOperationVectorizer : public TIntermTraverser {
+public:
+    // Expressions contain no blocks, but the fields selected by a swizzle
+    // are held in a sequence node.
+    virtual bool visitBinary(Visit visit, TIntermBinary* node)
+    {
+        return false;
+    }
+
+    virtual bool visitAggregate(Visit visit, TIntermAggregate* node)
+    {
+        if (node->getOp() == EOpSequence) {
+            TIntermSequence& statements = node->getSequence();
+            for (size_t i = 0; i < statements.size(); ++i)
+                VectorizeStatements(statements, i);
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+void VectorizeScalarOperations(TIntermNode* root)
+{
+    ScalarOperationVectorizer vectorizer;
+    root->traverse(&vectorizer);
+}
@@ -0,0 +1,21 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_VECTORIZE_SCALAR_OPERATIONS_H_
+#define COMPILER_VECTORIZE_SCALAR_OPERATIONS_H_
+
+class TIntermNode;
+
+// Merges adjacent statements that assign to different components of the
+// same vector, computing the same operations on corresponding components
+// of other vectors, into a single statement operating on swizzles:
+//     r.x = a.x * b.x + c;
+//     r.y = a.y * b.y + c;
+// becomes
+//     r.xy = a.xy * b.xy + c;
+void VectorizeScalarOperations(TIntermNode* root);
+
+#endif  // COMPILER_VECTORIZE_SCALAR_OPERATIONS_H_
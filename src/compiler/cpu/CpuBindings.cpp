@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/cpu/CpuBindings.h"
+
+#include <algorithm>
+
+// Defined for the uses that bind a reference to it, such as std::min.
+const int CpuBindings::kLanes;
+
+CpuBindings::CpuBindings(const CpuProgram& program)
+    : mProgram(program),
+      mSampler(NULL),
+      mUniforms(program.getStorageSize(), 0.0f),
+      mUniformsSet(program.getVariables().size(), false)
+{
+}
+
+bool CpuBindings::setUniform(const std::string& name, const float* values)
+{
+    int index = mProgram.getVariableIndex(name);
+    if (index < 0 || mProgram.getVariables()[index].qualifier != EvqUniform)
+        return false;
+
+    const CpuVariable& variable = mProgram.getVariables()[index];
+    std::copy(values, values + variable.size * variable.arraySize, mUniforms.begin() + variable.slot);
+    mUniformsSet[index] = true;
+    return true;
+}
+
+bool CpuBindings::setInput(const std::string& name, const float* values)
+{
+    int index = mProgram.getVariableIndex(name);
+    if (index < 0 || mProgram.getVariables()[index].qualifier == EvqUniform)
+        return false;
+
+    Binding binding;
+    binding.variable = index;
+    binding.input = values;
+    binding.output = NULL;
+    mBindings.push_back(binding);
+    return true;
+}
+
+bool CpuBindings::setOutput(const std::string& name, float* values)
+{
+    int index = mProgram.getVariableIndex(name);
+    if (index < 0 || mProgram.getVariables()[index].qualifier == EvqUniform)
+        return false;
+
+    Binding binding;
+    binding.variable = index;
+    binding.input = NULL;
+    binding.output = values;
+    mBindings.push_back(binding);
+    return true;
+}
+
+void CpuBindings::loadBatch(float* storage, int first, int lanes) const
+{
+    const std::vector<CpuVariable>& variables = mProgram.getVariables();
+    std::fill(storage, storage + mProgram.getStorageSize() * kLanes, 0.0f);
+    for (size_t i = 0; i < variables.size(); ++i)
+    {
+        if (!mUniformsSet[i])
+            continue;
+        const CpuVariable& variable = variables[i];
+        for (int c = 0; c < variable.size * variable.arraySize; ++c)
+        {
+            float* destination = storage + (variable.slot + c) * kLanes;
+            std::fill(destination, destination + kLanes, mUniforms[variable.slot + c]);
+        }
+    }
+    for (size_t i = 0; i < mBindings.size(); ++i)
+    {
+        if (mBindings[i].input == NULL)
+            continue;
+        const CpuVariable& variable = variables[mBindings[i].variable];
+        int size = variable.size * variable.arraySize;
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            const float* source = mBindings[i].input + (first + lane) * size;
+            for (int c = 0; c < size; ++c)
+                storage[(variable.slot + c) * kLanes + lane] = source[c];
+        }
+    }
+}
+
+void CpuBindings::storeBatch(const float* storage, int first, int lanes) const
+{
+    const std::vector<CpuVariable>& variables = mProgram.getVariables();
+    for (size_t i = 0; i < mBindings.size(); ++i)
+    {
+        if (mBindings[i].output == NULL)
+            continue;
+        const CpuVariable& variable = variables[mBindings[i].variable];
+        int size = variable.size * variable.arraySize;
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            float* destination = mBindings[i].output + (first + lane) * size;
+            for (int c = 0; c < size; ++c)
+                destination[c] = storage[(variable.slot + c) * kLanes + lane];
+        }
+    }
+}
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_CPU_CPU_BINDINGS_H_
+#define COMPILER_CPU_CPU_BINDINGS_H_
+
+#include <string>
+#include <vector>
+
+#include "compiler/cpu/CpuProgram.h"
+
+//
+// Provides texture lookups. The sampler is called once for each active
+// invocation of a texture lookup function.
+//
+class CpuSampler
+{
+public:
+    virtual ~CpuSampler() { }
+
+    // Writes to rgba the color of the texture bound to unit at coordinates,
+    // which are s and t for 2D textures, after the projection of the Proj
+    // functions, and a direction for cube maps. lod is the level of detail
+    // of the Lod functions, or the bias given to the other functions, if
+    // any.
+    virtual void sample(int unit, bool cube, const float* coordinates,
+                        float lod, bool explicitLod, float* rgba) = 0;
+};
+
+//
+// The values that the engines which run a CpuProgram read and write: the
+// uniforms, the arrays of inputs and outputs of the invocations, and the
+// sampler.
+//
+// Invocations are run kLanes at a time, with the storage of the program
+// laid out by component: component c of the variable at slot s of lane l
+// is at storage[(s + c) * kLanes + l].
+//
+class CpuBindings
+{
+public:
+    // Number of invocations evaluated together. A multiple of four, so
+    // that quads are not split.
+    static const int kLanes = 64;
+
+    CpuBindings(const CpuProgram& program);
+
+    // Sets the value of a uniform, size * arraySize components of the
+    // variable, shared by all invocations. Samplers take the texture unit.
+    // Returns false if the shader has no such uniform.
+    bool setUniform(const std::string& name, const float* values);
+    // Binds an array that holds size * arraySize components for each
+    // invocation to an attribute or an input varying or built-in variable.
+    bool setInput(const std::string& name, const float* values);
+    // Binds an array that receives size * arraySize components for each
+    // invocation from a varying or an output built-in variable.
+    bool setOutput(const std::string& name, float* values);
+    void setSampler(CpuSampler* sampler) { mSampler = sampler; }
+
+protected:
+    // Clears the storage of the program for invocations first to
+    // first + lanes - 1, then writes the uniforms and inputs into it.
+    // Variables are zero unless they are set, so that results do not
+    // depend on the previous batch.
+    void loadBatch(float* storage, int first, int lanes) const;
+    // Copies the outputs of the invocations from the storage.
+    void storeBatch(const float* storage, int first, int lanes) const;
+
+    const CpuProgram& mProgram;
+    CpuSampler* mSampler;
+
+private:
+    struct Binding
+    {
+        int variable;
+        const float* input;
+        float* output;
+    };
+
+    std::vector<float> mUniforms;
+    std::vector<bool> mUniformsSet;
+    std::vector<Binding> mBindings;
+};
+
+#endif  // COMPILER_CPU_CPU_BINDINGS_H_
@@ -0,0 +1,853 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/cpu/CpuBytecode.h"
+
+#include <algorithm>
+
+#include "compiler/debug.h"
+
+namespace {
+
+// Temporaries are numbered from kTemporaryBase while the program is
+// lowered, and moved after the constants once their number is known.
+const int kTemporaryBase = 1 << 24;
+
+CpuOperand Registers(int reg, int count)
+{
+    CpuOperand operand;
+    operand.reg = reg;
+    operand.count = count;
+    return operand;
+}
+
+// The components first to first + count - 1 of operand.
+CpuOperand Components(const CpuOperand& operand, int first, int count)
+{
+    CpuOperand result = operand;
+    result.count = count;
+    if (operand.swizzled)
+    {
+        for (int i = 0; i < count; ++i)
+            result.swizzle[i] = operand.swizzle[first + i];
+    }
+    else
+    {
+        result.reg += first;
+    }
+    return result;
+}
+
+CpuOpcode GetBuiltInOpcode(TOperator op, size_t argumentCount)
+{
+    switch (op)
+    {
+        case EOpRadians: return ECpuOpRadians;
+        case EOpDegrees: return ECpuOpDegrees;
+        case EOpSin: return ECpuOpSin;
+        case EOpCos: return ECpuOpCos;
+        case EOpTan: return ECpuOpTan;
+        case EOpAsin: return ECpuOpAsin;
+        case EOpAcos: return ECpuOpAcos;
+        case EOpAtan: return argumentCount == 2 ? ECpuOpAtan2 : ECpuOpAtan;
+        case EOpPow: return ECpuOpPow;
+        case EOpExp: return ECpuOpExp;
+        case EOpLog: return ECpuOpLog;
+        case EOpExp2: return ECpuOpExp2;
+        case EOpLog2: return ECpuOpLog2;
+        case EOpSqrt: return ECpuOpSqrt;
+        case EOpInverseSqrt: return ECpuOpInverseSqrt;
+        case EOpAbs: return ECpuOpAbs;
+        case EOpSign: return ECpuOpSign;
+        case EOpFloor: return ECpuOpFloor;
+        case EOpCeil: return ECpuOpCeil;
+        case EOpFract: return ECpuOpFract;
+        case EOpMod: return ECpuOpMod;
+        case EOpMin: return ECpuOpMin;
+        case EOpMax: return ECpuOpMax;
+        case EOpClamp: return ECpuOpClamp;
+        case EOpMix: return ECpuOpMix;
+        case EOpStep: return ECpuOpStep;
+        case EOpSmoothStep: return ECpuOpSmoothStep;
+        case EOpLength: return ECpuOpLength;
+        case EOpDistance: return ECpuOpDistance;
+        case EOpDot: return ECpuOpDot;
+        case EOpCross: return ECpuOpCross;
+        case EOpNormalize: return ECpuOpNormalize;
+        case EOpFaceForward: return ECpuOpFaceForward;
+        case EOpReflect: return ECpuOpReflect;
+        case EOpRefract: return ECpuOpRefract;
+        case EOpDFdx: return ECpuOpDFdx;
+        case EOpDFdy: return ECpuOpDFdy;
+        case EOpFwidth: return ECpuOpFwidth;
+        // matrixCompMult.
+        case EOpMul: return ECpuOpMul;
+        case EOpLessThan: return ECpuOpLessThan;
+        case EOpGreaterThan: return ECpuOpGreaterThan;
+        case EOpLessThanEqual: return ECpuOpLessThanEqual;
+        case EOpGreaterThanEqual: return ECpuOpGreaterThanEqual;
+        case EOpVectorEqual: return ECpuOpVectorEqual;
+        case EOpVectorNotEqual: return ECpuOpVectorNotEqual;
+        case EOpVectorLogicalNot: return ECpuOpLogicalNot;
+        case EOpAny: return ECpuOpAny;
+        case EOpAll: return ECpuOpAll;
+        default: UNREACHABLE(); return ECpuOpMove;
+    }
+}
+
+// Opcode that converts a component of type from to type to.
+CpuOpcode GetConversionOpcode(TBasicType from, TBasicType to)
+{
+    if (to == EbtBool && from != EbtBool)
+        return ECpuOpToBool;
+    if (to == EbtInt && from == EbtFloat)
+        return ECpuOpToInt;
+    return ECpuOpMove;
+}
+
+}  // namespace
+
+//
+// Lowers the nodes of a CpuProgram to instructions.
+//
+class CpuBytecodeCompiler
+{
+public:
+    CpuBytecodeCompiler(CpuBytecode* bytecode)
+        : mBytecode(bytecode),
+          mProgram(*bytecode->mProgram),
+          mFunction(-1),
+          mTemporaryCount(0),
+          mMaxTemporaryCount(0)
+    {
+    }
+
+    void compile();
+
+private:
+    const CpuNode& node(int index) const { return mProgram.getNode(index); }
+
+    int emit(CpuOpcode op, int count, const CpuOperand& dst,
+             const CpuOperand& a = CpuOperand(), const CpuOperand& b = CpuOperand(),
+             const CpuOperand& c = CpuOperand());
+    int emitJump(CpuOpcode op, const CpuOperand& condition = CpuOperand());
+    void move(const CpuOperand& dst, const CpuOperand& src);
+    CpuOperand newTemporary(int count);
+    CpuOperand constant(const std::vector<float>& values);
+    CpuOperand constant(float value);
+
+    bool hasSideEffects(int index) const;
+    // Copies operand to a temporary if it is a variable that a later
+    // operand may modify before it is read.
+    CpuOperand protect(const CpuOperand& operand, bool modified);
+    void lowerArguments(const std::vector<int>& children, std::vector<CpuOperand>* operands);
+
+    void lowerFunction(int function);
+    void lowerStatement(int index);
+    void lowerSelection(const CpuNode& selection);
+    void lowerLoop(const CpuNode& loop);
+    CpuOperand lower(int index);
+    CpuOperand lowerReference(int index);
+    CpuOperand lowerUnary(const CpuNode& unary);
+    CpuOperand lowerBinary(const CpuNode& binary);
+    CpuOperand lowerLogical(const CpuNode& binary);
+    CpuOperand lowerTernary(const CpuNode& ternary);
+    CpuOperand lowerConstruct(const CpuNode& construct);
+    CpuOperand lowerCall(const CpuNode& call);
+
+    CpuBytecode* mBytecode;
+    const CpuProgram& mProgram;
+    int mFunction;
+    int mTemporaryCount;
+    int mMaxTemporaryCount;
+    // Call instructions and the functions they call.
+    std::vector<std::pair<int, int> > mCalls;
+    std::vector<int> mEntries;
+};
+
+void CpuBytecodeCompiler::compile()
+{
+    const std::vector<int>& globals = mProgram.getGlobals();
+    for (size_t i = 0; i < globals.size(); ++i)
+        lowerStatement(globals[i]);
+
+    if (mProgram.getFunction(mProgram.getMain()).body >= 0)
+        mCalls.push_back(std::make_pair(emitJump(ECpuOpCall), mProgram.getMain()));
+    emitJump(ECpuOpHalt);
+
+    for (int i = 0; i < mProgram.getFunctionCount(); ++i)
+        lowerFunction(i);
+
+    std::vector<CpuInstruction>& instructions = mBytecode->mInstructions;
+    for (size_t i = 0; i < mCalls.size(); ++i)
+        instructions[mCalls[i].first].target = mEntries[mCalls[i].second];
+
+    // Temporaries follow the constants.
+    int temporaryStart = mProgram.getStorageSize() + static_cast<int>(mBytecode->mConstants.size());
+    int shift = temporaryStart - kTemporaryBase;
+    for (size_t i = 0; i < instructions.size(); ++i)
+    {
+        CpuOperand* operands[] = {
+            &instructions[i].dst, &instructions[i].a, &instructions[i].b, &instructions[i].c
+        };
+        for (int j = 0; j < 4; ++j)
+        {
+            if (operands[j]->reg >= kTemporaryBase)
+                operands[j]->reg += shift;
+            if (operands[j]->offset >= kTemporaryBase)
+                operands[j]->offset += shift;
+        }
+    }
+    mBytecode->mRegisterCount = temporaryStart + mMaxTemporaryCount;
+}
+
+void CpuBytecodeCompiler::lowerFunction(int index)
+{
+    const CpuFunction& function = mProgram.getFunction(index);
+    mEntries.push_back(static_cast<int>(mBytecode->mInstructions.size()));
+    if (function.body < 0)
+        return;
+
+    // Each function has its own temporaries, since they are live across
+    // the calls it makes.
+    mFunction = index;
+    mTemporaryCount = mMaxTemporaryCount;
+    lowerStatement(function.body);
+    emitJump(ECpuOpFunctionEnd);
+}
+
+int CpuBytecodeCompiler::emit(CpuOpcode op, int count, const CpuOperand& dst,
+                              const CpuOperand& a, const CpuOperand& b, const CpuOperand& c)
+{
+    CpuInstruction instruction;
+    instruction.op = op;
+    instruction.count = count;
+    instruction.n = 0;
+    instruction.m = 0;
+    instruction.target = -1;
+    instruction.dst = dst;
+    instruction.a = a;
+    instruction.b = b;
+    instruction.c = c;
+    mBytecode->mInstructions.push_back(instruction);
+
+    int size = std::max(std::max(count, a.count), std::max(b.count, c.count));
+    mBytecode->mMaxOperandSize = std::max(mBytecode->mMaxOperandSize, size);
+    return static_cast<int>(mBytecode->mInstructions.size()) - 1;
+}
+
+int CpuBytecodeCompiler::emitJump(CpuOpcode op, const CpuOperand& condition)
+{
+    return emit(op, 0, CpuOperand(), condition);
+}
+
+void CpuBytecodeCompiler::move(const CpuOperand& dst, const CpuOperand& src)
+{
+    emit(ECpuOpMove, dst.count, dst, src);
+}
+
+CpuOperand CpuBytecodeCompiler::newTemporary(int count)
+{
+    CpuOperand operand = Registers(kTemporaryBase + mTemporaryCount, count);
+    mTemporaryCount += count;
+    mMaxTemporaryCount = std::max(mMaxTemporaryCount, mTemporaryCount);
+    return operand;
+}
+
+CpuOperand CpuBytecodeCompiler::constant(const std::vector<float>& values)
+{
+    // Constants that are already in the pool are shared.
+    std::vector<float>& constants = mBytecode->mConstants;
+    int count = static_cast<int>(values.size());
+    int size = static_cast<int>(constants.size());
+    for (int i = 0; i + count <= size; ++i)
+    {
+        if (std::equal(values.begin(), values.end(), constants.begin() + i))
+            return Registers(mProgram.getStorageSize() + i, count);
+    }
+    constants.insert(constants.end(), values.begin(), values.end());
+    return Registers(mProgram.getStorageSize() + size, count);
+}
+
+CpuOperand CpuBytecodeCompiler::constant(float value)
+{
+    return constant(std::vector<float>(1, value));
+}
+
+bool CpuBytecodeCompiler::hasSideEffects(int index) const
+{
+    if (index < 0)
+        return false;
+
+    const CpuNode& current = node(index);
+    switch (current.kind)
+    {
+        case ECpuCall:
+            return true;
+        case ECpuUnary:
+            switch (current.op)
+            {
+                case EOpPostIncrement:
+                case EOpPostDecrement:
+                case EOpPreIncrement:
+                case EOpPreDecrement:
+                    return true;
+                default:
+                    break;
+            }
+            break;
+        case ECpuBinary:
+            switch (current.op)
+            {
+                case EOpInitialize:
+                case EOpAssign:
+                case EOpAddAssign:
+                case EOpSubAssign:
+                case EOpMulAssign:
+                case EOpDivAssign:
+                case EOpVectorTimesScalarAssign:
+                case EOpMatrixTimesScalarAssign:
+                case EOpVectorTimesMatrixAssign:
+                case EOpMatrixTimesMatrixAssign:
+                    return true;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < current.children.size(); ++i)
+    {
+        if (hasSideEffects(current.children[i]))
+            return true;
+    }
+    return false;
+}
+
+CpuOperand CpuBytecodeCompiler::protect(const CpuOperand& operand, bool modified)
+{
+    if (!modified || operand.reg >= mProgram.getStorageSize())
+        return operand;
+
+    CpuOperand copy = newTemporary(operand.count);
+    move(copy, operand);
+    return copy;
+}
+
+void CpuBytecodeCompiler::lowerArguments(const std::vector<int>& children,
+                                         std::vector<CpuOperand>* operands)
+{
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        bool modified = false;
+        for (size_t j = i + 1; j < children.size() && !modified; ++j)
+            modified = hasSideEffects(children[j]);
+        operands->push_back(protect(lower(children[i]), modified));
+    }
+}
+
+void CpuBytecodeCompiler::lowerStatement(int index)
+{
+    // Temporaries of a statement are free once it ends.
+    int temporaryCount = mTemporaryCount;
+
+    const CpuNode& statement = node(index);
+    switch (statement.kind)
+    {
+        case ECpuBlock:
+            for (size_t i = 0; i < statement.children.size(); ++i)
+                lowerStatement(statement.children[i]);
+            break;
+        case ECpuDeclaration:
+            for (size_t i = 0; i < statement.children.size(); ++i)
+            {
+                if (node(statement.children[i]).kind != ECpuSymbol)
+                    lower(statement.children[i]);
+            }
+            break;
+        case ECpuSelection:
+            lowerSelection(statement);
+            break;
+        case ECpuLoop:
+            lowerLoop(statement);
+            break;
+        case ECpuBranch:
+            switch (statement.op)
+            {
+                case EOpKill: emitJump(ECpuOpKill); break;
+                case EOpBreak: emitJump(ECpuOpBreak); break;
+                case EOpContinue: emitJump(ECpuOpContinue); break;
+                case EOpReturn: {
+                    if (!statement.children.empty())
+                    {
+                        const CpuFunction& function = mProgram.getFunction(mFunction);
+                        CpuOperand value = lower(statement.children[0]);
+                        move(Registers(function.resultSlot, function.resultSize), value);
+                    }
+                    emitJump(ECpuOpReturn);
+                    break;
+                }
+                default:
+                    UNREACHABLE();
+                    break;
+            }
+            break;
+        default:
+            lower(index);
+            break;
+    }
+
+    mTemporaryCount = temporaryCount;
+}
+
+void CpuBytecodeCompiler::lowerSelection(const CpuNode& selection)
+{
+    std::vector<CpuInstruction>& instructions = mBytecode->mInstructions;
+
+    int branch = emitJump(ECpuOpIf, lower(selection.children[0]));
+    if (selection.children[1] >= 0)
+        lowerStatement(selection.children[1]);
+    if (selection.children[2] >= 0)
+    {
+        int otherwise = emitJump(ECpuOpElse);
+        instructions[branch].target = otherwise;
+        branch = otherwise;
+        lowerStatement(selection.children[2]);
+    }
+    int end = emitJump(ECpuOpEndIf);
+    instructions[branch].target = end;
+}
+
+void CpuBytecodeCompiler::lowerLoop(const CpuNode& loop)
+{
+    std::vector<CpuInstruction>& instructions = mBytecode->mInstructions;
+    int init = loop.children[0];
+    int condition = loop.children[1];
+    int expression = loop.children[2];
+    int body = loop.children[3];
+    bool testFirst = loop.loopType != ELoopDoWhile;
+
+    if (init >= 0)
+        lowerStatement(init);
+    int begin = emitJump(ECpuOpLoop);
+    int top = static_cast<int>(instructions.size());
+
+    int test = -1;
+    if (testFirst && condition >= 0)
+        test = emitJump(ECpuOpLoopTest, lower(condition));
+    if (body >= 0)
+        lowerStatement(body);
+    emitJump(ECpuOpLoopContinue);
+    if (expression >= 0)
+        lowerStatement(expression);
+    if (!testFirst && condition >= 0)
+        test = emitJump(ECpuOpLoopTest, lower(condition));
+    int jump = emitJump(ECpuOpLoopJump);
+    int end = emitJump(ECpuOpLoopEnd);
+
+    instructions[begin].target = end;
+    instructions[jump].target = top;
+    if (test >= 0)
+        instructions[test].target = end;
+}
+
+CpuOperand CpuBytecodeCompiler::lower(int index)
+{
+    const CpuNode& current = node(index);
+    switch (current.kind)
+    {
+        case ECpuSymbol:
+        case ECpuField:
+        case ECpuSwizzle:
+        case ECpuIndex:
+            return lowerReference(index);
+        case ECpuConstant:
+            return constant(current.constants);
+        case ECpuUnary:
+            return lowerUnary(current);
+        case ECpuBinary:
+            return lowerBinary(current);
+        case ECpuTernary:
+            return lowerTernary(current);
+        case ECpuConstruct:
+            return lowerConstruct(current);
+        case ECpuBuiltIn: {
+            std::vector<CpuOperand> arguments;
+            lowerArguments(current.children, &arguments);
+            arguments.resize(3);
+            CpuOperand result = newTemporary(current.size);
+            emit(GetBuiltInOpcode(current.op, current.children.size()), current.size,
+                 result, arguments[0], arguments[1], arguments[2]);
+            return result;
+        }
+        case ECpuTexture: {
+            std::vector<CpuOperand> arguments;
+            lowerArguments(current.children, &arguments);
+            arguments.resize(3);
+            CpuOperand result = newTemporary(4);
+            int texture = emit(ECpuOpTexture, 4, result, arguments[0], arguments[1], arguments[2]);
+            mBytecode->mInstructions[texture].n = current.texture;
+            return result;
+        }
+        case ECpuCall:
+            return lowerCall(current);
+        default:
+            UNREACHABLE();
+            return CpuOperand();
+    }
+}
+
+CpuOperand CpuBytecodeCompiler::lowerReference(int index)
+{
+    const CpuNode& current = node(index);
+    switch (current.kind)
+    {
+        case ECpuSymbol:
+            return Registers(current.slot, current.size);
+        case ECpuField: {
+            CpuOperand base = lowerReference(current.children[0]);
+            ASSERT(!base.swizzled);
+            return Components(base, current.slot, current.size);
+        }
+        case ECpuSwizzle: {
+            CpuOperand base = lowerReference(current.children[0]);
+            CpuOperand result = base;
+            result.count = static_cast<int>(current.swizzle.size());
+            result.swizzled = true;
+            for (int i = 0; i < result.count; ++i)
+            {
+                int component = current.swizzle[i];
+                result.swizzle[i] = base.swizzled ? base.swizzle[component] : component;
+            }
+            return result;
+        }
+        case ECpuIndex: {
+            CpuOperand base = lowerReference(current.children[0]);
+            const CpuNode& indexNode = node(current.children[1]);
+            if (indexNode.kind == ECpuConstant)
+            {
+                int element = std::max(0, std::min(static_cast<int>(indexNode.constants[0]),
+                                                   current.elementCount - 1));
+                return Components(base, element * current.elementSize, current.elementSize);
+            }
+
+            // Swizzled vectors are copied before they are indexed.
+            if (base.swizzled)
+            {
+                CpuOperand copy = newTemporary(base.count);
+                move(copy, base);
+                base = copy;
+            }
+            CpuOperand element = lower(current.children[1]);
+            CpuOperand offset = newTemporary(1);
+            CpuOperand previous = base.offset >= 0 ? Registers(base.offset, 1) : CpuOperand();
+            int instruction = emit(ECpuOpIndex, 1, offset, element, previous);
+            mBytecode->mInstructions[instruction].n = current.elementCount;
+            mBytecode->mInstructions[instruction].m = current.elementSize;
+
+            CpuOperand result = Components(base, 0, current.elementSize);
+            result.offset = offset.reg;
+            return result;
+        }
+        default:
+            return lower(index);
+    }
+}
+
+CpuOperand CpuBytecodeCompiler::lowerUnary(const CpuNode& unary)
+{
+    const CpuNode& operandNode = node(unary.children[0]);
+    CpuOpcode op = ECpuOpMove;
+    switch (unary.op)
+    {
+        case EOpPostIncrement:
+        case EOpPostDecrement:
+        case EOpPreIncrement:
+        case EOpPreDecrement: {
+            CpuOperand reference = lowerReference(unary.children[0]);
+            bool post = unary.op == EOpPostIncrement || unary.op == EOpPostDecrement;
+            bool increment = unary.op == EOpPostIncrement || unary.op == EOpPreIncrement;
+            CpuOperand result = reference;
+            if (post)
+            {
+                result = newTemporary(reference.count);
+                move(result, reference);
+            }
+            emit(increment ? ECpuOpAdd : ECpuOpSub, reference.count, reference,
+                 reference, constant(1.0f));
+            return result;
+        }
+        case EOpNegative: op = ECpuOpNegate; break;
+        case EOpLogicalNot: op = ECpuOpLogicalNot; break;
+        case EOpConvIntToBool:
+        case EOpConvFloatToBool:
+        case EOpConvBoolToFloat:
+        case EOpConvIntToFloat:
+        case EOpConvFloatToInt:
+        case EOpConvBoolToInt:
+            op = GetConversionOpcode(operandNode.basicType, unary.basicType);
+            break;
+        default:
+            op = GetBuiltInOpcode(unary.op, 1);
+            break;
+    }
+
+    CpuOperand operand = lower(unary.children[0]);
+    CpuOperand result = newTemporary(unary.size);
+    emit(op, unary.size, result, operand);
+    return result;
+}
+
+CpuOperand CpuBytecodeCompiler::lowerBinary(const CpuNode& binary)
+{
+    const CpuNode& left = node(binary.children[0]);
+    const CpuNode& right = node(binary.children[1]);
+
+    CpuOpcode op = ECpuOpMove;
+    int n = 0;
+    bool assign = false;
+    switch (binary.op)
+    {
+        case EOpInitialize:
+        case EOpAssign: {
+            CpuOperand value = protect(lower(binary.children[1]), hasSideEffects(binary.children[0]));
+            CpuOperand reference = lowerReference(binary.children[0]);
+            move(reference, value);
+            return reference;
+        }
+        case EOpComma:
+            lower(binary.children[0]);
+            return lower(binary.children[1]);
+        case EOpLogicalAnd:
+        case EOpLogicalOr:
+            return lowerLogical(binary);
+
+        case EOpAddAssign: assign = true; op = ECpuOpAdd; break;
+        case EOpSubAssign: assign = true; op = ECpuOpSub; break;
+        case EOpDivAssign:
+            assign = true;
+            op = left.basicType == EbtInt ? ECpuOpIntDiv : ECpuOpDiv;
+            break;
+        case EOpMulAssign:
+        case EOpVectorTimesScalarAssign:
+        case EOpMatrixTimesScalarAssign: assign = true; op = ECpuOpMul; break;
+        case EOpVectorTimesMatrixAssign:
+            assign = true;
+            op = ECpuOpVectorTimesMatrix;
+            n = right.nominalSize;
+            break;
+        case EOpMatrixTimesMatrixAssign:
+            assign = true;
+            op = ECpuOpMatrixTimesMatrix;
+            n = left.nominalSize;
+            break;
+
+        case EOpAdd: op = ECpuOpAdd; break;
+        case EOpSub: op = ECpuOpSub; break;
+        case EOpMul:
+        case EOpVectorTimesScalar:
+        case EOpMatrixTimesScalar: op = ECpuOpMul; break;
+        case EOpDiv: op = binary.basicType == EbtInt ? ECpuOpIntDiv : ECpuOpDiv; break;
+        case EOpMatrixTimesVector: op = ECpuOpMatrixTimesVector; n = left.nominalSize; break;
+        case EOpVectorTimesMatrix: op = ECpuOpVectorTimesMatrix; n = right.nominalSize; break;
+        case EOpMatrixTimesMatrix: op = ECpuOpMatrixTimesMatrix; n = left.nominalSize; break;
+        case EOpEqual: op = ECpuOpEqual; break;
+        case EOpNotEqual: op = ECpuOpNotEqual; break;
+        case EOpLessThan: op = ECpuOpLessThan; break;
+        case EOpGreaterThan: op = ECpuOpGreaterThan; break;
+        case EOpLessThanEqual: op = ECpuOpLessThanEqual; break;
+        case EOpGreaterThanEqual: op = ECpuOpGreaterThanEqual; break;
+        case EOpLogicalXor: op = ECpuOpLogicalXor; break;
+        default: UNREACHABLE(); break;
+    }
+
+    CpuOperand result;
+    int instruction = -1;
+    if (assign)
+    {
+        CpuOperand value = protect(lower(binary.children[1]), hasSideEffects(binary.children[0]));
+        result = lowerReference(binary.children[0]);
+        instruction = emit(op, result.count, result, result, value);
+    }
+    else
+    {
+        std::vector<CpuOperand> operands;
+        lowerArguments(binary.children, &operands);
+        result = newTemporary(binary.size);
+        instruction = emit(op, binary.size, result, operands[0], operands[1]);
+    }
+    mBytecode->mInstructions[instruction].n = n;
+    return result;
+}
+
+CpuOperand CpuBytecodeCompiler::lowerLogical(const CpuNode& binary)
+{
+    CpuOpcode op = binary.op == EOpLogicalAnd ? ECpuOpLogicalAnd : ECpuOpLogicalOr;
+    CpuOperand result = newTemporary(1);
+    if (!hasSideEffects(binary.children[1]))
+    {
+        // Both operands can be evaluated.
+        CpuOperand left = lower(binary.children[0]);
+        CpuOperand right = lower(binary.children[1]);
+        emit(op, 1, result, left, right);
+        return result;
+    }
+
+    move(result, lower(binary.children[0]));
+    CpuOperand condition = result;
+    if (binary.op == EOpLogicalOr)
+    {
+        condition = newTemporary(1);
+        emit(ECpuOpLogicalNot, 1, condition, result);
+    }
+    int branch = emitJump(ECpuOpIf, condition);
+    move(result, lower(binary.children[1]));
+    int end = emitJump(ECpuOpEndIf);
+    mBytecode->mInstructions[branch].target = end;
+    return result;
+}
+
+CpuOperand CpuBytecodeCompiler::lowerTernary(const CpuNode& ternary)
+{
+    CpuOperand result = newTemporary(ternary.size);
+    CpuOperand condition = lower(ternary.children[0]);
+    if (!hasSideEffects(ternary.children[1]) && !hasSideEffects(ternary.children[2]))
+    {
+        // Both values can be evaluated, and one of them selected.
+        CpuOperand trueValue = lower(ternary.children[1]);
+        CpuOperand falseValue = lower(ternary.children[2]);
+        emit(ECpuOpSelect, ternary.size, result, condition, trueValue, falseValue);
+        return result;
+    }
+
+    std::vector<CpuInstruction>& instructions = mBytecode->mInstructions;
+    int branch = emitJump(ECpuOpIf, condition);
+    move(result, lower(ternary.children[1]));
+    int otherwise = emitJump(ECpuOpElse);
+    instructions[branch].target = otherwise;
+    move(result, lower(ternary.children[2]));
+    int end = emitJump(ECpuOpEndIf);
+    instructions[otherwise].target = end;
+    return result;
+}
+
+CpuOperand CpuBytecodeCompiler::lowerConstruct(const CpuNode& construct)
+{
+    std::vector<CpuOperand> arguments;
+    lowerArguments(construct.children, &arguments);
+    CpuOperand result = newTemporary(construct.size);
+    const CpuNode& first = node(construct.children[0]);
+
+    if (construct.op == EOpConstructStruct)
+    {
+        int offset = 0;
+        for (size_t i = 0; i < arguments.size(); ++i)
+        {
+            move(Components(result, offset, arguments[i].count), arguments[i]);
+            offset += arguments[i].count;
+        }
+        return result;
+    }
+
+    if (construct.matrix && arguments.size() == 1 && (first.size == 1 || first.matrix))
+    {
+        CpuOpcode op = first.matrix ? ECpuOpMatrixFromMatrix : ECpuOpMatrixFromScalar;
+        int instruction = emit(op, construct.size, result, arguments[0]);
+        mBytecode->mInstructions[instruction].n = construct.nominalSize;
+        mBytecode->mInstructions[instruction].m = first.nominalSize;
+        return result;
+    }
+
+    if (arguments.size() == 1 && first.size == 1)
+    {
+        emit(GetConversionOpcode(first.basicType, construct.basicType), construct.size,
+             result, arguments[0]);
+        return result;
+    }
+
+    // The components of the arguments fill the result in order.
+    int offset = 0;
+    for (size_t i = 0; i < arguments.size() && offset < construct.size; ++i)
+    {
+        int count = std::min(arguments[i].count, construct.size - offset);
+        CpuOpcode op = GetConversionOpcode(node(construct.children[i]).basicType, construct.basicType);
+        emit(op, count, Components(result, offset, count), Components(arguments[i], 0, count));
+        offset += count;
+    }
+    return result;
+}
+
+CpuOperand CpuBytecodeCompiler::lowerCall(const CpuNode& call)
+{
+    const CpuFunction& function = mProgram.getFunction(call.slot);
+    size_t count = function.parameters.size();
+
+    // All the arguments are evaluated before any parameter is written,
+    // since the arguments may call the function too.
+    std::vector<CpuOperand> arguments;
+    for (size_t i = 0; i < count; ++i)
+    {
+        TQualifier qualifier = function.parameters[i].qualifier;
+        if (qualifier == EvqOut || qualifier == EvqInOut)
+        {
+            arguments.push_back(lowerReference(call.children[i]));
+            continue;
+        }
+        bool modified = false;
+        for (size_t j = i + 1; j < count && !modified; ++j)
+            modified = hasSideEffects(call.children[j]);
+        arguments.push_back(protect(lower(call.children[i]), modified));
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const CpuFunction::Parameter& parameter = function.parameters[i];
+        if (parameter.qualifier != EvqOut)
+            move(Registers(parameter.slot, parameter.size), arguments[i]);
+    }
+    if (function.body >= 0)
+        mCalls.push_back(std::make_pair(emitJump(ECpuOpCall), call.slot));
+    for (size_t i = 0; i < count; ++i)
+    {
+        const CpuFunction::Parameter& parameter = function.parameters[i];
+        if (parameter.qualifier == EvqOut || parameter.qualifier == EvqInOut)
+            move(arguments[i], Registers(parameter.slot, parameter.size));
+    }
+
+    // The result is copied, since another call to the function may
+    // overwrite it before it is used.
+    if (function.resultSize == 0)
+        return CpuOperand();
+    CpuOperand result = newTemporary(function.resultSize);
+    move(result, Registers(function.resultSlot, function.resultSize));
+    return result;
+}
+
+CpuBytecode::CpuBytecode()
+    : mProgram(NULL),
+      mRegisterCount(0),
+      mMaxOperandSize(0)
+{
+}
+
+void CpuBytecode::clear()
+{
+    mProgram = NULL;
+    mInstructions.clear();
+    mConstants.clear();
+    mRegisterCount = 0;
+    mMaxOperandSize = 0;
+}
+
+void CpuBytecode::compile(const CpuProgram& program)
+{
+    clear();
+    mProgram = &program;
+    CpuBytecodeCompiler compiler(this);
+    compiler.compile();
+}
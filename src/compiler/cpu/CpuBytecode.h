@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_CPU_CPU_BYTECODE_H_
+#define COMPILER_CPU_CPU_BYTECODE_H_
+
+//
+// A CpuProgram lowered to register bytecode, which CpuVirtualMachine runs.
+//
+// Registers hold one float component each. The first registers are the
+// storage of the CpuProgram, so that variables keep their slots; they are
+// followed by the constants of the program, then by temporaries. Functions
+// cannot recurse, so each function has its own temporaries.
+//
+// An operand names a run of components: count registers from reg, or the
+// components selected by swizzle, offset for each invocation by the value
+// of the offset register when the operand is indexed dynamically. Operands
+// of one component are broadcast to the size of the instruction.
+//
+// Control flow is structured: each If, Loop and Call pushes a frame that
+// holds the masks of the invocations to resume when it ends, and the
+// instructions only write the components of the active invocations.
+//
+
+#include <vector>
+
+#include "compiler/cpu/CpuProgram.h"
+
+enum CpuOpcode
+{
+    // dst = a, with a converted to an int or a bool.
+    ECpuOpMove,
+    ECpuOpToInt,
+    ECpuOpToBool,
+    // dst = a ? b : c, per component.
+    ECpuOpSelect,
+
+    // Arithmetic, per component.
+    ECpuOpAdd,
+    ECpuOpSub,
+    ECpuOpMul,
+    ECpuOpDiv,
+    ECpuOpIntDiv,
+    ECpuOpNegate,
+    // Linear algebra on n x n matrices.
+    ECpuOpMatrixTimesVector,
+    ECpuOpVectorTimesMatrix,
+    ECpuOpMatrixTimesMatrix,
+    // dst = n x n matrix from the scalar a, or from the m x m matrix a.
+    ECpuOpMatrixFromScalar,
+    ECpuOpMatrixFromMatrix,
+
+    // Comparisons: Equal and NotEqual compare all the components of their
+    // operands; the others compare each component.
+    ECpuOpEqual,
+    ECpuOpNotEqual,
+    ECpuOpLessThan,
+    ECpuOpGreaterThan,
+    ECpuOpLessThanEqual,
+    ECpuOpGreaterThanEqual,
+    ECpuOpVectorEqual,
+    ECpuOpVectorNotEqual,
+    ECpuOpLogicalNot,
+    ECpuOpLogicalAnd,
+    ECpuOpLogicalOr,
+    ECpuOpLogicalXor,
+    ECpuOpAny,
+    ECpuOpAll,
+
+    // Built-in functions.
+    ECpuOpRadians,
+    ECpuOpDegrees,
+    ECpuOpSin,
+    ECpuOpCos,
+    ECpuOpTan,
+    ECpuOpAsin,
+    ECpuOpAcos,
+    ECpuOpAtan,
+    ECpuOpAtan2,
+    ECpuOpPow,
+    ECpuOpExp,
+    ECpuOpLog,
+    ECpuOpExp2,
+    ECpuOpLog2,
+    ECpuOpSqrt,
+    ECpuOpInverseSqrt,
+    ECpuOpAbs,
+    ECpuOpSign,
+    ECpuOpFloor,
+    ECpuOpCeil,
+    ECpuOpFract,
+    ECpuOpMod,
+    ECpuOpMin,
+    ECpuOpMax,
+    ECpuOpClamp,
+    ECpuOpMix,
+    ECpuOpStep,
+    ECpuOpSmoothStep,
+    ECpuOpLength,
+    ECpuOpDistance,
+    ECpuOpDot,
+    ECpuOpCross,
+    ECpuOpNormalize,
+    ECpuOpFaceForward,
+    ECpuOpReflect,
+    ECpuOpRefract,
+    ECpuOpDFdx,
+    ECpuOpDFdy,
+    ECpuOpFwidth,
+    // dst = texture lookup n (a CpuTexture) with sampler a, coordinates b
+    // and bias or lod c, if c has components.
+    ECpuOpTexture,
+    // dst = a, clamped to [0, n - 1], times m, plus b if b has components.
+    ECpuOpIndex,
+
+    // Control flow. Jumps go to target.
+    ECpuOpIf,           // a: condition; jumps to the Else or EndIf if no
+                        // invocation takes the branch.
+    ECpuOpElse,         // jumps to the EndIf if no invocation takes it
+    ECpuOpEndIf,
+    ECpuOpLoop,
+    ECpuOpLoopTest,     // a: condition; jumps to the LoopEnd if it is false
+                        // for all invocations.
+    ECpuOpLoopContinue, // resumes the invocations that ran continue
+    ECpuOpLoopJump,     // jumps to the top of the loop if any invocation
+                        // is active.
+    ECpuOpLoopEnd,
+    ECpuOpBreak,
+    ECpuOpContinue,
+    ECpuOpReturn,
+    ECpuOpKill,
+    ECpuOpCall,         // jumps to the function at target
+    ECpuOpFunctionEnd,
+    ECpuOpHalt,
+};
+
+struct CpuOperand
+{
+    CpuOperand() : reg(0), count(0), swizzled(false), offset(-1) { }
+
+    // Register that holds component c.
+    int component(int c) const
+    {
+        if (count == 1)
+            c = 0;
+        return reg + (swizzled ? swizzle[c] : c);
+    }
+
+    int reg;
+    int count;
+    bool swizzled;
+    unsigned char swizzle[4];
+    // Register of the dynamic offset, or -1.
+    int offset;
+};
+
+struct CpuInstruction
+{
+    CpuOpcode op;
+    // Components written to dst.
+    int count;
+    // Sizes of matrices, or other immediate operands.
+    int n;
+    int m;
+    int target;
+    CpuOperand dst;
+    CpuOperand a;
+    CpuOperand b;
+    CpuOperand c;
+};
+
+class CpuBytecode
+{
+public:
+    CpuBytecode();
+
+    void clear();
+    // Lowers the program. The program must outlive the bytecode.
+    void compile(const CpuProgram& program);
+
+    const CpuProgram& getProgram() const { return *mProgram; }
+    const std::vector<CpuInstruction>& getInstructions() const { return mInstructions; }
+    // Constants, stored from register getStorageSize() of the program on.
+    const std::vector<float>& getConstants() const { return mConstants; }
+    int getRegisterCount() const { return mRegisterCount; }
+    // Largest number of components of an operand.
+    int getMaxOperandSize() const { return mMaxOperandSize; }
+
+private:
+    friend class CpuBytecodeCompiler;
+
+    const CpuProgram* mProgram;
+    std::vector<CpuInstruction> mInstructions;
+    std::vector<float> mConstants;
+    int mRegisterCount;
+    int mMaxOperandSize;
+};
+
+#endif  // COMPILER_CPU_CPU_BYTECODE_H_
@@ -0,0 +1,1172 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/cpu/CpuExecutor.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "compiler/debug.h"
+
+namespace {
+
+const int kLanes = CpuExecutor::kLanes;
+
+typedef std::vector<unsigned char> Mask;
+
+bool AnyActive(const Mask& mask)
+{
+    for (int lane = 0; lane < kLanes; ++lane)
+    {
+        if (mask[lane])
+            return true;
+    }
+    return false;
+}
+
+// Clears the lanes of mask that are set in lanes.
+void RemoveLanes(Mask& mask, const Mask& lanes)
+{
+    for (int lane = 0; lane < kLanes; ++lane)
+        mask[lane] &= ~lanes[lane];
+}
+
+// The value of an expression: size components of kLanes floats each.
+struct Value
+{
+    Value() : size(0) { }
+
+    void resize(int components)
+    {
+        size = components;
+        data.resize(components * kLanes);
+    }
+    float* component(int c) { return &data[c * kLanes]; }
+    const float* component(int c) const { return &data[c * kLanes]; }
+    // Scalars are broadcast to all the components of the other operands.
+    float get(int c, int lane) const
+    {
+        return size == 1 ? data[lane] : data[c * kLanes + lane];
+    }
+
+    int size;
+    std::vector<float> data;
+};
+
+// The location of an l-value, or of a value that is indexed. Component c of
+// lane l is at base[(components[c] + dynamic[l]) * kLanes + l], where the
+// dynamic offsets come from indices that differ between lanes.
+struct Reference
+{
+    Reference() : base(NULL) { }
+
+    bool isContiguous() const
+    {
+        for (size_t c = 1; c < components.size(); ++c)
+        {
+            if (components[c] != components[0] + static_cast<int>(c))
+                return false;
+        }
+        return true;
+    }
+    int address(int c, int lane) const
+    {
+        int offset = components[c] + (dynamic.empty() ? 0 : dynamic[lane]);
+        return offset * kLanes + lane;
+    }
+
+    float* base;
+    std::vector<int> components;
+    std::vector<int> dynamic;
+    // Holds the indexed value if it is not a variable.
+    Value temporary;
+};
+
+float Truncate(float f)
+{
+    return f < 0.0f ? ceilf(f) : floorf(f);
+}
+
+int ClampIndex(float index, int count)
+{
+    // Comparisons are false for NaN, which becomes 0.
+    if (!(index >= 0.0f))
+        return 0;
+    if (index >= static_cast<float>(count - 1))
+        return count - 1;
+    return static_cast<int>(index);
+}
+
+// Converts a component from one basic type to another.
+float Convert(float f, TBasicType from, TBasicType to)
+{
+    switch (to)
+    {
+        case EbtBool: return f != 0.0f ? 1.0f : 0.0f;
+        case EbtInt: return from == EbtFloat ? Truncate(f) : f;
+        default: return f;
+    }
+}
+
+}  // namespace
+
+//
+// The state of one group of kLanes invocations.
+//
+class CpuBatch
+{
+public:
+    CpuBatch(const CpuProgram& program, CpuSampler* sampler, std::vector<float>& storage)
+        : mProgram(program),
+          mSampler(sampler),
+          mStorage(storage),
+          mDiscarded(kLanes, 0)
+    {
+    }
+
+    // Runs the global initializers and main for the lanes of mask.
+    void run(const Mask& mask);
+    const Mask& getDiscarded() const { return mDiscarded; }
+
+private:
+    float* slot(int index) { return &mStorage[index * kLanes]; }
+
+    void execute(int index, Mask& mask);
+    void executeSelection(const CpuNode& node, Mask& mask);
+    void executeLoop(const CpuNode& node, Mask& mask);
+    void executeBranch(const CpuNode& node, Mask& mask);
+    void callFunction(int function, const Mask& mask);
+
+    void evaluate(int index, const Mask& mask, Value& result);
+    void evaluateReference(int index, const Mask& mask, Reference& reference);
+    void load(const Reference& reference, Value& result);
+    void store(const Reference& reference, const Value& value, const Mask& mask);
+
+    void evaluateUnary(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateBinary(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateLogical(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateTernary(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateConstruct(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateBuiltIn(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateTexture(const CpuNode& node, const Mask& mask, Value& result);
+    void evaluateCall(const CpuNode& node, const Mask& mask, Value& result);
+    void arithmetic(TOperator op, const CpuNode& left, const Value& a,
+                    const CpuNode& right, const Value& b,
+                    const CpuNode& node, Value& result);
+
+    const CpuProgram& mProgram;
+    CpuSampler* mSampler;
+    std::vector<float>& mStorage;
+
+    Mask mDiscarded;
+    // Lanes that left the enclosing loops with break, and the enclosing
+    // function calls with return, innermost last.
+    std::vector<Mask> mBreaks;
+    std::vector<Mask> mReturns;
+    std::vector<int> mCalls;
+};
+
+void CpuBatch::run(const Mask& mask)
+{
+    Mask active = mask;
+    const std::vector<int>& globals = mProgram.getGlobals();
+    for (size_t i = 0; i < globals.size(); ++i)
+        execute(globals[i], active);
+    callFunction(mProgram.getMain(), active);
+}
+
+void CpuBatch::callFunction(int index, const Mask& mask)
+{
+    const CpuFunction& function = mProgram.getFunction(index);
+    if (function.body < 0)
+        return;
+
+    mReturns.push_back(Mask(kLanes, 0));
+    mCalls.push_back(index);
+    Mask active = mask;
+    execute(function.body, active);
+    mCalls.pop_back();
+    mReturns.pop_back();
+}
+
+void CpuBatch::execute(int index, Mask& mask)
+{
+    const CpuNode& node = mProgram.getNode(index);
+    switch (node.kind)
+    {
+        case ECpuBlock:
+            for (size_t i = 0; i < node.children.size() && AnyActive(mask); ++i)
+                execute(node.children[i], mask);
+            break;
+        case ECpuDeclaration:
+            for (size_t i = 0; i < node.children.size(); ++i)
+            {
+                // Declarations without initializers have nothing to run.
+                if (mProgram.getNode(node.children[i]).kind != ECpuSymbol)
+                {
+                    Value value;
+                    evaluate(node.children[i], mask, value);
+                }
+            }
+            break;
+        case ECpuSelection:
+            executeSelection(node, mask);
+            break;
+        case ECpuLoop:
+            executeLoop(node, mask);
+            break;
+        case ECpuBranch:
+            executeBranch(node, mask);
+            break;
+        default: {
+            Value value;
+            evaluate(index, mask, value);
+            break;
+        }
+    }
+    RemoveLanes(mask, mDiscarded);
+}
+
+void CpuBatch::executeSelection(const CpuNode& node, Mask& mask)
+{
+    Value condition;
+    evaluate(node.children[0], mask, condition);
+
+    Mask trueMask(kLanes), falseMask(kLanes);
+    for (int lane = 0; lane < kLanes; ++lane)
+    {
+        bool taken = condition.data[lane] != 0.0f;
+        trueMask[lane] = mask[lane] && taken;
+        falseMask[lane] = mask[lane] && !taken;
+    }
+    if (node.children[1] >= 0 && AnyActive(trueMask))
+        execute(node.children[1], trueMask);
+    if (node.children[2] >= 0 && AnyActive(falseMask))
+        execute(node.children[2], falseMask);
+
+    // Lanes that left the branches with break, continue, return or
+    // discard are no longer active.
+    for (int lane = 0; lane < kLanes; ++lane)
+        mask[lane] = trueMask[lane] | falseMask[lane];
+}
+
+void CpuBatch::executeLoop(const CpuNode& node, Mask& mask)
+{
+    int init = node.children[0];
+    int condition = node.children[1];
+    int expression = node.children[2];
+    int body = node.children[3];
+
+    if (init >= 0)
+        execute(init, mask);
+
+    mBreaks.push_back(Mask(kLanes, 0));
+    Mask active = mask;
+    bool first = true;
+    while (true)
+    {
+        if (condition >= 0 && !(node.loopType == ELoopDoWhile && first))
+        {
+            Value value;
+            evaluate(condition, active, value);
+            for (int lane = 0; lane < kLanes; ++lane)
+                active[lane] &= value.data[lane] != 0.0f;
+        }
+        if (!AnyActive(active))
+            break;
+
+        // Lanes that continue leave the body, but stay in the loop.
+        Mask iteration = active;
+        if (body >= 0)
+            execute(body, iteration);
+        RemoveLanes(active, mBreaks.back());
+        RemoveLanes(active, mReturns.back());
+        RemoveLanes(active, mDiscarded);
+
+        if (expression >= 0 && AnyActive(active))
+        {
+            Value value;
+            evaluate(expression, active, value);
+        }
+        first = false;
+    }
+    mBreaks.pop_back();
+
+    RemoveLanes(mask, mReturns.back());
+    RemoveLanes(mask, mDiscarded);
+}
+
+void CpuBatch::executeBranch(const CpuNode& node, Mask& mask)
+{
+    switch (node.op)
+    {
+        case EOpKill:
+            for (int lane = 0; lane < kLanes; ++lane)
+                mDiscarded[lane] |= mask[lane];
+            break;
+        case EOpBreak:
+            for (int lane = 0; lane < kLanes; ++lane)
+                mBreaks.back()[lane] |= mask[lane];
+            break;
+        case EOpContinue:
+            break;
+        case EOpReturn: {
+            if (!node.children.empty())
+            {
+                const CpuFunction& function = mProgram.getFunction(mCalls.back());
+                Value value;
+                evaluate(node.children[0], mask, value);
+                Reference result;
+                result.base = slot(function.resultSlot);
+                for (int c = 0; c < function.resultSize; ++c)
+                    result.components.push_back(c);
+                store(result, value, mask);
+            }
+            for (int lane = 0; lane < kLanes; ++lane)
+                mReturns.back()[lane] |= mask[lane];
+            break;
+        }
+        default:
+            UNREACHABLE();
+            break;
+    }
+    std::fill(mask.begin(), mask.end(), 0);
+}
+
+void CpuBatch::evaluateReference(int index, const Mask& mask, Reference& reference)
+{
+    const CpuNode& node = mProgram.getNode(index);
+    switch (node.kind)
+    {
+        case ECpuSymbol:
+            reference.base = slot(node.slot);
+            for (int c = 0; c < node.size; ++c)
+                reference.components.push_back(c);
+            break;
+        case ECpuField: {
+            evaluateReference(node.children[0], mask, reference);
+            std::vector<int> components(reference.components.begin() + node.slot,
+                                        reference.components.begin() + node.slot + node.size);
+            reference.components.swap(components);
+            break;
+        }
+        case ECpuSwizzle: {
+            evaluateReference(node.children[0], mask, reference);
+            std::vector<int> components;
+            for (size_t i = 0; i < node.swizzle.size(); ++i)
+                components.push_back(reference.components[node.swizzle[i]]);
+            reference.components.swap(components);
+            break;
+        }
+        case ECpuIndex: {
+            evaluateReference(node.children[0], mask, reference);
+            const CpuNode& indexNode = mProgram.getNode(node.children[1]);
+            if (indexNode.kind == ECpuConstant)
+            {
+                int element = ClampIndex(indexNode.constants[0], node.elementCount);
+                std::vector<int> components(
+                    reference.components.begin() + element * node.elementSize,
+                    reference.components.begin() + (element + 1) * node.elementSize);
+                reference.components.swap(components);
+                break;
+            }
+
+            if (!reference.isContiguous())
+            {
+                // Swizzled vectors are copied before they are indexed.
+                Value value;
+                load(reference, value);
+                reference.temporary = value;
+                reference.base = &reference.temporary.data[0];
+                reference.dynamic.clear();
+                for (int c = 0; c < value.size; ++c)
+                    reference.components[c] = c;
+            }
+            Value element;
+            evaluate(node.children[1], mask, element);
+            if (reference.dynamic.empty())
+                reference.dynamic.resize(kLanes, 0);
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                int clamped = ClampIndex(element.data[lane], node.elementCount);
+                reference.dynamic[lane] += clamped * node.elementSize;
+            }
+            reference.components.resize(node.elementSize);
+            break;
+        }
+        default:
+            // The value is not a variable, so it is evaluated and indexed
+            // in a temporary.
+            evaluate(index, mask, reference.temporary);
+            reference.base = &reference.temporary.data[0];
+            for (int c = 0; c < node.size; ++c)
+                reference.components.push_back(c);
+            break;
+    }
+}
+
+void CpuBatch::load(const Reference& reference, Value& result)
+{
+    int size = static_cast<int>(reference.components.size());
+    result.resize(size);
+    for (int c = 0; c < size; ++c)
+    {
+        float* destination = result.component(c);
+        if (reference.dynamic.empty())
+        {
+            const float* source = reference.base + reference.components[c] * kLanes;
+            memcpy(destination, source, kLanes * sizeof(float));
+        }
+        else
+        {
+            for (int lane = 0; lane < kLanes; ++lane)
+                destination[lane] = reference.base[reference.address(c, lane)];
+        }
+    }
+}
+
+void CpuBatch::store(const Reference& reference, const Value& value, const Mask& mask)
+{
+    int size = static_cast<int>(reference.components.size());
+    for (int c = 0; c < size; ++c)
+    {
+        for (int lane = 0; lane < kLanes; ++lane)
+        {
+            if (mask[lane])
+                reference.base[reference.address(c, lane)] = value.get(c, lane);
+        }
+    }
+}
+
+void CpuBatch::evaluate(int index, const Mask& mask, Value& result)
+{
+    const CpuNode& node = mProgram.getNode(index);
+    switch (node.kind)
+    {
+        case ECpuSymbol:
+        case ECpuField:
+        case ECpuSwizzle:
+        case ECpuIndex: {
+            Reference reference;
+            evaluateReference(index, mask, reference);
+            load(reference, result);
+            break;
+        }
+        case ECpuConstant:
+            result.resize(node.size);
+            for (int c = 0; c < node.size; ++c)
+                std::fill(result.component(c), result.component(c) + kLanes, node.constants[c]);
+            break;
+        case ECpuUnary:
+            evaluateUnary(node, mask, result);
+            break;
+        case ECpuBinary:
+            evaluateBinary(node, mask, result);
+            break;
+        case ECpuTernary:
+            evaluateTernary(node, mask, result);
+            break;
+        case ECpuConstruct:
+            evaluateConstruct(node, mask, result);
+            break;
+        case ECpuBuiltIn:
+            evaluateBuiltIn(node, mask, result);
+            break;
+        case ECpuTexture:
+            evaluateTexture(node, mask, result);
+            break;
+        case ECpuCall:
+            evaluateCall(node, mask, result);
+            break;
+        default:
+            UNREACHABLE();
+            break;
+    }
+}
+
+void CpuBatch::evaluateUnary(const CpuNode& node, const Mask& mask, Value& result)
+{
+    const CpuNode& operandNode = mProgram.getNode(node.children[0]);
+    switch (node.op)
+    {
+        case EOpPostIncrement:
+        case EOpPostDecrement:
+        case EOpPreIncrement:
+        case EOpPreDecrement: {
+            Reference reference;
+            evaluateReference(node.children[0], mask, reference);
+            Value value;
+            load(reference, value);
+            float delta = (node.op == EOpPostIncrement || node.op == EOpPreIncrement) ? 1.0f : -1.0f;
+            Value updated = value;
+            for (size_t i = 0; i < updated.data.size(); ++i)
+                updated.data[i] += delta;
+            store(reference, updated, mask);
+            bool post = node.op == EOpPostIncrement || node.op == EOpPostDecrement;
+            result = post ? value : updated;
+            return;
+        }
+        case EOpNegative:
+        case EOpLogicalNot:
+        case EOpVectorLogicalNot:
+        case EOpConvIntToBool:
+        case EOpConvFloatToBool:
+        case EOpConvBoolToFloat:
+        case EOpConvIntToFloat:
+        case EOpConvFloatToInt:
+        case EOpConvBoolToInt:
+            break;
+        default: {
+            // Built-in functions of one argument take the common path.
+            CpuNode builtIn = node;
+            builtIn.kind = ECpuBuiltIn;
+            evaluateBuiltIn(builtIn, mask, result);
+            return;
+        }
+    }
+
+    Value operand;
+    evaluate(node.children[0], mask, operand);
+    switch (node.op)
+    {
+        case EOpNegative:
+            result = operand;
+            for (size_t i = 0; i < result.data.size(); ++i)
+                result.data[i] = -result.data[i];
+            break;
+        case EOpLogicalNot:
+        case EOpVectorLogicalNot:
+            result = operand;
+            for (size_t i = 0; i < result.data.size(); ++i)
+                result.data[i] = result.data[i] != 0.0f ? 0.0f : 1.0f;
+            break;
+        default:
+            // Conversions.
+            result = operand;
+            for (size_t i = 0; i < result.data.size(); ++i)
+                result.data[i] = Convert(result.data[i], operandNode.basicType, node.basicType);
+            break;
+    }
+}
+
+void CpuBatch::arithmetic(TOperator op, const CpuNode& left, const Value& a,
+                          const CpuNode& right, const Value& b,
+                          const CpuNode& node, Value& result)
+{
+    result.resize(node.size);
+    switch (op)
+    {
+        case EOpMatrixTimesVector: {
+            int n = left.nominalSize;
+            for (int row = 0; row < n; ++row)
+            {
+                float* out = result.component(row);
+                std::fill(out, out + kLanes, 0.0f);
+                for (int k = 0; k < n; ++k)
+                {
+                    const float* m = a.component(k * n + row);
+                    const float* v = b.component(k);
+                    for (int lane = 0; lane < kLanes; ++lane)
+                        out[lane] += m[lane] * v[lane];
+                }
+            }
+            return;
+        }
+        case EOpVectorTimesMatrix: {
+            int n = right.nominalSize;
+            for (int column = 0; column < n; ++column)
+            {
+                float* out = result.component(column);
+                std::fill(out, out + kLanes, 0.0f);
+                for (int k = 0; k < n; ++k)
+                {
+                    const float* v = a.component(k);
+                    const float* m = b.component(column * n + k);
+                    for (int lane = 0; lane < kLanes; ++lane)
+                        out[lane] += v[lane] * m[lane];
+                }
+            }
+            return;
+        }
+        case EOpMatrixTimesMatrix: {
+            int n = left.nominalSize;
+            for (int column = 0; column < n; ++column)
+            {
+                for (int row = 0; row < n; ++row)
+                {
+                    float* out = result.component(column * n + row);
+                    std::fill(out, out + kLanes, 0.0f);
+                    for (int k = 0; k < n; ++k)
+                    {
+                        const float* l = a.component(k * n + row);
+                        const float* r = b.component(column * n + k);
+                        for (int lane = 0; lane < kLanes; ++lane)
+                            out[lane] += l[lane] * r[lane];
+                    }
+                }
+            }
+            return;
+        }
+        default:
+            break;
+    }
+
+    bool integer = node.basicType == EbtInt;
+    for (int c = 0; c < node.size; ++c)
+    {
+        float* out = result.component(c);
+        for (int lane = 0; lane < kLanes; ++lane)
+        {
+            float x = a.get(c, lane);
+            float y = b.get(c, lane);
+            switch (op)
+            {
+                case EOpAdd: out[lane] = x + y; break;
+                case EOpSub: out[lane] = x - y; break;
+                case EOpDiv: out[lane] = integer ? Truncate(x / y) : x / y; break;
+                default: out[lane] = x * y; break;
+            }
+        }
+    }
+}
+
+void CpuBatch::evaluateBinary(const CpuNode& node, const Mask& mask, Value& result)
+{
+    const CpuNode& left = mProgram.getNode(node.children[0]);
+    const CpuNode& right = mProgram.getNode(node.children[1]);
+
+    TOperator op = EOpNull;
+    switch (node.op)
+    {
+        case EOpInitialize:
+        case EOpAssign: {
+            evaluate(node.children[1], mask, result);
+            Reference reference;
+            evaluateReference(node.children[0], mask, reference);
+            store(reference, result, mask);
+            return;
+        }
+        case EOpComma: {
+            Value discarded;
+            evaluate(node.children[0], mask, discarded);
+            evaluate(node.children[1], mask, result);
+            return;
+        }
+        case EOpLogicalAnd:
+        case EOpLogicalOr:
+        case EOpLogicalXor:
+            evaluateLogical(node, mask, result);
+            return;
+        case EOpAddAssign: op = EOpAdd; break;
+        case EOpSubAssign: op = EOpSub; break;
+        case EOpDivAssign: op = EOpDiv; break;
+        case EOpMulAssign:
+        case EOpVectorTimesScalarAssign:
+        case EOpMatrixTimesScalarAssign: op = EOpMul; break;
+        case EOpVectorTimesMatrixAssign: op = EOpVectorTimesMatrix; break;
+        case EOpMatrixTimesMatrixAssign: op = EOpMatrixTimesMatrix; break;
+        default: break;
+    }
+
+    if (op != EOpNull)
+    {
+        Value value;
+        evaluate(node.children[1], mask, value);
+        Reference reference;
+        evaluateReference(node.children[0], mask, reference);
+        Value current;
+        load(reference, current);
+        arithmetic(op, left, current, right, value, left, result);
+        store(reference, result, mask);
+        return;
+    }
+
+    Value a, b;
+    evaluate(node.children[0], mask, a);
+    evaluate(node.children[1], mask, b);
+    switch (node.op)
+    {
+        case EOpEqual:
+        case EOpNotEqual: {
+            result.resize(1);
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                bool equal = true;
+                for (int c = 0; c < a.size; ++c)
+                    equal = equal && a.component(c)[lane] == b.component(c)[lane];
+                result.data[lane] = (equal == (node.op == EOpEqual)) ? 1.0f : 0.0f;
+            }
+            break;
+        }
+        case EOpLessThan:
+        case EOpGreaterThan:
+        case EOpLessThanEqual:
+        case EOpGreaterThanEqual: {
+            result.resize(1);
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                float x = a.data[lane], y = b.data[lane];
+                bool value = false;
+                switch (node.op)
+                {
+                    case EOpLessThan: value = x < y; break;
+                    case EOpGreaterThan: value = x > y; break;
+                    case EOpLessThanEqual: value = x <= y; break;
+                    default: value = x >= y; break;
+                }
+                result.data[lane] = value ? 1.0f : 0.0f;
+            }
+            break;
+        }
+        default:
+            arithmetic(node.op, left, a, right, b, node, result);
+            break;
+    }
+}
+
+void CpuBatch::evaluateLogical(const CpuNode& node, const Mask& mask, Value& result)
+{
+    Value left;
+    evaluate(node.children[0], mask, left);
+
+    // The right operand of && and || only runs in the lanes that need it.
+    Mask rightMask(kLanes);
+    for (int lane = 0; lane < kLanes; ++lane)
+    {
+        bool value = left.data[lane] != 0.0f;
+        switch (node.op)
+        {
+            case EOpLogicalAnd: rightMask[lane] = mask[lane] && value; break;
+            case EOpLogicalOr: rightMask[lane] = mask[lane] && !value; break;
+            default: rightMask[lane] = mask[lane]; break;
+        }
+    }
+    Value right;
+    right.resize(1);
+    if (AnyActive(rightMask))
+        evaluate(node.children[1], rightMask, right);
+
+    result.resize(1);
+    for (int lane = 0; lane < kLanes; ++lane)
+    {
+        bool x = left.data[lane] != 0.0f;
+        bool y = right.data[lane] != 0.0f;
+        bool value = false;
+        switch (node.op)
+        {
+            case EOpLogicalAnd: value = x && y; break;
+            case EOpLogicalOr: value = x || y; break;
+            default: value = x != y; break;
+        }
+        result.data[lane] = value ? 1.0f : 0.0f;
+    }
+}
+
+void CpuBatch::evaluateTernary(const CpuNode& node, const Mask& mask, Value& result)
+{
+    Value condition;
+    evaluate(node.children[0], mask, condition);
+
+    Mask trueMask(kLanes), falseMask(kLanes);
+    for (int lane = 0; lane < kLanes; ++lane)
+    {
+        bool taken = condition.data[lane] != 0.0f;
+        trueMask[lane] = mask[lane] && taken;
+        falseMask[lane] = mask[lane] && !taken;
+    }
+
+    Value trueValue, falseValue;
+    trueValue.resize(node.size);
+    falseValue.resize(node.size);
+    if (AnyActive(trueMask))
+        evaluate(node.children[1], trueMask, trueValue);
+    if (AnyActive(falseMask))
+        evaluate(node.children[2], falseMask, falseValue);
+
+    result.resize(node.size);
+    for (int c = 0; c < node.size; ++c)
+    {
+        for (int lane = 0; lane < kLanes; ++lane)
+        {
+            bool taken = condition.data[lane] != 0.0f;
+            result.component(c)[lane] = taken ? trueValue.get(c, lane) : falseValue.get(c, lane);
+        }
+    }
+}
+
+void CpuBatch::evaluateConstruct(const CpuNode& node, const Mask& mask, Value& result)
+{
+    std::vector<Value> arguments(node.children.size());
+    for (size_t i = 0; i < node.children.size(); ++i)
+        evaluate(node.children[i], mask, arguments[i]);
+
+    result.resize(node.size);
+    if (node.op == EOpConstructStruct)
+    {
+        int offset = 0;
+        for (size_t i = 0; i < arguments.size(); ++i)
+        {
+            std::copy(arguments[i].data.begin(), arguments[i].data.end(),
+                      result.data.begin() + offset * kLanes);
+            offset += arguments[i].size;
+        }
+        return;
+    }
+
+    const CpuNode& first = mProgram.getNode(node.children[0]);
+    if (node.matrix && arguments.size() == 1 && (first.size == 1 || first.matrix))
+    {
+        // A scalar fills the diagonal; a matrix fills the corresponding
+        // elements, and the identity the others.
+        int n = node.nominalSize;
+        int m = first.matrix ? first.nominalSize : 0;
+        for (int column = 0; column < n; ++column)
+        {
+            for (int row = 0; row < n; ++row)
+            {
+                float* out = result.component(column * n + row);
+                for (int lane = 0; lane < kLanes; ++lane)
+                {
+                    float value = 0.0f;
+                    if (first.size == 1)
+                        value = column == row ? arguments[0].data[lane] : 0.0f;
+                    else if (column < m && row < m)
+                        value = arguments[0].component(column * m + row)[lane];
+                    else
+                        value = column == row ? 1.0f : 0.0f;
+                    out[lane] = Convert(value, first.basicType, node.basicType);
+                }
+            }
+        }
+        return;
+    }
+
+    if (arguments.size() == 1 && first.size == 1)
+    {
+        for (int c = 0; c < node.size; ++c)
+        {
+            for (int lane = 0; lane < kLanes; ++lane)
+                result.component(c)[lane] = Convert(arguments[0].data[lane], first.basicType, node.basicType);
+        }
+        return;
+    }
+
+    // The components of the arguments fill the result in order.
+    int c = 0;
+    for (size_t i = 0; i < arguments.size() && c < node.size; ++i)
+    {
+        TBasicType from = mProgram.getNode(node.children[i]).basicType;
+        for (int k = 0; k < arguments[i].size && c < node.size; ++k, ++c)
+        {
+            for (int lane = 0; lane < kLanes; ++lane)
+                result.component(c)[lane] = Convert(arguments[i].component(k)[lane], from, node.basicType);
+        }
+    }
+}
+
+void CpuBatch::evaluateBuiltIn(const CpuNode& node, const Mask& mask, Value& result)
+{
+    std::vector<Value> arguments(node.children.size());
+    for (size_t i = 0; i < node.children.size(); ++i)
+        evaluate(node.children[i], mask, arguments[i]);
+    const Value& x = arguments[0];
+    const Value* y = arguments.size() > 1 ? &arguments[1] : NULL;
+    const Value* z = arguments.size() > 2 ? &arguments[2] : NULL;
+    int size = x.size;
+
+    result.resize(node.size);
+    switch (node.op)
+    {
+        case EOpLength:
+        case EOpDistance:
+        case EOpDot:
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                float sum = 0.0f;
+                for (int c = 0; c < size; ++c)
+                {
+                    float a = x.component(c)[lane];
+                    if (node.op == EOpDot)
+                        sum += a * y->component(c)[lane];
+                    else if (node.op == EOpDistance)
+                        sum += (a - y->component(c)[lane]) * (a - y->component(c)[lane]);
+                    else
+                        sum += a * a;
+                }
+                result.data[lane] = node.op == EOpDot ? sum : sqrtf(sum);
+            }
+            return;
+        case EOpNormalize:
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                float sum = 0.0f;
+                for (int c = 0; c < size; ++c)
+                    sum += x.component(c)[lane] * x.component(c)[lane];
+                float scale = 1.0f / sqrtf(sum);
+                for (int c = 0; c < size; ++c)
+                    result.component(c)[lane] = x.component(c)[lane] * scale;
+            }
+            return;
+        case EOpCross:
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                float a0 = x.component(0)[lane], a1 = x.component(1)[lane], a2 = x.component(2)[lane];
+                float b0 = y->component(0)[lane], b1 = y->component(1)[lane], b2 = y->component(2)[lane];
+                result.component(0)[lane] = a1 * b2 - a2 * b1;
+                result.component(1)[lane] = a2 * b0 - a0 * b2;
+                result.component(2)[lane] = a0 * b1 - a1 * b0;
+            }
+            return;
+        case EOpFaceForward:
+        case EOpReflect:
+        case EOpRefract:
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                // faceforward(N, I, Nref), reflect(I, N), refract(I, N, eta).
+                float d = 0.0f;
+                for (int c = 0; c < size; ++c)
+                {
+                    if (node.op == EOpFaceForward)
+                        d += z->component(c)[lane] * y->component(c)[lane];
+                    else
+                        d += y->component(c)[lane] * x.component(c)[lane];
+                }
+                float k = 0.0f;
+                float eta = node.op == EOpRefract ? z->data[lane] : 0.0f;
+                if (node.op == EOpRefract)
+                    k = 1.0f - eta * eta * (1.0f - d * d);
+                for (int c = 0; c < size; ++c)
+                {
+                    float a = x.component(c)[lane];
+                    float value = 0.0f;
+                    if (node.op == EOpFaceForward)
+                        value = d < 0.0f ? a : -a;
+                    else if (node.op == EOpReflect)
+                        value = a - 2.0f * d * y->component(c)[lane];
+                    else if (k >= 0.0f)
+                        value = eta * a - (eta * d + sqrtf(k)) * y->component(c)[lane];
+                    result.component(c)[lane] = value;
+                }
+            }
+            return;
+        case EOpAny:
+        case EOpAll:
+            for (int lane = 0; lane < kLanes; ++lane)
+            {
+                bool any = false, all = true;
+                for (int c = 0; c < size; ++c)
+                {
+                    bool value = x.component(c)[lane] != 0.0f;
+                    any = any || value;
+                    all = all && value;
+                }
+                result.data[lane] = (node.op == EOpAny ? any : all) ? 1.0f : 0.0f;
+            }
+            return;
+        case EOpDFdx:
+        case EOpDFdy:
+        case EOpFwidth:
+            for (int c = 0; c < size; ++c)
+            {
+                const float* v = x.component(c);
+                for (int lane = 0; lane < kLanes; ++lane)
+                {
+                    float dx = v[lane | 1] - v[lane & ~1];
+                    float dy = v[lane | 2] - v[lane & ~2];
+                    float value = node.op == EOpDFdx ? dx :
+                                  node.op == EOpDFdy ? dy : fabsf(dx) + fabsf(dy);
+                    result.component(c)[lane] = value;
+                }
+            }
+            return;
+        default:
+            break;
+    }
+
+    // The remaining functions operate on each component, with scalar
+    // arguments broadcast to the size of the result.
+    for (int c = 0; c < node.size; ++c)
+    {
+        float* out = result.component(c);
+        for (int lane = 0; lane < kLanes; ++lane)
+        {
+            float a = x.get(c, lane);
+            float b = y ? y->get(c, lane) : 0.0f;
+            float t = z ? z->get(c, lane) : 0.0f;
+            float value = 0.0f;
+            switch (node.op)
+            {
+                case EOpRadians: value = a * 0.017453292519943295f; break;
+                case EOpDegrees: value = a * 57.29577951308232f; break;
+                case EOpSin: value = sinf(a); break;
+                case EOpCos: value = cosf(a); break;
+                case EOpTan: value = tanf(a); break;
+                case EOpAsin: value = asinf(a); break;
+                case EOpAcos: value = acosf(a); break;
+                case EOpAtan: value = y ? atan2f(a, b) : atanf(a); break;
+                case EOpPow: value = powf(a, b); break;
+                case EOpExp: value = expf(a); break;
+                case EOpLog: value = logf(a); break;
+                case EOpExp2: value = powf(2.0f, a); break;
+                case EOpLog2: value = logf(a) * 1.4426950408889634f; break;
+                case EOpSqrt: value = sqrtf(a); break;
+                case EOpInverseSqrt: value = 1.0f / sqrtf(a); break;
+                case EOpAbs: value = fabsf(a); break;
+                case EOpSign: value = a > 0.0f ? 1.0f : (a < 0.0f ? -1.0f : 0.0f); break;
+                case EOpFloor: value = floorf(a); break;
+                case EOpCeil: value = ceilf(a); break;
+                case EOpFract: value = a - floorf(a); break;
+                case EOpMod: value = a - b * floorf(a / b); break;
+                case EOpMin: value = b < a ? b : a; break;
+                case EOpMax: value = a < b ? b : a; break;
+                case EOpClamp: value = std::min(std::max(a, b), t); break;
+                case EOpMix: value = a * (1.0f - t) + b * t; break;
+                case EOpStep: value = b < a ? 0.0f : 1.0f; break;
+                case EOpSmoothStep: {
+                    float s = std::min(std::max((t - a) / (b - a), 0.0f), 1.0f);
+                    value = s * s * (3.0f - 2.0f * s);
+                    break;
+                }
+                case EOpMul: value = a * b; break;
+                case EOpLessThan: value = a < b ? 1.0f : 0.0f; break;
+                case EOpGreaterThan: value = a > b ? 1.0f : 0.0f; break;
+                case EOpLessThanEqual: value = a <= b ? 1.0f : 0.0f; break;
+                case EOpGreaterThanEqual: value = a >= b ? 1.0f : 0.0f; break;
+                case EOpVectorEqual: value = a == b ? 1.0f : 0.0f; break;
+                case EOpVectorNotEqual: value = a != b ? 1.0f : 0.0f; break;
+                case EOpVectorLogicalNot: value = a != 0.0f ? 0.0f : 1.0f; break;
+                default: UNREACHABLE(); break;
+            }
+            out[lane] = value;
+        }
+    }
+}
+
+void CpuBatch::evaluateTexture(const CpuNode& node, const Mask& mask, Value& result)
+{
+    std::vector<Value> arguments(node.children.size());
+    for (size_t i = 0; i < node.children.size(); ++i)
+        evaluate(node.children[i], mask, arguments[i]);
+
+    bool cube = node.texture == ECpuTextureCube || node.texture == ECpuTextureCubeLod;
+    bool projected = node.texture == ECpuTexture2DProj || node.texture == ECpuTexture2DProjLod;
+    bool explicitLod = node.texture == ECpuTexture2DLod || node.texture == ECpuTexture2DProjLod ||
+                       node.texture == ECpuTextureCubeLod;
+    const Value& coordinates = arguments[1];
+
+    result.resize(4);
+    std::fill(result.data.begin(), result.data.end(), 0.0f);
+    for (int lane = 0; lane < kLanes; ++lane)
+    {
+        if (!mask[lane] || mSampler == NULL)
+            continue;
+
+        float point[3] = { 0.0f, 0.0f, 0.0f };
+        int dimensions = cube ? 3 : 2;
+        for (int c = 0; c < dimensions; ++c)
+            point[c] = coordinates.component(c)[lane];
+        if (projected)
+        {
+            // The last component of a vec3 or vec4 divides the others.
+            float q = coordinates.component(coordinates.size - 1)[lane];
+            point[0] /= q;
+            point[1] /= q;
+        }
+        float lod = arguments.size() > 2 ? arguments[2].data[lane] : 0.0f;
+
+        float rgba[4];
+        int unit = static_cast<int>(arguments[0].data[lane]);
+        mSampler->sample(unit, cube, point, lod, explicitLod, rgba);
+        for (int c = 0; c < 4; ++c)
+            result.component(c)[lane] = rgba[c];
+    }
+}
+
+void CpuBatch::evaluateCall(const CpuNode& node, const Mask& mask, Value& result)
+{
+    const CpuFunction& function = mProgram.getFunction(node.slot);
+    size_t count = function.parameters.size();
+
+    // All the arguments are evaluated before any parameter is written,
+    // since the arguments may call the function too.
+    std::vector<Value> values(count);
+    std::vector<Reference> references(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        TQualifier qualifier = function.parameters[i].qualifier;
+        if (qualifier == EvqOut || qualifier == EvqInOut)
+        {
+            evaluateReference(node.children[i], mask, references[i]);
+            if (qualifier == EvqInOut)
+                load(references[i], values[i]);
+        }
+        else
+        {
+            evaluate(node.children[i], mask, values[i]);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const CpuFunction::Parameter& parameter = function.parameters[i];
+        if (parameter.qualifier == EvqOut)
+            continue;
+        Reference target;
+        target.base = slot(parameter.slot);
+        for (int c = 0; c < parameter.size; ++c)
+            target.components.push_back(c);
+        store(target, values[i], mask);
+    }
+
+    callFunction(node.slot, mask);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const CpuFunction::Parameter& parameter = function.parameters[i];
+        if (parameter.qualifier != EvqOut && parameter.qualifier != EvqInOut)
+            continue;
+        Reference source;
+        source.base = slot(parameter.slot);
+        for (int c = 0; c < parameter.size; ++c)
+            source.components.push_back(c);
+        Value value;
+        load(source, value);
+        store(references[i], value, mask);
+    }
+
+    result.resize(function.resultSize);
+    if (function.resultSize > 0)
+        memcpy(&result.data[0], slot(function.resultSlot), function.resultSize * kLanes * sizeof(float));
+}
+
+CpuExecutor::CpuExecutor(const CpuProgram& program)
+    : CpuBindings(program)
+{
+}
+
+void CpuExecutor::run(int count, bool* discarded)
+{
+    std::vector<float> storage(mProgram.getStorageSize() * kLanes);
+    for (int first = 0; first < count; first += kLanes)
+    {
+        int lanes = std::min(kLanes, count - first);
+        loadBatch(&storage[0], first, lanes);
+
+        Mask mask(kLanes, 0);
+        std::fill(mask.begin(), mask.begin() + lanes, 1);
+        CpuBatch batch(mProgram, mSampler, storage);
+        batch.run(mask);
+
+        storeBatch(&storage[0], first, lanes);
+        if (discarded)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+                discarded[first + lane] = batch.getDiscarded()[lane] != 0;
+        }
+    }
+}
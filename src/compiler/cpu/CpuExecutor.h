@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_CPU_CPU_EXECUTOR_H_
+#define COMPILER_CPU_CPU_EXECUTOR_H_
+
+//
+// Runs a CpuProgram on the CPU.
+//
+// Invocations are evaluated kLanes at a time. Every variable and every
+// intermediate value holds one component of all the lanes contiguously, so
+// that each operation of the shader is a loop over the lanes that the
+// compiler can vectorize. Control flow is evaluated with a mask of active
+// lanes: both sides of a branch whose condition differs between lanes are
+// run, each with the lanes that take it, and loops run until no lane
+// continues.
+//
+// Derivatives are computed between the fragments of a quad: invocations 4k,
+// 4k + 1, 4k + 2 and 4k + 3 are taken to be the fragments at (x, y),
+// (x + 1, y), (x, y + 1) and (x + 1, y + 1). Dynamic indices are clamped
+// to the bounds of the indexed value.
+//
+
+#include "compiler/cpu/CpuBindings.h"
+
+class CpuExecutor : public CpuBindings
+{
+public:
+    CpuExecutor(const CpuProgram& program);
+
+    // Runs count invocations of the shader. If discarded is not null, it
+    // receives for each invocation whether the fragment was discarded.
+    void run(int count, bool* discarded);
+};
+
+#endif  // COMPILER_CPU_CPU_EXECUTOR_H_
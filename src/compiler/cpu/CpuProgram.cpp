@@ -0,0 +1,512 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/cpu/CpuProgram.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "compiler/SymbolTable.h"
+#include "compiler/debug.h"
+
+namespace {
+
+int GetElementCount(const TType& type)
+{
+    return type.isArray() ? std::max(type.getArraySize(), type.getMaxArraySize()) : 1;
+}
+
+int GetElementSize(const TType& type)
+{
+    return type.getObjectSize() / GetElementCount(type);
+}
+
+bool IsInterfaceQualifier(TQualifier qualifier)
+{
+    switch (qualifier)
+    {
+        case EvqAttribute:
+        case EvqVaryingIn:
+        case EvqVaryingOut:
+        case EvqInvariantVaryingIn:
+        case EvqInvariantVaryingOut:
+        case EvqUniform:
+        case EvqPosition:
+        case EvqPointSize:
+        case EvqFragCoord:
+        case EvqFrontFacing:
+        case EvqPointCoord:
+        case EvqFragColor:
+        case EvqFragData:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string ArrayElementName(const std::string& name, int index)
+{
+    std::ostringstream stream;
+    stream << name << "[" << index << "]";
+    return stream.str();
+}
+
+bool GetTexture(const TString& name, CpuTexture* texture)
+{
+    TString function = TFunction::unmangleName(name);
+    if (function == "texture2D" || function == "texture2DRect")
+        *texture = ECpuTexture2D;
+    else if (function == "texture2DProj" || function == "texture2DRectProj")
+        *texture = ECpuTexture2DProj;
+    else if (function == "texture2DLod")
+        *texture = ECpuTexture2DLod;
+    else if (function == "texture2DProjLod")
+        *texture = ECpuTexture2DProjLod;
+    else if (function == "textureCube")
+        *texture = ECpuTextureCube;
+    else if (function == "textureCubeLod")
+        *texture = ECpuTextureCubeLod;
+    else
+        return false;
+    return true;
+}
+
+}  // namespace
+
+//
+// Copies the tree into the nodes of a CpuProgram.
+//
+class CpuProgramBuilder
+{
+public:
+    CpuProgramBuilder(CpuProgram* program) : mProgram(program) { }
+
+    bool build(TIntermNode* root);
+
+private:
+    int newNode(CpuNodeKind kind, TIntermTyped* typed);
+    int symbolSlot(TIntermSymbol* symbol);
+    void addVariable(const TType& type, TQualifier qualifier, const std::string& name, int slot);
+    void addFunction(TIntermAggregate* node);
+    void buildFunction(TIntermAggregate* node);
+
+    int buildNode(TIntermNode* node);
+    int buildBinary(TIntermBinary* node);
+    int buildAggregate(TIntermAggregate* node);
+    void buildChildren(const TIntermSequence& sequence, int index);
+
+    CpuProgram* mProgram;
+    std::map<int, int> mSlots;
+    std::map<TString, int> mFunctionIndices;
+};
+
+bool CpuProgramBuilder::build(TIntermNode* root)
+{
+    TIntermAggregate* sequence = root->getAsAggregate();
+    if (sequence == NULL || sequence->getOp() != EOpSequence)
+        return false;
+
+    // Functions get their indices first, since calls may precede the
+    // definition of the function they call.
+    const TIntermSequence& statements = sequence->getSequence();
+    for (size_t i = 0; i < statements.size(); ++i)
+    {
+        TIntermAggregate* function = statements[i]->getAsAggregate();
+        if (function && function->getOp() == EOpFunction)
+            addFunction(function);
+    }
+
+    for (size_t i = 0; i < statements.size(); ++i)
+    {
+        TIntermAggregate* aggregate = statements[i]->getAsAggregate();
+        if (aggregate == NULL)
+            continue;
+        if (aggregate->getOp() == EOpFunction)
+            buildFunction(aggregate);
+        else if (aggregate->getOp() == EOpDeclaration)
+            mProgram->mGlobals.push_back(buildNode(aggregate));
+    }
+
+    std::map<TString, int>::const_iterator main = mFunctionIndices.find("main(");
+    if (main == mFunctionIndices.end())
+        return false;
+    mProgram->mMain = main->second;
+    return true;
+}
+
+int CpuProgramBuilder::newNode(CpuNodeKind kind, TIntermTyped* typed)
+{
+    CpuNode node;
+    node.kind = kind;
+    node.op = EOpNull;
+    node.basicType = EbtVoid;
+    node.nominalSize = 1;
+    node.matrix = false;
+    node.size = 0;
+    node.slot = -1;
+    node.elementSize = 0;
+    node.elementCount = 0;
+    node.loopType = ELoopFor;
+    node.texture = ECpuTexture2D;
+    if (typed)
+    {
+        const TType& type = typed->getType();
+        node.basicType = type.getBasicType();
+        node.nominalSize = type.getNominalSize();
+        node.matrix = type.isMatrix();
+        node.size = type.getBasicType() == EbtVoid ? 0 : type.getObjectSize();
+    }
+    mProgram->mNodes.push_back(node);
+    return static_cast<int>(mProgram->mNodes.size()) - 1;
+}
+
+int CpuProgramBuilder::symbolSlot(TIntermSymbol* symbol)
+{
+    std::map<int, int>::const_iterator iter = mSlots.find(symbol->getId());
+    if (iter != mSlots.end())
+        return iter->second;
+
+    int slot = mProgram->mStorageSize;
+    mProgram->mStorageSize += symbol->getType().getObjectSize();
+    mSlots[symbol->getId()] = slot;
+
+    TQualifier qualifier = symbol->getQualifier();
+    if (IsInterfaceQualifier(qualifier))
+        addVariable(symbol->getType(), qualifier, symbol->getOriginalSymbol().c_str(), slot);
+    return slot;
+}
+
+void CpuProgramBuilder::addVariable(const TType& type, TQualifier qualifier,
+                                    const std::string& name, int slot)
+{
+    if (type.getBasicType() == EbtStruct)
+    {
+        int elementCount = GetElementCount(type);
+        int elementSize = GetElementSize(type);
+        for (int i = 0; i < elementCount; ++i)
+        {
+            std::string elementName = type.isArray() ? ArrayElementName(name, i) : name;
+            int offset = slot + i * elementSize;
+            const TTypeList* structure = type.getStruct();
+            for (size_t j = 0; j < structure->size(); ++j)
+            {
+                const TType* field = (*structure)[j].type;
+                addVariable(*field, qualifier,
+                            elementName + "." + field->getFieldName().c_str(), offset);
+                offset += field->getObjectSize();
+            }
+        }
+        return;
+    }
+
+    CpuVariable variable;
+    variable.name = type.isArray() ? ArrayElementName(name, 0) : name;
+    variable.qualifier = qualifier;
+    variable.basicType = type.getBasicType();
+    variable.slot = slot;
+    variable.size = GetElementSize(type);
+    variable.arraySize = GetElementCount(type);
+    mProgram->mVariables.push_back(variable);
+}
+
+void CpuProgramBuilder::addFunction(TIntermAggregate* node)
+{
+    CpuFunction function;
+    function.name = TFunction::unmangleName(node->getName()).c_str();
+    const TType& type = node->getType();
+    function.resultSize = type.getBasicType() == EbtVoid ? 0 : type.getObjectSize();
+    function.resultSlot = mProgram->mStorageSize;
+    mProgram->mStorageSize += function.resultSize;
+    function.body = -1;
+
+    mFunctionIndices[node->getName()] = static_cast<int>(mProgram->mFunctions.size());
+    mProgram->mFunctions.push_back(function);
+}
+
+void CpuProgramBuilder::buildFunction(TIntermAggregate* node)
+{
+    // Function definition node contains one or two children nodes
+    // representing function parameters and function body. The latter
+    // is not present in case of empty function bodies.
+    const TIntermSequence& sequence = node->getSequence();
+    ASSERT((sequence.size() == 1) || (sequence.size() == 2));
+    TIntermAggregate* parameters = sequence[0]->getAsAggregate();
+    ASSERT(parameters != NULL && parameters->getOp() == EOpParameters);
+
+    int index = mFunctionIndices[node->getName()];
+    const TIntermSequence& symbols = parameters->getSequence();
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        TIntermSymbol* symbol = symbols[i]->getAsSymbolNode();
+        ASSERT(symbol != NULL);
+        CpuFunction::Parameter parameter;
+        parameter.slot = symbolSlot(symbol);
+        parameter.size = symbol->getType().getObjectSize();
+        parameter.qualifier = symbol->getQualifier();
+        mProgram->mFunctions[index].parameters.push_back(parameter);
+    }
+
+    if (sequence.size() == 2)
+    {
+        int body = buildNode(sequence[1]);
+        mProgram->mFunctions[index].body = body;
+    }
+}
+
+void CpuProgramBuilder::buildChildren(const TIntermSequence& sequence, int index)
+{
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        int child = buildNode(sequence[i]);
+        mProgram->mNodes[index].children.push_back(child);
+    }
+}
+
+int CpuProgramBuilder::buildNode(TIntermNode* node)
+{
+    if (node == NULL)
+        return -1;
+
+    if (TIntermSymbol* symbol = node->getAsSymbolNode())
+    {
+        int slot = symbolSlot(symbol);
+        int index = newNode(ECpuSymbol, symbol);
+        mProgram->mNodes[index].slot = slot;
+        return index;
+    }
+
+    if (TIntermConstantUnion* constant = node->getAsConstantUnion())
+    {
+        int index = newNode(ECpuConstant, constant);
+        const ConstantUnion* values = constant->getUnionArrayPointer();
+        CpuNode& cpuNode = mProgram->mNodes[index];
+        for (int i = 0; i < cpuNode.size; ++i)
+        {
+            switch (values[i].getType())
+            {
+                case EbtFloat: cpuNode.constants.push_back(values[i].getFConst()); break;
+                case EbtInt: cpuNode.constants.push_back(static_cast<float>(values[i].getIConst())); break;
+                case EbtBool: cpuNode.constants.push_back(values[i].getBConst() ? 1.0f : 0.0f); break;
+                default: UNREACHABLE(); break;
+            }
+        }
+        return index;
+    }
+
+    if (TIntermBinary* binary = node->getAsBinaryNode())
+        return buildBinary(binary);
+
+    if (TIntermUnary* unary = node->getAsUnaryNode())
+    {
+        int index = newNode(ECpuUnary, unary);
+        int operand = buildNode(unary->getOperand());
+        mProgram->mNodes[index].op = unary->getOp();
+        mProgram->mNodes[index].children.push_back(operand);
+        return index;
+    }
+
+    if (TIntermSelection* selection = node->getAsSelectionNode())
+    {
+        bool ternary = selection->usesTernaryOperator();
+        int index = newNode(ternary ? ECpuTernary : ECpuSelection,
+                            ternary ? selection : NULL);
+        int condition = buildNode(selection->getCondition());
+        int trueBlock = buildNode(selection->getTrueBlock());
+        int falseBlock = buildNode(selection->getFalseBlock());
+        std::vector<int>& children = mProgram->mNodes[index].children;
+        children.push_back(condition);
+        children.push_back(trueBlock);
+        children.push_back(falseBlock);
+        return index;
+    }
+
+    if (TIntermLoop* loop = node->getAsLoopNode())
+    {
+        int index = newNode(ECpuLoop, NULL);
+        mProgram->mNodes[index].loopType = loop->getType();
+        int init = buildNode(loop->getInit());
+        int condition = buildNode(loop->getCondition());
+        int expression = buildNode(loop->getExpression());
+        int body = buildNode(loop->getBody());
+        std::vector<int>& children = mProgram->mNodes[index].children;
+        children.push_back(init);
+        children.push_back(condition);
+        children.push_back(expression);
+        children.push_back(body);
+        return index;
+    }
+
+    if (TIntermBranch* branch = node->getAsBranchNode())
+    {
+        int index = newNode(ECpuBranch, NULL);
+        mProgram->mNodes[index].op = branch->getFlowOp();
+        if (branch->getExpression())
+        {
+            int value = buildNode(branch->getExpression());
+            mProgram->mNodes[index].children.push_back(value);
+        }
+        return index;
+    }
+
+    TIntermAggregate* aggregate = node->getAsAggregate();
+    ASSERT(aggregate != NULL);
+    return buildAggregate(aggregate);
+}
+
+int CpuProgramBuilder::buildBinary(TIntermBinary* node)
+{
+    switch (node->getOp())
+    {
+        case EOpIndexDirect:
+        case EOpIndexIndirect: {
+            int index = newNode(ECpuIndex, node);
+            const TType& baseType = node->getLeft()->getType();
+            CpuNode& cpuNode = mProgram->mNodes[index];
+            if (baseType.isArray())
+            {
+                cpuNode.elementSize = GetElementSize(baseType);
+                cpuNode.elementCount = GetElementCount(baseType);
+            }
+            else if (baseType.isMatrix())
+            {
+                cpuNode.elementSize = baseType.getNominalSize();
+                cpuNode.elementCount = baseType.getNominalSize();
+            }
+            else
+            {
+                cpuNode.elementSize = 1;
+                cpuNode.elementCount = baseType.getNominalSize();
+            }
+            int base = buildNode(node->getLeft());
+            int element = buildNode(node->getRight());
+            mProgram->mNodes[index].children.push_back(base);
+            mProgram->mNodes[index].children.push_back(element);
+            return index;
+        }
+        case EOpIndexDirectStruct: {
+            int index = newNode(ECpuField, node);
+            const TTypeList* structure = node->getLeft()->getType().getStruct();
+            int field = node->getRight()->getAsConstantUnion()->getUnionArrayPointer()->getIConst();
+            int offset = 0;
+            for (int i = 0; i < field; ++i)
+                offset += (*structure)[i].type->getObjectSize();
+            int base = buildNode(node->getLeft());
+            mProgram->mNodes[index].slot = offset;
+            mProgram->mNodes[index].children.push_back(base);
+            return index;
+        }
+        case EOpVectorSwizzle: {
+            int index = newNode(ECpuSwizzle, node);
+            const TIntermSequence& components = node->getRight()->getAsAggregate()->getSequence();
+            for (size_t i = 0; i < components.size(); ++i)
+            {
+                int component = components[i]->getAsConstantUnion()->getUnionArrayPointer()->getIConst();
+                mProgram->mNodes[index].swizzle.push_back(component);
+            }
+            int base = buildNode(node->getLeft());
+            mProgram->mNodes[index].children.push_back(base);
+            return index;
+        }
+        default: {
+            int index = newNode(ECpuBinary, node);
+            mProgram->mNodes[index].op = node->getOp();
+            int left = buildNode(node->getLeft());
+            int right = buildNode(node->getRight());
+            mProgram->mNodes[index].children.push_back(left);
+            mProgram->mNodes[index].children.push_back(right);
+            return index;
+        }
+    }
+}
+
+int CpuProgramBuilder::buildAggregate(TIntermAggregate* node)
+{
+    int index = -1;
+    switch (node->getOp())
+    {
+        case EOpSequence:
+            index = newNode(ECpuBlock, NULL);
+            break;
+        case EOpDeclaration:
+            index = newNode(ECpuDeclaration, NULL);
+            break;
+        case EOpComma:
+            index = newNode(ECpuBinary, node);
+            break;
+        case EOpFunctionCall:
+            index = newNode(ECpuCall, node);
+            if (node->isUserDefined())
+            {
+                std::map<TString, int>::const_iterator iter = mFunctionIndices.find(node->getName());
+                ASSERT(iter != mFunctionIndices.end());
+                mProgram->mNodes[index].slot = iter->second;
+            }
+            else
+            {
+                mProgram->mNodes[index].kind = ECpuTexture;
+                bool found = GetTexture(node->getName(), &mProgram->mNodes[index].texture);
+                ASSERT(found);
+            }
+            break;
+        case EOpConstructInt:
+        case EOpConstructBool:
+        case EOpConstructFloat:
+        case EOpConstructVec2:
+        case EOpConstructVec3:
+        case EOpConstructVec4:
+        case EOpConstructBVec2:
+        case EOpConstructBVec3:
+        case EOpConstructBVec4:
+        case EOpConstructIVec2:
+        case EOpConstructIVec3:
+        case EOpConstructIVec4:
+        case EOpConstructMat2:
+        case EOpConstructMat3:
+        case EOpConstructMat4:
+        case EOpConstructStruct:
+            index = newNode(ECpuConstruct, node);
+            break;
+        default:
+            index = newNode(ECpuBuiltIn, node);
+            break;
+    }
+    mProgram->mNodes[index].op = node->getOp();
+    buildChildren(node->getSequence(), index);
+    return index;
+}
+
+CpuProgram::CpuProgram()
+    : mMain(-1),
+      mStorageSize(0)
+{
+}
+
+void CpuProgram::clear()
+{
+    mNodes.clear();
+    mFunctions.clear();
+    mVariables.clear();
+    mGlobals.clear();
+    mMain = -1;
+    mStorageSize = 0;
+}
+
+bool CpuProgram::build(TIntermNode* root)
+{
+    clear();
+    CpuProgramBuilder builder(this);
+    return builder.build(root);
+}
+
+int CpuProgram::getVariableIndex(const std::string& name) const
+{
+    for (size_t i = 0; i < mVariables.size(); ++i)
+    {
+        if (mVariables[i].name == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_CPU_CPU_PROGRAM_H_
+#define COMPILER_CPU_CPU_PROGRAM_H_
+
+//
+// A compiled shader in the form executed by CpuExecutor.
+//
+// The intermediate tree lives in the pool of the compiler and is freed at
+// the end of the compile, so TranslatorCPU copies it into a CpuProgram:
+// a flat array of nodes that refer to each other by index, and that only
+// keep what evaluation needs. Every value is stored as a sequence of float
+// components; ints hold integral values and bools hold 0 or 1. Since
+// recursion is forbidden, every variable of the shader, including locals
+// and parameters, has a fixed slot in the storage of the program.
+//
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "compiler/intermediate.h"
+
+enum CpuNodeKind
+{
+    ECpuBlock,          // children: statements
+    ECpuDeclaration,    // children: symbols or initializations
+    ECpuSymbol,         // slot
+    ECpuConstant,       // constants
+    ECpuUnary,          // op; children: operand. Includes the built-in
+                        // functions of one argument.
+    ECpuBinary,         // op; children: left, right
+    ECpuIndex,          // children: base, index; elementSize, elementCount
+    ECpuField,          // children: base; slot is the offset of the field
+    ECpuSwizzle,        // children: base; swizzle
+    ECpuConstruct,      // op; children: arguments
+    ECpuBuiltIn,        // op; children: arguments
+    ECpuTexture,        // texture; children: arguments
+    ECpuCall,           // slot is the function; children: arguments
+    ECpuSelection,      // children: condition, true, false (or -1)
+    ECpuTernary,        // children: condition, true, false
+    ECpuLoop,           // loopType; children: init, condition, expression,
+                        // body, each -1 if absent
+    ECpuBranch,         // op; children: returned value, if any
+};
+
+// Texture lookup functions, which call CpuSampler.
+enum CpuTexture
+{
+    ECpuTexture2D,
+    ECpuTexture2DProj,
+    ECpuTexture2DLod,
+    ECpuTexture2DProjLod,
+    ECpuTextureCube,
+    ECpuTextureCubeLod,
+};
+
+struct CpuNode
+{
+    CpuNodeKind kind;
+    TOperator op;
+    TBasicType basicType;
+    // Components of a vector or columns of a matrix, as in TType.
+    int nominalSize;
+    bool matrix;
+    // Number of float components of the value.
+    int size;
+
+    int slot;
+    int elementSize;
+    int elementCount;
+    TLoopType loopType;
+    CpuTexture texture;
+
+    std::vector<int> children;
+    std::vector<float> constants;
+    std::vector<int> swizzle;
+};
+
+struct CpuFunction
+{
+    struct Parameter
+    {
+        int slot;
+        int size;
+        TQualifier qualifier;
+    };
+
+    std::string name;
+    std::vector<Parameter> parameters;
+    int resultSlot;
+    int resultSize;
+    // Node of the body, or -1 if the function is empty.
+    int body;
+};
+
+// A variable of the interface of the shader: a uniform, an attribute, a
+// varying or a built-in variable such as gl_Position. Variables are named
+// like TVariableInfo does, so that the attributes and uniforms listed by
+// the compiler can be looked up by name: variables of struct type are split
+// into their fields, as in "lights[1].color", and arrays of other types are
+// a single variable named after their first element, as in "weights[0]".
+struct CpuVariable
+{
+    std::string name;
+    TQualifier qualifier;
+    TBasicType basicType;
+    int slot;
+    // Components of one element, and number of elements.
+    int size;
+    int arraySize;
+};
+
+class CpuProgram
+{
+public:
+    CpuProgram();
+
+    void clear();
+    // Builds the program from the tree of a compiled shader. Returns false
+    // if the tree has no main function.
+    bool build(TIntermNode* root);
+
+    const CpuNode& getNode(int index) const { return mNodes[index]; }
+    const CpuFunction& getFunction(int index) const { return mFunctions[index]; }
+    int getFunctionCount() const { return static_cast<int>(mFunctions.size()); }
+    const std::vector<CpuVariable>& getVariables() const { return mVariables; }
+    // Returns the index of the variable with the given name, or -1.
+    int getVariableIndex(const std::string& name) const;
+
+    // Global declarations, run before main, in order.
+    const std::vector<int>& getGlobals() const { return mGlobals; }
+    int getMain() const { return mMain; }
+    int getStorageSize() const { return mStorageSize; }
+
+private:
+    friend class CpuProgramBuilder;
+
+    std::vector<CpuNode> mNodes;
+    std::vector<CpuFunction> mFunctions;
+    std::vector<CpuVariable> mVariables;
+    std::vector<int> mGlobals;
+    int mMain;
+    int mStorageSize;
+};
+
+#endif  // COMPILER_CPU_CPU_PROGRAM_H_
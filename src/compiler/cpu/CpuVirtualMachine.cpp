@@ -0,0 +1,645 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/cpu/CpuVirtualMachine.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "compiler/debug.h"
+
+namespace {
+
+const int kLanes = CpuBindings::kLanes;
+
+// Scratch areas of the operands and of the result of an instruction.
+enum ScratchArea
+{
+    EScratchA,
+    EScratchB,
+    EScratchC,
+    EScratchResult,
+    EScratchCount
+};
+
+float Truncate(float f)
+{
+    return f < 0.0f ? ceilf(f) : floorf(f);
+}
+
+float Clamp(float x, float low, float high)
+{
+    return std::min(std::max(x, low), high);
+}
+
+float Boolean(bool b)
+{
+    return b ? 1.0f : 0.0f;
+}
+
+}  // namespace
+
+// Evaluates expression for each lane into d.
+#define FOR_EACH_LANE(expression) \
+    for (int l = 0; l < kLanes; ++l) \
+        d[l] = (expression)
+
+CpuVirtualMachine::CpuVirtualMachine(const CpuBytecode& bytecode)
+    : CpuBindings(bytecode.getProgram()),
+      mBytecode(bytecode),
+      mFrameCount(0),
+      mAnyActive(false),
+      mAllActive(false),
+      mExecutedInstructions(0)
+{
+}
+
+void CpuVirtualMachine::run(int count, bool* discarded)
+{
+    mRegisters.resize(mBytecode.getRegisterCount() * kLanes);
+    mScratch.resize(EScratchCount * std::max(mBytecode.getMaxOperandSize(), 1) * kLanes);
+
+    // Constants are not written by the program, so they are set once.
+    const std::vector<float>& constants = mBytecode.getConstants();
+    for (size_t i = 0; i < constants.size(); ++i)
+    {
+        float* destination = &mRegisters[(mProgram.getStorageSize() + i) * kLanes];
+        std::fill(destination, destination + kLanes, constants[i]);
+    }
+
+    for (int first = 0; first < count; first += kLanes)
+    {
+        int lanes = std::min(kLanes, count - first);
+        loadBatch(&mRegisters[0], first, lanes);
+        runBatch(lanes);
+        storeBatch(&mRegisters[0], first, lanes);
+        if (discarded)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+                discarded[first + lane] = mDiscarded[lane] != 0;
+        }
+    }
+}
+
+CpuVirtualMachine::Frame& CpuVirtualMachine::pushFrame()
+{
+    if (mFrameCount == static_cast<int>(mFrames.size()))
+        mFrames.push_back(Frame());
+    return mFrames[mFrameCount++];
+}
+
+void CpuVirtualMachine::updateMask()
+{
+    int active = 0;
+    for (int l = 0; l < kLanes; ++l)
+        active += mMask[l];
+    mAnyActive = active > 0;
+    mAllActive = active == kLanes;
+}
+
+void CpuVirtualMachine::runBatch(int lanes)
+{
+    for (int l = 0; l < kLanes; ++l)
+    {
+        mMask[l] = l < lanes;
+        mDiscarded[l] = 0;
+    }
+    updateMask();
+    mFrameCount = 0;
+    int loop = -1;
+    int call = -1;
+
+    const std::vector<CpuInstruction>& instructions = mBytecode.getInstructions();
+    int pc = 0;
+    while (true)
+    {
+        const CpuInstruction& instruction = instructions[pc];
+        ++mExecutedInstructions;
+        switch (instruction.op)
+        {
+            case ECpuOpIf: {
+                gather(instruction.a, EScratchA);
+                const float* condition = source(instruction.a, 0, EScratchA);
+                Frame& frame = pushFrame();
+                for (int l = 0; l < kLanes; ++l)
+                {
+                    bool taken = condition[l] != 0.0f;
+                    frame.first[l] = 0;
+                    frame.second[l] = mMask[l] && !taken;
+                    mMask[l] = mMask[l] && taken;
+                }
+                updateMask();
+                pc = mAnyActive ? pc + 1 : instruction.target;
+                break;
+            }
+            case ECpuOpElse: {
+                Frame& frame = mFrames[mFrameCount - 1];
+                for (int l = 0; l < kLanes; ++l)
+                {
+                    frame.first[l] |= mMask[l];
+                    mMask[l] = frame.second[l];
+                    frame.second[l] = 0;
+                }
+                updateMask();
+                pc = mAnyActive ? pc + 1 : instruction.target;
+                break;
+            }
+            case ECpuOpEndIf: {
+                // The invocations that ran break, continue, return or
+                // discard in the branches are not resumed.
+                const Frame& frame = mFrames[--mFrameCount];
+                for (int l = 0; l < kLanes; ++l)
+                    mMask[l] |= frame.first[l] | frame.second[l];
+                updateMask();
+                ++pc;
+                break;
+            }
+            case ECpuOpLoop: {
+                Frame& frame = pushFrame();
+                memcpy(frame.first, mMask, kLanes);
+                memset(frame.second, 0, kLanes);
+                frame.link = loop;
+                loop = mFrameCount - 1;
+                ++pc;
+                break;
+            }
+            case ECpuOpLoopTest: {
+                gather(instruction.a, EScratchA);
+                const float* condition = source(instruction.a, 0, EScratchA);
+                for (int l = 0; l < kLanes; ++l)
+                    mMask[l] = mMask[l] && condition[l] != 0.0f;
+                updateMask();
+                pc = mAnyActive ? pc + 1 : instruction.target;
+                break;
+            }
+            case ECpuOpLoopContinue: {
+                Frame& frame = mFrames[loop];
+                for (int l = 0; l < kLanes; ++l)
+                {
+                    mMask[l] |= frame.second[l];
+                    frame.second[l] = 0;
+                }
+                updateMask();
+                ++pc;
+                break;
+            }
+            case ECpuOpLoopJump:
+                pc = mAnyActive ? instruction.target : pc + 1;
+                break;
+            case ECpuOpLoopEnd: {
+                // The invocations that left the loop resume, unless they
+                // returned or were discarded.
+                const Frame& frame = mFrames[--mFrameCount];
+                for (int l = 0; l < kLanes; ++l)
+                {
+                    bool returned = call >= 0 && mFrames[call].second[l];
+                    mMask[l] = frame.first[l] && !returned && !mDiscarded[l];
+                }
+                loop = frame.link;
+                updateMask();
+                ++pc;
+                break;
+            }
+            case ECpuOpBreak:
+                memset(mMask, 0, kLanes);
+                updateMask();
+                ++pc;
+                break;
+            case ECpuOpContinue:
+                for (int l = 0; l < kLanes; ++l)
+                    mFrames[loop].second[l] |= mMask[l];
+                memset(mMask, 0, kLanes);
+                updateMask();
+                ++pc;
+                break;
+            case ECpuOpReturn:
+                for (int l = 0; l < kLanes; ++l)
+                    mFrames[call].second[l] |= mMask[l];
+                memset(mMask, 0, kLanes);
+                updateMask();
+                ++pc;
+                break;
+            case ECpuOpKill:
+                for (int l = 0; l < kLanes; ++l)
+                    mDiscarded[l] |= mMask[l];
+                memset(mMask, 0, kLanes);
+                updateMask();
+                ++pc;
+                break;
+            case ECpuOpCall: {
+                if (!mAnyActive)
+                {
+                    ++pc;
+                    break;
+                }
+                Frame& frame = pushFrame();
+                memcpy(frame.first, mMask, kLanes);
+                memset(frame.second, 0, kLanes);
+                frame.returnAddress = pc + 1;
+                frame.link = call;
+                call = mFrameCount - 1;
+                pc = instruction.target;
+                break;
+            }
+            case ECpuOpFunctionEnd: {
+                const Frame& frame = mFrames[--mFrameCount];
+                for (int l = 0; l < kLanes; ++l)
+                    mMask[l] = frame.first[l] && !mDiscarded[l];
+                call = frame.link;
+                pc = frame.returnAddress;
+                updateMask();
+                break;
+            }
+            case ECpuOpHalt:
+                return;
+            default:
+                // Instructions have no effect when no invocation is active.
+                if (mAnyActive)
+                    execute(instruction);
+                ++pc;
+                break;
+        }
+    }
+}
+
+const float* CpuVirtualMachine::source(const CpuOperand& operand, int c, int scratch) const
+{
+    if (operand.offset < 0)
+        return &mRegisters[operand.component(c) * kLanes];
+
+    int size = std::max(mBytecode.getMaxOperandSize(), 1);
+    if (operand.count == 1)
+        c = 0;
+    return &mScratch[(scratch * size + c) * kLanes];
+}
+
+void CpuVirtualMachine::gather(const CpuOperand& operand, int scratch)
+{
+    if (operand.offset < 0)
+        return;
+
+    int size = std::max(mBytecode.getMaxOperandSize(), 1);
+    const float* offsets = &mRegisters[operand.offset * kLanes];
+    for (int c = 0; c < operand.count; ++c)
+    {
+        float* d = &mScratch[(scratch * size + c) * kLanes];
+        int component = operand.component(c);
+        FOR_EACH_LANE(mRegisters[(component + static_cast<int>(offsets[l])) * kLanes + l]);
+    }
+}
+
+void CpuVirtualMachine::commit(const CpuInstruction& instruction)
+{
+    const CpuOperand& dst = instruction.dst;
+    int size = std::max(mBytecode.getMaxOperandSize(), 1);
+    const float* offsets = dst.offset >= 0 ? &mRegisters[dst.offset * kLanes] : NULL;
+    for (int c = 0; c < instruction.count; ++c)
+    {
+        const float* result = &mScratch[(EScratchResult * size + c) * kLanes];
+        int component = dst.component(c);
+        if (offsets)
+        {
+            for (int l = 0; l < kLanes; ++l)
+            {
+                if (mMask[l])
+                    mRegisters[(component + static_cast<int>(offsets[l])) * kLanes + l] = result[l];
+            }
+        }
+        else if (mAllActive)
+        {
+            memcpy(&mRegisters[component * kLanes], result, kLanes * sizeof(float));
+        }
+        else
+        {
+            float* d = &mRegisters[component * kLanes];
+            FOR_EACH_LANE(mMask[l] ? result[l] : d[l]);
+        }
+    }
+}
+
+void CpuVirtualMachine::execute(const CpuInstruction& instruction)
+{
+    const CpuOperand& a = instruction.a;
+    const CpuOperand& b = instruction.b;
+    const CpuOperand& c = instruction.c;
+    gather(a, EScratchA);
+    gather(b, EScratchB);
+    gather(c, EScratchC);
+
+    int size = std::max(mBytecode.getMaxOperandSize(), 1);
+    float* result = &mScratch[EScratchResult * size * kLanes];
+    int n = instruction.n;
+
+    switch (instruction.op)
+    {
+        case ECpuOpMatrixTimesVector:
+        case ECpuOpVectorTimesMatrix:
+        case ECpuOpMatrixTimesMatrix: {
+            int columns = instruction.op == ECpuOpMatrixTimesMatrix ? n : 1;
+            for (int column = 0; column < columns; ++column)
+            {
+                for (int row = 0; row < n; ++row)
+                {
+                    float* d = result + (column * n + row) * kLanes;
+                    std::fill(d, d + kLanes, 0.0f);
+                    for (int k = 0; k < n; ++k)
+                    {
+                        const float* x = NULL;
+                        const float* y = NULL;
+                        switch (instruction.op)
+                        {
+                            case ECpuOpMatrixTimesVector:
+                                x = source(a, k * n + row, EScratchA);
+                                y = source(b, k, EScratchB);
+                                break;
+                            case ECpuOpVectorTimesMatrix:
+                                x = source(a, k, EScratchA);
+                                y = source(b, row * n + k, EScratchB);
+                                break;
+                            default:
+                                x = source(a, k * n + row, EScratchA);
+                                y = source(b, column * n + k, EScratchB);
+                                break;
+                        }
+                        FOR_EACH_LANE(d[l] + x[l] * y[l]);
+                    }
+                }
+            }
+            break;
+        }
+        case ECpuOpMatrixFromScalar:
+        case ECpuOpMatrixFromMatrix: {
+            int m = instruction.m;
+            const float* scalar = source(a, 0, EScratchA);
+            for (int column = 0; column < n; ++column)
+            {
+                for (int row = 0; row < n; ++row)
+                {
+                    float* d = result + (column * n + row) * kLanes;
+                    if (instruction.op == ECpuOpMatrixFromScalar)
+                    {
+                        if (column == row)
+                            FOR_EACH_LANE(scalar[l]);
+                        else
+                            std::fill(d, d + kLanes, 0.0f);
+                    }
+                    else if (column < m && row < m)
+                    {
+                        memcpy(d, source(a, column * m + row, EScratchA), kLanes * sizeof(float));
+                    }
+                    else
+                    {
+                        std::fill(d, d + kLanes, column == row ? 1.0f : 0.0f);
+                    }
+                }
+            }
+            break;
+        }
+        case ECpuOpEqual:
+        case ECpuOpNotEqual: {
+            float* d = result;
+            std::fill(d, d + kLanes, 1.0f);
+            for (int k = 0; k < a.count; ++k)
+            {
+                const float* x = source(a, k, EScratchA);
+                const float* y = source(b, k, EScratchB);
+                FOR_EACH_LANE(x[l] == y[l] ? d[l] : 0.0f);
+            }
+            if (instruction.op == ECpuOpNotEqual)
+                FOR_EACH_LANE(1.0f - d[l]);
+            break;
+        }
+        case ECpuOpAny:
+        case ECpuOpAll: {
+            bool any = instruction.op == ECpuOpAny;
+            float* d = result;
+            std::fill(d, d + kLanes, any ? 0.0f : 1.0f);
+            for (int k = 0; k < a.count; ++k)
+            {
+                const float* x = source(a, k, EScratchA);
+                if (any)
+                    FOR_EACH_LANE(x[l] != 0.0f ? 1.0f : d[l]);
+                else
+                    FOR_EACH_LANE(x[l] != 0.0f ? d[l] : 0.0f);
+            }
+            break;
+        }
+        case ECpuOpLength:
+        case ECpuOpDistance:
+        case ECpuOpDot: {
+            float* d = result;
+            std::fill(d, d + kLanes, 0.0f);
+            for (int k = 0; k < a.count; ++k)
+            {
+                const float* x = source(a, k, EScratchA);
+                if (instruction.op == ECpuOpLength)
+                {
+                    FOR_EACH_LANE(d[l] + x[l] * x[l]);
+                    continue;
+                }
+                const float* y = source(b, k, EScratchB);
+                if (instruction.op == ECpuOpDot)
+                    FOR_EACH_LANE(d[l] + x[l] * y[l]);
+                else
+                    FOR_EACH_LANE(d[l] + (x[l] - y[l]) * (x[l] - y[l]));
+            }
+            if (instruction.op != ECpuOpDot)
+                FOR_EACH_LANE(sqrtf(d[l]));
+            break;
+        }
+        case ECpuOpNormalize:
+        case ECpuOpFaceForward:
+        case ECpuOpReflect:
+        case ECpuOpRefract: {
+            // The dot product that scales the vector: x.x for normalize,
+            // Nref.I for faceforward(N, I, Nref), N.I for reflect(I, N)
+            // and refract(I, N, eta).
+            float scale[kLanes];
+            float* d = scale;
+            std::fill(d, d + kLanes, 0.0f);
+            for (int k = 0; k < a.count; ++k)
+            {
+                const float* x = source(instruction.op == ECpuOpFaceForward ? c : a, k,
+                                        instruction.op == ECpuOpFaceForward ? EScratchC : EScratchA);
+                const float* y = instruction.op == ECpuOpNormalize ? x : source(b, k, EScratchB);
+                FOR_EACH_LANE(d[l] + x[l] * y[l]);
+            }
+            const float* eta = instruction.op == ECpuOpRefract ? source(c, 0, EScratchC) : NULL;
+            for (int k = 0; k < a.count; ++k)
+            {
+                const float* x = source(a, k, EScratchA);
+                const float* y = instruction.op == ECpuOpNormalize ? x : source(b, k, EScratchB);
+                d = result + k * kLanes;
+                switch (instruction.op)
+                {
+                    case ECpuOpNormalize:
+                        FOR_EACH_LANE(x[l] * (1.0f / sqrtf(scale[l])));
+                        break;
+                    case ECpuOpFaceForward:
+                        FOR_EACH_LANE(scale[l] < 0.0f ? x[l] : -x[l]);
+                        break;
+                    case ECpuOpReflect:
+                        FOR_EACH_LANE(x[l] - 2.0f * scale[l] * y[l]);
+                        break;
+                    default:
+                        for (int l = 0; l < kLanes; ++l)
+                        {
+                            float k2 = 1.0f - eta[l] * eta[l] * (1.0f - scale[l] * scale[l]);
+                            d[l] = k2 < 0.0f ? 0.0f : eta[l] * x[l] - (eta[l] * scale[l] + sqrtf(k2)) * y[l];
+                        }
+                        break;
+                }
+            }
+            break;
+        }
+        case ECpuOpCross: {
+            const float* x0 = source(a, 0, EScratchA);
+            const float* x1 = source(a, 1, EScratchA);
+            const float* x2 = source(a, 2, EScratchA);
+            const float* y0 = source(b, 0, EScratchB);
+            const float* y1 = source(b, 1, EScratchB);
+            const float* y2 = source(b, 2, EScratchB);
+            float* d = result;
+            FOR_EACH_LANE(x1[l] * y2[l] - x2[l] * y1[l]);
+            d = result + kLanes;
+            FOR_EACH_LANE(x2[l] * y0[l] - x0[l] * y2[l]);
+            d = result + 2 * kLanes;
+            FOR_EACH_LANE(x0[l] * y1[l] - x1[l] * y0[l]);
+            break;
+        }
+        case ECpuOpTexture: {
+            CpuTexture texture = static_cast<CpuTexture>(n);
+            bool cube = texture == ECpuTextureCube || texture == ECpuTextureCubeLod;
+            bool projected = texture == ECpuTexture2DProj || texture == ECpuTexture2DProjLod;
+            bool explicitLod = texture == ECpuTexture2DLod || texture == ECpuTexture2DProjLod ||
+                               texture == ECpuTextureCubeLod;
+            const float* unit = source(a, 0, EScratchA);
+            const float* lod = c.count > 0 ? source(c, 0, EScratchC) : NULL;
+            std::fill(result, result + 4 * kLanes, 0.0f);
+            for (int l = 0; l < kLanes; ++l)
+            {
+                if (!mMask[l] || mSampler == NULL)
+                    continue;
+                float point[3] = { 0.0f, 0.0f, 0.0f };
+                for (int k = 0; k < (cube ? 3 : 2); ++k)
+                    point[k] = source(b, k, EScratchB)[l];
+                if (projected)
+                {
+                    // The last component of a vec3 or vec4 divides the others.
+                    float q = source(b, b.count - 1, EScratchB)[l];
+                    point[0] /= q;
+                    point[1] /= q;
+                }
+                float rgba[4];
+                mSampler->sample(static_cast<int>(unit[l]), cube, point,
+                                 lod ? lod[l] : 0.0f, explicitLod, rgba);
+                for (int k = 0; k < 4; ++k)
+                    result[k * kLanes + l] = rgba[k];
+            }
+            break;
+        }
+        case ECpuOpIndex: {
+            const float* x = source(a, 0, EScratchA);
+            float* d = result;
+            float last = static_cast<float>(n - 1);
+            // Comparisons are false for NaN, which becomes 0.
+            FOR_EACH_LANE(x[l] >= 0.0f ? floorf(std::min(x[l], last)) * instruction.m : 0.0f);
+            if (b.count > 0)
+            {
+                const float* y = source(b, 0, EScratchB);
+                FOR_EACH_LANE(d[l] + y[l]);
+            }
+            break;
+        }
+        default:
+            // The remaining instructions operate on each component.
+            for (int k = 0; k < instruction.count; ++k)
+            {
+                float* d = result + k * kLanes;
+                const float* x = source(a, k, EScratchA);
+                const float* y = b.count > 0 ? source(b, k, EScratchB) : NULL;
+                const float* z = c.count > 0 ? source(c, k, EScratchC) : NULL;
+                switch (instruction.op)
+                {
+                    case ECpuOpMove: FOR_EACH_LANE(x[l]); break;
+                    case ECpuOpToInt: FOR_EACH_LANE(Truncate(x[l])); break;
+                    case ECpuOpToBool: FOR_EACH_LANE(Boolean(x[l] != 0.0f)); break;
+                    case ECpuOpSelect: FOR_EACH_LANE(x[l] != 0.0f ? y[l] : z[l]); break;
+                    case ECpuOpAdd: FOR_EACH_LANE(x[l] + y[l]); break;
+                    case ECpuOpSub: FOR_EACH_LANE(x[l] - y[l]); break;
+                    case ECpuOpMul: FOR_EACH_LANE(x[l] * y[l]); break;
+                    case ECpuOpDiv: FOR_EACH_LANE(x[l] / y[l]); break;
+                    case ECpuOpIntDiv: FOR_EACH_LANE(Truncate(x[l] / y[l])); break;
+                    case ECpuOpNegate: FOR_EACH_LANE(-x[l]); break;
+                    case ECpuOpLessThan: FOR_EACH_LANE(Boolean(x[l] < y[l])); break;
+                    case ECpuOpGreaterThan: FOR_EACH_LANE(Boolean(x[l] > y[l])); break;
+                    case ECpuOpLessThanEqual: FOR_EACH_LANE(Boolean(x[l] <= y[l])); break;
+                    case ECpuOpGreaterThanEqual: FOR_EACH_LANE(Boolean(x[l] >= y[l])); break;
+                    case ECpuOpVectorEqual: FOR_EACH_LANE(Boolean(x[l] == y[l])); break;
+                    case ECpuOpVectorNotEqual: FOR_EACH_LANE(Boolean(x[l] != y[l])); break;
+                    case ECpuOpLogicalNot: FOR_EACH_LANE(Boolean(x[l] == 0.0f)); break;
+                    case ECpuOpLogicalAnd: FOR_EACH_LANE(Boolean(x[l] != 0.0f && y[l] != 0.0f)); break;
+                    case ECpuOpLogicalOr: FOR_EACH_LANE(Boolean(x[l] != 0.0f || y[l] != 0.0f)); break;
+                    case ECpuOpLogicalXor: FOR_EACH_LANE(Boolean((x[l] != 0.0f) != (y[l] != 0.0f))); break;
+                    case ECpuOpRadians: FOR_EACH_LANE(x[l] * 0.017453292519943295f); break;
+                    case ECpuOpDegrees: FOR_EACH_LANE(x[l] * 57.29577951308232f); break;
+                    case ECpuOpSin: FOR_EACH_LANE(sinf(x[l])); break;
+                    case ECpuOpCos: FOR_EACH_LANE(cosf(x[l])); break;
+                    case ECpuOpTan: FOR_EACH_LANE(tanf(x[l])); break;
+                    case ECpuOpAsin: FOR_EACH_LANE(asinf(x[l])); break;
+                    case ECpuOpAcos: FOR_EACH_LANE(acosf(x[l])); break;
+                    case ECpuOpAtan: FOR_EACH_LANE(atanf(x[l])); break;
+                    case ECpuOpAtan2: FOR_EACH_LANE(atan2f(x[l], y[l])); break;
+                    case ECpuOpPow: FOR_EACH_LANE(powf(x[l], y[l])); break;
+                    case ECpuOpExp: FOR_EACH_LANE(expf(x[l])); break;
+                    case ECpuOpLog: FOR_EACH_LANE(logf(x[l])); break;
+                    case ECpuOpExp2: FOR_EACH_LANE(powf(2.0f, x[l])); break;
+                    case ECpuOpLog2: FOR_EACH_LANE(logf(x[l]) * 1.4426950408889634f); break;
+                    case ECpuOpSqrt: FOR_EACH_LANE(sqrtf(x[l])); break;
+                    case ECpuOpInverseSqrt: FOR_EACH_LANE(1.0f / sqrtf(x[l])); break;
+                    case ECpuOpAbs: FOR_EACH_LANE(fabsf(x[l])); break;
+                    case ECpuOpSign: FOR_EACH_LANE(x[l] > 0.0f ? 1.0f : (x[l] < 0.0f ? -1.0f : 0.0f)); break;
+                    case ECpuOpFloor: FOR_EACH_LANE(floorf(x[l])); break;
+                    case ECpuOpCeil: FOR_EACH_LANE(ceilf(x[l])); break;
+                    case ECpuOpFract: FOR_EACH_LANE(x[l] - floorf(x[l])); break;
+                    case ECpuOpMod: FOR_EACH_LANE(x[l] - y[l] * floorf(x[l] / y[l])); break;
+                    case ECpuOpMin: FOR_EACH_LANE(y[l] < x[l] ? y[l] : x[l]); break;
+                    case ECpuOpMax: FOR_EACH_LANE(x[l] < y[l] ? y[l] : x[l]); break;
+                    case ECpuOpClamp: FOR_EACH_LANE(Clamp(x[l], y[l], z[l])); break;
+                    case ECpuOpMix: FOR_EACH_LANE(x[l] * (1.0f - z[l]) + y[l] * z[l]); break;
+                    case ECpuOpStep: FOR_EACH_LANE(y[l] < x[l] ? 0.0f : 1.0f); break;
+                    case ECpuOpSmoothStep:
+                        for (int l = 0; l < kLanes; ++l)
+                        {
+                            float t = Clamp((z[l] - x[l]) / (y[l] - x[l]), 0.0f, 1.0f);
+                            d[l] = t * t * (3.0f - 2.0f * t);
+                        }
+                        break;
+                    case ECpuOpDFdx:
+                    case ECpuOpDFdy:
+                    case ECpuOpFwidth:
+                        // Invocations 4k to 4k + 3 are the fragments of a
+                        // quad, in rows.
+                        for (int l = 0; l < kLanes; ++l)
+                        {
+                            float dx = x[l | 1] - x[l & ~1];
+                            float dy = x[l | 2] - x[l & ~2];
+                            d[l] = instruction.op == ECpuOpDFdx ? dx :
+                                   instruction.op == ECpuOpDFdy ? dy : fabsf(dx) + fabsf(dy);
+                        }
+                        break;
+                    default:
+                        UNREACHABLE();
+                        break;
+                }
+            }
+            break;
+    }
+
+    commit(instruction);
+}
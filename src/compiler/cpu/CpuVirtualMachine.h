@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_CPU_CPU_VIRTUAL_MACHINE_H_
+#define COMPILER_CPU_CPU_VIRTUAL_MACHINE_H_
+
+//
+// Runs CpuBytecode on the CPU.
+//
+// Each instruction is executed for kLanes invocations at once, as a loop
+// over the lanes of each of its components, which makes the cost of
+// dispatching an instruction small next to the work it does. Results
+// match those of CpuExecutor, which is simpler and slower, except for
+// derivatives in non-uniform control flow, which are undefined: inactive
+// invocations keep the values they had before the branch.
+//
+
+#include "compiler/cpu/CpuBindings.h"
+#include "compiler/cpu/CpuBytecode.h"
+
+class CpuVirtualMachine : public CpuBindings
+{
+public:
+    CpuVirtualMachine(const CpuBytecode& bytecode);
+
+    // Runs count invocations of the shader. If discarded is not null, it
+    // receives for each invocation whether the fragment was discarded.
+    void run(int count, bool* discarded);
+
+    // Number of instructions run for each group of kLanes invocations,
+    // summed over the calls to run. A measure of the cost of the shader.
+    unsigned long getExecutedInstructions() const { return mExecutedInstructions; }
+
+private:
+    // The state saved by an If, a Loop or a Call. The masks are those of
+    // the invocations that resume when it ends; link is the enclosing Loop
+    // or Call frame.
+    struct Frame
+    {
+        unsigned char first[kLanes];
+        unsigned char second[kLanes];
+        int returnAddress;
+        int link;
+    };
+
+    void runBatch(int lanes);
+    Frame& pushFrame();
+    void updateMask();
+
+    void execute(const CpuInstruction& instruction);
+    const float* source(const CpuOperand& operand, int c, int scratch) const;
+    void gather(const CpuOperand& operand, int scratch);
+    void commit(const CpuInstruction& instruction);
+
+    const CpuBytecode& mBytecode;
+    std::vector<float> mRegisters;
+    // Dynamically indexed operands, and the result of the instruction.
+    std::vector<float> mScratch;
+    std::vector<Frame> mFrames;
+    int mFrameCount;
+
+    unsigned char mMask[kLanes];
+    unsigned char mDiscarded[kLanes];
+    bool mAnyActive;
+    bool mAllActive;
+    unsigned long mExecutedInstructions;
+};
+
+#endif  // COMPILER_CPU_CPU_VIRTUAL_MACHINE_H_
@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "compiler/cpu/TranslatorCPU.h"
+
+TranslatorCPU::TranslatorCPU(ShShaderType type, ShShaderSpec spec)
+    : TCompiler(type, spec) {
+}
+
+void TranslatorCPU::translate(TIntermNode* root) {
+    mBytecode.clear();
+    if (!mProgram.build(root)) {
+        getInfoSink().info.message(EPrefixInternalError, "Unable to build the CPU program");
+        return;
+    }
+    mBytecode.compile(mProgram);
+}
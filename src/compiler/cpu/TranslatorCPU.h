@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#ifndef COMPILER_CPU_TRANSLATORCPU_H_
+#define COMPILER_CPU_TRANSLATORCPU_H_
+
+#include "compiler/ShHandle.h"
+#include "compiler/cpu/CpuBytecode.h"
+#include "compiler/cpu/CpuProgram.h"
+
+//
+// Compiles shaders into a CpuProgram that CpuExecutor runs on the CPU, as a
+// reference to test the other backends and drivers against, and into the
+// CpuBytecode that CpuVirtualMachine runs faster. Both are built when the
+// shader is compiled with SH_OBJECT_CODE.
+//
+class TranslatorCPU : public TCompiler {
+public:
+    TranslatorCPU(ShShaderType type, ShShaderSpec spec);
+
+    const CpuProgram& getProgram() const { return mProgram; }
+    const CpuBytecode& getBytecode() const { return mBytecode; }
+
+protected:
+    virtual void translate(TIntermNode* root);
+
+private:
+    CpuProgram mProgram;
+    CpuBytecode mBytecode;
+};
+
+#endif  // COMPILER_CPU_TRANSLATORCPU_H_
@@ -9,9 +9,35 @@
 #include "compiler/depgraph/DependencyGraph.h"
 #include "compiler/depgraph/DependencyGraphBuilder.h"
 
+#include <algorithm>
+
+namespace {
+
+bool compareNodeIndices(const TGraphNode* node1, const TGraphNode* node2)
+{
+    return node1->getIndex() < node2->getIndex();
+}
+
+}  // namespace
+
+void TGraphParentNode::sortDependentNodes()
+{
+    std::sort(mDependentNodes.begin(), mDependentNodes.end(), compareNodeIndices);
+    mDependentNodes.erase(std::unique(mDependentNodes.begin(), mDependentNodes.end()),
+                          mDependentNodes.end());
+}
+
 TDependencyGraph::TDependencyGraph(TIntermNode* intermNode)
 {
     TDependencyGraphBuilder::build(intermNode, this);
+
+    // The traversals visit the dependent nodes of a node in the order of their creation.
+    for (TGraphParentNodeVector::const_iterator iter = mParentNodes.begin();
+         iter != mParentNodes.end();
+         ++iter)
+    {
+        (*iter)->sortDependentNodes();
+    }
 }
 
 TDependencyGraph::~TDependencyGraph()
@@ -27,14 +53,14 @@ TGraphArgument* TDependencyGraph::createArgument(TIntermAggregate* intermFunctio
                                                  int argumentNumber)
 {
     TGraphArgument* argument = new TGraphArgument(intermFunctionCall, argumentNumber);
-    mAllNodes.push_back(argument);
+    addParentNode(argument);
     return argument;
 }
 
 TGraphFunctionCall* TDependencyGraph::createFunctionCall(TIntermAggregate* intermFunctionCall)
 {
     TGraphFunctionCall* functionCall = new TGraphFunctionCall(intermFunctionCall);
-    mAllNodes.push_back(functionCall);
+    addParentNode(functionCall);
     if (functionCall->getIntermFunctionCall()->isUserDefined())
         mUserDefinedFunctionCalls.push_back(functionCall);
     return functionCall;
@@ -51,7 +77,7 @@ TGraphSymbol* TDependencyGraph::getOrCreateSymbol(TIntermSymbol* intermSymbol)
         symbol = pair.second;
     } else {
         symbol = new TGraphSymbol(intermSymbol);
-        mAllNodes.push_back(symbol);
+        addParentNode(symbol);
 
         TSymbolIdPair pair(intermSymbol->getId(), symbol);
         mSymbolIdMap.insert(pair);
@@ -67,24 +93,36 @@ TGraphSymbol* TDependencyGraph::getOrCreateSymbol(TIntermSymbol* intermSymbol)
 TGraphSelection* TDependencyGraph::createSelection(TIntermSelection* intermSelection)
 {
     TGraphSelection* selection = new TGraphSelection(intermSelection);
-    mAllNodes.push_back(selection);
+    addNode(selection);
     return selection;
 }
 
 TGraphLoop* TDependencyGraph::createLoop(TIntermLoop* intermLoop)
 {
     TGraphLoop* loop = new TGraphLoop(intermLoop);
-    mAllNodes.push_back(loop);
+    addNode(loop);
     return loop;
 }
 
 TGraphLogicalOp* TDependencyGraph::createLogicalOp(TIntermBinary* intermLogicalOp)
 {
     TGraphLogicalOp* logicalOp = new TGraphLogicalOp(intermLogicalOp);
-    mAllNodes.push_back(logicalOp);
+    addNode(logicalOp);
     return logicalOp;
 }
 
+void TDependencyGraph::addNode(TGraphNode* node)
+{
+    node->mIndex = static_cast<int>(mAllNodes.size());
+    mAllNodes.push_back(node);
+}
+
+void TDependencyGraph::addParentNode(TGraphParentNode* node)
+{
+    addNode(node);
+    mParentNodes.push_back(node);
+}
+
 const char* TGraphLogicalOp::getOpString() const
 {
     const char* opString = NULL;
@@ -9,7 +9,6 @@
 
 #include "compiler/intermediate.h"
 
-#include <set>
 #include <stack>
 
 class TGraphNode;
@@ -23,8 +22,17 @@ class TGraphLogicalOp;
 class TDependencyGraphTraverser;
 class TDependencyGraphOutput;
 
-typedef std::set<TGraphNode*> TGraphNodeSet;
+enum TGraphNodeKind {
+    EGraphNodeArgument,
+    EGraphNodeFunctionCall,
+    EGraphNodeSymbol,
+    EGraphNodeSelection,
+    EGraphNodeLoop,
+    EGraphNodeLogicalOp
+};
+
 typedef std::vector<TGraphNode*> TGraphNodeVector;
+typedef std::vector<TGraphParentNode*> TGraphParentNodeVector;
 typedef std::vector<TGraphSymbol*> TGraphSymbolVector;
 typedef std::vector<TGraphFunctionCall*> TFunctionCallVector;
 
@@ -33,11 +41,19 @@ typedef std::vector<TGraphFunctionCall*> TFunctionCallVector;
 //
 class TGraphNode {
 public:
-    TGraphNode(TIntermNode* node) : intermNode(node) {}
+    TGraphNode(TIntermNode* node) : intermNode(node), mIndex(-1) {}
     virtual ~TGraphNode() {}
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const = 0;
+    virtual const TGraphParentNode* getAsParentNode() const { return NULL; }
+    // Position of the node in the graph, from 0 in the order of creation.
+    int getIndex() const { return mIndex; }
+    TSourceLoc getLine() const { return intermNode->getLine(); }
 protected:
     TIntermNode* intermNode;
+private:
+    friend class TDependencyGraph;
+    int mIndex;
 };
 
 //
@@ -47,10 +63,21 @@ class TGraphParentNode : public TGraphNode {
 public:
     TGraphParentNode(TIntermNode* node) : TGraphNode(node) {}
     virtual ~TGraphParentNode() {}
-    void addDependentNode(TGraphNode* node) { if (node != this) mDependentNodes.insert(node); }
+    void addDependentNode(TGraphNode* node)
+    {
+        if (node != this && (mDependentNodes.empty() || mDependentNodes.back() != node))
+            mDependentNodes.push_back(node);
+    }
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual const TGraphParentNode* getAsParentNode() const { return this; }
+    // Sorted by index once the graph is built.
+    const TGraphNodeVector& getDependentNodes() const { return mDependentNodes; }
 private:
-    TGraphNodeSet mDependentNodes;
+    friend class TDependencyGraph;
+    // Sorts the dependent nodes by index and removes the duplicates.
+    void sortDependentNodes();
+
+    TGraphNodeVector mDependentNodes;
 };
 
 //
@@ -65,6 +92,7 @@ public:
     const TIntermAggregate* getIntermFunctionCall() const { return intermNode->getAsAggregate(); }
     int getArgumentNumber() const { return mArgumentNumber; }
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const { return EGraphNodeArgument; }
 private:
     int mArgumentNumber;
 };
@@ -79,6 +107,7 @@ public:
     virtual ~TGraphFunctionCall() {}
     const TIntermAggregate* getIntermFunctionCall() const { return intermNode->getAsAggregate(); }
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const { return EGraphNodeFunctionCall; }
 };
 
 //
@@ -90,6 +119,7 @@ public:
     virtual ~TGraphSymbol() {}
     const TIntermSymbol* getIntermSymbol() const { return intermNode->getAsSymbolNode(); }
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const { return EGraphNodeSymbol; }
 };
 
 //
@@ -101,6 +131,7 @@ public:
     virtual ~TGraphSelection() {}
     const TIntermSelection* getIntermSelection() const { return intermNode->getAsSelectionNode(); }
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const { return EGraphNodeSelection; }
 };
 
 //
@@ -112,6 +143,7 @@ public:
     virtual ~TGraphLoop() {}
     const TIntermLoop* getIntermLoop() const { return intermNode->getAsLoopNode(); }
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const { return EGraphNodeLoop; }
 };
 
 //
@@ -124,6 +156,7 @@ public:
     const TIntermBinary* getIntermLogicalOp() const { return intermNode->getAsBinaryNode(); }
     const char* getOpString() const;
     virtual void traverse(TDependencyGraphTraverser* graphTraverser);
+    virtual TGraphNodeKind getKind() const { return EGraphNodeLogicalOp; }
 };
 
 //
@@ -169,11 +202,17 @@ public:
     TGraphSelection* createSelection(TIntermSelection* intermSelection);
     TGraphLoop* createLoop(TIntermLoop* intermLoop);
     TGraphLogicalOp* createLogicalOp(TIntermBinary* intermLogicalOp);
+
+    int getNodeCount() const { return static_cast<int>(mAllNodes.size()); }
 private:
     typedef TMap<int, TGraphSymbol*> TSymbolIdMap;
     typedef std::pair<int, TGraphSymbol*> TSymbolIdPair;
 
+    void addNode(TGraphNode* node);
+    void addParentNode(TGraphParentNode* node);
+
     TGraphNodeVector mAllNodes;
+    TGraphParentNodeVector mParentNodes;
     TGraphSymbolVector mSamplerSymbols;
     TFunctionCallVector mUserDefinedFunctionCalls;
     TSymbolIdMap mSymbolIdMap;
@@ -201,12 +240,24 @@ public:
     void incrementDepth() { ++mDepth; }
     void decrementDepth() { --mDepth; }
 
-    void clearVisited() { mVisited.clear(); }
-    void markVisited(TGraphNode* node) { mVisited.insert(node); }
-    bool isVisited(TGraphNode* node) const { return mVisited.find(node) != mVisited.end(); }
+    // The visited nodes are marked by index in a bitset, which keeps its
+    // memory when it is cleared for another traversal.
+    void clearVisited() { mVisited.assign(mVisited.size(), false); }
+    void markVisited(TGraphNode* node)
+    {
+        size_t index = static_cast<size_t>(node->getIndex());
+        if (index >= mVisited.size())
+            mVisited.resize(index + 1, false);
+        mVisited[index] = true;
+    }
+    bool isVisited(TGraphNode* node) const
+    {
+        size_t index = static_cast<size_t>(node->getIndex());
+        return index < mVisited.size() && mVisited[index];
+    }
 private:
     int mDepth;
-    TGraphNodeSet mVisited;
+    std::vector<bool> mVisited;
 };
 
 #endif
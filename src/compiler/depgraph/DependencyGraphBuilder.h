@@ -9,6 +9,8 @@
 
 #include "compiler/depgraph/DependencyGraph.h"
 
+#include <set>
+
 //
 // Creates a dependency graph of symbols, function calls, conditions etc. by traversing a
 // intermediate tree.
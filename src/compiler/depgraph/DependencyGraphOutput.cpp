@@ -15,39 +15,43 @@ void TDependencyGraphOutput::outputIndentation()
 void TDependencyGraphOutput::visitArgument(TGraphArgument* parameter)
 {
     outputIndentation();
-    mSink << "argument " << parameter->getArgumentNumber() << " of call to "
-          << parameter->getIntermFunctionCall()->getName() << "\n";
+    outputNodeLabel(parameter);
+    mSink << "\n";
 }
 
 void TDependencyGraphOutput::visitFunctionCall(TGraphFunctionCall* functionCall)
 {
     outputIndentation();
-    mSink << "function call " <<  functionCall->getIntermFunctionCall()->getName() << "\n";
+    outputNodeLabel(functionCall);
+    mSink << "\n";
 }
 
 void TDependencyGraphOutput::visitSymbol(TGraphSymbol* symbol)
 {
     outputIndentation();
-    mSink << symbol->getIntermSymbol()->getSymbol() << " (symbol id: "
-          << symbol->getIntermSymbol()->getId() << ")\n";
+    outputNodeLabel(symbol);
+    mSink << "\n";
 }
 
 void TDependencyGraphOutput::visitSelection(TGraphSelection* selection)
 {
     outputIndentation();
-    mSink << "selection\n";
+    outputNodeLabel(selection);
+    mSink << "\n";
 }
 
 void TDependencyGraphOutput::visitLoop(TGraphLoop* loop)
 {
     outputIndentation();
-    mSink << "loop condition\n";
+    outputNodeLabel(loop);
+    mSink << "\n";
 }
 
 void TDependencyGraphOutput::visitLogicalOp(TGraphLogicalOp* logicalOp)
 {
     outputIndentation();
-    mSink << "logical " << logicalOp->getOpString() << "\n";
+    outputNodeLabel(logicalOp);
+    mSink << "\n";
 }
 
 void TDependencyGraphOutput::outputAllSpanningTrees(TDependencyGraph& graph)
@@ -63,3 +67,156 @@ void TDependencyGraphOutput::outputAllSpanningTrees(TDependencyGraph& graph)
         mSink << "\n";
     }
 }
+
+int TDependencyGraphOutput::getLocation(const TGraphNode* node)
+{
+    int index = 0;
+    DecodeSourceLoc(node->getLine(), NULL, NULL, &index);
+    return index;
+}
+
+// The names of symbols and functions are identifiers and mangled signatures, which need no
+// escaping in JSON or DOT strings.
+void TDependencyGraphOutput::outputJSON(const TDependencyGraph& graph)
+{
+    mSink << "{\"nodes\":[";
+    for (TGraphNodeVector::const_iterator iter = graph.begin(); iter != graph.end(); ++iter)
+    {
+        const TGraphNode* node = *iter;
+        if (iter != graph.begin())
+            mSink << ",";
+        mSink << "\n{\"id\":" << node->getIndex() << ",\"location\":" << getLocation(node);
+        switch (node->getKind()) {
+            case EGraphNodeArgument: {
+                const TGraphArgument* argument = static_cast<const TGraphArgument*>(node);
+                mSink << ",\"kind\":\"argument\",\"function\":\""
+                      << argument->getIntermFunctionCall()->getName()
+                      << "\",\"argument\":" << argument->getArgumentNumber();
+                break;
+            }
+            case EGraphNodeFunctionCall: {
+                const TIntermAggregate* intermFunctionCall =
+                    static_cast<const TGraphFunctionCall*>(node)->getIntermFunctionCall();
+                mSink << ",\"kind\":\"function call\",\"function\":\""
+                      << intermFunctionCall->getName() << "\",\"userDefined\":"
+                      << intermFunctionCall->isUserDefined();
+                break;
+            }
+            case EGraphNodeSymbol: {
+                const TIntermSymbol* intermSymbol =
+                    static_cast<const TGraphSymbol*>(node)->getIntermSymbol();
+                mSink << ",\"kind\":\"symbol\",\"name\":\"" << intermSymbol->getSymbol()
+                      << "\",\"symbolId\":" << intermSymbol->getId();
+                break;
+            }
+            case EGraphNodeSelection:
+                mSink << ",\"kind\":\"selection\"";
+                break;
+            case EGraphNodeLoop:
+                mSink << ",\"kind\":\"loop condition\"";
+                break;
+            case EGraphNodeLogicalOp:
+                mSink << ",\"kind\":\"logical\",\"op\":\""
+                      << static_cast<const TGraphLogicalOp*>(node)->getOpString() << "\"";
+                break;
+        }
+        mSink << "}";
+    }
+
+    mSink << "\n],\"edges\":[";
+    bool firstEdge = true;
+    for (TGraphNodeVector::const_iterator iter = graph.begin(); iter != graph.end(); ++iter)
+    {
+        const TGraphParentNode* node = (*iter)->getAsParentNode();
+        if (!node)
+            continue;
+
+        const TGraphNodeVector& dependentNodes = node->getDependentNodes();
+        for (TGraphNodeVector::const_iterator dependent = dependentNodes.begin();
+             dependent != dependentNodes.end();
+             ++dependent)
+        {
+            mSink << (firstEdge ? "\n[" : ",[") << node->getIndex() << ","
+                  << (*dependent)->getIndex() << "]";
+            firstEdge = false;
+        }
+    }
+
+    mSink << "\n],\"samplers\":[";
+    for (TGraphSymbolVector::const_iterator iter = graph.beginSamplerSymbols();
+         iter != graph.endSamplerSymbols();
+         ++iter)
+    {
+        if (iter != graph.beginSamplerSymbols())
+            mSink << ",";
+        mSink << (*iter)->getIndex();
+    }
+    mSink << "]}\n";
+}
+
+void TDependencyGraphOutput::outputDot(const TDependencyGraph& graph)
+{
+    mSink << "digraph dependencies {\n";
+    for (TGraphNodeVector::const_iterator iter = graph.begin(); iter != graph.end(); ++iter)
+    {
+        const TGraphNode* node = *iter;
+        mSink << "  n" << node->getIndex() << " [label=\"";
+        outputNodeLabel(node);
+        mSink << "\", location=" << getLocation(node) << "];\n";
+    }
+
+    for (TGraphNodeVector::const_iterator iter = graph.begin(); iter != graph.end(); ++iter)
+    {
+        const TGraphParentNode* node = (*iter)->getAsParentNode();
+        if (!node)
+            continue;
+
+        const TGraphNodeVector& dependentNodes = node->getDependentNodes();
+        for (TGraphNodeVector::const_iterator dependent = dependentNodes.begin();
+             dependent != dependentNodes.end();
+             ++dependent)
+        {
+            mSink << "  n" << node->getIndex() << " -> n" << (*dependent)->getIndex() << ";\n";
+        }
+    }
+
+    // Sampler symbols are drawn as the sources of the graph.
+    for (TGraphSymbolVector::const_iterator iter = graph.beginSamplerSymbols();
+         iter != graph.endSamplerSymbols();
+         ++iter)
+    {
+        mSink << "  n" << (*iter)->getIndex() << " [shape=box];\n";
+    }
+    mSink << "}\n";
+}
+
+void TDependencyGraphOutput::outputNodeLabel(const TGraphNode* node)
+{
+    switch (node->getKind()) {
+        case EGraphNodeArgument: {
+            const TGraphArgument* argument = static_cast<const TGraphArgument*>(node);
+            mSink << "argument " << argument->getArgumentNumber() << " of call to "
+                  << argument->getIntermFunctionCall()->getName();
+            break;
+        }
+        case EGraphNodeFunctionCall:
+            mSink << "function call "
+                  << static_cast<const TGraphFunctionCall*>(node)->getIntermFunctionCall()->getName();
+            break;
+        case EGraphNodeSymbol: {
+            const TIntermSymbol* intermSymbol =
+                static_cast<const TGraphSymbol*>(node)->getIntermSymbol();
+            mSink << intermSymbol->getSymbol() << " (symbol id: " << intermSymbol->getId() << ")";
+            break;
+        }
+        case EGraphNodeSelection:
+            mSink << "selection";
+            break;
+        case EGraphNodeLoop:
+            mSink << "loop condition";
+            break;
+        case EGraphNodeLogicalOp:
+            mSink << "logical " << static_cast<const TGraphLogicalOp*>(node)->getOpString();
+            break;
+    }
+}
@@ -21,8 +21,16 @@ public:
     virtual void visitLogicalOp(TGraphLogicalOp* logicalOp);
 
     void outputAllSpanningTrees(TDependencyGraph& graph);
+
+    // Write the whole graph for other tools: its nodes, with their kind and source location,
+    // its edges from each node to its dependent nodes, and its sampler symbols. Nodes are
+    // identified by index.
+    void outputJSON(const TDependencyGraph& graph);
+    void outputDot(const TDependencyGraph& graph);
 private:
     void outputIndentation();
+    void outputNodeLabel(const TGraphNode* node);
+    static int getLocation(const TGraphNode* node);
 
     TInfoSinkBase& mSink;
 };
@@ -20,7 +20,7 @@ void TGraphParentNode::traverse(TDependencyGraphTraverser* graphTraverser)
     graphTraverser->incrementDepth();
 
     // Visit the parent node's children.
-    for (TGraphNodeSet::const_iterator iter = mDependentNodes.begin();
+    for (TGraphNodeVector::const_iterator iter = mDependentNodes.begin();
          iter != mDependentNodes.end();
          ++iter)
     {
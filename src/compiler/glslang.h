@@ -7,6 +7,7 @@
 struct TParseContext;
 extern int glslang_initialize(TParseContext* context);
 extern int glslang_finalize(TParseContext* context);
+extern void glslang_destroy(void* scanner);
 
 extern int glslang_scan(int count,
                         const char* const string[],
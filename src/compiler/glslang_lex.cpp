@@ -782,6 +782,7 @@ WHICH GENERATES THE GLSL ES LEXER (glslang_lex.cpp).
 */
 
 #include "compiler/glslang.h"
+#include "compiler/HeapProfile.h"
 #include "compiler/ParseHelper.h"
 #include "compiler/preprocessor/new/Token.h"
 #include "compiler/util.h"
@@ -3036,7 +3037,13 @@ void updateExtensionBehavior(const char* extName, const char* behavior)
 int string_input(char* buf, int max_size, yyscan_t yyscanner) {
     int len = 0;
 
+    // The input ends once the compile is over its budget, which the
+    // compiler then reports.
+    if (GlobalPoolAllocator.isOverBudget())
+        return 0;
+
 #if ANGLE_USE_NEW_PREPROCESSOR
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemPreprocessor);
     pp::Token token;
     yyget_extra(yyscanner)->preprocessor.lex(&token);
     len = token.type == pp::Token::LAST ? 0 : token.text.size();
@@ -3081,7 +3088,9 @@ int reserved_word(yyscan_t yyscanner) {
 void yyerror(TParseContext* context, const char* reason) {
     struct yyguts_t* yyg = (struct yyguts_t*) context->scanner;
 
-    if (context->AfterEOF) {
+    if (GlobalPoolAllocator.isOverBudget()) {
+        // The source was cut short by the budget, which the compiler reports.
+    } else if (context->AfterEOF) {
         context->error(context->line, reason, "unexpected EOF");
     } else {
         context->error(context->line, reason, yytext);
@@ -3090,20 +3099,26 @@ void yyerror(TParseContext* context, const char* reason) {
 }
 
 int glslang_initialize(TParseContext* context) {
-    yyscan_t scanner = NULL;
-    if (yylex_init_extra(context,&scanner))
-        return 1;
+    yyscan_t scanner = context->scanner;
+    if (scanner == NULL) {
+        if (yylex_init_extra(context,&scanner))
+            return 1;
 
-    context->scanner = scanner;
+        context->scanner = scanner;
+        return 0;
+    }
+
+    // The scanner of the previous parse is used again, with its buffers.
+    struct yyguts_t* yyg = (struct yyguts_t*) scanner;
+    yyset_extra(context,scanner);
+    yyg->yy_start_stack_ptr = 0;
+    BEGIN(INITIAL);
     return 0;
 }
 
 int glslang_finalize(TParseContext* context) {
-    yyscan_t scanner = context->scanner;
-    if (scanner == NULL) return 0;
-    
-    context->scanner = NULL;
-    yylex_destroy(scanner);
+    // The scanner is kept for the next parse, until glslang_destroy.
+    if (context->scanner == NULL) return 0;
 
 #if !ANGLE_USE_NEW_PREPROCESSOR
     FinalizePreprocessor();
@@ -3111,11 +3126,17 @@ int glslang_finalize(TParseContext* context) {
     return 0;
 }
 
+void glslang_destroy(void* scanner) {
+    if (scanner != NULL)
+        yylex_destroy(scanner);
+}
+
 int glslang_scan(int count, const char* const string[], const int length[],
                  TParseContext* context) {
     yyrestart(NULL,context->scanner);
     yyset_lineno(EncodeSourceLoc(0, 1, 1),context->scanner);
     context->AfterEOF = false;
+    HEAP_PROFILE_SUBSYSTEM(EHeapSubsystemPreprocessor);
 
     // Initialize preprocessor.
 #if ANGLE_USE_NEW_PREPROCESSOR
@@ -194,6 +194,7 @@ class TIntermUnary;
 class TIntermConstantUnion;
 class TIntermSelection;
 class TIntermTyped;
+class TIntermBranch;
 class TIntermSymbol;
 class TIntermLoop;
 class TInfoSink;
@@ -219,6 +220,7 @@ public:
     virtual TIntermSelection* getAsSelectionNode() { return 0; }
     virtual TIntermSymbol* getAsSymbolNode() { return 0; }
     virtual TIntermLoop* getAsLoopNode() { return 0; }
+    virtual TIntermBranch* getAsBranchNode() { return 0; }
     virtual ~TIntermNode() { }
 
 protected:
@@ -291,6 +293,9 @@ public:
     TIntermTyped* getCondition() { return cond; }
     TIntermTyped* getExpression() { return expr; }
     TIntermNode* getBody() { return body; }
+    void setCondition(TIntermTyped* c) { cond = c; }
+    void setExpression(TIntermTyped* e) { expr = e; }
+    void setBody(TIntermNode* b) { body = b; }
 
     void setUnrollFlag(bool flag) { unrollFlag = flag; }
     bool getUnrollFlag() { return unrollFlag; }
@@ -314,10 +319,12 @@ public:
             flowOp(op),
             expression(e) { }
 
+    virtual TIntermBranch* getAsBranchNode() { return this; }
     virtual void traverse(TIntermTraverser*);
 
     TOperator getFlowOp() { return flowOp; }
     TIntermTyped* getExpression() { return expression; }
+    void setExpression(TIntermTyped* e) { expression = e; }
 
 protected:
     TOperator flowOp;
@@ -498,6 +505,9 @@ public:
     TIntermNode* getCondition() const { return condition; }
     TIntermNode* getTrueBlock() const { return trueBlock; }
     TIntermNode* getFalseBlock() const { return falseBlock; }
+    void setCondition(TIntermTyped* c) { condition = c; }
+    void setTrueBlock(TIntermNode* b) { trueBlock = b; }
+    void setFalseBlock(TIntermNode* b) { falseBlock = b; }
     TIntermSelection* getAsSelectionNode() { return this; }
 
 protected:
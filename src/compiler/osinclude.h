@@ -77,4 +77,33 @@ inline void* OS_GetTLSValue(OS_TLSIndex nIndex)
 void* OS_GetTLSValue(OS_TLSIndex nIndex);
 #endif
 
+//
+// Thread Operations
+//
+#if defined(ANGLE_USE_NSPR)
+typedef PRThread* OS_Thread;
+#elif defined(ANGLE_OS_WIN)
+typedef HANDLE OS_Thread;
+#elif defined(ANGLE_OS_POSIX)
+typedef pthread_t OS_Thread;
+#elif defined(ANGLE_OS_JS)
+typedef int OS_Thread;
+#endif  // ANGLE_USE_NSPR
+
+typedef void (*OS_ThreadFunction)(void* data);
+
+// Runs the function on a new thread, which must be joined. Returns false if
+// the thread could not be created, as always happens without threads.
+bool OS_CreateThread(OS_Thread* thread, OS_ThreadFunction function, void* data);
+// Waits for the thread to finish and releases it.
+void OS_JoinThread(OS_Thread thread);
+
+//
+// Time
+//
+// Returns a time in milliseconds that never goes back and is the same on
+// all threads, so that the difference between two calls, on any threads,
+// measures the time elapsed between them.
+double OS_GetTimeMs();
+
 #endif // __OSINCLUDE_H
@@ -7,6 +7,7 @@
 // This file contains the JS specific functions.
 #include "compiler/osinclude.h"
 #include <map>
+#include <time.h>
 
 #if !defined(ANGLE_OS_JS)
 #error Trying to build a JS specific file in a non-JS build.
@@ -67,3 +68,23 @@ void* OS_GetTLSValue(OS_TLSIndex nIndex)
 		return 0;
 	return iter->second;
 }
+
+//
+// Thread Operations
+//
+bool OS_CreateThread(OS_Thread* thread, OS_ThreadFunction function, void* data)
+{
+	// JavaScript has no threads; callers run the function themselves.
+	return false;
+}
+
+void OS_JoinThread(OS_Thread thread)
+{
+}
+
+double OS_GetTimeMs()
+{
+    // Without threads, the processor time of the process is that of the
+    // compile.
+    return clock() * 1000.0 / CLOCKS_PER_SEC;
+}
@@ -41,3 +41,23 @@ bool OS_FreeTLSIndex(OS_TLSIndex nIndex)
     return true;
 }
 
+
+//
+// Thread Operations
+//
+bool OS_CreateThread(OS_Thread* thread, OS_ThreadFunction function, void* data)
+{
+    *thread = PR_CreateThread(PR_USER_THREAD, function, data, PR_PRIORITY_NORMAL,
+                              PR_GLOBAL_THREAD, PR_JOINABLE_THREAD, 0);
+    return *thread != NULL;
+}
+
+void OS_JoinThread(OS_Thread thread)
+{
+    PR_JoinThread(thread);
+}
+
+double OS_GetTimeMs()
+{
+    return PR_IntervalToMicroseconds(PR_IntervalNow()) / 1000.0;
+}
@@ -9,6 +9,8 @@
 //
 #include "compiler/osinclude.h"
 
+#include <time.h>
+
 #if !defined(ANGLE_OS_POSIX)
 #error Trying to build a posix specific file in a non-posix build.
 #endif
@@ -62,3 +64,45 @@ bool OS_FreeTLSIndex(OS_TLSIndex nIndex)
     else
         return false;
 }
+
+//
+// Thread Operations
+//
+namespace {
+struct ThreadStart {
+    OS_ThreadFunction function;
+    void* data;
+};
+
+void* RunThread(void* argument)
+{
+    ThreadStart* start = static_cast<ThreadStart*>(argument);
+    start->function(start->data);
+    delete start;
+    return NULL;
+}
+}  // namespace
+
+bool OS_CreateThread(OS_Thread* thread, OS_ThreadFunction function, void* data)
+{
+    ThreadStart* start = new ThreadStart;
+    start->function = function;
+    start->data = data;
+    if (pthread_create(thread, NULL, RunThread, start) != 0) {
+        delete start;
+        return false;
+    }
+    return true;
+}
+
+void OS_JoinThread(OS_Thread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+double OS_GetTimeMs()
+{
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
@@ -55,3 +55,49 @@ bool OS_FreeTLSIndex(OS_TLSIndex nIndex)
 	else
 		return false;
 }
+
+
+//
+// Thread Operations
+//
+namespace {
+struct ThreadStart {
+	OS_ThreadFunction function;
+	void* data;
+};
+
+DWORD WINAPI RunThread(LPVOID argument)
+{
+	ThreadStart* start = static_cast<ThreadStart*>(argument);
+	start->function(start->data);
+	delete start;
+	return 0;
+}
+}  // namespace
+
+bool OS_CreateThread(OS_Thread* thread, OS_ThreadFunction function, void* data)
+{
+	ThreadStart* start = new ThreadStart;
+	start->function = function;
+	start->data = data;
+	*thread = CreateThread(NULL, 0, RunThread, start, 0, NULL);
+	if (*thread == NULL) {
+		delete start;
+		return false;
+	}
+	return true;
+}
+
+void OS_JoinThread(OS_Thread thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+double OS_GetTimeMs()
+{
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
@@ -216,6 +216,12 @@ DirectiveParser::DirectiveParser(Tokenizer* tokenizer,
 {
 }
 
+void DirectiveParser::reset()
+{
+    mPastFirstStatement = false;
+    mConditionalStack.clear();
+}
+
 void DirectiveParser::lex(Token* token)
 {
     do
@@ -27,6 +27,9 @@ class DirectiveParser : public Lexer
                     Diagnostics* diagnostics,
                     DirectiveHandler* directiveHandler);
 
+    // Forgets the conditional blocks and the statements seen so far.
+    void reset();
+
     virtual void lex(Token* token);
 
   private:
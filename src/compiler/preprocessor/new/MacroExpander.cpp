@@ -63,6 +63,17 @@ MacroExpander::~MacroExpander()
     }
 }
 
+void MacroExpander::reset()
+{
+    for (size_t i = 0; i < mContextStack.size(); ++i)
+    {
+        mContextStack[i]->macro->disabled = false;
+        delete mContextStack[i];
+    }
+    mContextStack.clear();
+    mReserveToken.reset();
+}
+
 void MacroExpander::lex(Token* token)
 {
     while (true)
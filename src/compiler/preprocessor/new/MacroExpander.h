@@ -26,6 +26,9 @@ class MacroExpander : public Lexer
     MacroExpander(Lexer* lexer, MacroSet* macroSet, Diagnostics* diagnostics);
     virtual ~MacroExpander();
 
+    // Abandons the macros being expanded, and the token read ahead.
+    void reset();
+
     virtual void lex(Token* token);
 
   private:
@@ -35,6 +35,23 @@ struct PreprocessorImpl
         macroExpander(&directiveParser, &macroSet, diag)
     {
     }
+
+    // Forgets the macros defined by the strings preprocessed before, and
+    // the state they left. The containers keep their memory.
+    void reset()
+    {
+        macroExpander.reset();
+        directiveParser.reset();
+
+        MacroSet::iterator iter = macroSet.begin();
+        while (iter != macroSet.end())
+        {
+            if (iter->second.predefined)
+                ++iter;
+            else
+                macroSet.erase(iter++);
+        }
+    }
 };
 
 Preprocessor::Preprocessor(Diagnostics* diagnostics,
@@ -54,6 +71,8 @@ bool Preprocessor::init(int count,
 {
     static const int kGLSLVersion = 100;
 
+    mImpl->reset();
+
     // Add standard pre-defined macros.
     predefineMacro("__LINE__", 0);
     predefineMacro("__FILE__", 0);
@@ -72,6 +91,14 @@ void Preprocessor::predefineMacro(const char* name, int value)
     token.type = Token::CONST_INT;
     token.text = stream.str();
 
+    // A macro kept from the previous strings is updated in place.
+    MacroSet::iterator iter = mImpl->macroSet.find(name);
+    if ((iter != mImpl->macroSet.end()) && iter->second.predefined)
+    {
+        iter->second.replacements.assign(1, token);
+        return;
+    }
+
     Macro macro;
     macro.predefined = true;
     macro.type = Macro::kTypeObj;
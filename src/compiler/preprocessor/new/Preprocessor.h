@@ -32,6 +32,8 @@ class Preprocessor
     // Each element in the length array may contain the length of the
     // corresponding string or a value less than 0 to indicate that the string
     // is null terminated.
+    // init may be called again to preprocess other strings. The macros they
+    // define are removed, while the pre-defined macros are kept.
     bool init(int count, const char* const string[], const int length[]);
     // Adds a pre-defined macro.
     void predefineMacro(const char* name, int value);
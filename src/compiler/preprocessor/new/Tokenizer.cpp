@@ -2342,6 +2342,16 @@ bool Tokenizer::initScanner()
         return false;
 
     pprestart(0,mHandle);
+
+    // YY_USER_INIT only runs for a new scanner. A scanner used again for
+    // another set of strings starts over from the same state.
+    struct yyguts_t* yyg = static_cast<struct yyguts_t*>(mHandle);
+    BEGIN(INITIAL);
+    setFileNumber(0);
+    setLineNumber(1);
+    mContext.scanLoc = Input::Location();
+    mContext.leadingSpace = false;
+    mContext.lineStart = true;
     return true;
 }
 
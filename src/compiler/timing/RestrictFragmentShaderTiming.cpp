@@ -12,6 +12,7 @@
 RestrictFragmentShaderTiming::RestrictFragmentShaderTiming(TInfoSinkBase& sink)
     : mSink(sink)
     , mNumErrors(0)
+    , mReportErrors(true)
 {
     // Sampling ops found only in fragment shaders.
     mSamplingOps.insert("texture2D(s21;vf2;f1;");
@@ -38,11 +39,31 @@ RestrictFragmentShaderTiming::RestrictFragmentShaderTiming(TInfoSinkBase& sink)
 void RestrictFragmentShaderTiming::enforceRestrictions(const TDependencyGraph& graph)
 {
     mNumErrors = 0;
+    mReportErrors = true;
 
     // FIXME(mvujovic): The dependency graph does not support user defined function calls right now,
     // so we generate errors for them.
     validateUserDefinedFunctionCallUsage(graph);
 
+    // A single traversal from all the samplers first finds whether sampler dependent values reach
+    // any node where they are not allowed. Most shaders pass, and need no other traversal.
+    int numUserDefinedFunctionCallErrors = mNumErrors;
+    mReportErrors = false;
+    clearVisited();
+    for (TGraphSymbolVector::const_iterator iter = graph.beginSamplerSymbols();
+         iter != graph.endSamplerSymbols();
+         ++iter)
+    {
+        TGraphSymbol* samplerSymbol = *iter;
+        if (!isVisited(samplerSymbol))
+            samplerSymbol->traverse(this);
+    }
+    bool samplerErrors = mNumErrors > numUserDefinedFunctionCallErrors;
+    mNumErrors = numUserDefinedFunctionCallErrors;
+    mReportErrors = true;
+    if (!samplerErrors)
+        return;
+
     // Starting from each sampler, traverse the dependency graph and generate an error each time we
     // hit a node where sampler dependent values are not allowed.
     for (TGraphSymbolVector::const_iterator iter = graph.beginSamplerSymbols();
@@ -62,16 +83,20 @@ void RestrictFragmentShaderTiming::validateUserDefinedFunctionCallUsage(const TD
          ++iter)
     {
         TGraphFunctionCall* functionCall = *iter;
-        beginError(functionCall->getIntermFunctionCall());
-        mSink << "A call to a user defined function is not permitted.\n";
+        if (beginError(functionCall->getIntermFunctionCall()))
+            mSink << "A call to a user defined function is not permitted.\n";
     }
 }
 
-void RestrictFragmentShaderTiming::beginError(const TIntermNode* node)
+bool RestrictFragmentShaderTiming::beginError(const TIntermNode* node)
 {
     ++mNumErrors;
+    if (!mReportErrors)
+        return false;
+
     mSink.prefix(EPrefixError);
     mSink.location(node->getLine());
+    return true;
 }
 
 bool RestrictFragmentShaderTiming::isSamplingOp(const TIntermAggregate* intermFunctionCall) const
@@ -89,15 +114,15 @@ void RestrictFragmentShaderTiming::visitArgument(TGraphArgument* parameter)
         switch (parameter->getArgumentNumber()) {
             case 1:
                 // Second argument (coord)
-                beginError(parameter->getIntermFunctionCall());
-                mSink << "An expression dependent on a sampler is not permitted to be the"
-                      << " coordinate argument of a sampling operation.\n";
+                if (beginError(parameter->getIntermFunctionCall()))
+                    mSink << "An expression dependent on a sampler is not permitted to be the"
+                          << " coordinate argument of a sampling operation.\n";
                 break;
             case 2:
                 // Third argument (bias)
-                beginError(parameter->getIntermFunctionCall());
-                mSink << "An expression dependent on a sampler is not permitted to be the"
-                      << " bias argument of a sampling operation.\n";
+                if (beginError(parameter->getIntermFunctionCall()))
+                    mSink << "An expression dependent on a sampler is not permitted to be the"
+                          << " bias argument of a sampling operation.\n";
                 break;
             default:
                 // First argument (sampler)
@@ -108,20 +133,21 @@ void RestrictFragmentShaderTiming::visitArgument(TGraphArgument* parameter)
 
 void RestrictFragmentShaderTiming::visitSelection(TGraphSelection* selection)
 {
-    beginError(selection->getIntermSelection());
-    mSink << "An expression dependent on a sampler is not permitted in a conditional statement.\n";
+    if (beginError(selection->getIntermSelection()))
+        mSink << "An expression dependent on a sampler is not permitted in a conditional statement.\n";
 }
 
 void RestrictFragmentShaderTiming::visitLoop(TGraphLoop* loop)
 {
-    beginError(loop->getIntermLoop());
-    mSink << "An expression dependent on a sampler is not permitted in a loop condition.\n";
+    if (beginError(loop->getIntermLoop()))
+        mSink << "An expression dependent on a sampler is not permitted in a loop condition.\n";
 }
 
 void RestrictFragmentShaderTiming::visitLogicalOp(TGraphLogicalOp* logicalOp)
 {
-    beginError(logicalOp->getIntermLogicalOp());
-    mSink << "An expression dependent on a sampler is not permitted on the left hand side of a logical "
-          << logicalOp->getOpString()
-          << " operator.\n";
+    if (beginError(logicalOp->getIntermLogicalOp())) {
+        mSink << "An expression dependent on a sampler is not permitted on the left hand side of a logical "
+              << logicalOp->getOpString()
+              << " operator.\n";
+    }
 }
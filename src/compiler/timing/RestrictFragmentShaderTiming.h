@@ -7,6 +7,8 @@
 #ifndef COMPILER_TIMING_RESTRICT_FRAGMENT_SHADER_TIMING_H_
 #define COMPILER_TIMING_RESTRICT_FRAGMENT_SHADER_TIMING_H_
 
+#include <set>
+
 #include "GLSLANG/ShaderLang.h"
 
 #include "compiler/intermediate.h"
@@ -26,12 +28,15 @@ public:
     virtual void visitLogicalOp(TGraphLogicalOp* logicalOp);
 
 private:
-    void beginError(const TIntermNode* node);
+    // Counts an error at the node. Returns true if the error is reported, after writing its
+    // prefix and location; the caller then writes its message.
+    bool beginError(const TIntermNode* node);
     void validateUserDefinedFunctionCallUsage(const TDependencyGraph& graph);
     bool isSamplingOp(const TIntermAggregate* intermFunctionCall) const;
 
     TInfoSinkBase& mSink;
     int mNumErrors;
+    bool mReportErrors;
 
     typedef std::set<TString> StringSet;
     StringSet mSamplingOps;
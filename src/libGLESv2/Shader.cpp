@@ -255,42 +255,43 @@ void Shader::releaseCompiler()
     ShFinalize();
 }
 
-void Shader::parseVaryings()
+void Shader::parseVaryings(void *compiler)
 {
     if (mHlsl)
     {
-        const char *input = strstr(mHlsl, "// Varyings") + 12;
+        int varyingCount = 0;
+        ShGetInfo(compiler, SH_ACTIVE_VARYINGS, &varyingCount);
+        int maxNameLength = 0;
+        ShGetInfo(compiler, SH_ACTIVE_VARYING_MAX_LENGTH, &maxNameLength);
+        int maxMappedNameLength = 0;
+        ShGetInfo(compiler, SH_MAPPED_NAME_MAX_LENGTH, &maxMappedNameLength);
+        std::vector<char> name(maxNameLength);
+        std::vector<char> mappedName(maxMappedNameLength);
 
-        while(true)
+        for (int i = 0; i < varyingCount; i++)
         {
-            char varyingType[256];
-            char varyingName[256];
-
-            int matches = sscanf(input, "static %255s %255s", varyingType, varyingName);
-
-            if (matches != 2)
-            {
-                break;
-            }
-
-            char *array = strstr(varyingName, "[");
-            int size = 1;
-
+            int size = 0;
+            ShDataType type = SH_NONE;
+            ShGetActiveVarying(compiler, i, NULL, &size, &type, &name[0], &mappedName[0]);
+
+            // Arrays are named after their first element, while the HLSL
+            // declares them with the decorated name of the variable.
+            std::string varyingName = std::string("_") + &mappedName[0];
+            bool array = varyingName.size() > 3 && varyingName.compare(varyingName.size() - 3, 3, "[0]") == 0;
             if (array)
             {
-                size = atoi(array + 1);
-                *array = '\0';
+                varyingName.erase(varyingName.size() - 3);
             }
 
-            mVaryings.push_back(Varying(parseType(varyingType), varyingName, size, array != NULL));
-
-            input = strstr(input, ";") + 2;
+            mVaryings.push_back(Varying(type, varyingName, size, array));
         }
 
-        mUsesFragCoord = strstr(mHlsl, "GL_USES_FRAG_COORD") != NULL;
-        mUsesFrontFacing = strstr(mHlsl, "GL_USES_FRONT_FACING") != NULL;
-        mUsesPointSize = strstr(mHlsl, "GL_USES_POINT_SIZE") != NULL;
-        mUsesPointCoord = strstr(mHlsl, "GL_USES_POINT_COORD") != NULL;
+        int builtInUsage = 0;
+        ShGetInfo(compiler, SH_BUILT_IN_USAGE, &builtInUsage);
+        mUsesFragCoord = (builtInUsage & SH_USES_FRAG_COORD) != 0;
+        mUsesFrontFacing = (builtInUsage & SH_USES_FRONT_FACING) != 0;
+        mUsesPointSize = (builtInUsage & SH_USES_POINT_SIZE) != 0;
+        mUsesPointCoord = (builtInUsage & SH_USES_POINT_COORD) != 0;
     }
 }
 
@@ -324,7 +325,7 @@ void Shader::compileToHLSL(void *compiler)
     // ensure the compiler is loaded
     initializeCompiler();
 
-    int compileOptions = SH_OBJECT_CODE;
+    int compileOptions = SH_OBJECT_CODE | SH_ATTRIBUTES_UNIFORMS | SH_STATIC_USE_ATTRIBUTES_UNIFORMS;
     std::string sourcePath;
     if (perfActive())
     {
@@ -367,41 +368,6 @@ void Shader::compileToHLSL(void *compiler)
     }
 }
 
-GLenum Shader::parseType(const std::string &type)
-{
-    if (type == "float")
-    {
-        return GL_FLOAT;
-    }
-    else if (type == "float2")
-    {
-        return GL_FLOAT_VEC2;
-    }
-    else if (type == "float3")
-    {
-        return GL_FLOAT_VEC3;
-    }
-    else if (type == "float4")
-    {
-        return GL_FLOAT_VEC4;
-    }
-    else if (type == "float2x2")
-    {
-        return GL_FLOAT_MAT2;
-    }
-    else if (type == "float3x3")
-    {
-        return GL_FLOAT_MAT3;
-    }
-    else if (type == "float4x4")
-    {
-        return GL_FLOAT_MAT4;
-    }
-    else UNREACHABLE();
-
-    return GL_NONE;
-}
-
 // true if varying x has a higher priority in packing than y
 bool Shader::compareVarying(const Varying &x, const Varying &y)
 {
@@ -512,7 +478,7 @@ void VertexShader::compile()
 
     compileToHLSL(mVertexCompiler);
     parseAttributes();
-    parseVaryings();
+    parseVaryings(mVertexCompiler);
 }
 
 int VertexShader::getSemanticIndex(const std::string &attributeName)
@@ -539,23 +505,19 @@ void VertexShader::parseAttributes()
     const char *hlsl = getHLSL();
     if (hlsl)
     {
-        const char *input = strstr(hlsl, "// Attributes") + 14;
+        int attributeCount = 0;
+        ShGetInfo(mVertexCompiler, SH_ACTIVE_ATTRIBUTES, &attributeCount);
+        int maxNameLength = 0;
+        ShGetInfo(mVertexCompiler, SH_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+        std::vector<char> attributeName(maxNameLength);
 
-        while(true)
+        for (int i = 0; i < attributeCount; i++)
         {
-            char attributeType[256];
-            char attributeName[256];
-
-            int matches = sscanf(input, "static %255s _%255s", attributeType, attributeName);
-
-            if (matches != 2)
-            {
-                break;
-            }
-
-            mAttributes.push_back(Attribute(parseType(attributeType), attributeName));
+            int size = 0;
+            ShDataType type = SH_NONE;
+            ShGetActiveAttrib(mVertexCompiler, i, NULL, &size, &type, &attributeName[0], NULL);
 
-            input = strstr(input, ";") + 2;
+            mAttributes.push_back(Attribute(type, &attributeName[0]));
         }
     }
 }
@@ -578,7 +540,7 @@ void FragmentShader::compile()
     uncompile();
 
     compileToHLSL(mFragmentCompiler);
-    parseVaryings();
+    parseVaryings(mFragmentCompiler);
     mVaryings.sort(compareVarying);
 }
 }
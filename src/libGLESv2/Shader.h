@@ -75,13 +75,12 @@ class Shader
     static void releaseCompiler();
 
   protected:
-    void parseVaryings();
+    void parseVaryings(void *compiler);
 
     void compileToHLSL(void *compiler);
 
     void getSourceImpl(char *source, GLsizei bufSize, GLsizei *length, char *buffer);
 
-    static GLenum parseType(const std::string &type);
     static bool compareVarying(const Varying &x, const Varying &y);
 
     VaryingList mVaryings;
@@ -63,6 +63,37 @@
         'preprocessor_tests/version_test.cpp',
       ],
     },
+    {
+      'target_name': 'compiler_tests',
+      'type': 'executable',
+      'dependencies': [
+        '../src/build_angle.gyp:translator_cpu',
+        '../src/build_angle.gyp:translator_glsl',
+        'gtest',
+        'gmock',
+      ],
+      'include_dirs': [
+        '../include',
+        '../src',
+        '../third_party/googletest/include',
+        '../third_party/googlemock/include',
+      ],
+      'sources': [
+        '../third_party/googlemock/src/gmock_main.cc',
+        'compiler_tests/CompilerTest.cpp',
+        'compiler_tests/CompilerTest.h',
+        'compiler_tests/compile_budget_test.cpp',
+        'compiler_tests/cpu_executor_test.cpp',
+        'compiler_tests/eliminate_common_subexpressions_test.cpp',
+        'compiler_tests/hoist_loop_invariants_test.cpp',
+        'compiler_tests/inline_functions_test.cpp',
+        'compiler_tests/parallel_translation_test.cpp',
+        'compiler_tests/pool_statistics_test.cpp',
+        'compiler_tests/remove_dead_code_test.cpp',
+        'compiler_tests/specialize_uniforms_test.cpp',
+        'compiler_tests/vectorize_scalar_operations_test.cpp',
+      ],
+    },
   ],
 }
 
@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+void CompilerTest::SetUp()
+{
+    ASSERT_TRUE(ShInitialize());
+
+    ShBuiltInResources resources;
+    ShInitBuiltInResources(&resources);
+    mCompiler = ShConstructCompiler(SH_FRAGMENT_SHADER, mSpec,
+                                    SH_ESSL_OUTPUT, &resources);
+    ASSERT_TRUE(mCompiler != NULL);
+}
+
+void CompilerTest::TearDown()
+{
+    if (mCompiler)
+        ShDestruct(mCompiler);
+    mCompiler = NULL;
+    ShFinalize();
+}
+
+bool CompilerTest::compile(const char* source, int compileOptions)
+{
+    bool success = ShCompile(mCompiler, &source, 1, compileOptions) != 0;
+
+    int length = 0;
+    const char* infoLog = ShGetInfoLogPointer(mCompiler, &length);
+    mInfoLog.assign(infoLog, length);
+    const char* objectCode = ShGetObjectCodePointer(mCompiler, &length);
+    mObjectCode.assign(objectCode, length);
+    return success;
+}
@@ -0,0 +1,34 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "GLSLANG/ShaderLang.h"
+
+#ifndef COMPILER_TESTS_COMPILER_TEST_H_
+#define COMPILER_TESTS_COMPILER_TEST_H_
+
+class CompilerTest : public testing::Test
+{
+  protected:
+    CompilerTest(ShShaderSpec spec = SH_GLES2_SPEC) : mSpec(spec), mCompiler(NULL) { }
+
+    virtual void SetUp();
+    virtual void TearDown();
+
+    // Compiles the fragment shader source with the given options, and
+    // keeps its info log and object code.
+    bool compile(const char* source, int compileOptions);
+
+    ShShaderSpec mSpec;
+    ShHandle mCompiler;
+    std::string mInfoLog;
+    std::string mObjectCode;
+};
+
+#endif  // COMPILER_TESTS_COMPILER_TEST_H_
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include <sstream>
+
+#include "CompilerTest.h"
+
+class CompileBudgetTest : public CompilerTest
+{
+  protected:
+    // A shader long enough that parsing it takes well over a millisecond.
+    static std::string longShader(int statements)
+    {
+        std::ostringstream str;
+        str << "precision mediump float;\n"
+               "uniform float u;\n"
+               "void main() {\n"
+               "    float x = u;\n";
+        for (int i = 0; i < statements; ++i)
+            str << "    x = x * u + " << i << ".0;\n";
+        str << "    gl_FragColor = vec4(x);\n"
+               "}\n";
+        return str.str();
+    }
+};
+
+TEST_F(CompileBudgetTest, FailsOverMemoryBudget)
+{
+    std::string str = longShader(1000);
+
+    ShSetCompileBudget(mCompiler, 4096, 0);
+    EXPECT_FALSE(compile(str.c_str(), SH_OBJECT_CODE));
+    EXPECT_NE(std::string::npos, mInfoLog.find("memory budget")) << mInfoLog;
+    EXPECT_TRUE(mObjectCode.empty());
+
+    ShSetCompileBudget(mCompiler, 0, 0);
+    EXPECT_TRUE(compile(str.c_str(), SH_OBJECT_CODE)) << mInfoLog;
+}
+
+TEST_F(CompileBudgetTest, StopsParsingOverTimeBudget)
+{
+    std::string str = longShader(200000);
+
+    ShSetCompileBudget(mCompiler, 0, 1);
+    EXPECT_FALSE(compile(str.c_str(), SH_OBJECT_CODE));
+    EXPECT_NE(std::string::npos, mInfoLog.find("time budget")) << mInfoLog;
+    EXPECT_EQ(std::string::npos, mInfoLog.find("syntax error")) << mInfoLog;
+}
+
+TEST_F(CompileBudgetTest, SucceedsWithinBudget)
+{
+    std::string str = longShader(100);
+
+    ShSetCompileBudget(mCompiler, 64 * 1024 * 1024, 60 * 1000);
+    EXPECT_TRUE(compile(str.c_str(), SH_OBJECT_CODE)) << mInfoLog;
+    EXPECT_FALSE(mObjectCode.empty());
+}
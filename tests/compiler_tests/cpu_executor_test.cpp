@@ -0,0 +1,294 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "GLSLANG/ShaderLang.h"
+#include "compiler/cpu/CpuExecutor.h"
+#include "compiler/cpu/CpuVirtualMachine.h"
+#include "compiler/cpu/TranslatorCPU.h"
+
+// Returns a color computed from the arguments of the lookup, so that
+// lookups with different arguments give different colors.
+class CoordinateSampler : public CpuSampler
+{
+  public:
+    virtual void sample(int unit, bool cube, const float* coordinates,
+                        float lod, bool explicitLod, float* rgba)
+    {
+        rgba[0] = coordinates[0];
+        rgba[1] = coordinates[1];
+        rgba[2] = cube ? coordinates[2] : lod;
+        rgba[3] = unit + (explicitLod ? 0.5f : 0.0f);
+    }
+};
+
+class CpuExecutorTest : public testing::Test
+{
+  protected:
+    CpuExecutorTest() : mTranslator(NULL) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_TRUE(ShInitialize());
+
+        ShBuiltInResources resources;
+        ShInitBuiltInResources(&resources);
+        resources.OES_standard_derivatives = 1;
+        mTranslator = new TranslatorCPU(SH_FRAGMENT_SHADER, SH_GLES2_SPEC);
+        ASSERT_TRUE(mTranslator->Init(resources));
+    }
+
+    virtual void TearDown()
+    {
+        delete mTranslator;
+        mTranslator = NULL;
+        ShFinalize();
+    }
+
+    bool compile(const char* source)
+    {
+        return mTranslator->compile(&source, 1, SH_OBJECT_CODE);
+    }
+
+    // Runs the compiled shader on both engines over count invocations, with
+    // the uniforms u, m and s and the varying v, and expects the same
+    // results. Shaders need not use all of them.
+    void expectSameResults(int count)
+    {
+        const float uniform[4] = { 0.5f, -1.25f, 2.0f, 3.0f };
+        const float matrix[9] = { 1.0f, 0.5f, -2.0f, 0.25f, 3.0f, 1.5f, -1.0f, 0.0f, 2.0f };
+        const float unit = 1.0f;
+        std::vector<float> varying(count * 4);
+        for (int i = 0; i < count; ++i)
+        {
+            varying[i * 4] = i * 0.25f;
+            varying[i * 4 + 1] = i * 0.125f - 3.0f;
+            varying[i * 4 + 2] = (i % 7) * 0.5f - 1.0f;
+            varying[i * 4 + 3] = 1.0f + (i % 3);
+        }
+
+        CoordinateSampler sampler;
+        CpuExecutor executor(mTranslator->getProgram());
+        CpuVirtualMachine machine(mTranslator->getBytecode());
+        std::vector<float> executorColors(count * 4), machineColors(count * 4);
+        std::vector<char> executorDiscarded(count), machineDiscarded(count);
+        CpuBindings* engines[2] = { &executor, &machine };
+        float* colors[2] = { &executorColors[0], &machineColors[0] };
+        for (int e = 0; e < 2; ++e)
+        {
+            engines[e]->setUniform("u", uniform);
+            engines[e]->setUniform("m", matrix);
+            engines[e]->setUniform("s", &unit);
+            engines[e]->setInput("v", &varying[0]);
+            ASSERT_TRUE(engines[e]->setOutput("gl_FragColor", colors[e]));
+            engines[e]->setSampler(&sampler);
+        }
+
+        bool* discarded = new bool[count * 2];
+        executor.run(count, discarded);
+        machine.run(count, discarded + count);
+        for (int i = 0; i < count; ++i)
+        {
+            executorDiscarded[i] = discarded[i];
+            machineDiscarded[i] = discarded[count + i];
+        }
+        delete[] discarded;
+
+        bool varies = false;
+        for (int i = 0; i < count; ++i)
+        {
+            EXPECT_EQ(executorDiscarded[i], machineDiscarded[i]) << "invocation " << i;
+            if (executorDiscarded[i])
+                continue;
+            for (int c = 0; c < 4; ++c)
+            {
+                EXPECT_FLOAT_EQ(executorColors[i * 4 + c], machineColors[i * 4 + c])
+                    << "invocation " << i << ", component " << c;
+                varies = varies || executorColors[i * 4 + c] != executorColors[c];
+            }
+        }
+        // The shader is not trivial for the inputs.
+        EXPECT_TRUE(varies);
+    }
+
+    TranslatorCPU* mTranslator;
+};
+
+// The virtual machine gives the same results as the executor, over more
+// invocations than are evaluated together.
+TEST_F(CpuExecutorTest, MatchesVirtualMachine)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "varying vec2 v;\n"
+                      "float f(float x) { return x > 10.0 ? x * 0.5 : x + u; }\n"
+                      "void main() {\n"
+                      "    vec4 color = vec4(0.0);\n"
+                      "    for (int i = 0; i < 4; i++) {\n"
+                      "        if (v.x > float(i) * 8.0)\n"
+                      "            color[i] = f(v.x - v.y);\n"
+                      "        else\n"
+                      "            break;\n"
+                      "    }\n"
+                      "    if (v.y > 30.0)\n"
+                      "        discard;\n"
+                      "    gl_FragColor = color;\n"
+                      "}\n";
+    ASSERT_TRUE(compile(str)) << mTranslator->getInfoSink().info.c_str();
+
+    const int count = CpuBindings::kLanes + 36;
+    float uniform = 1.5f;
+    std::vector<float> varying(count * 2);
+    for (int i = 0; i < count; ++i)
+    {
+        varying[i * 2] = i * 0.5f;
+        varying[i * 2 + 1] = i * 0.375f;
+    }
+
+    CpuExecutor executor(mTranslator->getProgram());
+    CpuVirtualMachine machine(mTranslator->getBytecode());
+    std::vector<float> executorColors(count * 4), machineColors(count * 4);
+    bool executorDiscarded[count], machineDiscarded[count];
+    ASSERT_TRUE(executor.setUniform("u", &uniform));
+    ASSERT_TRUE(machine.setUniform("u", &uniform));
+    ASSERT_TRUE(executor.setInput("v", &varying[0]));
+    ASSERT_TRUE(machine.setInput("v", &varying[0]));
+    ASSERT_TRUE(executor.setOutput("gl_FragColor", &executorColors[0]));
+    ASSERT_TRUE(machine.setOutput("gl_FragColor", &machineColors[0]));
+
+    executor.run(count, executorDiscarded);
+    machine.run(count, machineDiscarded);
+
+    for (int i = 0; i < count; ++i)
+    {
+        EXPECT_EQ(executorDiscarded[i], machineDiscarded[i]) << "invocation " << i;
+        if (executorDiscarded[i])
+            continue;
+        for (int c = 0; c < 4; ++c)
+            EXPECT_FLOAT_EQ(executorColors[i * 4 + c], machineColors[i * 4 + c])
+                << "invocation " << i << ", component " << c;
+    }
+    // The shader is not trivial for the inputs.
+    EXPECT_TRUE(executorDiscarded[count - 1]);
+    EXPECT_FALSE(executorDiscarded[0]);
+    EXPECT_NE(0.0f, executorColors[4 * 40 + 1]);
+}
+
+// The engines agree on shaders that exercise each kind of instruction.
+TEST_F(CpuExecutorTest, MatchesVirtualMachineOnShaders)
+{
+    const char* shaders[] = {
+        // Swizzles, writes to parts of vectors and vector built-ins.
+        "precision mediump float;\n"
+        "uniform vec4 u;\n"
+        "varying vec4 v;\n"
+        "void main() {\n"
+        "    vec3 a = v.xyz * u.w;\n"
+        "    a.zx += v.yw;\n"
+        "    a.y = -a.y;\n"
+        "    vec3 n = normalize(a + vec3(0.5));\n"
+        "    vec3 r = reflect(n, normalize(u.xyz));\n"
+        "    vec3 c = cross(a, u.zyx);\n"
+        "    gl_FragColor = vec4(r.yzx + c * 0.01, dot(a, u.xyz) + distance(a, r));\n"
+        "}\n",
+
+        // Matrices, constructed from vectors and from scalars.
+        "precision mediump float;\n"
+        "uniform mat3 m;\n"
+        "varying vec4 v;\n"
+        "void main() {\n"
+        "    mat3 n = m * mat3(v.x);\n"
+        "    n[1] = v.yzw;\n"
+        "    n *= m;\n"
+        "    vec3 r = n * v.xyz + v.xyz * m;\n"
+        "    mat2 p = mat2(m);\n"
+        "    vec2 q = p * v.zw;\n"
+        "    gl_FragColor = vec4(r.xy + q, matrixCompMult(m, n)[2][1], n[0].z);\n"
+        "}\n",
+
+        // Scalar built-ins, component-wise on vectors.
+        "precision mediump float;\n"
+        "uniform vec4 u;\n"
+        "varying vec4 v;\n"
+        "void main() {\n"
+        "    vec4 a = clamp(v, -1.0, 2.0);\n"
+        "    vec4 b = mix(a, u, fract(v.x));\n"
+        "    vec4 c = step(0.5, v) + smoothstep(vec4(-1.0), vec4(3.0), v);\n"
+        "    vec4 d = pow(abs(v) + 1.0, vec4(0.5)) + mod(v, 1.5) - floor(v) + ceil(v * 0.3);\n"
+        "    float e = atan(v.y, v.x + 0.5) + exp2(a.z) + inversesqrt(v.w) + sign(v.y);\n"
+        "    float f = max(sin(v.x), cos(v.y)) + min(log(v.w), sqrt(v.w));\n"
+        "    gl_FragColor = b + c * 0.25 + d * 0.125 + vec4(e, f, length(a), degrees(a.y));\n"
+        "}\n",
+
+        // Loops with break and continue, integers and dynamic indexing.
+        "precision mediump float;\n"
+        "uniform vec4 u;\n"
+        "varying vec4 v;\n"
+        "void main() {\n"
+        "    float values[4];\n"
+        "    for (int i = 0; i < 4; i++)\n"
+        "        values[i] = u[i] * float(i + 1);\n"
+        "    vec4 color = vec4(0.0);\n"
+        "    int count = 0;\n"
+        "    for (int i = 0; i < 8; ++i) {\n"
+        "        if (float(i) > v.x)\n"
+        "            break;\n"
+        "        if (mod(float(i), 2.0) == 0.0)\n"
+        "            continue;\n"
+        "        for (int j = 0; j < 4; j++) {\n"
+        "            if (float(j) > v.w)\n"
+        "                break;\n"
+        "            color[j] += values[j] * v.z;\n"
+        "        }\n"
+        "        count++;\n"
+        "    }\n"
+        "    gl_FragColor = color + vec4(float(count));\n"
+        "}\n",
+
+        // Calls with out parameters, short-circuit operators with side
+        // effects, structures and selections.
+        "precision mediump float;\n"
+        "uniform vec4 u;\n"
+        "varying vec4 v;\n"
+        "struct S { vec2 a; float b; };\n"
+        "float g;\n"
+        "bool bump(float x) { g += x; return x > 0.0; }\n"
+        "void split(vec4 x, out S s, inout float t) { s = S(x.xy, x.z); t *= x.w; }\n"
+        "void main() {\n"
+        "    g = 0.0;\n"
+        "    S s;\n"
+        "    float t = 2.0;\n"
+        "    split(v * u, s, t);\n"
+        "    bool b = (v.y > 0.0 && bump(v.z)) || bump(v.x) ^^ v.w > 2.0;\n"
+        "    float c = b ? s.a.y : s.b;\n"
+        "    gl_FragColor = vec4(s.a, c + t, g);\n"
+        "}\n",
+
+        // Texture lookups, discard, and derivatives in uniform control flow.
+        "#extension GL_OES_standard_derivatives : enable\n"
+        "precision mediump float;\n"
+        "uniform sampler2D s;\n"
+        "varying vec4 v;\n"
+        "void main() {\n"
+        "    vec4 a = texture2D(s, v.xy) + texture2D(s, v.zw, 0.5);\n"
+        "    vec4 b = texture2DProj(s, v.xyw);\n"
+        "    float d = dFdx(v.x * v.y) + dFdy(v.y * v.z) + fwidth(v.x * v.x);\n"
+        "    if (v.z > 1.5)\n"
+        "        discard;\n"
+        "    gl_FragColor = a + b + vec4(d);\n"
+        "}\n",
+    };
+
+    for (size_t i = 0; i < sizeof(shaders) / sizeof(shaders[0]); ++i)
+    {
+        SCOPED_TRACE(shaders[i]);
+        ASSERT_TRUE(compile(shaders[i])) << mTranslator->getInfoSink().info.c_str();
+        expectSameResults(CpuBindings::kLanes * 2 + 12);
+    }
+}
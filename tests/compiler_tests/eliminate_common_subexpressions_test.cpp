@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class EliminateCommonSubexpressionsTest : public CompilerTest
+{
+};
+
+TEST_F(EliminateCommonSubexpressionsTest, ReusesRepeatedExpression)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform vec4 u;\n"
+                      "varying vec4 v;\n"
+                      "void main() {\n"
+                      "    float x = v.x * u.y + v.z;\n"
+                      "    float y = v.x * u.y + v.z;\n"
+                      "    gl_FragColor = vec4(x, y, 0.0, 1.0);\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_ELIMINATE_COMMON_SUBEXPRESSIONS)) << mInfoLog;
+    size_t pos = mObjectCode.find("((v[0] * u[1]) + v[2])");
+    ASSERT_NE(std::string::npos, pos) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("((v[0] * u[1]) + v[2])", pos + 1));
+    EXPECT_NE(std::string::npos, mObjectCode.find("webgl_cse"));
+}
+
+TEST_F(EliminateCommonSubexpressionsTest, RecomputesAfterAssignment)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform vec4 u;\n"
+                      "varying vec4 v;\n"
+                      "void set(out float t) { t = u.z; }\n"
+                      "void main() {\n"
+                      "    vec4 a = v;\n"
+                      "    float x = a.x * u.y + a.z;\n"
+                      "    a.x = u.w;\n"
+                      "    float y = a.x * u.y + a.z;\n"
+                      "    set(a.z);\n"
+                      "    float z = a.x * u.y + a.z;\n"
+                      "    gl_FragColor = vec4(x, y, z, 1.0);\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_ELIMINATE_COMMON_SUBEXPRESSIONS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("float x = ((a[0] * u[1]) + a[2])"))
+        << mObjectCode;
+    EXPECT_NE(std::string::npos, mObjectCode.find("float y = ((a[0] * u[1]) + a[2])"))
+        << mObjectCode;
+    EXPECT_NE(std::string::npos, mObjectCode.find("float z = ((a[0] * u[1]) + a[2])"))
+        << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("webgl_cse"));
+}
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class HoistLoopInvariantsTest : public CompilerTest
+{
+  protected:
+    // Only the loops validated for WebGL are processed.
+    HoistLoopInvariantsTest() : CompilerTest(SH_WEBGL_SPEC) { }
+};
+
+TEST_F(HoistLoopInvariantsTest, KeepsArrayIndex)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform vec4 s[16];\n"
+                      "uniform vec4 a;\n"
+                      "void main() {\n"
+                      "    vec4 sum = vec4(0.0);\n"
+                      "    for (int j = 0; j < 4; j++) {\n"
+                      "        for (int i = 0; i < 4; i++) {\n"
+                      "            sum += s[j * 4 + i] * a;\n"
+                      "        }\n"
+                      "    }\n"
+                      "    gl_FragColor = sum;\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_HOIST_LOOP_INVARIANTS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("s[((j * 4) + i)]"));
+    EXPECT_EQ(std::string::npos, mObjectCode.find("webgl_inv"));
+}
+
+TEST_F(HoistLoopInvariantsTest, SharesIdenticalInvariants)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform vec4 a;\n"
+                      "uniform float k;\n"
+                      "void main() {\n"
+                      "    vec4 sum = vec4(0.0);\n"
+                      "    for (int i = 0; i < 4; i++) {\n"
+                      "        sum += a * k + (a * k) * float(i);\n"
+                      "    }\n"
+                      "    gl_FragColor = sum;\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_HOIST_LOOP_INVARIANTS)) << mInfoLog;
+    size_t product = mObjectCode.find("(a * k)");
+    ASSERT_NE(std::string::npos, product);
+    EXPECT_EQ(std::string::npos, mObjectCode.find("(a * k)", product + 1));
+}
+
+// The functions called in the loop may write the outputs.
+TEST_F(HoistLoopInvariantsTest, KeepsOutputWrittenByCall)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "void set() { gl_FragColor = vec4(u); }\n"
+                      "void main() {\n"
+                      "    float x = 0.0;\n"
+                      "    for (int i = 0; i < 4; i++) {\n"
+                      "        set();\n"
+                      "        x += gl_FragColor.x * 2.0;\n"
+                      "    }\n"
+                      "    gl_FragColor.y = x;\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_HOIST_LOOP_INVARIANTS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(x += (gl_FragColor[0] * 2.0))"));
+    EXPECT_EQ(std::string::npos, mObjectCode.find("webgl_inv"));
+}
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class InlineFunctionsTest : public CompilerTest
+{
+};
+
+TEST_F(InlineFunctionsTest, VoidCallAsStatement)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "float g;\n"
+                      "void set() { g = u * 2.0; }\n"
+                      "void main() {\n"
+                      "    set();\n"
+                      "    gl_FragColor = vec4(g);\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_INLINE_FUNCTIONS)) << mInfoLog;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("set();"));
+}
+
+// A void function has no value to replace its call with when the call is
+// an operand of the comma operator, so the call is kept.
+TEST_F(InlineFunctionsTest, VoidCallInCommaExpression)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "float g;\n"
+                      "void set() { g = u * 2.0; }\n"
+                      "void main() {\n"
+                      "    float z = (set(), 1.0);\n"
+                      "    gl_FragColor = vec4(z, g, 0.0, 1.0);\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_INLINE_FUNCTIONS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("set()"));
+}
+
+// The code of an inlined function runs before the rest of the statement,
+// so a call to a function that may write an output read earlier in the
+// statement is kept.
+TEST_F(InlineFunctionsTest, OutputReadBeforeCall)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "void set() {\n"
+                      "    if (u > 0.0) {\n"
+                      "        gl_FragColor = vec4(1.0);\n"
+                      "        return;\n"
+                      "    }\n"
+                      "    gl_FragColor = vec4(u);\n"
+                      "}\n"
+                      "float getHalf() { set(); return 0.5; }\n"
+                      "void main() {\n"
+                      "    gl_FragColor = vec4(0.0);\n"
+                      "    float r = gl_FragColor.x + getHalf();\n"
+                      "    gl_FragColor.y = r;\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_INLINE_FUNCTIONS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(gl_FragColor[0] + getHalf())"));
+}
@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include <sstream>
+
+#include "CompilerTest.h"
+
+class ParallelTranslationTest : public CompilerTest
+{
+  protected:
+    // Builds a shader with enough functions to be translated on several
+    // threads. The names are longer than the strings stored without
+    // allocation, so that copying them allocates from a pool.
+    std::string buildShader(int functionCount)
+    {
+        const char* structName = "AStructureNameLongerThan32Chars";
+        std::ostringstream stream;
+        stream << "precision mediump float;\n"
+               << "uniform float u;\n"
+               << "struct " << structName << " { vec4 field; };\n"
+               << "uniform " << structName << " s;\n";
+        for (int i = 0; i < functionCount; ++i)
+        {
+            stream << "float aFunctionNameLongerThanTheInlineBuffer" << i << "(float x) {\n"
+                   << "    " << structName << " copy = s;\n"
+                   << "    return copy.field.x * x + " << i << ".0;\n"
+                   << "}\n";
+        }
+        stream << "void main() {\n"
+               << "    float r = 0.0;\n";
+        for (int i = 0; i < functionCount; ++i)
+            stream << "    r += aFunctionNameLongerThanTheInlineBuffer" << i << "(u);\n";
+        stream << "    gl_FragColor = vec4(r);\n"
+               << "}\n";
+        return stream.str();
+    }
+};
+
+// Run under ThreadSanitizer to detect the threads allocating from the pool
+// of the compiler.
+TEST_F(ParallelTranslationTest, MatchesSerialTranslation)
+{
+    std::string shader = buildShader(40);
+
+    ASSERT_TRUE(compile(shader.c_str(), SH_OBJECT_CODE)) << mInfoLog;
+    std::string serialCode = mObjectCode;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(compile(shader.c_str(), SH_OBJECT_CODE | SH_PARALLEL_TRANSLATION))
+            << mInfoLog;
+        EXPECT_EQ(serialCode, mObjectCode);
+    }
+}
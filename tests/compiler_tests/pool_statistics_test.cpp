@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class PoolStatisticsTest : public CompilerTest
+{
+  protected:
+    int getInfo(ShShaderInfo info)
+    {
+        int value = 0;
+        ShGetInfo(mCompiler, info, &value);
+        return value;
+    }
+};
+
+TEST_F(PoolStatisticsTest, CountsEachCompile)
+{
+    const char* shortStr = "precision mediump float;\n"
+                           "uniform vec4 u;\n"
+                           "void main() {\n"
+                           "    gl_FragColor = u * 2.0;\n"
+                           "}\n";
+    const char* longStr = "precision mediump float;\n"
+                          "uniform vec4 u;\n"
+                          "vec4 f(vec4 x) { return x * x + u; }\n"
+                          "void main() {\n"
+                          "    vec4 a = f(u);\n"
+                          "    vec4 b = f(a) * f(u + a);\n"
+                          "    gl_FragColor = f(b) + a * b;\n"
+                          "}\n";
+
+    ASSERT_TRUE(compile(shortStr, SH_OBJECT_CODE)) << mInfoLog;
+    int peakSize = getInfo(SH_POOL_PEAK_SIZE);
+    int allocationCount = getInfo(SH_POOL_ALLOCATION_COUNT);
+    EXPECT_LT(0, peakSize);
+    EXPECT_LT(0, allocationCount);
+
+    ASSERT_TRUE(compile(longStr, SH_OBJECT_CODE)) << mInfoLog;
+    EXPECT_LT(allocationCount, getInfo(SH_POOL_ALLOCATION_COUNT));
+
+    // The statistics start over with each compile.
+    ASSERT_TRUE(compile(shortStr, SH_OBJECT_CODE)) << mInfoLog;
+    EXPECT_EQ(peakSize, getInfo(SH_POOL_PEAK_SIZE));
+    EXPECT_EQ(allocationCount, getInfo(SH_POOL_ALLOCATION_COUNT));
+}
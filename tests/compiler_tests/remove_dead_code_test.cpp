@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class RemoveDeadCodeTest : public CompilerTest
+{
+};
+
+TEST_F(RemoveDeadCodeTest, RemovesUnusedCallWithoutSideEffects)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "float sq(float x) { float y = x; y *= x; return y; }\n"
+                      "float sqPlusOne(float x) { return sq(x) + 1.0; }\n"
+                      "void main() {\n"
+                      "    float dead = sqPlusOne(u);\n"
+                      "    gl_FragColor = vec4(u);\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_REMOVE_DEAD_CODE)) << mInfoLog;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("dead"));
+    EXPECT_EQ(std::string::npos, mObjectCode.find("sq"));
+}
+
+TEST_F(RemoveDeadCodeTest, KeepsUnusedCallWithSideEffects)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform float u;\n"
+                      "float g;\n"
+                      "float setGlobal(float x) { g = x; return x; }\n"
+                      "void setOut(out float x) { x = u; }\n"
+                      "float discardNegative(float x) { if (x < 0.0) discard; return x; }\n"
+                      "void main() {\n"
+                      "    float dead1 = setGlobal(u);\n"
+                      "    float dead2;\n"
+                      "    setOut(dead2);\n"
+                      "    float dead3 = discardNegative(u);\n"
+                      "    gl_FragColor = vec4(g);\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_REMOVE_DEAD_CODE)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("setGlobal(u)"));
+    EXPECT_NE(std::string::npos, mObjectCode.find("setOut(dead2)"));
+    EXPECT_NE(std::string::npos, mObjectCode.find("discardNegative(u)"));
+}
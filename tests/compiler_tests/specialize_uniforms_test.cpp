@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class SpecializeUniformsTest : public CompilerTest
+{
+  protected:
+    static const char* shader()
+    {
+        return "precision mediump float;\n"
+               "uniform int mode;\n"
+               "uniform float scale;\n"
+               "varying vec4 v;\n"
+               "void main() {\n"
+               "    if (mode == 2)\n"
+               "        gl_FragColor = v * scale;\n"
+               "    else\n"
+               "        gl_FragColor = vec4(scale);\n"
+               "}\n";
+    }
+
+    void specialize(int mode, float scale)
+    {
+        ShSpecializeUniformiv(mCompiler, "mode", 1, &mode);
+        ShSpecializeUniformfv(mCompiler, "scale", 1, &scale);
+    }
+};
+
+TEST_F(SpecializeUniformsTest, FoldsTakenBranch)
+{
+    specialize(2, 0.5f);
+    ASSERT_TRUE(compile(shader(), SH_OBJECT_CODE | SH_SPECIALIZE_UNIFORMS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(gl_FragColor = (v * 0.5))")) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("if")) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("vec4(0.5")) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("mode")) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("scale")) << mObjectCode;
+}
+
+TEST_F(SpecializeUniformsTest, FoldsElseBranch)
+{
+    specialize(1, 0.5f);
+    ASSERT_TRUE(compile(shader(), SH_OBJECT_CODE | SH_SPECIALIZE_UNIFORMS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(gl_FragColor = vec4(0.5, 0.5, 0.5, 0.5))"))
+        << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("if")) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("(v * ")) << mObjectCode;
+}
+
+TEST_F(SpecializeUniformsTest, KeepsBranchOfClearedUniforms)
+{
+    specialize(2, 0.5f);
+    ShClearSpecializedUniforms(mCompiler);
+    ASSERT_TRUE(compile(shader(), SH_OBJECT_CODE | SH_SPECIALIZE_UNIFORMS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("uniform mediump int mode;")) << mObjectCode;
+    EXPECT_NE(std::string::npos, mObjectCode.find("if ((mode == 2))")) << mObjectCode;
+}
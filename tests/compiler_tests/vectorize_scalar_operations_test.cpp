@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2012 The ANGLE Project Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+
+#include "CompilerTest.h"
+
+class VectorizeScalarOperationsTest : public CompilerTest
+{
+};
+
+TEST_F(VectorizeScalarOperationsTest, MergesComponentStatements)
+{
+    const char* str = "precision mediump float;\n"
+                      "uniform vec4 u;\n"
+                      "varying vec4 v;\n"
+                      "void main() {\n"
+                      "    vec4 a = vec4(0.0);\n"
+                      "    a.x = v.x * u.x;\n"
+                      "    a.y = v.y * u.y;\n"
+                      "    a.z = v.z * u.z;\n"
+                      "    gl_FragColor = a;\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_VECTORIZE_SCALAR_OPERATIONS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(a.xyz = (v.xyz * u.xyz))")) << mObjectCode;
+}
+
+TEST_F(VectorizeScalarOperationsTest, KeepsStatementReadingWrittenComponent)
+{
+    // Merging the statements would read b.x before it is written.
+    const char* str = "precision mediump float;\n"
+                      "uniform vec4 u;\n"
+                      "varying vec4 v;\n"
+                      "void main() {\n"
+                      "    vec4 b = v;\n"
+                      "    b.x = b.y * u.x;\n"
+                      "    b.y = b.x * u.y;\n"
+                      "    gl_FragColor = b;\n"
+                      "}\n";
+
+    ASSERT_TRUE(compile(str, SH_OBJECT_CODE | SH_VECTORIZE_SCALAR_OPERATIONS)) << mInfoLog;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(b[0] = (b[1] * u[0]))")) << mObjectCode;
+    EXPECT_NE(std::string::npos, mObjectCode.find("(b[1] = (b[0] * u[1]))")) << mObjectCode;
+    EXPECT_EQ(std::string::npos, mObjectCode.find("b.xy")) << mObjectCode;
+}